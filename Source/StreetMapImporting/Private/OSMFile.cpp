@@ -2,401 +2,1997 @@
 
 #include "OSMFile.h"
 #include "StreetMapImporting.h"
+#include "StreetMapImportProfiler.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/ScopedSlowTask.h"
+#include "Algo/BinarySearch.h"
+
+#define LOCTEXT_NAMESPACE "StreetMapImporting"
+
+DECLARE_CYCLE_STAT( TEXT( "Parse OSM file" ), STAT_StreetMapImport_ParseFile, STATGROUP_StreetMapImport );
+DECLARE_CYCLE_STAT( TEXT( "Finish loading OSM file" ), STAT_StreetMapImport_FinishLoading, STATGROUP_StreetMapImport );
+
+
+namespace OSMFileParsing
+{
+	// How much XML we parse between progress updates.  Also the size of the read buffer when we can't memory map the file.
+	static const int64 ChunkSize = 16 * 1024 * 1024;
+
+	// Powers of ten that can be represented exactly as doubles
+	static const int32 MaxExactPowerOfTen = 22;
+	static const double ExactPowersOfTen[ MaxExactPowerOfTen + 1 ] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	static inline bool IsWhitespace( const ANSICHAR Char )
+	{
+		return Char == ' ' || Char == '\t' || Char == '\r' || Char == '\n';
+	}
+
+	static inline bool IsNameTerminator( const ANSICHAR Char )
+	{
+		return IsWhitespace( Char ) || Char == '>' || Char == '/' || Char == '=';
+	}
+
+	static constexpr ANSICHAR ToLower( const ANSICHAR Char )
+	{
+		return ( Char >= 'A' && Char <= 'Z' ) ? ( Char + ( 'a' - 'A' ) ) : Char;
+	}
+
+	/** Finds the first occurrence of the specified (short) token, or nullptr if it's not in the range */
+	static const ANSICHAR* FindToken( const ANSICHAR* Begin, const ANSICHAR* End, const ANSICHAR* Token, const int32 TokenLength )
+	{
+		for( const ANSICHAR* Cursor = Begin; Cursor + TokenLength <= End; ++Cursor )
+		{
+			Cursor = (const ANSICHAR*)memchr( Cursor, Token[ 0 ], End - Cursor );
+			if( Cursor == nullptr || Cursor + TokenLength > End )
+			{
+				break;
+			}
+			if( FMemory::Memcmp( Cursor, Token, TokenLength ) == 0 )
+			{
+				return Cursor;
+			}
+		}
+		return nullptr;
+	}
+
+	/** Case-insensitive FNV-1a hash of a null terminated ASCII literal.  Evaluated at compile time for switch cases. */
+	static constexpr uint32 HashName( const ANSICHAR* Literal )
+	{
+		uint32 Hash = 2166136261u;
+		for( ; *Literal != '\0'; ++Literal )
+		{
+			Hash = ( Hash ^ (uint8)ToLower( *Literal ) ) * 16777619u;
+		}
+		return Hash;
+	}
+
+	/** Case-insensitive FNV-1a hash of a string from the file.  Matches HashName() for literals. */
+	static inline uint32 HashName( const FOSMStringView& String )
+	{
+		uint32 Hash = 2166136261u;
+		for( int32 CharIndex = 0; CharIndex < String.Len; ++CharIndex )
+		{
+			Hash = ( Hash ^ (uint8)ToLower( String.Data[ CharIndex ] ) ) * 16777619u;
+		}
+		return Hash;
+	}
+
+	/** Continues the hash of a tag key (from HashName()) with its value, for looking up tag filter rules */
+	static inline uint32 HashTagValue( uint32 Hash, const FOSMStringView& Value )
+	{
+		Hash = ( Hash ^ (uint8)'=' ) * 16777619u;
+		for( int32 CharIndex = 0; CharIndex < Value.Len; ++CharIndex )
+		{
+			Hash = ( Hash ^ (uint8)ToLower( Value.Data[ CharIndex ] ) ) * 16777619u;
+		}
+		return Hash;
+	}
+
+	/** Case-insensitive comparison of a string from the file with one that isn't null terminated */
+	static inline bool EqualsIgnoringCase( const FOSMStringView& String, const TArray<ANSICHAR>& Other )
+	{
+		if( String.Len != Other.Num() )
+		{
+			return false;
+		}
+		for( int32 CharIndex = 0; CharIndex < String.Len; ++CharIndex )
+		{
+			if( ToLower( String.Data[ CharIndex ] ) != ToLower( Other[ CharIndex ] ) )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/** Element names, attribute names and tag keys that we care about */
+	enum class EOSMName : uint8
+	{
+		Unknown,
+		Node,
+		Way,
+		Nd,
+		Tag,
+		Id,
+		Lat,
+		Lon,
+		Ref,
+		K,
+		V,
+		Name,
+		Highway,
+		Building,
+		Height,
+		BuildingLevels,
+		OneWay,
+		Create,
+		Modify,
+		Delete
+	};
+
+	/** Returns the result if the string really is the literal we found by hash, otherwise the default */
+	template<typename ResultType>
+	static inline ResultType MatchName( const FOSMStringView& String, const ANSICHAR* Literal, const ResultType Result, const ResultType Default )
+	{
+		return String.Equals( Literal ) ? Result : Default;
+	}
+
+	// The lookups below switch on the hash of the name, so the compiler builds the table for us.  Any hash collision
+	// between two of the names shows up as a duplicate case compile error, and the one string compare per lookup makes
+	// sure that unknown names can never be misclassified.
+
+	/** Identifies an element name, attribute name or tag key */
+	static EOSMName FindName( const FOSMStringView& String )
+	{
+		switch( HashName( String ) )
+		{
+			case HashName( "node" ):			return MatchName( String, "node", EOSMName::Node, EOSMName::Unknown );
+			case HashName( "way" ):				return MatchName( String, "way", EOSMName::Way, EOSMName::Unknown );
+			case HashName( "nd" ):				return MatchName( String, "nd", EOSMName::Nd, EOSMName::Unknown );
+			case HashName( "tag" ):				return MatchName( String, "tag", EOSMName::Tag, EOSMName::Unknown );
+			case HashName( "id" ):				return MatchName( String, "id", EOSMName::Id, EOSMName::Unknown );
+			case HashName( "lat" ):				return MatchName( String, "lat", EOSMName::Lat, EOSMName::Unknown );
+			case HashName( "lon" ):				return MatchName( String, "lon", EOSMName::Lon, EOSMName::Unknown );
+			case HashName( "ref" ):				return MatchName( String, "ref", EOSMName::Ref, EOSMName::Unknown );
+			case HashName( "k" ):				return MatchName( String, "k", EOSMName::K, EOSMName::Unknown );
+			case HashName( "v" ):				return MatchName( String, "v", EOSMName::V, EOSMName::Unknown );
+			case HashName( "name" ):			return MatchName( String, "name", EOSMName::Name, EOSMName::Unknown );
+			case HashName( "highway" ):			return MatchName( String, "highway", EOSMName::Highway, EOSMName::Unknown );
+			case HashName( "building" ):		return MatchName( String, "building", EOSMName::Building, EOSMName::Unknown );
+			case HashName( "height" ):			return MatchName( String, "height", EOSMName::Height, EOSMName::Unknown );
+			case HashName( "building:levels" ):	return MatchName( String, "building:levels", EOSMName::BuildingLevels, EOSMName::Unknown );
+			case HashName( "oneway" ):			return MatchName( String, "oneway", EOSMName::OneWay, EOSMName::Unknown );
+			case HashName( "create" ):			return MatchName( String, "create", EOSMName::Create, EOSMName::Unknown );
+			case HashName( "modify" ):			return MatchName( String, "modify", EOSMName::Modify, EOSMName::Unknown );
+			case HashName( "delete" ):			return MatchName( String, "delete", EOSMName::Delete, EOSMName::Unknown );
+			default:							return EOSMName::Unknown;
+		}
+	}
+
+	/** Identifies the type of way from the value of a highway tag.  See http://wiki.openstreetmap.org/wiki/Key:highway */
+	static FOSMFile::EOSMWayType FindHighwayType( const FOSMStringView& Value )
+	{
+		typedef FOSMFile::EOSMWayType EOSMWayType;
+		const EOSMWayType Other = EOSMWayType::Other;
+
+		switch( HashName( Value ) )
+		{
+			case HashName( "motorway" ):		return MatchName( Value, "motorway", EOSMWayType::Motorway, Other );
+			case HashName( "motorway_link" ):	return MatchName( Value, "motorway_link", EOSMWayType::Motorway_Link, Other );
+			case HashName( "trunk" ):			return MatchName( Value, "trunk", EOSMWayType::Trunk, Other );
+			case HashName( "trunk_link" ):		return MatchName( Value, "trunk_link", EOSMWayType::Trunk_Link, Other );
+			case HashName( "primary" ):			return MatchName( Value, "primary", EOSMWayType::Primary, Other );
+			case HashName( "primary_link" ):	return MatchName( Value, "primary_link", EOSMWayType::Primary_Link, Other );
+			case HashName( "secondary" ):		return MatchName( Value, "secondary", EOSMWayType::Secondary, Other );
+			case HashName( "secondary_link" ):	return MatchName( Value, "secondary_link", EOSMWayType::Secondary_Link, Other );
+			case HashName( "tertiary" ):		return MatchName( Value, "tertiary", EOSMWayType::Tertiary, Other );
+			case HashName( "tertiary_link" ):	return MatchName( Value, "tertiary_link", EOSMWayType::Tertiary_Link, Other );
+			case HashName( "residential" ):		return MatchName( Value, "residential", EOSMWayType::Residential, Other );
+			case HashName( "service" ):			return MatchName( Value, "service", EOSMWayType::Service, Other );
+			case HashName( "unclassified" ):	return MatchName( Value, "unclassified", EOSMWayType::Unclassified, Other );
+			case HashName( "living_street" ):	return MatchName( Value, "living_street", EOSMWayType::Living_Street, Other );
+			case HashName( "pedestrian" ):		return MatchName( Value, "pedestrian", EOSMWayType::Pedestrian, Other );
+			case HashName( "track" ):			return MatchName( Value, "track", EOSMWayType::Track, Other );
+			case HashName( "bus_guideway" ):	return MatchName( Value, "bus_guideway", EOSMWayType::Bus_Guideway, Other );
+			case HashName( "raceway" ):			return MatchName( Value, "raceway", EOSMWayType::Raceway, Other );
+			case HashName( "road" ):			return MatchName( Value, "road", EOSMWayType::Road, Other );
+			case HashName( "footway" ):			return MatchName( Value, "footway", EOSMWayType::Footway, Other );
+			case HashName( "cycleway" ):		return MatchName( Value, "cycleway", EOSMWayType::Cycleway, Other );
+			case HashName( "bridleway" ):		return MatchName( Value, "bridleway", EOSMWayType::Bridleway, Other );
+			case HashName( "steps" ):			return MatchName( Value, "steps", EOSMWayType::Steps, Other );
+			case HashName( "path" ):			return MatchName( Value, "path", EOSMWayType::Path, Other );
+			case HashName( "proposed" ):		return MatchName( Value, "proposed", EOSMWayType::Proposed, Other );
+			case HashName( "construction" ):	return MatchName( Value, "construction", EOSMWayType::Construction, Other );
+
+			// Other type that we don't recognize yet
+			default:							return Other;
+		}
+	}
+
+	// Sorts a list of node IDs and removes the duplicates
+	static void SortUniqueNodeIDs( TArray<int64>& InOutNodeIDs )
+	{
+		InOutNodeIDs.Sort();
+		int32 UniqueNodeIDCount = 0;
+		for( int32 NodeIDIndex = 0; NodeIDIndex < InOutNodeIDs.Num(); ++NodeIDIndex )
+		{
+			if( UniqueNodeIDCount == 0 || InOutNodeIDs[ NodeIDIndex ] != InOutNodeIDs[ UniqueNodeIDCount - 1 ] )
+			{
+				InOutNodeIDs[ UniqueNodeIDCount++ ] = InOutNodeIDs[ NodeIDIndex ];
+			}
+		}
+		InOutNodeIDs.SetNum( UniqueNodeIDCount, true );
+	}
+}
+
+
+bool FOSMStringView::Equals( const ANSICHAR* Literal ) const
+{
+	int32 CharIndex = 0;
+	for( ; CharIndex < Len; ++CharIndex )
+	{
+		if( Literal[ CharIndex ] == '\0' || OSMFileParsing::ToLower( Data[ CharIndex ] ) != OSMFileParsing::ToLower( Literal[ CharIndex ] ) )
+		{
+			return false;
+		}
+	}
+	return Literal[ CharIndex ] == '\0';
+}
+
+
+int64 FOSMStringView::ToInt64() const
+{
+	int32 CharIndex = 0;
+	const bool bIsNegative = Len > 0 && Data[ 0 ] == '-';
+	if( bIsNegative || ( Len > 0 && Data[ 0 ] == '+' ) )
+	{
+		++CharIndex;
+	}
+
+	int64 Value = 0;
+	for( ; CharIndex < Len && Data[ CharIndex ] >= '0' && Data[ CharIndex ] <= '9'; ++CharIndex )
+	{
+		Value = Value * 10 + ( Data[ CharIndex ] - '0' );
+	}
+	return bIsNegative ? -Value : Value;
+}
+
+
+double FOSMStringView::ToDouble() const
+{
+	// Coordinates in OSM files are plain decimals with up to seven fractional digits.  We gather all of the digits into
+	// a single integer mantissa and divide by an exact power of ten once, which yields the correctly rounded result
+	// without needing to copy the string somewhere so that it can be null terminated.
+	int32 CharIndex = 0;
+	const bool bIsNegative = Len > 0 && Data[ 0 ] == '-';
+	if( bIsNegative || ( Len > 0 && Data[ 0 ] == '+' ) )
+	{
+		++CharIndex;
+	}
+
+	uint64 Mantissa = 0;
+	int32 MantissaDigits = 0;
+	int32 FractionalDigits = 0;
+	bool bInFraction = false;
+	bool bIsSimpleDecimal = true;
+	for( ; CharIndex < Len; ++CharIndex )
+	{
+		const ANSICHAR Char = Data[ CharIndex ];
+		if( Char >= '0' && Char <= '9' )
+		{
+			Mantissa = Mantissa * 10 + ( Char - '0' );
+			if( Mantissa != 0 )
+			{
+				++MantissaDigits;
+			}
+			if( bInFraction )
+			{
+				++FractionalDigits;
+			}
+		}
+		else if( Char == '.' && !bInFraction )
+		{
+			bInFraction = true;
+		}
+		else
+		{
+			// Exponents or garbage.  Let the slow path deal with it.
+			bIsSimpleDecimal = false;
+			break;
+		}
+	}
+
+	if( bIsSimpleDecimal && MantissaDigits <= 15 && FractionalDigits <= OSMFileParsing::MaxExactPowerOfTen )
+	{
+		const double Value = (double)Mantissa / OSMFileParsing::ExactPowersOfTen[ FractionalDigits ];
+		return bIsNegative ? -Value : Value;
+	}
+
+	// Slow path, for numbers we can't convert exactly ourselves
+	ANSICHAR NumberBuffer[ 64 ];
+	const int32 CopyLength = FMath::Min( Len, (int32)sizeof( NumberBuffer ) - 1 );
+	FMemory::Memcpy( NumberBuffer, Data, CopyLength );
+	NumberBuffer[ CopyLength ] = '\0';
+	return FCStringAnsi::Atod( NumberBuffer );
+}
+
+
+FString FOSMStringView::ToString() const
+{
+	FString Result;
+	if( Len == 0 )
+	{
+		return Result;
+	}
+
+	// Only strings with character entities need to be unescaped, which is rare
+	if( memchr( Data, '&', Len ) == nullptr )
+	{
+		const FUTF8ToTCHAR Converted( Data, Len );
+		Result = FString( Converted.Length(), Converted.Get() );
+		return Result;
+	}
+
+	TArray<ANSICHAR> Unescaped;
+	Unescaped.Reserve( Len );
+	for( int32 CharIndex = 0; CharIndex < Len; ++CharIndex )
+	{
+		if( Data[ CharIndex ] == '&' )
+		{
+			const ANSICHAR* EntityEnd = (const ANSICHAR*)memchr( Data + CharIndex, ';', Len - CharIndex );
+			if( EntityEnd != nullptr )
+			{
+				const FOSMStringView Entity( Data + CharIndex + 1, EntityEnd - ( Data + CharIndex + 1 ) );
+				uint32 CodePoint = 0;
+				if( Entity.Equals( "amp" ) )		CodePoint = '&';
+				else if( Entity.Equals( "lt" ) )	CodePoint = '<';
+				else if( Entity.Equals( "gt" ) )	CodePoint = '>';
+				else if( Entity.Equals( "quot" ) )	CodePoint = '"';
+				else if( Entity.Equals( "apos" ) )	CodePoint = '\'';
+				else if( Entity.Len > 1 && Entity.Data[ 0 ] == '#' )
+				{
+					const bool bIsHex = Entity.Data[ 1 ] == 'x' || Entity.Data[ 1 ] == 'X';
+					for( int32 DigitIndex = bIsHex ? 2 : 1; DigitIndex < Entity.Len; ++DigitIndex )
+					{
+						const ANSICHAR Digit = OSMFileParsing::ToLower( Entity.Data[ DigitIndex ] );
+						CodePoint = CodePoint * ( bIsHex ? 16 : 10 ) + ( ( Digit >= 'a' ) ? ( Digit - 'a' + 10 ) : ( Digit - '0' ) );
+					}
+				}
+
+				if( CodePoint != 0 )
+				{
+					// Re-encode the code point as UTF-8
+					if( CodePoint < 0x80 )
+					{
+						Unescaped.Add( (ANSICHAR)CodePoint );
+					}
+					else if( CodePoint < 0x800 )
+					{
+						Unescaped.Add( (ANSICHAR)( 0xC0 | ( CodePoint >> 6 ) ) );
+						Unescaped.Add( (ANSICHAR)( 0x80 | ( CodePoint & 0x3F ) ) );
+					}
+					else if( CodePoint < 0x10000 )
+					{
+						Unescaped.Add( (ANSICHAR)( 0xE0 | ( CodePoint >> 12 ) ) );
+						Unescaped.Add( (ANSICHAR)( 0x80 | ( ( CodePoint >> 6 ) & 0x3F ) ) );
+						Unescaped.Add( (ANSICHAR)( 0x80 | ( CodePoint & 0x3F ) ) );
+					}
+					else
+					{
+						Unescaped.Add( (ANSICHAR)( 0xF0 | ( CodePoint >> 18 ) ) );
+						Unescaped.Add( (ANSICHAR)( 0x80 | ( ( CodePoint >> 12 ) & 0x3F ) ) );
+						Unescaped.Add( (ANSICHAR)( 0x80 | ( ( CodePoint >> 6 ) & 0x3F ) ) );
+						Unescaped.Add( (ANSICHAR)( 0x80 | ( CodePoint & 0x3F ) ) );
+					}
+					CharIndex += Entity.Len + 1;
+					continue;
+				}
+			}
+		}
+		Unescaped.Add( Data[ CharIndex ] );
+	}
+
+	const FUTF8ToTCHAR Converted( Unescaped.GetData(), Unescaped.Num() );
+	Result = FString( Converted.Length(), Converted.Get() );
+	return Result;
+}
+
+
+void FOSMTagFilter::AddRule( const FString& Key, const FString& Value, const bool bKeep )
+{
+	FRule& Rule = Rules[ Rules.AddDefaulted() ];
+
+	const FTCHARToUTF8 KeyUTF8( *Key );
+	Rule.Key.Append( (const ANSICHAR*)KeyUTF8.Get(), KeyUTF8.Length() );
+
+	Rule.bAnyValue = Value.IsEmpty() || Value == TEXT( "*" );
+	if( !Rule.bAnyValue )
+	{
+		const FTCHARToUTF8 ValueUTF8( *Value );
+		Rule.Value.Append( (const ANSICHAR*)ValueUTF8.Get(), ValueUTF8.Length() );
+	}
+
+	Rule.bKeep = bKeep;
+	Rule.Hash = 0;
+}
+
+
+void FOSMTagFilter::Compile()
+{
+	RuleTable.Reset();
+	if( Rules.Num() == 0 )
+	{
+		return;
+	}
+
+	// Keep the table at most half full, so that lookups of tags we don't have rules for stop quickly
+	const int32 TableSize = FMath::RoundUpToPowerOfTwo( Rules.Num() * 2 );
+	RuleTable.Init( INDEX_NONE, TableSize );
+
+	for( int32 RuleIndex = 0; RuleIndex < Rules.Num(); ++RuleIndex )
+	{
+		FRule& Rule = Rules[ RuleIndex ];
+		const FOSMStringView Key( Rule.Key.GetData(), Rule.Key.Num() );
+		const FOSMStringView Value( Rule.Value.GetData(), Rule.Value.Num() );
+		Rule.Hash = OSMFileParsing::HashName( Key );
+		if( !Rule.bAnyValue )
+		{
+			Rule.Hash = OSMFileParsing::HashTagValue( Rule.Hash, Value );
+		}
+
+		if( FindRuleWithHash( Rule.Hash, Key, Rule.bAnyValue ? nullptr : &Value ) != INDEX_NONE )
+		{
+			// An earlier rule is for the same tag, so this one can never win
+			continue;
+		}
+
+		uint32 Slot = Rule.Hash & ( TableSize - 1 );
+		while( RuleTable[ Slot ] != INDEX_NONE )
+		{
+			Slot = ( Slot + 1 ) & ( TableSize - 1 );
+		}
+		RuleTable[ Slot ] = RuleIndex;
+	}
+}
+
+
+int32 FOSMTagFilter::FindRuleWithHash( const uint32 Hash, const FOSMStringView& Key, const FOSMStringView* Value ) const
+{
+	const uint32 TableMask = RuleTable.Num() - 1;
+	for( uint32 Slot = Hash & TableMask; RuleTable[ Slot ] != INDEX_NONE; Slot = ( Slot + 1 ) & TableMask )
+	{
+		const FRule& Rule = Rules[ RuleTable[ Slot ] ];
+		if( Rule.Hash == Hash &&
+			Rule.bAnyValue == ( Value == nullptr ) &&
+			OSMFileParsing::EqualsIgnoringCase( Key, Rule.Key ) &&
+			( Value == nullptr || OSMFileParsing::EqualsIgnoringCase( *Value, Rule.Value ) ) )
+		{
+			return RuleTable[ Slot ];
+		}
+	}
+	return INDEX_NONE;
+}
+
+
+int32 FOSMTagFilter::FindRule( const FOSMStringView& Key, const FOSMStringView& Value ) const
+{
+	if( RuleTable.Num() == 0 )
+	{
+		return INDEX_NONE;
+	}
+
+	// A tag can match a rule for its key and a rule for its exact value.  The earlier rule wins.
+	const uint32 KeyHash = OSMFileParsing::HashName( Key );
+	const int32 AnyValueRuleIndex = FindRuleWithHash( KeyHash, Key, nullptr );
+	const int32 ValueRuleIndex = FindRuleWithHash( OSMFileParsing::HashTagValue( KeyHash, Value ), Key, &Value );
+	if( AnyValueRuleIndex == INDEX_NONE || ( ValueRuleIndex != INDEX_NONE && ValueRuleIndex < AnyValueRuleIndex ) )
+	{
+		return ValueRuleIndex;
+	}
+	return AnyValueRuleIndex;
+}
 
 
 FOSMFile::FOSMFile()
-	: ParsingState( ParsingState::Root )
+	: bNodeIDsAreSorted( true ),
+	  MissingNodeCount( 0 ),
+	  DroppedWayCount( 0 ),
+	  WeldedNodeCount( 0 ),
+	  RemovedWayNodeCount( 0 ),
+	  FileNodeCount( 0 ),
+	  bLoadNodes( true ),
+	  bLoadWays( true ),
+	  ReferencedNodeCursor( 0 ),
+	  ClipLoadMinLatitude( -MAX_dbl ),
+	  ClipLoadMinLongitude( -MAX_dbl ),
+	  ClipLoadMaxLatitude( MAX_dbl ),
+	  ClipLoadMaxLongitude( MAX_dbl ),
+	  bClipRegionIsConvex( true ),
+	  ParsingState( ParsingState::Root ),
+	  CurrentChangeAction( EChangeAction::None ),
+	  ChangeActionDepth( 0 ),
+	  SkippedElementDepth( 0 )
 {
 }
 		
 
 FOSMFile::~FOSMFile()
 {
-	// Clean up time
+	// Clean up time.  The ways themselves are freed all at once by their arena.
+	Ways.Empty();
+}
+
+
+bool FOSMFile::LoadOpenStreetMapFile( const FString& OSMFilePath, const bool bIsFilePathActuallyTextBuffer, FFeedbackContext* FeedbackContext )
+{
+	FString ErrorMessage;
+	bool bLoadedOkay = false;
+
+	if( ClipRegion.Num() > 0 )
+	{
+		if( ClipRegion.Num() < 3 )
+		{
+			if( FeedbackContext != nullptr )
+			{
+				FeedbackContext->Logf( ELogVerbosity::Error, TEXT( "Region to clip the OpenStreetMap file to needs at least three points" ) );
+			}
+			return false;
+		}
+
+		// Figure out which nodes we'll need to load.  The margin is in meters, so it covers more longitude further from
+		// the equator.  We use the edge of the region that is furthest from the equator, so that it's never too small.
+		ClipLoadMinLatitude = ClipLoadMinLongitude = MAX_dbl;
+		ClipLoadMaxLatitude = ClipLoadMaxLongitude = -MAX_dbl;
+		for( const FOSMCoordinate& Coordinate : ClipRegion )
+		{
+			ClipLoadMinLatitude = FMath::Min( ClipLoadMinLatitude, Coordinate.Latitude );
+			ClipLoadMinLongitude = FMath::Min( ClipLoadMinLongitude, Coordinate.Longitude );
+			ClipLoadMaxLatitude = FMath::Max( ClipLoadMaxLatitude, Coordinate.Latitude );
+			ClipLoadMaxLongitude = FMath::Max( ClipLoadMaxLongitude, Coordinate.Longitude );
+		}
+
+		const double MetersPerDegree = 40075036.0 / 360.0;
+		const double FurthestLatitude = FMath::Min( FMath::Max( FMath::Abs( ClipLoadMinLatitude ), FMath::Abs( ClipLoadMaxLatitude ) ), 89.0 );
+		const double LatitudeMargin = ClipMargin / MetersPerDegree;
+		const double LongitudeMargin = ClipMargin / ( MetersPerDegree * FMath::Cos( FMath::DegreesToRadians( FurthestLatitude ) ) );
+		ClipLoadMinLatitude -= LatitudeMargin;
+		ClipLoadMaxLatitude += LatitudeMargin;
+		ClipLoadMinLongitude -= LongitudeMargin;
+		ClipLoadMaxLongitude += LongitudeMargin;
+
+		// Check whether the region is convex, by making sure that it always turns the same way
+		bool bTurnsLeft = false;
+		bool bTurnsRight = false;
+		for( int32 PointIndex = 0; PointIndex < ClipRegion.Num(); ++PointIndex )
+		{
+			const FOSMCoordinate& A = ClipRegion[ PointIndex ];
+			const FOSMCoordinate& B = ClipRegion[ ( PointIndex + 1 ) % ClipRegion.Num() ];
+			const FOSMCoordinate& C = ClipRegion[ ( PointIndex + 2 ) % ClipRegion.Num() ];
+			const double Turn = 
+				( B.Longitude - A.Longitude ) * ( C.Latitude - B.Latitude ) - 
+				( B.Latitude - A.Latitude ) * ( C.Longitude - B.Longitude );
+			bTurnsLeft |= Turn > 0.0;
+			bTurnsRight |= Turn < 0.0;
+		}
+		bClipRegionIsConvex = !( bTurnsLeft && bTurnsRight );
+	}
+
+	// How much we have to read on each pass over the file, for the profiler's throughput numbers
+	const int64 FileSize = Profiler == nullptr ? 0 :
+		( bIsFilePathActuallyTextBuffer ? (int64)OSMFilePath.Len() : FMath::Max( IFileManager::Get().FileSize( *OSMFilePath ), (int64)0 ) );
+
+	if( NodeIDsToLoad.Num() > 0 )
+	{
+		// Just the nodes we were asked for, in a single pass
+		ReferencedNodeIDs = NodeIDsToLoad;
+		OSMFileParsing::SortUniqueNodeIDs( ReferencedNodeIDs );
+		ReferencedNodeCursor = 0;
+		bLoadNodes = true;
+		bLoadWays = false;
+		{
+			FStreetMapImportProfiler::FScopedPhase Phase( Profiler, TEXT( "Parse nodes" ), GET_STATID( STAT_StreetMapImport_ParseFile ) );
+			bLoadedOkay = ParseFile( OSMFilePath, bIsFilePathActuallyTextBuffer, FeedbackContext, ErrorMessage );
+			Phase.SetItemCount( FileNodeCount, TEXT( "nodes" ) );
+			Phase.SetByteCount( FileSize );
+		}
+		ReferencedNodeIDs.Empty();
+		bLoadWays = true;
+	}
+	else if( bOnlyLoadReferencedNodes )
+	{
+		// First pass: Load the ways, and figure out which nodes they need
+		bLoadNodes = false;
+		bLoadWays = true;
+		{
+			FStreetMapImportProfiler::FScopedPhase Phase( Profiler, TEXT( "Parse ways" ), GET_STATID( STAT_StreetMapImport_ParseFile ) );
+			bLoadedOkay = ParseFile( OSMFilePath, bIsFilePathActuallyTextBuffer, FeedbackContext, ErrorMessage );
+			Phase.SetItemCount( WayArena.Num(), TEXT( "ways" ) );
+			Phase.SetByteCount( FileSize );
+		}
+
+		if( bLoadedOkay )
+		{
+			ReferencedNodeIDs = PendingWayNodeIDs;
+			OSMFileParsing::SortUniqueNodeIDs( ReferencedNodeIDs );
+			ReferencedNodeCursor = 0;
+
+			// Second pass: Load just those nodes
+			bLoadNodes = true;
+			bLoadWays = false;
+			{
+				FStreetMapImportProfiler::FScopedPhase Phase( Profiler, TEXT( "Parse nodes" ), GET_STATID( STAT_StreetMapImport_ParseFile ) );
+				bLoadedOkay = ParseFile( OSMFilePath, bIsFilePathActuallyTextBuffer, FeedbackContext, ErrorMessage );
+				Phase.SetItemCount( FileNodeCount, TEXT( "nodes" ) );
+				Phase.SetByteCount( FileSize );
+			}
+
+			ReferencedNodeIDs.Empty();
+		}
+
+		bLoadNodes = true;
+		bLoadWays = true;
+	}
+	else
+	{
+		FStreetMapImportProfiler::FScopedPhase Phase( Profiler, TEXT( "Parse file" ), GET_STATID( STAT_StreetMapImport_ParseFile ) );
+		bLoadedOkay = ParseFile( OSMFilePath, bIsFilePathActuallyTextBuffer, FeedbackContext, ErrorMessage );
+		Phase.SetItemCount( FileNodeCount, TEXT( "nodes" ) );
+		Phase.SetByteCount( FileSize );
+	}
+
+	if( bLoadedOkay )
+	{
+		{
+			FStreetMapImportProfiler::FScopedPhase Phase( Profiler, TEXT( "Finish loading" ), GET_STATID( STAT_StreetMapImport_FinishLoading ) );
+			FinishLoading();
+			Phase.SetItemCount( NodeIDs.Num(), TEXT( "nodes" ) );
+		}
+
+		if( FileNodeCount > 0 )
+		{
+			AverageLatitude /= FileNodeCount;
+			AverageLongitude /= FileNodeCount;
+		}
+
+		if( FeedbackContext != nullptr )
+		{
+			const int64 NodeStoreSize =
+				NodeIDs.GetAllocatedSize() + NodeLatitudes.GetAllocatedSize() + NodeLongitudes.GetAllocatedSize() +
+				NodeWayRefOffsets.GetAllocatedSize() + NodeWayRefs.GetAllocatedSize();
+			FeedbackContext->Logf(
+				ELogVerbosity::Log,
+				TEXT( "Loaded %i nodes (%.1f MB) and %lld ways (%.1f MB arena, %.1f MB node lists) from OpenStreetMap file" ),
+				NodeIDs.Num(),
+				(double)NodeStoreSize / ( 1024.0 * 1024.0 ),
+				WayArena.Num(),
+				(double)WayArena.GetAllocatedSize() / ( 1024.0 * 1024.0 ),
+				(double)( WayNodes.GetAllocatedSize() + UnweldedWayNodes.GetAllocatedSize() ) / ( 1024.0 * 1024.0 ) );
+
+			if( DroppedWayCount > 0 )
+			{
+				FeedbackContext->Logf( ELogVerbosity::Log, TEXT( "Dropped %i ways that matched tag filter rules" ), DroppedWayCount );
+			}
+
+			if( WeldedNodeCount > 0 || RemovedWayNodeCount > 0 )
+			{
+				FeedbackContext->Logf(
+					ELogVerbosity::Log,
+					TEXT( "Welded %i nodes that were within %.2f meters of another node, and removed %i points from ways that were left in the same place" ),
+					WeldedNodeCount,
+					WeldDistance,
+					RemovedWayNodeCount );
+			}
+		}
+
+		return true;
+	}
+
+	if( FeedbackContext != nullptr )
+	{
+		FeedbackContext->Logf(
+			ELogVerbosity::Error,
+			TEXT( "Failed to load OpenStreetMap file (%s)" ),
+			*ErrorMessage );
+	}
+
+	return false;
+}
+
+
+bool FOSMFile::ParseFile( const FString& OSMFilePath, const bool bIsFilePathActuallyTextBuffer, FFeedbackContext* FeedbackContext, FString& OutErrorMessage )
+{
+	ParsingState = ParsingState::Root;
+	SkippedElementDepth = 0;
+	CurrentChangeAction = EChangeAction::None;
+	ChangeActionDepth = 0;
+
+	if( bIsFilePathActuallyTextBuffer )
+	{
+		// Text that was handed to us directly needs to be converted to UTF-8, which is what the tokenizer expects.  Files
+		// on disk don't need this, because they're already UTF-8.
+		const FTCHARToUTF8 UTF8Text( *OSMFilePath, OSMFilePath.Len() );
+		return ParseXmlDocument( UTF8Text.Get(), UTF8Text.Length(), FeedbackContext, OutErrorMessage );
+	}
+	else if( FPaths::GetExtension( OSMFilePath ).Equals( TEXT( "pbf" ), ESearchCase::IgnoreCase ) )
+	{
+		return ParsePbfFile( OSMFilePath, FeedbackContext, OutErrorMessage );
+	}
+	else if( FPaths::GetExtension( OSMFilePath ).Equals( TEXT( "gz" ), ESearchCase::IgnoreCase ) )
 	{
-		for( auto* Way : Ways )
+		return ParseGzipXmlFile( OSMFilePath, FeedbackContext, OutErrorMessage );
+	}
+	else if( FPaths::GetExtension( OSMFilePath ).Equals( TEXT( "bz2" ), ESearchCase::IgnoreCase ) )
+	{
+		// The engine doesn't come with a bzip2 library, so these are refused rather than read as XML
+		OutErrorMessage = TEXT( "bzip2 compressed files aren't supported.  Please decompress the file, or compress it with gzip instead." );
+		return false;
+	}
+	else
+	{
+		// Map the file into memory, so that we can tokenize it in place.  The operating system pages the file in as we
+		// go, so the file's contents never count against our memory usage, no matter how large the file is.
+		IPlatformFile& PlatformFile = IPlatformFile::GetPlatformPhysical();
+		TUniquePtr<IMappedFileHandle> MappedFile( PlatformFile.OpenMapped( *OSMFilePath ) );
+		TUniquePtr<IMappedFileRegion> MappedRegion( MappedFile.IsValid() ? MappedFile->MapRegion() : nullptr );
+		if( MappedRegion.IsValid() )
+		{
+			return ParseXmlDocument( (const ANSICHAR*)MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize(), FeedbackContext, OutErrorMessage );
+		}
+		else
+		{
+			// Memory mapping isn't supported for this file.  Stream it from disk instead.
+			return ParseXmlFileStreaming( OSMFilePath, FeedbackContext, OutErrorMessage );
+		}
+	}
+}
+
+
+bool FOSMFile::ParseXmlDocument( const ANSICHAR* Document, const int64 DocumentLength, FFeedbackContext* FeedbackContext, FString& OutErrorMessage )
+{
+	const bool bShowCancelButton = true;
+	FScopedSlowTask SlowTask( (float)FMath::DivideAndRoundUp( DocumentLength, OSMFileParsing::ChunkSize ), LOCTEXT( "ParsingOSMFile", "Parsing OpenStreetMap file" ), true, FeedbackContext != nullptr ? *FeedbackContext : *GWarn );
+	SlowTask.MakeDialog( bShowCancelButton );
+
+	int64 ParsedBytes = 0;
+	while( ParsedBytes < DocumentLength )
+	{
+		// Each chunk is parsed up to the end of the last complete element in it, and the next chunk picks up right there
+		const int64 RemainingBytes = DocumentLength - ParsedBytes;
+		int64 ChunkLength = FMath::Min( OSMFileParsing::ChunkSize, RemainingBytes );
+		int64 ConsumedBytes = 0;
+		while( ConsumedBytes == 0 )
+		{
+			const bool bIsFinalChunk = ChunkLength == RemainingBytes;
+			ConsumedBytes = ParseXmlBuffer( Document + ParsedBytes, ChunkLength, bIsFinalChunk, OutErrorMessage );
+			if( ConsumedBytes == INDEX_NONE )
+			{
+				return false;
+			}
+
+			// Not even a single element fit into the chunk, so try again with a bigger one
+			ChunkLength = FMath::Min( ChunkLength * 2, RemainingBytes );
+		}
+		ParsedBytes += ConsumedBytes;
+
+		SlowTask.EnterProgressFrame( (float)ConsumedBytes / (float)OSMFileParsing::ChunkSize );
+		if( SlowTask.ShouldCancel() )
+		{
+			OutErrorMessage = TEXT( "Cancelled by user" );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+bool FOSMFile::ParseXmlFileStreaming( const FString& OSMFilePath, FFeedbackContext* FeedbackContext, FString& OutErrorMessage )
+{
+	IPlatformFile& PlatformFile = IPlatformFile::GetPlatformPhysical();
+	TUniquePtr<IFileHandle> FileHandle( PlatformFile.OpenRead( *OSMFilePath ) );
+	if( !FileHandle.IsValid() )
+	{
+		OutErrorMessage = FString::Printf( TEXT( "Unable to open '%s'" ), *OSMFilePath );
+		return false;
+	}
+
+	const int64 FileSize = FileHandle->Size();
+
+	const bool bShowCancelButton = true;
+	FScopedSlowTask SlowTask( (float)FMath::DivideAndRoundUp( FileSize, OSMFileParsing::ChunkSize ), LOCTEXT( "ParsingOSMFile", "Parsing OpenStreetMap file" ), true, FeedbackContext != nullptr ? *FeedbackContext : *GWarn );
+	SlowTask.MakeDialog( bShowCancelButton );
+
+	// Any element that is cut off at the end of a chunk is moved to the front of the buffer before we read the next chunk
+	TArray<ANSICHAR> Buffer;
+	int64 BufferedBytes = 0;
+	int64 ReadBytes = 0;
+	while( ReadBytes < FileSize || BufferedBytes > 0 )
+	{
+		const int64 BytesToRead = FMath::Min( OSMFileParsing::ChunkSize, FileSize - ReadBytes );
+		if( Buffer.Num() < BufferedBytes + BytesToRead )
+		{
+			Buffer.SetNumUninitialized( BufferedBytes + BytesToRead );
+		}
+		if( BytesToRead > 0 && !FileHandle->Read( (uint8*)Buffer.GetData() + BufferedBytes, BytesToRead ) )
+		{
+			OutErrorMessage = FString::Printf( TEXT( "Error reading '%s'" ), *OSMFilePath );
+			return false;
+		}
+		ReadBytes += BytesToRead;
+		BufferedBytes += BytesToRead;
+
+		const bool bIsFinalChunk = ReadBytes == FileSize;
+		const int64 ConsumedBytes = ParseXmlBuffer( Buffer.GetData(), BufferedBytes, bIsFinalChunk, OutErrorMessage );
+		if( ConsumedBytes == INDEX_NONE )
+		{
+			return false;
+		}
+
+		BufferedBytes -= ConsumedBytes;
+		if( BufferedBytes > 0 && ConsumedBytes > 0 )
+		{
+			FMemory::Memmove( Buffer.GetData(), Buffer.GetData() + ConsumedBytes, BufferedBytes );
+		}
+
+		SlowTask.EnterProgressFrame( (float)BytesToRead / (float)OSMFileParsing::ChunkSize );
+		if( SlowTask.ShouldCancel() )
+		{
+			OutErrorMessage = TEXT( "Cancelled by user" );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+int64 FOSMFile::ParseXmlBuffer( const ANSICHAR* Buffer, const int64 BufferLength, const bool bIsFinalBuffer, FString& OutErrorMessage )
+{
+	using namespace OSMFileParsing;
+
+	const ANSICHAR* const BufferEnd = Buffer + BufferLength;
+	const ANSICHAR* Cursor = Buffer;
+
+	// Reports an element that is cut off by the end of the buffer.  That's only an error if there is no more data coming.
+	auto Truncated = [&]( const ANSICHAR* ElementStart ) -> int64
+	{
+		if( bIsFinalBuffer )
+		{
+			OutErrorMessage = FString::Printf( TEXT( "Unexpected end of file inside element at byte offset %lld" ), (long long)( ElementStart - Buffer ) );
+			return INDEX_NONE;
+		}
+		return ElementStart - Buffer;
+	};
+
+	while( Cursor < BufferEnd )
+	{
+		// Skip any text content between elements.  OpenStreetMap files don't store anything interesting there.
+		const ANSICHAR* ElementStart = (const ANSICHAR*)memchr( Cursor, '<', BufferEnd - Cursor );
+		if( ElementStart == nullptr )
+		{
+			return BufferLength;
+		}
+
+		Cursor = ElementStart + 1;
+		if( Cursor >= BufferEnd )
+		{
+			return Truncated( ElementStart );
+		}
+
+		if( *Cursor == '?' )
+		{
+			// XML declaration or processing instruction.  Don't care about these.
+			const ANSICHAR* DeclarationEnd = FindToken( Cursor, BufferEnd, "?>", 2 );
+			if( DeclarationEnd == nullptr )
+			{
+				return Truncated( ElementStart );
+			}
+			Cursor = DeclarationEnd + 2;
+		}
+		else if( *Cursor == '!' )
+		{
+			// Comments, CDATA and DOCTYPE declarations.  Don't care about these either.
+			const bool bIsComment = ( BufferEnd - Cursor ) >= 3 && Cursor[ 1 ] == '-' && Cursor[ 2 ] == '-';
+			const ANSICHAR* CommentEnd = bIsComment ? FindToken( Cursor + 3, BufferEnd, "-->", 3 ) : FindToken( Cursor, BufferEnd, ">", 1 );
+			if( CommentEnd == nullptr )
+			{
+				return Truncated( ElementStart );
+			}
+			Cursor = CommentEnd + ( bIsComment ? 3 : 1 );
+		}
+		else if( *Cursor == '/' )
+		{
+			// Closing tag
+			const ANSICHAR* CloseEnd = (const ANSICHAR*)memchr( Cursor, '>', BufferEnd - Cursor );
+			if( CloseEnd == nullptr )
+			{
+				return Truncated( ElementStart );
+			}
+			Cursor = CloseEnd + 1;
+
+			ProcessClose();
+		}
+		else
+		{
+			// Opening tag.  We gather up all of the attributes before processing anything, because the element might
+			// turn out to be cut off by the end of the buffer.
+			const ANSICHAR* NameStart = Cursor;
+			while( Cursor < BufferEnd && !IsNameTerminator( *Cursor ) )
+			{
+				++Cursor;
+			}
+			const FOSMStringView ElementName( NameStart, Cursor - NameStart );
+
+			PendingAttributes.Reset();
+			bool bIsSelfClosing = false;
+			bool bIsComplete = false;
+			while( Cursor < BufferEnd )
+			{
+				if( IsWhitespace( *Cursor ) )
+				{
+					++Cursor;
+				}
+				else if( *Cursor == '>' )
+				{
+					++Cursor;
+					bIsComplete = true;
+					break;
+				}
+				else if( *Cursor == '/' )
+				{
+					if( Cursor + 1 >= BufferEnd )
+					{
+						break;
+					}
+					if( Cursor[ 1 ] != '>' )
+					{
+						OutErrorMessage = FString::Printf( TEXT( "Malformed element at byte offset %lld" ), (long long)( ElementStart - Buffer ) );
+						return INDEX_NONE;
+					}
+					Cursor += 2;
+					bIsSelfClosing = true;
+					bIsComplete = true;
+					break;
+				}
+				else
+				{
+					// Attribute name
+					const ANSICHAR* AttributeNameStart = Cursor;
+					while( Cursor < BufferEnd && !IsNameTerminator( *Cursor ) )
+					{
+						++Cursor;
+					}
+					const FOSMStringView AttributeName( AttributeNameStart, Cursor - AttributeNameStart );
+
+					while( Cursor < BufferEnd && IsWhitespace( *Cursor ) )
+					{
+						++Cursor;
+					}
+					if( Cursor >= BufferEnd )
+					{
+						break;
+					}
+					if( *Cursor != '=' )
+					{
+						OutErrorMessage = FString::Printf( TEXT( "Expected '=' after attribute name at byte offset %lld" ), (long long)( Cursor - Buffer ) );
+						return INDEX_NONE;
+					}
+					++Cursor;
+					while( Cursor < BufferEnd && IsWhitespace( *Cursor ) )
+					{
+						++Cursor;
+					}
+					if( Cursor >= BufferEnd )
+					{
+						break;
+					}
+
+					// Attribute value
+					const ANSICHAR QuoteChar = *Cursor;
+					if( QuoteChar != '"' && QuoteChar != '\'' )
+					{
+						OutErrorMessage = FString::Printf( TEXT( "Expected quoted attribute value at byte offset %lld" ), (long long)( Cursor - Buffer ) );
+						return INDEX_NONE;
+					}
+					const ANSICHAR* ValueStart = Cursor + 1;
+					const ANSICHAR* ValueEnd = (const ANSICHAR*)memchr( ValueStart, QuoteChar, BufferEnd - ValueStart );
+					if( ValueEnd == nullptr )
+					{
+						break;
+					}
+					Cursor = ValueEnd + 1;
+
+					PendingAttributes.Emplace( AttributeName, FOSMStringView( ValueStart, ValueEnd - ValueStart ) );
+				}
+			}
+
+			if( !bIsComplete )
+			{
+				return Truncated( ElementStart );
+			}
+
+			ProcessElement( ElementName );
+			for( const TPair< FOSMStringView, FOSMStringView >& Attribute : PendingAttributes )
+			{
+				ProcessAttribute( Attribute.Key, Attribute.Value );
+			}
+			if( bIsSelfClosing )
+			{
+				ProcessClose();
+			}
+		}
+	}
+
+	return BufferLength;
+}
+	
+	
+void FOSMFile::ProcessElement( const FOSMStringView& ElementName )
+{
+	using OSMFileParsing::EOSMName;
+
+	if( ParsingState == ParsingState::Root )
+	{
+		const EOSMName Name = OSMFileParsing::FindName( ElementName );
+		if( ( Name == EOSMName::Node && !bLoadNodes ) || ( Name == EOSMName::Way && !bLoadWays ) )
+		{
+			// Not interested in these in this pass over the file
+			ParsingState = ParsingState::Skipped;
+			SkippedElementDepth = 1;
+		}
+		else if( Name == EOSMName::Node )
+		{
+			ParsingState = ParsingState::Node;
+			CurrentNodeID = 0;
+			CurrentNodeLatitude = 0.0;
+			CurrentNodeLongitude = 0.0;
+		}
+		else if( Name == EOSMName::Way )
+		{
+			ParsingState = ParsingState::Way;
+			CurrentWayInfo = FOSMWayInfo();
+			CurrentWayNodeIDs.Reset();
+
+			// @todo: We're currently ignoring the "visible" tag on ways, which means that roads will always
+			//        be included in our data set.  It might be nice to make this an import option.
+		}
+		else if( Name == EOSMName::Create || Name == EOSMName::Modify || Name == EOSMName::Delete )
+		{
+			// Sections of an osmChange file.  The nodes and ways inside are handled as usual, but we remember which
+			// section they were in.
+			CurrentChangeAction = 
+				Name == EOSMName::Create ? EChangeAction::Create :
+				Name == EOSMName::Modify ? EChangeAction::Modify : 
+				EChangeAction::Delete;
+			ChangeActionDepth = 1;
+		}
+		else if( CurrentChangeAction != EChangeAction::None )
+		{
+			++ChangeActionDepth;
+		}
+	}
+	else if( ParsingState == ParsingState::Way )
+	{
+		const EOSMName Name = OSMFileParsing::FindName( ElementName );
+		if( Name == EOSMName::Nd )
+		{
+			ParsingState = ParsingState::Way_NodeRef;
+		}
+		else if( Name == EOSMName::Tag )
+		{
+			ParsingState = ParsingState::Way_Tag;
+		}
+		else
+		{
+			ParsingState = ParsingState::Way_Other;
+		}
+	}
+	else if( ParsingState == ParsingState::Node )
+	{
+		// Nodes can have tags too, but we don't use them for anything yet
+		ParsingState = ParsingState::Node_Tag;
+	}
+	else if( ParsingState == ParsingState::Skipped )
+	{
+		++SkippedElementDepth;
+	}
+}
+
+
+void FOSMFile::ProcessAttribute( const FOSMStringView& AttributeName, const FOSMStringView& AttributeValue )
+{
+	using OSMFileParsing::EOSMName;
+
+	if( ParsingState == ParsingState::Node )
+	{
+		switch( OSMFileParsing::FindName( AttributeName ) )
+		{
+			case EOSMName::Id:
+				CurrentNodeID = AttributeValue.ToInt64();
+				break;
+
+			case EOSMName::Lat:
+				CurrentNodeLatitude = AttributeValue.ToDouble();
+				break;
+
+			case EOSMName::Lon:
+				CurrentNodeLongitude = AttributeValue.ToDouble();
+				break;
+
+			default:
+				break;
+		}
+	}
+	else if( ParsingState == ParsingState::Way )
+	{
+		if( OSMFileParsing::FindName( AttributeName ) == EOSMName::Id )
+		{
+			CurrentWayInfo.ID = AttributeValue.ToInt64();
+		}
+	}
+	else if( ParsingState == ParsingState::Way_NodeRef )
+	{
+		if( OSMFileParsing::FindName( AttributeName ) == EOSMName::Ref )
+		{
+			// The referenced nodes are looked up when the way is closed
+			CurrentWayNodeIDs.Add( AttributeValue.ToInt64() );
+		}
+	}
+	else if( ParsingState == ParsingState::Way_Tag )
+	{
+		const EOSMName Name = OSMFileParsing::FindName( AttributeName );
+		if( Name == EOSMName::K )
+		{
+			CurrentWayTagKey = AttributeValue;
+		}
+		else if( Name == EOSMName::V )
+		{
+			ProcessWayTag( CurrentWayInfo, CurrentWayTagKey, AttributeValue, TagFilter );
+		}
+	}
+}
+
+
+void FOSMFile::ProcessWayTag( FOSMWayInfo& WayInfo, const FOSMStringView& Key, const FOSMStringView& Value, const FOSMTagFilter* TagFilter )
+{
+	using OSMFileParsing::EOSMName;
+
+	if( TagFilter != nullptr )
+	{
+		const int32 RuleIndex = TagFilter->FindRule( Key, Value );
+		if( RuleIndex != INDEX_NONE && ( WayInfo.TagRuleIndex == INDEX_NONE || RuleIndex < WayInfo.TagRuleIndex ) )
+		{
+			WayInfo.TagRuleIndex = RuleIndex;
+		}
+	}
+
+	switch( OSMFileParsing::FindName( Key ) )
+	{
+		case EOSMName::Name:
+			WayInfo.Name = Value.ToString();
+			break;
+
+		case EOSMName::Ref:
+			WayInfo.Ref = Value.ToString();
+			break;
+
+		case EOSMName::Highway:
+			WayInfo.WayType = OSMFileParsing::FindHighwayType( Value );
+			break;
+
+		case EOSMName::Building:
+			// Every type of building is treated the same for now.  See http://wiki.openstreetmap.org/wiki/Key:building
+			WayInfo.WayType = EOSMWayType::Building;
+			break;
+
+		case EOSMName::Height:
+			// Check to see if there is a space character in the height value.  For now, we're looking
+			// for straight-up floating point values.
+			if( memchr( Value.Data, ' ', Value.Len ) == nullptr )
+			{
+				// Okay, no space character.  So this has got to be a floating point number.  The OSM
+				// spec says that the height values are in meters.
+				WayInfo.Height = Value.ToDouble();
+			}
+			else
+			{
+				// Looks like the height value contains units of some sort.
+				// @todo: Add support for interpreting unit strings and converting the values
+			}
+			break;
+
+		case EOSMName::BuildingLevels:
+			WayInfo.BuildingLevels = (int32)Value.ToInt64();
+			break;
+
+		case EOSMName::OneWay:
+			WayInfo.bIsOneWay = Value.Equals( "yes" );
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+void FOSMFile::ProcessClose()
+{
+	if( ParsingState == ParsingState::Root )
+	{
+		if( CurrentChangeAction != EChangeAction::None && --ChangeActionDepth == 0 )
+		{
+			CurrentChangeAction = EChangeAction::None;
+		}
+	}
+	else if( ParsingState == ParsingState::Node )
+	{
+		if( CurrentChangeAction == EChangeAction::Delete )
+		{
+			DeletedNodeIDs.Add( CurrentNodeID );
+		}
+		else
+		{
+			AddNode( CurrentNodeID, CurrentNodeLatitude, CurrentNodeLongitude );
+		}
+		CurrentNodeID = 0;
+				
+		ParsingState = ParsingState::Root;
+	}
+	else if( ParsingState == ParsingState::Way )
+	{
+		if( CurrentChangeAction == EChangeAction::Delete )
+		{
+			DeletedWayIDs.Add( CurrentWayInfo.ID );
+		}
+		else
+		{
+			if( CurrentChangeAction != EChangeAction::None )
+			{
+				ChangedWayIDs.Add( CurrentWayInfo.ID );
+			}
+			AddWay( MoveTemp( CurrentWayInfo ), CurrentWayNodeIDs.GetData(), CurrentWayNodeIDs.Num() );
+		}
+				
+		ParsingState = ParsingState::Root;
+	}
+	else if( ParsingState == ParsingState::Node_Tag )
+	{
+		ParsingState = ParsingState::Node;
+	}
+	else if( ParsingState == ParsingState::Way_NodeRef || ParsingState == ParsingState::Way_Other )
+	{
+		ParsingState = ParsingState::Way;
+	}
+	else if( ParsingState == ParsingState::Way_Tag )
+	{
+		CurrentWayTagKey = FOSMStringView();
+		ParsingState = ParsingState::Way;
+	}
+	else if( ParsingState == ParsingState::Skipped )
+	{
+		if( --SkippedElementDepth == 0 )
+		{
+			ParsingState = ParsingState::Root;
+		}
+	}
+}
+
+
+void FOSMFile::AddNode( const int64 NodeID, const double Latitude, const double Longitude )
+{
+	++FileNodeCount;
+	AverageLatitude += Latitude;
+	AverageLongitude += Longitude;
+
+	// Update minimum and maximum latitude and longitude
+	// @todo: Performance: Instead of computing our own bounding box, we could parse the "minlat" and
+	//        "minlon" tags from the OSM file
+	if( Latitude < MinLatitude )
+	{
+		MinLatitude = Latitude;
+	}
+	if( Latitude > MaxLatitude )
+	{
+		MaxLatitude = Latitude;
+	}
+	if( Longitude < MinLongitude )
+	{
+		MinLongitude = Longitude;
+	}
+	if( Longitude > MaxLongitude )
+	{
+		MaxLongitude = Longitude;
+	}
+
+	if( Latitude < ClipLoadMinLatitude || Latitude > ClipLoadMaxLatitude ||
+		Longitude < ClipLoadMinLongitude || Longitude > ClipLoadMaxLongitude )
+	{
+		// Too far outside of the region we're clipping to
+		return;
+	}
+
+	if( bOnlyLoadReferencedNodes || NodeIDsToLoad.Num() > 0 )
+	{
+		// Is this node one we want?  Usually it's at or just past where we found the last one.
+		if( ReferencedNodeCursor > 0 && ReferencedNodeIDs[ ReferencedNodeCursor - 1 ] >= NodeID )
+		{
+			ReferencedNodeCursor = Algo::LowerBound( ReferencedNodeIDs, NodeID );
+		}
+		while( ReferencedNodeCursor < ReferencedNodeIDs.Num() && ReferencedNodeIDs[ ReferencedNodeCursor ] < NodeID )
 		{
-			delete Way;
+			++ReferencedNodeCursor;
 		}
-		Ways.Empty();
-				
-		for( auto HashPair : NodeMap )
+		if( ReferencedNodeCursor == ReferencedNodeIDs.Num() || ReferencedNodeIDs[ ReferencedNodeCursor ] != NodeID )
 		{
-			FOSMNodeInfo* NodeInfo = HashPair.Value;
-			delete NodeInfo;
+			return;
 		}
-		NodeMap.Empty();
 	}
+
+	if( NodeIDs.Num() > 0 && NodeID <= NodeIDs.Last() )
+	{
+		// We'll need to sort the nodes after loading
+		bNodeIDsAreSorted = false;
+	}
+
+	NodeIDs.Add( NodeID );
+	NodeLatitudes.Add( (int32)FMath::FloorToDouble( Latitude * CoordinateScale + 0.5 ) );
+	NodeLongitudes.Add( (int32)FMath::FloorToDouble( Longitude * CoordinateScale + 0.5 ) );
 }
 
 
-bool FOSMFile::LoadOpenStreetMapFile( FString& OSMFilePath, const bool bIsFilePathActuallyTextBuffer, FFeedbackContext* FeedbackContext )
+void FOSMFile::AddWay( FOSMWayInfo&& NewWayInfo, const int64* WayNodeIDs, const int32 WayNodeIDCount )
 {
-	const bool bShowSlowTaskDialog = true;
-	const bool bShowCancelButton = true;
-
-	FText ErrorMessage;
-	int32 ErrorLineNumber;
-	if( FFastXml::ParseXmlFile( 
-		this, 
-		bIsFilePathActuallyTextBuffer ? nullptr : *OSMFilePath, 
-		bIsFilePathActuallyTextBuffer ? OSMFilePath.GetCharArray().GetData() : nullptr, 
-		FeedbackContext, 
-		bShowSlowTaskDialog, 
-		bShowCancelButton, 
-		/* Out */ ErrorMessage, 
-		/* Out */ ErrorLineNumber ) )
+	if( TagFilter != nullptr && NewWayInfo.TagRuleIndex != INDEX_NONE && !TagFilter->IsKeepRule( NewWayInfo.TagRuleIndex ) )
 	{
-		if( NodeMap.Num() > 0 )
-		{
-			AverageLatitude /= NodeMap.Num();
-			AverageLongitude /= NodeMap.Num();
-		}
-
-		return true;
+		++DroppedWayCount;
+		return;
 	}
-
-	if( FeedbackContext != nullptr )
+	if( WayFilter && !WayFilter( NewWayInfo ) )
 	{
-		FeedbackContext->Logf(
-			ELogVerbosity::Error,
-			TEXT( "Failed to load OpenStreetMap XML file ('%s', Line %i)" ),
-			*ErrorMessage.ToString(),
-			ErrorLineNumber );
+		return;
 	}
 
-	return false;
+	FOSMWayInfo* WayInfo = WayArena.Allocate( MoveTemp( NewWayInfo ) );
+	WayInfo->FirstNode = PendingWayNodeIDs.Num();
+	WayInfo->NodeCount = WayNodeIDCount;
+	PendingWayNodeIDs.Append( WayNodeIDs, WayNodeIDCount );
+
+	Ways.Add( WayInfo );
 }
 
-		
-bool FOSMFile::ProcessXmlDeclaration( const TCHAR* ElementData, int32 XmlFileLineNumber )
+
+int32 FOSMFile::FindNodeIndex( const int64 NodeID ) const
 {
-	// Don't care about XML declaration
-	return true;
+	const int32 NodeIndex = Algo::LowerBound( NodeIDs, NodeID );
+	return ( NodeIndex < NodeIDs.Num() && NodeIDs[ NodeIndex ] == NodeID ) ? NodeIndex : INDEX_NONE;
 }
 
 
-bool FOSMFile::ProcessComment( const TCHAR* Comment )
+void FOSMFile::SortNodes()
 {
-	// Don't care about comments
-	return true;
+	// Sort the nodes by ID, so that we can binary search them
+	TArray<int32> SortedOrder;
+	SortedOrder.SetNumUninitialized( NodeIDs.Num() );
+	for( int32 NodeIndex = 0; NodeIndex < NodeIDs.Num(); ++NodeIndex )
+	{
+		SortedOrder[ NodeIndex ] = NodeIndex;
+	}
+	SortedOrder.StableSort( [this]( const int32 A, const int32 B )
+	{
+		return NodeIDs[ A ] < NodeIDs[ B ];
+	} );
+
+	TArray<int64> SortedNodeIDs;
+	TArray<int32> SortedNodeLatitudes;
+	TArray<int32> SortedNodeLongitudes;
+	SortedNodeIDs.Reserve( NodeIDs.Num() );
+	SortedNodeLatitudes.Reserve( NodeIDs.Num() );
+	SortedNodeLongitudes.Reserve( NodeIDs.Num() );
+	for( int32 SortedIndex = 0; SortedIndex < SortedOrder.Num(); ++SortedIndex )
+	{
+		const int32 NodeIndex = SortedOrder[ SortedIndex ];
+		if( SortedIndex + 1 < SortedOrder.Num() && NodeIDs[ SortedOrder[ SortedIndex + 1 ] ] == NodeIDs[ NodeIndex ] )
+		{
+			continue;
+		}
+		SortedNodeIDs.Add( NodeIDs[ NodeIndex ] );
+		SortedNodeLatitudes.Add( NodeLatitudes[ NodeIndex ] );
+		SortedNodeLongitudes.Add( NodeLongitudes[ NodeIndex ] );
+	}
+
+	NodeIDs = MoveTemp( SortedNodeIDs );
+	NodeLatitudes = MoveTemp( SortedNodeLatitudes );
+	NodeLongitudes = MoveTemp( SortedNodeLongitudes );
+	bNodeIDsAreSorted = true;
 }
-	
-	
-bool FOSMFile::ProcessElement( const TCHAR* ElementName, const TCHAR* ElementData, int32 XmlFileLineNumber )
+
+
+void FOSMFile::FinishLoading()
 {
-	if( ParsingState == ParsingState::Root )
+	if( !bNodeIDsAreSorted )
+	{
+		SortNodes();
+	}
+
+	if( ExternalNodeLookup )
 	{
-		if( !FCString::Stricmp( ElementName, TEXT( "node" ) ) )
+		// Bring in any nodes that our ways use but that aren't in the file
+		TArray<int64> ExternalNodeIDs;
+		for( const int64 NodeID : PendingWayNodeIDs )
 		{
-			ParsingState = ParsingState::Node;
-			CurrentNodeInfo = new FOSMNodeInfo();
-			CurrentNodeInfo->Latitude = 0.0;
-			CurrentNodeInfo->Longitude = 0.0;
+			if( FindNodeIndex( NodeID ) == INDEX_NONE )
+			{
+				ExternalNodeIDs.Add( NodeID );
+			}
 		}
-		else if( !FCString::Stricmp( ElementName, TEXT( "way" ) ) )
-		{
-			ParsingState = ParsingState::Way;
-			CurrentWayInfo = new FOSMWayInfo();
-			CurrentWayInfo->Name.Empty();
-			CurrentWayInfo->Ref.Empty();
-			CurrentWayInfo->WayType = EOSMWayType::Other;
-			CurrentWayInfo->Height = 0.0;
-			CurrentWayInfo->bIsOneWay = false;
 
-			// @todo: We're currently ignoring the "visible" tag on ways, which means that roads will always
-			//        be included in our data set.  It might be nice to make this an import option.
+		if( ExternalNodeIDs.Num() > 0 )
+		{
+			for( const int64 NodeID : ExternalNodeIDs )
+			{
+				FOSMCoordinate Coordinate;
+				if( ExternalNodeLookup( NodeID, Coordinate ) )
+				{
+					NodeIDs.Add( NodeID );
+					NodeLatitudes.Add( (int32)FMath::FloorToDouble( Coordinate.Latitude * CoordinateScale + 0.5 ) );
+					NodeLongitudes.Add( (int32)FMath::FloorToDouble( Coordinate.Longitude * CoordinateScale + 0.5 ) );
+				}
+			}
+			SortNodes();
 		}
 	}
-	else if( ParsingState == ParsingState::Way )
+
+	// Resolve the nodes along each way
+	const bool bClipToRegion = ClipRegion.Num() > 0;
+	WayNodes.SetNumUninitialized( PendingWayNodeIDs.Num() );
+	int32 WayNodeCount = 0;
+	for( FOSMWayInfo* WayInfo : Ways )
 	{
-		if( !FCString::Stricmp( ElementName, TEXT( "nd" ) ) )
+		const int32 FirstPendingNode = WayInfo->FirstNode;
+		WayInfo->FirstNode = WayNodeCount;
+		for( int32 PendingNodeIndex = FirstPendingNode; PendingNodeIndex < FirstPendingNode + WayInfo->NodeCount; ++PendingNodeIndex )
 		{
-			ParsingState = ParsingState::Way_NodeRef;
+			const int32 NodeIndex = FindNodeIndex( PendingWayNodeIDs[ PendingNodeIndex ] );
+			if( NodeIndex == INDEX_NONE )
+			{
+				++MissingNodeCount;
+
+				// Extracts that were cut out of a larger map can reference nodes that aren't in the file.  When we're
+				// clipping, we keep a marker for the missing node so that the way is split there, rather than joining
+				// up the nodes on either side of a stretch that we didn't load.
+				if( bClipToRegion )
+				{
+					WayNodes[ WayNodeCount++ ] = INDEX_NONE;
+				}
+				continue;
+			}
+
+			WayNodes[ WayNodeCount++ ] = NodeIndex;
 		}
-		else if( !FCString::Stricmp( ElementName, TEXT( "tag" ) ) )
+		WayInfo->NodeCount = WayNodeCount - WayInfo->FirstNode;
+	}
+	WayNodes.SetNum( WayNodeCount, true );
+	PendingWayNodeIDs.Empty();
+
+	if( bClipToRegion )
+	{
+		ClipWaysToRegion();
+	}
+
+	WeldWayNodes();
+	WayNodeCount = WayNodes.Num();
+
+	// Count how many ways pass through each node
+	TArray<int32> NodeWayRefCounts;
+	NodeWayRefCounts.SetNumZeroed( NodeIDs.Num() );
+	for( const int32 NodeIndex : WayNodes )
+	{
+		++NodeWayRefCounts[ NodeIndex ];
+	}
+
+	// Now link every node up with the ways that pass through it
+	NodeWayRefOffsets.SetNumUninitialized( NodeIDs.Num() + 1 );
+	NodeWayRefOffsets[ 0 ] = 0;
+	for( int32 NodeIndex = 0; NodeIndex < NodeIDs.Num(); ++NodeIndex )
+	{
+		NodeWayRefOffsets[ NodeIndex + 1 ] = NodeWayRefOffsets[ NodeIndex ] + NodeWayRefCounts[ NodeIndex ];
+		NodeWayRefCounts[ NodeIndex ] = NodeWayRefOffsets[ NodeIndex ];
+	}
+
+	NodeWayRefs.SetNumUninitialized( WayNodeCount );
+	for( int32 WayIndex = 0; WayIndex < Ways.Num(); ++WayIndex )
+	{
+		const FOSMWayInfo& WayInfo = *Ways[ WayIndex ];
+		for( int32 WayNodeIndex = 0; WayNodeIndex < WayInfo.NodeCount; ++WayNodeIndex )
 		{
-			ParsingState = ParsingState::Way_Tag;
+			FOSMWayRef& WayRef = NodeWayRefs[ NodeWayRefCounts[ WayNodes[ WayInfo.FirstNode + WayNodeIndex ] ]++ ];
+			WayRef.WayIndex = WayIndex;
+			WayRef.NodeIndex = WayNodeIndex;
 		}
 	}
-
-	return true;
 }
 
 
-bool FOSMFile::ProcessAttribute( const TCHAR* AttributeName, const TCHAR* AttributeValue )
+namespace OSMFileClipping
 {
-	if( ParsingState == ParsingState::Node )
+	/** A point on a way or building that we're clipping.  X is longitude and Y is latitude. */
+	struct FClipVertex
+	{
+		double X;
+		double Y;
+
+		// Node at this point, or INDEX_NONE if the point is where the way crosses the edge of the region
+		int32 NodeIndex;
+	};
+
+	// How close to the end of a segment a crossing needs to be for us to treat it as being at the node itself
+	static const double CrossingTolerance = 1e-9;
+
+	/** Returns true if the point is inside of the region outline, using the even-odd rule */
+	static bool IsInsideRegion( const TArray<FOSMFile::FOSMCoordinate>& Region, const double X, const double Y )
 	{
-		if( !FCString::Stricmp( AttributeName, TEXT( "id" ) ) )
+		bool bIsInside = false;
+		for( int32 PointIndex = 0, PrevPointIndex = Region.Num() - 1; PointIndex < Region.Num(); PrevPointIndex = PointIndex++ )
 		{
-			CurrentNodeID = FPlatformString::Atoi64( AttributeValue );
+			const FOSMFile::FOSMCoordinate& P = Region[ PointIndex ];
+			const FOSMFile::FOSMCoordinate& Q = Region[ PrevPointIndex ];
+			if( ( P.Latitude > Y ) != ( Q.Latitude > Y ) &&
+				X < ( Q.Longitude - P.Longitude ) * ( Y - P.Latitude ) / ( Q.Latitude - P.Latitude ) + P.Longitude )
+			{
+				bIsInside = !bIsInside;
+			}
 		}
-		else if( !FCString::Stricmp( AttributeName, TEXT( "lat" ) ) )
-		{
-			CurrentNodeInfo->Latitude = FPlatformString::Atod( AttributeValue );
+		return bIsInside;
+	}
 
-			AverageLatitude += CurrentNodeInfo->Latitude;
-					
-			// Update minimum and maximum latitude
-			// @todo: Performance: Instead of computing our own bounding box, we could parse the "minlat" and
-			//        "minlon" tags from the OSM file
-			if( CurrentNodeInfo->Latitude < MinLatitude )
+	/** Finds the stretches of the segment from A to B that are inside of the region, as fractions of the way from A to B */
+	template<typename SpanArrayType>
+	static void FindSpansInsideRegion( const TArray<FOSMFile::FOSMCoordinate>& Region, const FClipVertex& A, const FClipVertex& B, SpanArrayType& OutSpans )
+	{
+		const double DX = B.X - A.X;
+		const double DY = B.Y - A.Y;
+
+		// Find everywhere the segment crosses the outline
+		TArray<double, TInlineAllocator<8>> Crossings;
+		Crossings.Add( 0.0 );
+		Crossings.Add( 1.0 );
+		for( int32 PointIndex = 0, PrevPointIndex = Region.Num() - 1; PointIndex < Region.Num(); PrevPointIndex = PointIndex++ )
+		{
+			const FOSMFile::FOSMCoordinate& P = Region[ PrevPointIndex ];
+			const FOSMFile::FOSMCoordinate& Q = Region[ PointIndex ];
+			const double EX = Q.Longitude - P.Longitude;
+			const double EY = Q.Latitude - P.Latitude;
+			const double Denominator = DX * EY - DY * EX;
+			if( Denominator == 0.0 )
 			{
-				MinLatitude = CurrentNodeInfo->Latitude;
+				// Parallel
+				continue;
 			}
-			if( CurrentNodeInfo->Latitude > MaxLatitude )
+
+			const double T = ( ( P.Longitude - A.X ) * EY - ( P.Latitude - A.Y ) * EX ) / Denominator;
+			const double U = ( ( P.Longitude - A.X ) * DY - ( P.Latitude - A.Y ) * DX ) / Denominator;
+			if( T > 0.0 && T < 1.0 && U >= 0.0 && U <= 1.0 )
 			{
-				MaxLatitude = CurrentNodeInfo->Latitude;
+				Crossings.Add( T );
 			}
 		}
-		else if( !FCString::Stricmp( AttributeName, TEXT( "lon" ) ) )
-		{
-			CurrentNodeInfo->Longitude = FPlatformString::Atod( AttributeValue );
+		Crossings.Sort();
 
-			AverageLongitude += CurrentNodeInfo->Longitude;
-					
-			// Update minimum and maximum longitude
-			if( CurrentNodeInfo->Longitude < MinLongitude )
+		// Each piece between two crossings is either entirely inside or entirely outside
+		OutSpans.Reset();
+		for( int32 CrossingIndex = 0; CrossingIndex < Crossings.Num() - 1; ++CrossingIndex )
+		{
+			const double T0 = Crossings[ CrossingIndex ];
+			const double T1 = Crossings[ CrossingIndex + 1 ];
+			if( T1 - T0 <= CrossingTolerance )
 			{
-				MinLongitude = CurrentNodeInfo->Longitude;
+				continue;
 			}
-			if( CurrentNodeInfo->Longitude > MaxLongitude )
+
+			const double MidT = ( T0 + T1 ) * 0.5;
+			if( IsInsideRegion( Region, A.X + DX * MidT, A.Y + DY * MidT ) )
 			{
-				MaxLongitude = CurrentNodeInfo->Longitude;
+				if( OutSpans.Num() > 0 && OutSpans.Last().Value >= T0 - CrossingTolerance )
+				{
+					OutSpans.Last().Value = T1;
+				}
+				else
+				{
+					OutSpans.Add( TPair<double, double>( T0, T1 ) );
+				}
 			}
 		}
 	}
-	else if( ParsingState == ParsingState::Way )
+}
+
+
+int32 FOSMFile::AddClipNode( const double Latitude, const double Longitude, TMap<uint64, int32>& ClipNodeMap )
+{
+	const int32 FixedLatitude = (int32)FMath::FloorToDouble( Latitude * CoordinateScale + 0.5 );
+	const int32 FixedLongitude = (int32)FMath::FloorToDouble( Longitude * CoordinateScale + 0.5 );
+	const uint64 Key = ( (uint64)(uint32)FixedLatitude << 32 ) | (uint64)(uint32)FixedLongitude;
+
+	const int32* FoundNodeIndex = ClipNodeMap.Find( Key );
+	if( FoundNodeIndex != nullptr )
 	{
-		// ...
+		return *FoundNodeIndex;
 	}
-	else if( ParsingState == ParsingState::Way_NodeRef )
+
+	// The nodes are sorted by now, so giving the new node the next ID up keeps them that way
+	const int32 NodeIndex = NodeIDs.Num();
+	NodeIDs.Add( NodeIDs.Num() > 0 ? NodeIDs.Last() + 1 : 1 );
+	NodeLatitudes.Add( FixedLatitude );
+	NodeLongitudes.Add( FixedLongitude );
+	ClipNodeMap.Add( Key, NodeIndex );
+	return NodeIndex;
+}
+
+
+void FOSMFile::WeldWayNodes()
+{
+	// Only the nodes that are on our ways matter
+	TBitArray<> IsNodeUsed( false, NodeIDs.Num() );
+	for( const int32 NodeIndex : WayNodes )
+	{
+		IsNodeUsed[ NodeIndex ] = true;
+	}
+
+	// Cells of the spatial hash are at least WeldDistance across, so nodes we might weld together are always in the same
+	// cell or a neighboring one.  Degrees of longitude get shorter further from the equator, so the cells are sized for
+	// the edge of the map that is furthest from it.
+	const double MetersPerDegree = 40075036.0 / 360.0;
+	const double MetersPerUnit = MetersPerDegree / CoordinateScale;
+	const double FurthestLatitude = FMath::Min( FMath::Max( FMath::Abs( MinLatitude ), FMath::Abs( MaxLatitude ) ), 89.0 );
+	const int64 CellLatitudeUnits = FMath::Max( (int64)FMath::CeilToDouble( WeldDistance / MetersPerUnit ), (int64)1 );
+	const int64 CellLongitudeUnits = FMath::Max( (int64)FMath::CeilToDouble( WeldDistance / ( MetersPerUnit * FMath::Cos( FMath::DegreesToRadians( FurthestLatitude ) ) ) ), (int64)1 );
+	const double WeldDistanceSquared = WeldDistance * WeldDistance;
+
+	// Visit the nodes in order of ID, so that it's always the node with the lowest ID that the others are welded onto.
+	// Each cell keeps a list of the nodes that weren't welded onto anything, linked through NextNodeInCell.
+	TArray<int32> WeldedNodeIndices;
+	WeldedNodeIndices.SetNumUninitialized( NodeIDs.Num() );
+	TArray<int32> NextNodeInCell;
+	NextNodeInCell.SetNumUninitialized( NodeIDs.Num() );
+	TMap<uint64, int32> CellFirstNodes;
+	WeldedNodeCount = 0;
+	for( int32 NodeIndex = 0; NodeIndex < NodeIDs.Num(); ++NodeIndex )
 	{
-		if( !FCString::Stricmp( AttributeName, TEXT( "ref" ) ) )
+		WeldedNodeIndices[ NodeIndex ] = NodeIndex;
+		if( !IsNodeUsed[ NodeIndex ] )
 		{
-			FOSMNodeInfo* ReferencedNode = NodeMap.FindRef( FPlatformString::Atoi64( AttributeValue ) );
-			const int NewNodeIndex = CurrentWayInfo->Nodes.Num();
-			CurrentWayInfo->Nodes.Add( ReferencedNode );
-					
-			// Update the node with information about the way that is referencing it
+			continue;
+		}
+
+		const int32 Latitude = NodeLatitudes[ NodeIndex ];
+		const int32 Longitude = NodeLongitudes[ NodeIndex ];
+		const double LongitudeMetersPerUnit = MetersPerUnit * FMath::Cos( FMath::DegreesToRadians( GetNodeLatitude( NodeIndex ) ) );
+		const int64 CellX = (int64)FMath::FloorToDouble( (double)Longitude / CellLongitudeUnits );
+		const int64 CellY = (int64)FMath::FloorToDouble( (double)Latitude / CellLatitudeUnits );
+
+		for( int64 NeighborY = CellY - 1; NeighborY <= CellY + 1; ++NeighborY )
+		{
+			for( int64 NeighborX = CellX - 1; NeighborX <= CellX + 1; ++NeighborX )
 			{
-				FOSMWayRef NewWayRef;
-				NewWayRef.Way = CurrentWayInfo;
-				NewWayRef.NodeIndex = NewNodeIndex;
-				ReferencedNode->WayRefs.Add( NewWayRef );
+				const int32* FirstNodeIndex = CellFirstNodes.Find( ( (uint64)(uint32)NeighborY << 32 ) | (uint64)(uint32)NeighborX );
+				for( int32 OtherNodeIndex = FirstNodeIndex != nullptr ? *FirstNodeIndex : INDEX_NONE; OtherNodeIndex != INDEX_NONE; OtherNodeIndex = NextNodeInCell[ OtherNodeIndex ] )
+				{
+					const double DeltaY = (double)( NodeLatitudes[ OtherNodeIndex ] - Latitude ) * MetersPerUnit;
+					const double DeltaX = (double)( NodeLongitudes[ OtherNodeIndex ] - Longitude ) * LongitudeMetersPerUnit;
+					if( DeltaX * DeltaX + DeltaY * DeltaY <= WeldDistanceSquared && OtherNodeIndex < WeldedNodeIndices[ NodeIndex ] )
+					{
+						WeldedNodeIndices[ NodeIndex ] = OtherNodeIndex;
+					}
+				}
 			}
 		}
-	}
-	else if( ParsingState == ParsingState::Way_Tag )
-	{
-		if( !FCString::Stricmp( AttributeName, TEXT( "k" ) ) )
+
+		if( WeldedNodeIndices[ NodeIndex ] != NodeIndex )
 		{
-			CurrentWayTagKey = AttributeValue;
+			++WeldedNodeCount;
+		}
+		else
+		{
+			const uint64 CellKey = ( (uint64)(uint32)CellY << 32 ) | (uint64)(uint32)CellX;
+			const int32* CellFirstNode = CellFirstNodes.Find( CellKey );
+			NextNodeInCell[ NodeIndex ] = CellFirstNode != nullptr ? *CellFirstNode : INDEX_NONE;
+			CellFirstNodes.Add( CellKey, NodeIndex );
 		}
-		else if( !FCString::Stricmp( AttributeName, TEXT( "v" ) ) )
+	}
+
+	// Point the ways at the welded nodes, dropping any point that ends up in the same place as the one before it.  Each
+	// point remembers the node it started out as, so that changes to that node can be applied later.
+	const bool bKeepUnweldedNodes = WeldedNodeCount > 0;
+	UnweldedWayNodes.SetNumUninitialized( bKeepUnweldedNodes ? WayNodes.Num() : 0 );
+	int32 WayNodeCount = 0;
+	for( FOSMWayInfo* WayInfo : Ways )
+	{
+		const int32 FirstNode = WayNodeCount;
+		const bool bIsBuilding = WayInfo->WayType == EOSMWayType::Building;
+		for( int32 WayNodeIndex = WayInfo->FirstNode; WayNodeIndex < WayInfo->FirstNode + WayInfo->NodeCount; ++WayNodeIndex )
 		{
-			if( !FCString::Stricmp( CurrentWayTagKey, TEXT( "name" ) ) )
+			const int32 UnweldedNodeIndex = WayNodes[ WayNodeIndex ];
+			const int32 NodeIndex = WeldedNodeIndices[ UnweldedNodeIndex ];
+			if( WayNodeCount > FirstNode && WayNodes[ WayNodeCount - 1 ] == NodeIndex )
 			{
-				CurrentWayInfo->Name = AttributeValue;
+				continue;
 			}
-			else if( !FCString::Stricmp( CurrentWayTagKey, TEXT( "ref" ) ) )
+
+			// Buildings that go out to a point and straight back again have a spike with no area, which can't be
+			// triangulated.  Cut it off.
+			if( bIsBuilding && WayNodeCount - FirstNode > 1 && WayNodes[ WayNodeCount - 2 ] == NodeIndex )
 			{
-				CurrentWayInfo->Ref = AttributeValue;
+				--WayNodeCount;
+				continue;
 			}
-			else if( !FCString::Stricmp( CurrentWayTagKey, TEXT( "highway" ) ) )
+
+			if( bKeepUnweldedNodes )
 			{
-				EOSMWayType WayType = EOSMWayType::Other;
-						
-				if( !FCString::Stricmp( AttributeValue, TEXT( "motorway" ) ) )
-				{
-					WayType = EOSMWayType::Motorway;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "motorway_link" ) ) )
-				{
-					WayType = EOSMWayType::Motorway_Link;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "trunk" ) ) )
-				{
-					WayType = EOSMWayType::Trunk;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "trunk_link" ) ) )
-				{
-					WayType = EOSMWayType::Trunk_Link;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "primary" ) ) )
-				{
-					WayType = EOSMWayType::Primary;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "primary_link" ) ) )
-				{
-					WayType = EOSMWayType::Primary_Link;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "secondary" ) ) )
-				{
-					WayType = EOSMWayType::Secondary;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "secondary_link" ) ) )
-				{
-					WayType = EOSMWayType::Secondary_Link;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "tertiary" ) ) )
-				{
-					WayType = EOSMWayType::Tertiary;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "tertiary_link" ) ) )
-				{
-					WayType = EOSMWayType::Tertiary_Link;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "residential" ) ) )
-				{
-					WayType = EOSMWayType::Residential;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "service" ) ) )
-				{
-					WayType = EOSMWayType::Service;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "unclassified" ) ) )
-				{
-					WayType = EOSMWayType::Unclassified;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "living_street" ) ) )
-				{
-					WayType = EOSMWayType::Living_Street;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "pedestrian" ) ) )
-				{
-					WayType = EOSMWayType::Pedestrian;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "track" ) ) )
-				{
-					WayType = EOSMWayType::Track;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "bus_guideway" ) ) )
-				{
-					WayType = EOSMWayType::Bus_Guideway;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "raceway" ) ) )
-				{
-					WayType = EOSMWayType::Raceway;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "road" ) ) )
-				{
-					WayType = EOSMWayType::Road;
-				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "footway" ) ) )
+				UnweldedWayNodes[ WayNodeCount ] = UnweldedNodeIndex;
+			}
+			WayNodes[ WayNodeCount++ ] = NodeIndex;
+		}
+
+		// The spike might also be where the outline starts and ends
+		if( bIsBuilding )
+		{
+			while( WayNodeCount - FirstNode > 3 &&
+				WayNodes[ FirstNode ] == WayNodes[ WayNodeCount - 1 ] &&
+				WayNodes[ FirstNode + 1 ] == WayNodes[ WayNodeCount - 2 ] )
+			{
+				FMemory::Memmove( &WayNodes[ FirstNode ], &WayNodes[ FirstNode + 1 ], ( WayNodeCount - FirstNode - 2 ) * sizeof( int32 ) );
+				if( bKeepUnweldedNodes )
 				{
-					WayType = EOSMWayType::Footway;
+					FMemory::Memmove( &UnweldedWayNodes[ FirstNode ], &UnweldedWayNodes[ FirstNode + 1 ], ( WayNodeCount - FirstNode - 2 ) * sizeof( int32 ) );
 				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "cycleway" ) ) )
+				WayNodeCount -= 2;
+				WayNodes[ WayNodeCount - 1 ] = WayNodes[ FirstNode ];
+				if( bKeepUnweldedNodes )
 				{
-					WayType = EOSMWayType::Cycleway;
+					UnweldedWayNodes[ WayNodeCount - 1 ] = UnweldedWayNodes[ FirstNode ];
 				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "bridleway" ) ) )
+			}
+		}
+
+		WayInfo->FirstNode = FirstNode;
+		WayInfo->NodeCount = WayNodeCount - FirstNode;
+	}
+
+	RemovedWayNodeCount = WayNodes.Num() - WayNodeCount;
+	WayNodes.SetNum( WayNodeCount, true );
+	if( bKeepUnweldedNodes )
+	{
+		UnweldedWayNodes.SetNum( WayNodeCount, true );
+	}
+}
+
+
+void FOSMFile::ClipWaysToRegion()
+{
+	using namespace OSMFileClipping;
+
+	TArray<int32> ClippedWayNodes;
+	ClippedWayNodes.Reserve( WayNodes.Num() );
+	TArray<FOSMWayInfo*> ClippedWays;
+	ClippedWays.Reserve( Ways.Num() );
+	TMap<uint64, int32> ClipNodeMap;
+
+	// Which way the region winds, so we know which side of each edge is inside
+	double RegionArea = 0.0;
+	for( int32 PointIndex = 0, PrevPointIndex = ClipRegion.Num() - 1; PointIndex < ClipRegion.Num(); PrevPointIndex = PointIndex++ )
+	{
+		RegionArea += ClipRegion[ PrevPointIndex ].Longitude * ClipRegion[ PointIndex ].Latitude - ClipRegion[ PointIndex ].Longitude * ClipRegion[ PrevPointIndex ].Latitude;
+	}
+	const double RegionWinding = RegionArea >= 0.0 ? 1.0 : -1.0;
+
+	auto MakeVertex = [this]( const int32 NodeIndex ) -> FClipVertex
+	{
+		FClipVertex Vertex;
+		Vertex.X = GetNodeLongitude( NodeIndex );
+		Vertex.Y = GetNodeLatitude( NodeIndex );
+		Vertex.NodeIndex = NodeIndex;
+		return Vertex;
+	};
+
+	// Adds a piece of a way.  The first piece reuses the original way, and any others get a copy of it.
+	int32 WayPieceCount = 0;
+	auto AddWayPiece = [&]( FOSMWayInfo* WayInfo, const TArray<int32>& PieceNodes )
+	{
+		FOSMWayInfo* PieceWayInfo = WayPieceCount++ == 0 ? WayInfo : WayArena.Allocate( *WayInfo );
+		PieceWayInfo->FirstNode = ClippedWayNodes.Num();
+		PieceWayInfo->NodeCount = PieceNodes.Num();
+		ClippedWayNodes.Append( PieceNodes );
+		ClippedWays.Add( PieceWayInfo );
+	};
+
+	TArray<int32> PieceNodes;
+	TArray<TPair<double, double>, TInlineAllocator<4>> Spans;
+	TArray<FClipVertex> Polygon;
+	TArray<FClipVertex> ClippedPolygon;
+	for( FOSMWayInfo* WayInfo : Ways )
+	{
+		const int32* Nodes = WayNodes.GetData() + WayInfo->FirstNode;
+		const int32 NodeCount = WayInfo->NodeCount;
+		WayPieceCount = 0;
+
+		if( WayInfo->WayType == EOSMWayType::Building )
+		{
+			// We can't tell what shape a building is if some of it is missing
+			bool bHasAllNodes = NodeCount > 2;
+			bool bIsAllInside = true;
+			double CenterX = 0.0;
+			double CenterY = 0.0;
+			for( int32 WayNodeIndex = 0; WayNodeIndex < NodeCount && bHasAllNodes; ++WayNodeIndex )
+			{
+				if( Nodes[ WayNodeIndex ] == INDEX_NONE )
 				{
-					WayType = EOSMWayType::Bridleway;
+					bHasAllNodes = false;
+					break;
 				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "steps" ) ) )
+				const FClipVertex Vertex = MakeVertex( Nodes[ WayNodeIndex ] );
+				bIsAllInside = bIsAllInside && IsInsideRegion( ClipRegion, Vertex.X, Vertex.Y );
+				CenterX += Vertex.X / NodeCount;
+				CenterY += Vertex.Y / NodeCount;
+			}
+			if( !bHasAllNodes )
+			{
+				continue;
+			}
+
+			PieceNodes.Reset();
+			if( bIsAllInside )
+			{
+				PieceNodes.Append( Nodes, NodeCount );
+			}
+			else if( !bClipRegionIsConvex )
+			{
+				// We can only trim buildings against convex regions, so keep the whole building if most of it is inside
+				if( IsInsideRegion( ClipRegion, CenterX, CenterY ) )
 				{
-					WayType = EOSMWayType::Steps;
+					PieceNodes.Append( Nodes, NodeCount );
 				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "path" ) ) )
+			}
+			else
+			{
+				// Trim the building against each edge of the region in turn (Sutherland-Hodgman)
+				Polygon.Reset();
+				for( int32 WayNodeIndex = 0; WayNodeIndex < NodeCount; ++WayNodeIndex )
 				{
-					WayType = EOSMWayType::Path;
+					Polygon.Add( MakeVertex( Nodes[ WayNodeIndex ] ) );
 				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "proposed" ) ) )
+				if( Polygon.Num() > 1 && Polygon[ 0 ].NodeIndex == Polygon.Last().NodeIndex )
 				{
-					WayType = EOSMWayType::Proposed;
+					// Closing point
+					Polygon.Pop( false );
 				}
-				else if( !FCString::Stricmp( AttributeValue, TEXT( "construction" ) ) )
+
+				for( int32 PointIndex = 0, PrevPointIndex = ClipRegion.Num() - 1; PointIndex < ClipRegion.Num() && Polygon.Num() > 0; PrevPointIndex = PointIndex++ )
 				{
-					WayType = EOSMWayType::Construction;
+					const FOSMCoordinate& P = ClipRegion[ PrevPointIndex ];
+					const double EX = ClipRegion[ PointIndex ].Longitude - P.Longitude;
+					const double EY = ClipRegion[ PointIndex ].Latitude - P.Latitude;
+					auto SideOfEdge = [&]( const FClipVertex& Vertex ) -> double
+					{
+						return RegionWinding * ( EX * ( Vertex.Y - P.Latitude ) - EY * ( Vertex.X - P.Longitude ) );
+					};
+
+					ClippedPolygon.Reset();
+					for( int32 VertexIndex = 0; VertexIndex < Polygon.Num(); ++VertexIndex )
+					{
+						const FClipVertex& Start = Polygon[ ( VertexIndex + Polygon.Num() - 1 ) % Polygon.Num() ];
+						const FClipVertex& End = Polygon[ VertexIndex ];
+						const double StartSide = SideOfEdge( Start );
+						const double EndSide = SideOfEdge( End );
+						if( ( StartSide >= 0.0 ) != ( EndSide >= 0.0 ) )
+						{
+							const double T = StartSide / ( StartSide - EndSide );
+							FClipVertex Crossing;
+							Crossing.X = Start.X + ( End.X - Start.X ) * T;
+							Crossing.Y = Start.Y + ( End.Y - Start.Y ) * T;
+							Crossing.NodeIndex = INDEX_NONE;
+							ClippedPolygon.Add( Crossing );
+						}
+						if( EndSide >= 0.0 )
+						{
+							ClippedPolygon.Add( End );
+						}
+					}
+					Swap( Polygon, ClippedPolygon );
 				}
-				else
+
+				if( Polygon.Num() > 2 )
 				{
-					// Other type that we don't recognize yet.  See http://wiki.openstreetmap.org/wiki/Key:highway
+					for( const FClipVertex& Vertex : Polygon )
+					{
+						PieceNodes.Add( Vertex.NodeIndex != INDEX_NONE ? Vertex.NodeIndex : AddClipNode( Vertex.Y, Vertex.X, ClipNodeMap ) );
+					}
+					PieceNodes.Add( PieceNodes[ 0 ] );
 				}
-						
-						
-				CurrentWayInfo->WayType = WayType;
 			}
-			else if( !FCString::Stricmp( CurrentWayTagKey, TEXT( "building" ) ) )
-			{
-				CurrentWayInfo->WayType = EOSMWayType::Building;
 
-				if( !FCString::Stricmp( AttributeValue, TEXT( "yes" ) ) )
-				{
-					CurrentWayInfo->WayType = EOSMWayType::Building;
-				}
-				else
-				{
-					// Other type that we don't recognize yet.  See http://wiki.openstreetmap.org/wiki/Key:building
-				}
+			if( PieceNodes.Num() > 0 )
+			{
+				AddWayPiece( WayInfo, PieceNodes );
 			}
-			else if( !FCString::Stricmp( CurrentWayTagKey, TEXT( "height" ) ) )
+		}
+		else
+		{
+			// Walk along the way, starting a new piece every time it comes back into the region
+			PieceNodes.Reset();
+			auto FinishPiece = [&]()
 			{
-				// Check to see if there is a space character in the height value.  For now, we're looking
-				// for straight-up floating point values.
-				if( !FString( AttributeValue ).Contains( TEXT( " " ) ) )
+				if( PieceNodes.Num() > 1 )
 				{
-					// Okay, no space character.  So this has got to be a floating point number.  The OSM
-					// spec says that the height values are in meters.
-					CurrentWayInfo->Height = FPlatformString::Atod( AttributeValue );
+					AddWayPiece( WayInfo, PieceNodes );
 				}
-				else
+				PieceNodes.Reset();
+			};
+
+			for( int32 WayNodeIndex = 0; WayNodeIndex < NodeCount - 1; ++WayNodeIndex )
+			{
+				if( Nodes[ WayNodeIndex ] == INDEX_NONE || Nodes[ WayNodeIndex + 1 ] == INDEX_NONE )
 				{
-					// Looks like the height value contains units of some sort.
-					// @todo: Add support for interpreting unit strings and converting the values
+					FinishPiece();
+					continue;
 				}
-			}
-			else if (!FCString::Stricmp(CurrentWayTagKey, TEXT("building:levels")))
-			{
-				CurrentWayInfo->BuildingLevels = FPlatformString::Atoi(AttributeValue);
-			}
-			else if( !FCString::Stricmp( CurrentWayTagKey, TEXT( "oneway" ) ) )
-			{
-				if( !FCString::Stricmp( AttributeValue, TEXT( "yes" ) ) )
+
+				const FClipVertex A = MakeVertex( Nodes[ WayNodeIndex ] );
+				const FClipVertex B = MakeVertex( Nodes[ WayNodeIndex + 1 ] );
+				FindSpansInsideRegion( ClipRegion, A, B, Spans );
+				if( Spans.Num() == 0 )
 				{
-					CurrentWayInfo->bIsOneWay = true;
+					FinishPiece();
+					continue;
 				}
-				else
+
+				for( const TPair<double, double>& Span : Spans )
 				{
-					CurrentWayInfo->bIsOneWay = false;
+					if( Span.Key > CrossingTolerance )
+					{
+						// Coming into the region part way along the segment
+						FinishPiece();
+						PieceNodes.Add( AddClipNode( A.Y + ( B.Y - A.Y ) * Span.Key, A.X + ( B.X - A.X ) * Span.Key, ClipNodeMap ) );
+					}
+					else if( PieceNodes.Num() == 0 )
+					{
+						PieceNodes.Add( A.NodeIndex );
+					}
+
+					if( Span.Value < 1.0 - CrossingTolerance )
+					{
+						// Leaving the region part way along the segment
+						PieceNodes.Add( AddClipNode( A.Y + ( B.Y - A.Y ) * Span.Value, A.X + ( B.X - A.X ) * Span.Value, ClipNodeMap ) );
+						FinishPiece();
+					}
+					else
+					{
+						PieceNodes.Add( B.NodeIndex );
+					}
 				}
 			}
+			FinishPiece();
 		}
 	}
 
-	return true;
+	WayNodes = MoveTemp( ClippedWayNodes );
+	Ways = MoveTemp( ClippedWays );
 }
 
 
-bool FOSMFile::ProcessClose( const TCHAR* Element )
+uint8 FOSMFile::ClassifyName( const FOSMStringView& Name )
 {
-	if( ParsingState == ParsingState::Node )
-	{
-		NodeMap.Add( CurrentNodeID, CurrentNodeInfo );
-		CurrentNodeID = 0;
-		CurrentNodeInfo = nullptr;
-				
-		ParsingState = ParsingState::Root;
-	}
-	else if( ParsingState == ParsingState::Way )
-	{
-		Ways.Add( CurrentWayInfo );
-		CurrentWayInfo = nullptr;
-				
-		ParsingState = ParsingState::Root;
-	}
-	else if( ParsingState == ParsingState::Way_NodeRef )
-	{
-		ParsingState = ParsingState::Way;
-	}
-	else if( ParsingState == ParsingState::Way_Tag )
-	{
-		CurrentWayTagKey = TEXT( "" );
-		ParsingState = ParsingState::Way;
-	}
+	return (uint8)OSMFileParsing::FindName( Name );
+}
 
-	return true;
+
+FOSMFile::EOSMWayType FOSMFile::ClassifyHighwayType( const FOSMStringView& Value )
+{
+	return OSMFileParsing::FindHighwayType( Value );
 }
+
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,246 @@
+// Copyright 2017 Mike Fricker. All Rights Reserved.
+
+#include "OSMFile.h"
+#include "StreetMapImporting.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/Async.h"
+#include "Misc/ScopedSlowTask.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+#define LOCTEXT_NAMESPACE "StreetMapImporting"
+
+
+// Compressed OpenStreetMap XML files are never inflated all at once.  A background thread decompresses the next chunk of
+// XML while we parse the current one, so the two overlap and we only ever hold a couple of chunks in memory.
+namespace OSMGzipParsing
+{
+	// How much compressed data we read from disk at a time
+	static const int64 CompressedChunkSize = 1024 * 1024;
+
+	// How much XML we decompress at a time.  This is also how often we report progress.
+	static const int64 DecompressedChunkSize = 16 * 1024 * 1024;
+
+
+	/** Reads a gzip compressed file from disk, decompressing it a chunk at a time */
+	class FGzipFileReader
+	{
+
+	public:
+
+		FGzipFileReader( IFileHandle& InFileHandle )
+			: FileHandle( InFileHandle ),
+			  FileSize( InFileHandle.Size() ),
+			  CompressedBytesRead( 0 ),
+			  bIsStreamInitialized( false ),
+			  bIsFinished( false )
+		{
+			FMemory::Memzero( Stream );
+		}
+
+		~FGzipFileReader()
+		{
+			if( bIsStreamInitialized )
+			{
+				inflateEnd( &Stream );
+			}
+		}
+
+		/** Sets up the decompressor.  Returns false if that failed, with the reason in ErrorMessage. */
+		bool Initialize()
+		{
+			// Adding 16 to the window bits tells zlib to expect a gzip header instead of a zlib one
+			if( inflateInit2( &Stream, 16 + MAX_WBITS ) != Z_OK )
+			{
+				ErrorMessage = TEXT( "Unable to initialize decompression" );
+				return false;
+			}
+			bIsStreamInitialized = true;
+			CompressedBuffer.SetNumUninitialized( CompressedChunkSize );
+			return true;
+		}
+
+		/** Decompresses data into the specified buffer until it's full or the file ends.  Returns how many bytes were
+		    decompressed, or INDEX_NONE if the file couldn't be read or is corrupt. */
+		int64 ReadChunk( ANSICHAR* OutBuffer, const int64 OutBufferSize )
+		{
+			Stream.next_out = (Bytef*)OutBuffer;
+			Stream.avail_out = (uInt)OutBufferSize;
+			while( Stream.avail_out > 0 && !bIsFinished )
+			{
+				if( Stream.avail_in == 0 )
+				{
+					const int64 BytesToRead = FMath::Min( CompressedChunkSize, FileSize - CompressedBytesRead );
+					if( BytesToRead == 0 )
+					{
+						ErrorMessage = TEXT( "Unexpected end of compressed data" );
+						return INDEX_NONE;
+					}
+					if( !FileHandle.Read( CompressedBuffer.GetData(), BytesToRead ) )
+					{
+						ErrorMessage = TEXT( "Error reading compressed data" );
+						return INDEX_NONE;
+					}
+					CompressedBytesRead += BytesToRead;
+					Stream.next_in = CompressedBuffer.GetData();
+					Stream.avail_in = (uInt)BytesToRead;
+				}
+
+				const int Result = inflate( &Stream, Z_NO_FLUSH );
+				if( Result == Z_STREAM_END )
+				{
+					// Large extracts are often several gzip members back to back (parallel compressors write them that
+					// way), so keep going until we run out of file.
+					if( Stream.avail_in == 0 && CompressedBytesRead == FileSize )
+					{
+						bIsFinished = true;
+					}
+					else
+					{
+						inflateReset( &Stream );
+					}
+				}
+				else if( Result != Z_OK )
+				{
+					ErrorMessage = FString::Printf( TEXT( "Compressed data is corrupt (%s)" ), Stream.msg != nullptr ? ANSI_TO_TCHAR( Stream.msg ) : TEXT( "unknown error" ) );
+					return INDEX_NONE;
+				}
+			}
+
+			return OutBufferSize - Stream.avail_out;
+		}
+
+		/** True once everything in the file has been decompressed */
+		bool IsFinished() const
+		{
+			return bIsFinished;
+		}
+
+		/** How many bytes of the compressed file we've read so far */
+		int64 GetCompressedBytesRead() const
+		{
+			return CompressedBytesRead;
+		}
+
+		/** Size of the compressed file */
+		int64 GetFileSize() const
+		{
+			return FileSize;
+		}
+
+		/** Why decompressing failed */
+		FString ErrorMessage;
+
+
+	private:
+
+		IFileHandle& FileHandle;
+		const int64 FileSize;
+		int64 CompressedBytesRead;
+
+		z_stream Stream;
+		bool bIsStreamInitialized;
+		bool bIsFinished;
+
+		TArray<uint8> CompressedBuffer;
+	};
+}
+
+
+bool FOSMFile::ParseGzipXmlFile( const FString& OSMFilePath, FFeedbackContext* FeedbackContext, FString& OutErrorMessage )
+{
+	using namespace OSMGzipParsing;
+
+	IPlatformFile& PlatformFile = IPlatformFile::GetPlatformPhysical();
+	TUniquePtr<IFileHandle> FileHandle( PlatformFile.OpenRead( *OSMFilePath ) );
+	if( !FileHandle.IsValid() )
+	{
+		OutErrorMessage = FString::Printf( TEXT( "Unable to open '%s'" ), *OSMFilePath );
+		return false;
+	}
+
+	FGzipFileReader Reader( *FileHandle );
+	if( !Reader.Initialize() )
+	{
+		OutErrorMessage = FString::Printf( TEXT( "Error decompressing '%s': %s" ), *OSMFilePath, *Reader.ErrorMessage );
+		return false;
+	}
+
+	// Progress is measured in compressed bytes, because we don't know how big the XML is until we've decompressed it all
+	const bool bShowCancelButton = true;
+	FScopedSlowTask SlowTask( (float)FMath::DivideAndRoundUp( Reader.GetFileSize(), CompressedChunkSize ), LOCTEXT( "ParsingOSMFile", "Parsing OpenStreetMap file" ), true, FeedbackContext != nullptr ? *FeedbackContext : *GWarn );
+	SlowTask.MakeDialog( bShowCancelButton );
+
+	// The background thread decompresses into DecompressedChunk while we parse Buffer.  Any element that is cut off at
+	// the end of Buffer is moved to the front before the next chunk is appended.
+	TArray<ANSICHAR> DecompressedChunk;
+	DecompressedChunk.SetNumUninitialized( DecompressedChunkSize );
+	TArray<ANSICHAR> Buffer;
+	int64 BufferedBytes = 0;
+
+	auto DecompressNextChunk = [ &Reader, &DecompressedChunk ]() -> int64
+	{
+		return Reader.ReadChunk( DecompressedChunk.GetData(), DecompressedChunk.Num() );
+	};
+	TFuture<int64> PendingChunk = Async( EAsyncExecution::ThreadPool, DecompressNextChunk );
+
+	// The background thread uses our locals, so it has to be done before we can bail out
+	auto Fail = [ &PendingChunk, &OutErrorMessage ]( const FString& ErrorMessage ) -> bool
+	{
+		PendingChunk.Wait();
+		OutErrorMessage = ErrorMessage;
+		return false;
+	};
+
+	int64 ReportedCompressedBytes = 0;
+	bool bIsFinalChunk = false;
+	while( !bIsFinalChunk )
+	{
+		const int64 DecompressedBytes = PendingChunk.Get();
+		if( DecompressedBytes == INDEX_NONE )
+		{
+			return Fail( FString::Printf( TEXT( "Error decompressing '%s': %s" ), *OSMFilePath, *Reader.ErrorMessage ) );
+		}
+		bIsFinalChunk = Reader.IsFinished();
+		const int64 CompressedBytesRead = Reader.GetCompressedBytesRead();
+
+		if( Buffer.Num() < BufferedBytes + DecompressedBytes )
+		{
+			Buffer.SetNumUninitialized( BufferedBytes + DecompressedBytes );
+		}
+		FMemory::Memcpy( Buffer.GetData() + BufferedBytes, DecompressedChunk.GetData(), DecompressedBytes );
+		BufferedBytes += DecompressedBytes;
+
+		// Start on the next chunk before we parse this one
+		if( !bIsFinalChunk )
+		{
+			PendingChunk = Async( EAsyncExecution::ThreadPool, DecompressNextChunk );
+		}
+
+		const int64 ConsumedBytes = ParseXmlBuffer( Buffer.GetData(), BufferedBytes, bIsFinalChunk, OutErrorMessage );
+		if( ConsumedBytes == INDEX_NONE )
+		{
+			return Fail( OutErrorMessage );
+		}
+
+		BufferedBytes -= ConsumedBytes;
+		if( BufferedBytes > 0 && ConsumedBytes > 0 )
+		{
+			FMemory::Memmove( Buffer.GetData(), Buffer.GetData() + ConsumedBytes, BufferedBytes );
+		}
+
+		SlowTask.EnterProgressFrame( (float)( CompressedBytesRead - ReportedCompressedBytes ) / (float)CompressedChunkSize );
+		ReportedCompressedBytes = CompressedBytesRead;
+		if( SlowTask.ShouldCancel() )
+		{
+			return Fail( TEXT( "Cancelled by user" ) );
+		}
+	}
+
+	return true;
+}
+
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,729 @@
+// Copyright 2017 Mike Fricker. All Rights Reserved.
+
+#include "OSMFile.h"
+#include "StreetMapImporting.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Async/ParallelFor.h"
+#include "Misc/Compression.h"
+#include "Misc/ScopedSlowTask.h"
+
+#define LOCTEXT_NAMESPACE "StreetMapImporting"
+
+
+// OpenStreetMap PBF files are a sequence of length-prefixed blobs.  Each blob holds a (usually zlib compressed) protocol
+// buffer message, and apart from the header blob they can all be decoded independently of each other.  We find all of
+// the blobs up front, decode them in parallel, then merge the results into our node and way lists in file order.
+// See https://wiki.openstreetmap.org/wiki/PBF_Format for details on the format.
+namespace OSMPbfParsing
+{
+	// How many blobs we decode at once per hardware thread.  Each blob holds up to 8000 nodes or ways.
+	static const int32 BlobsPerBatchPerThread = 4;
+
+	// Largest blob header and blob allowed by the format
+	static const int32 MaxBlobHeaderSize = 64 * 1024;
+	static const int32 MaxBlobSize = 32 * 1024 * 1024;
+
+	/** Protocol buffer wire types */
+	enum EWireType
+	{
+		WireType_Varint = 0,
+		WireType_Fixed64 = 1,
+		WireType_LengthDelimited = 2,
+		WireType_Fixed32 = 5
+	};
+
+
+	/** Minimal reader for protocol buffer messages.  Supports just enough for OpenStreetMap data. */
+	struct FProtobufReader
+	{
+		FProtobufReader( const uint8* InData, const int64 InLength )
+			: Cursor( InData ),
+			  End( InData + InLength ),
+			  bHasError( false )
+		{
+		}
+
+		/** Returns true if there are more fields to read */
+		bool HasMoreData() const
+		{
+			return Cursor < End && !bHasError;
+		}
+
+		/** Reads the key for the next field in the message */
+		void ReadFieldKey( uint32& OutFieldNumber, uint32& OutWireType )
+		{
+			const uint64 Key = ReadVarint();
+			OutFieldNumber = (uint32)( Key >> 3 );
+			OutWireType = (uint32)( Key & 0x7 );
+		}
+
+		uint64 ReadVarint()
+		{
+			uint64 Value = 0;
+			for( int32 Shift = 0; Shift < 64; Shift += 7 )
+			{
+				if( Cursor >= End )
+				{
+					bHasError = true;
+					return 0;
+				}
+				const uint8 Byte = *Cursor++;
+				Value |= (uint64)( Byte & 0x7F ) << Shift;
+				if( ( Byte & 0x80 ) == 0 )
+				{
+					return Value;
+				}
+			}
+			bHasError = true;
+			return 0;
+		}
+
+		int64 ReadSignedVarint()
+		{
+			// ZigZag encoding
+			const uint64 Value = ReadVarint();
+			return (int64)( Value >> 1 ) ^ -(int64)( Value & 1 );
+		}
+
+		/** Reads a length-delimited field, returning a reader for just that field's contents */
+		FProtobufReader ReadLengthDelimited()
+		{
+			const uint64 Length = ReadVarint();
+			if( bHasError || Length > (uint64)( End - Cursor ) )
+			{
+				bHasError = true;
+				return FProtobufReader( End, 0 );
+			}
+			FProtobufReader SubReader( Cursor, (int64)Length );
+			Cursor += Length;
+			return SubReader;
+		}
+
+		/** Reads a length-delimited string field */
+		FOSMStringView ReadString()
+		{
+			const FProtobufReader SubReader = ReadLengthDelimited();
+			return FOSMStringView( (const ANSICHAR*)SubReader.Cursor, (int32)( SubReader.End - SubReader.Cursor ) );
+		}
+
+		/** Skips over a field that we're not interested in */
+		void SkipField( const uint32 WireType )
+		{
+			switch( WireType )
+			{
+				case WireType_Varint:
+					ReadVarint();
+					break;
+
+				case WireType_Fixed64:
+					Cursor += 8;
+					break;
+
+				case WireType_LengthDelimited:
+					ReadLengthDelimited();
+					break;
+
+				case WireType_Fixed32:
+					Cursor += 4;
+					break;
+
+				default:
+					bHasError = true;
+					break;
+			}
+			if( Cursor > End )
+			{
+				bHasError = true;
+			}
+		}
+
+		const uint8* Cursor;
+		const uint8* End;
+		bool bHasError;
+	};
+
+
+	/** Reads a repeated integer field, which can either be packed or stored one value at a time */
+	template<typename ValueType, bool bIsSigned>
+	static void ReadRepeatedField( FProtobufReader& Reader, const uint32 WireType, ValueType& OutValues )
+	{
+		if( WireType == WireType_LengthDelimited )
+		{
+			FProtobufReader PackedReader = Reader.ReadLengthDelimited();
+			while( PackedReader.HasMoreData() )
+			{
+				OutValues.Add( bIsSigned ? PackedReader.ReadSignedVarint() : (int64)PackedReader.ReadVarint() );
+			}
+			Reader.bHasError |= PackedReader.bHasError;
+		}
+		else
+		{
+			OutValues.Add( bIsSigned ? Reader.ReadSignedVarint() : (int64)Reader.ReadVarint() );
+		}
+	}
+
+
+	/** Where a blob lives in the file */
+	struct FBlobLocation
+	{
+		int64 Offset;
+		int32 Size;
+	};
+
+
+	/** Everything we decoded from a single data blob */
+	struct FDecodedBlock
+	{
+		TArray<int64> NodeIDs;
+		TArray<double> NodeLatitudes;
+		TArray<double> NodeLongitudes;
+
+		TArray<FOSMFile::FOSMWayInfo> Ways;
+		TArray<int64> WayNodeIDs;
+		TArray<int32> WayNodeCounts;
+
+		FString ErrorMessage;
+	};
+
+
+	/** Decompresses a blob, returning a pointer to the raw message data */
+	static bool DecompressBlob( const uint8* BlobData, const int32 BlobSize, TArray<uint8>& DecompressionBuffer, const uint8*& OutMessage, int32& OutMessageSize, FString& OutErrorMessage )
+	{
+		FProtobufReader BlobReader( BlobData, BlobSize );
+
+		int32 RawSize = 0;
+		FProtobufReader CompressedData( nullptr, 0 );
+		bool bHasCompressedData = false;
+		while( BlobReader.HasMoreData() )
+		{
+			uint32 FieldNumber, WireType;
+			BlobReader.ReadFieldKey( FieldNumber, WireType );
+			if( FieldNumber == 1 && WireType == WireType_LengthDelimited )		// raw
+			{
+				const FProtobufReader RawData = BlobReader.ReadLengthDelimited();
+				OutMessage = RawData.Cursor;
+				OutMessageSize = (int32)( RawData.End - RawData.Cursor );
+				return !BlobReader.bHasError;
+			}
+			else if( FieldNumber == 2 && WireType == WireType_Varint )			// raw_size
+			{
+				RawSize = (int32)BlobReader.ReadVarint();
+			}
+			else if( FieldNumber == 3 && WireType == WireType_LengthDelimited )	// zlib_data
+			{
+				CompressedData = BlobReader.ReadLengthDelimited();
+				bHasCompressedData = true;
+			}
+			else if( FieldNumber == 4 || FieldNumber == 6 || FieldNumber == 7 )	// lzma_data, lz4_data, zstd_data
+			{
+				OutErrorMessage = TEXT( "PBF blob uses an unsupported compression method.  Only zlib compressed files are supported." );
+				return false;
+			}
+			else
+			{
+				BlobReader.SkipField( WireType );
+			}
+		}
+
+		if( BlobReader.bHasError || !bHasCompressedData || RawSize <= 0 || RawSize > MaxBlobSize )
+		{
+			OutErrorMessage = TEXT( "Malformed PBF blob" );
+			return false;
+		}
+
+		DecompressionBuffer.SetNumUninitialized( RawSize, false );
+		if( !FCompression::UncompressMemory( NAME_Zlib, DecompressionBuffer.GetData(), RawSize, CompressedData.Cursor, (int32)( CompressedData.End - CompressedData.Cursor ) ) )
+		{
+			OutErrorMessage = TEXT( "Failed to decompress PBF blob" );
+			return false;
+		}
+
+		OutMessage = DecompressionBuffer.GetData();
+		OutMessageSize = RawSize;
+		return true;
+	}
+
+
+	/** Checks the file's header block for features that we don't support */
+	static bool CheckHeaderBlock( const uint8* Message, const int32 MessageSize, FString& OutErrorMessage )
+	{
+		FProtobufReader Reader( Message, MessageSize );
+		while( Reader.HasMoreData() )
+		{
+			uint32 FieldNumber, WireType;
+			Reader.ReadFieldKey( FieldNumber, WireType );
+			if( FieldNumber == 4 && WireType == WireType_LengthDelimited )		// required_features
+			{
+				const FOSMStringView Feature = Reader.ReadString();
+				if( !Feature.Equals( "OsmSchema-V0.6" ) && !Feature.Equals( "DenseNodes" ) )
+				{
+					OutErrorMessage = FString::Printf( TEXT( "PBF file requires unsupported feature '%s'" ), *Feature.ToString() );
+					return false;
+				}
+			}
+			else
+			{
+				Reader.SkipField( WireType );
+			}
+		}
+
+		if( Reader.bHasError )
+		{
+			OutErrorMessage = TEXT( "Malformed PBF header block" );
+			return false;
+		}
+		return true;
+	}
+
+
+	/** Decodes a PrimitiveBlock message into nodes and ways, matching the tags of ways against the (optional) tag filter.
+	    This is called on worker threads for many blocks at once. */
+	static bool DecodePrimitiveBlock( const uint8* Message, const int32 MessageSize, const bool bDecodeNodes, const bool bDecodeWays, const FOSMTagFilter* TagFilter, FDecodedBlock& OutBlock )
+	{
+		TArray<FOSMStringView> StringTable;
+		TArray<FProtobufReader, TInlineAllocator<4>> PrimitiveGroups;
+		int64 Granularity = 100;
+		int64 LatitudeOffset = 0;
+		int64 LongitudeOffset = 0;
+
+		// The coordinate settings can come after the groups, so we need to find everything before decoding any groups
+		FProtobufReader BlockReader( Message, MessageSize );
+		while( BlockReader.HasMoreData() )
+		{
+			uint32 FieldNumber, WireType;
+			BlockReader.ReadFieldKey( FieldNumber, WireType );
+			if( FieldNumber == 1 && WireType == WireType_LengthDelimited )		// stringtable
+			{
+				FProtobufReader StringTableReader = BlockReader.ReadLengthDelimited();
+				while( StringTableReader.HasMoreData() )
+				{
+					uint32 StringFieldNumber, StringWireType;
+					StringTableReader.ReadFieldKey( StringFieldNumber, StringWireType );
+					if( StringFieldNumber == 1 && StringWireType == WireType_LengthDelimited )
+					{
+						StringTable.Add( StringTableReader.ReadString() );
+					}
+					else
+					{
+						StringTableReader.SkipField( StringWireType );
+					}
+				}
+				BlockReader.bHasError |= StringTableReader.bHasError;
+			}
+			else if( FieldNumber == 2 && WireType == WireType_LengthDelimited )	// primitivegroup
+			{
+				PrimitiveGroups.Add( BlockReader.ReadLengthDelimited() );
+			}
+			else if( FieldNumber == 17 && WireType == WireType_Varint )			// granularity
+			{
+				Granularity = (int64)BlockReader.ReadVarint();
+			}
+			else if( FieldNumber == 19 && WireType == WireType_Varint )			// lat_offset
+			{
+				LatitudeOffset = (int64)BlockReader.ReadVarint();
+			}
+			else if( FieldNumber == 20 && WireType == WireType_Varint )			// lon_offset
+			{
+				LongitudeOffset = (int64)BlockReader.ReadVarint();
+			}
+			else
+			{
+				BlockReader.SkipField( WireType );
+			}
+		}
+
+		// Coordinates are stored in units of nanodegrees
+		auto ToDegrees = [Granularity]( const int64 Offset, const int64 Value ) -> double
+		{
+			return (double)( Offset + Granularity * Value ) / 1000000000.0;
+		};
+
+		auto GetString = [&StringTable]( const int64 StringIndex ) -> FOSMStringView
+		{
+			return StringTable.IsValidIndex( (int32)StringIndex ) ? StringTable[ (int32)StringIndex ] : FOSMStringView();
+		};
+
+		TArray<int64> IDs;
+		TArray<int64> Latitudes;
+		TArray<int64> Longitudes;
+		TArray<int64, TInlineAllocator<32>> Keys;
+		TArray<int64, TInlineAllocator<32>> Values;
+		TArray<int64> NodeRefs;
+
+		bool bHasError = BlockReader.bHasError;
+		for( FProtobufReader& GroupReader : PrimitiveGroups )
+		{
+			while( GroupReader.HasMoreData() )
+			{
+				uint32 FieldNumber, WireType;
+				GroupReader.ReadFieldKey( FieldNumber, WireType );
+				if( ( FieldNumber == 1 || FieldNumber == 2 ) && !bDecodeNodes )
+				{
+					GroupReader.SkipField( WireType );
+				}
+				else if( FieldNumber == 3 && !bDecodeWays )
+				{
+					GroupReader.SkipField( WireType );
+				}
+				else if( FieldNumber == 1 && WireType == WireType_LengthDelimited )	// nodes
+				{
+					int64 NodeID = 0;
+					int64 Latitude = 0;
+					int64 Longitude = 0;
+
+					FProtobufReader NodeReader = GroupReader.ReadLengthDelimited();
+					while( NodeReader.HasMoreData() )
+					{
+						uint32 NodeFieldNumber, NodeWireType;
+						NodeReader.ReadFieldKey( NodeFieldNumber, NodeWireType );
+						if( NodeFieldNumber == 1 && NodeWireType == WireType_Varint )
+						{
+							NodeID = NodeReader.ReadSignedVarint();
+						}
+						else if( NodeFieldNumber == 8 && NodeWireType == WireType_Varint )
+						{
+							Latitude = NodeReader.ReadSignedVarint();
+						}
+						else if( NodeFieldNumber == 9 && NodeWireType == WireType_Varint )
+						{
+							Longitude = NodeReader.ReadSignedVarint();
+						}
+						else
+						{
+							NodeReader.SkipField( NodeWireType );
+						}
+					}
+					bHasError |= NodeReader.bHasError;
+
+					OutBlock.NodeIDs.Add( NodeID );
+					OutBlock.NodeLatitudes.Add( ToDegrees( LatitudeOffset, Latitude ) );
+					OutBlock.NodeLongitudes.Add( ToDegrees( LongitudeOffset, Longitude ) );
+				}
+				else if( FieldNumber == 2 && WireType == WireType_LengthDelimited )	// dense
+				{
+					IDs.Reset();
+					Latitudes.Reset();
+					Longitudes.Reset();
+
+					FProtobufReader DenseReader = GroupReader.ReadLengthDelimited();
+					while( DenseReader.HasMoreData() )
+					{
+						uint32 DenseFieldNumber, DenseWireType;
+						DenseReader.ReadFieldKey( DenseFieldNumber, DenseWireType );
+						if( DenseFieldNumber == 1 )
+						{
+							ReadRepeatedField<TArray<int64>, true>( DenseReader, DenseWireType, IDs );
+						}
+						else if( DenseFieldNumber == 8 )
+						{
+							ReadRepeatedField<TArray<int64>, true>( DenseReader, DenseWireType, Latitudes );
+						}
+						else if( DenseFieldNumber == 9 )
+						{
+							ReadRepeatedField<TArray<int64>, true>( DenseReader, DenseWireType, Longitudes );
+						}
+						else
+						{
+							// Node tags and metadata.  We don't use these.
+							DenseReader.SkipField( DenseWireType );
+						}
+					}
+					bHasError |= DenseReader.bHasError;
+
+					if( IDs.Num() != Latitudes.Num() || IDs.Num() != Longitudes.Num() )
+					{
+						bHasError = true;
+						break;
+					}
+
+					// Everything in a dense node group is delta coded
+					const int32 FirstNewNode = OutBlock.NodeIDs.AddUninitialized( IDs.Num() );
+					OutBlock.NodeLatitudes.AddUninitialized( IDs.Num() );
+					OutBlock.NodeLongitudes.AddUninitialized( IDs.Num() );
+
+					int64 NodeID = 0;
+					int64 Latitude = 0;
+					int64 Longitude = 0;
+					for( int32 DenseNodeIndex = 0; DenseNodeIndex < IDs.Num(); ++DenseNodeIndex )
+					{
+						NodeID += IDs[ DenseNodeIndex ];
+						Latitude += Latitudes[ DenseNodeIndex ];
+						Longitude += Longitudes[ DenseNodeIndex ];
+
+						OutBlock.NodeIDs[ FirstNewNode + DenseNodeIndex ] = NodeID;
+						OutBlock.NodeLatitudes[ FirstNewNode + DenseNodeIndex ] = ToDegrees( LatitudeOffset, Latitude );
+						OutBlock.NodeLongitudes[ FirstNewNode + DenseNodeIndex ] = ToDegrees( LongitudeOffset, Longitude );
+					}
+				}
+				else if( FieldNumber == 3 && WireType == WireType_LengthDelimited )	// ways
+				{
+					Keys.Reset();
+					Values.Reset();
+					NodeRefs.Reset();
+					int64 WayID = 0;
+
+					FProtobufReader WayReader = GroupReader.ReadLengthDelimited();
+					while( WayReader.HasMoreData() )
+					{
+						uint32 WayFieldNumber, WayWireType;
+						WayReader.ReadFieldKey( WayFieldNumber, WayWireType );
+						if( WayFieldNumber == 1 && WayWireType == WireType_Varint )
+						{
+							WayID = (int64)WayReader.ReadVarint();
+						}
+						else if( WayFieldNumber == 2 )
+						{
+							ReadRepeatedField<TArray<int64, TInlineAllocator<32>>, false>( WayReader, WayWireType, Keys );
+						}
+						else if( WayFieldNumber == 3 )
+						{
+							ReadRepeatedField<TArray<int64, TInlineAllocator<32>>, false>( WayReader, WayWireType, Values );
+						}
+						else if( WayFieldNumber == 8 )
+						{
+							ReadRepeatedField<TArray<int64>, true>( WayReader, WayWireType, NodeRefs );
+						}
+						else
+						{
+							WayReader.SkipField( WayWireType );
+						}
+					}
+					bHasError |= WayReader.bHasError;
+
+					// Ways are moved into the arena when the block is merged, because the arena is only safe to use on one thread
+					FOSMFile::FOSMWayInfo& WayInfo = OutBlock.Ways[ OutBlock.Ways.AddDefaulted() ];
+					WayInfo.ID = WayID;
+					for( int32 TagIndex = 0; TagIndex < FMath::Min( Keys.Num(), Values.Num() ); ++TagIndex )
+					{
+						FOSMFile::ProcessWayTag( WayInfo, GetString( Keys[ TagIndex ] ), GetString( Values[ TagIndex ] ), TagFilter );
+					}
+
+					// Node references are delta coded
+					int64 NodeID = 0;
+					for( const int64 NodeRefDelta : NodeRefs )
+					{
+						NodeID += NodeRefDelta;
+						OutBlock.WayNodeIDs.Add( NodeID );
+					}
+					OutBlock.WayNodeCounts.Add( NodeRefs.Num() );
+				}
+				else
+				{
+					// Relations and changesets.  We don't use these.
+					GroupReader.SkipField( WireType );
+				}
+			}
+			bHasError |= GroupReader.bHasError;
+		}
+
+		if( bHasError )
+		{
+			OutBlock.ErrorMessage = TEXT( "Malformed PBF data block" );
+			return false;
+		}
+		return true;
+	}
+}
+
+
+bool FOSMFile::ParsePbfFile( const FString& OSMFilePath, FFeedbackContext* FeedbackContext, FString& OutErrorMessage )
+{
+	using namespace OSMPbfParsing;
+
+	// Map the file into memory if we can, otherwise we'll read blobs from disk one batch at a time
+	IPlatformFile& PlatformFile = IPlatformFile::GetPlatformPhysical();
+	TUniquePtr<IMappedFileHandle> MappedFile( PlatformFile.OpenMapped( *OSMFilePath ) );
+	TUniquePtr<IMappedFileRegion> MappedRegion( MappedFile.IsValid() ? MappedFile->MapRegion() : nullptr );
+	TUniquePtr<IFileHandle> FileHandle( MappedRegion.IsValid() ? nullptr : PlatformFile.OpenRead( *OSMFilePath ) );
+	if( !MappedRegion.IsValid() && !FileHandle.IsValid() )
+	{
+		OutErrorMessage = FString::Printf( TEXT( "Unable to open '%s'" ), *OSMFilePath );
+		return false;
+	}
+
+	const int64 FileSize = MappedRegion.IsValid() ? MappedRegion->GetMappedSize() : FileHandle->Size();
+
+	// Returns a pointer to the requested bytes of the file, reading them into the specified buffer if the file isn't mapped
+	auto GetFileBytes = [&]( const int64 Offset, const int32 Size, TArray<uint8>& ReadBuffer ) -> const uint8*
+	{
+		if( Offset < 0 || Size < 0 || Offset + Size > FileSize )
+		{
+			return nullptr;
+		}
+		if( MappedRegion.IsValid() )
+		{
+			return MappedRegion->GetMappedPtr() + Offset;
+		}
+		ReadBuffer.SetNumUninitialized( Size, false );
+		if( !FileHandle->Seek( Offset ) || !FileHandle->Read( ReadBuffer.GetData(), Size ) )
+		{
+			return nullptr;
+		}
+		return ReadBuffer.GetData();
+	};
+
+	// Find all of the data blobs in the file.  This only touches the small blob headers.
+	TArray<FBlobLocation> DataBlobs;
+	{
+		TArray<uint8> HeaderBuffer;
+		TArray<uint8> DecompressionBuffer;
+		int64 Offset = 0;
+		while( Offset < FileSize )
+		{
+			const uint8* HeaderSizeBytes = GetFileBytes( Offset, 4, HeaderBuffer );
+			if( HeaderSizeBytes == nullptr )
+			{
+				OutErrorMessage = TEXT( "Unexpected end of PBF file" );
+				return false;
+			}
+			const int32 HeaderSize = ( HeaderSizeBytes[ 0 ] << 24 ) | ( HeaderSizeBytes[ 1 ] << 16 ) | ( HeaderSizeBytes[ 2 ] << 8 ) | HeaderSizeBytes[ 3 ];
+			Offset += 4;
+
+			const uint8* HeaderBytes = HeaderSize > 0 && HeaderSize <= MaxBlobHeaderSize ? GetFileBytes( Offset, HeaderSize, HeaderBuffer ) : nullptr;
+			if( HeaderBytes == nullptr )
+			{
+				OutErrorMessage = TEXT( "Malformed PBF blob header" );
+				return false;
+			}
+			Offset += HeaderSize;
+
+			FOSMStringView BlobType;
+			int32 BlobSize = -1;
+			FProtobufReader HeaderReader( HeaderBytes, HeaderSize );
+			while( HeaderReader.HasMoreData() )
+			{
+				uint32 FieldNumber, WireType;
+				HeaderReader.ReadFieldKey( FieldNumber, WireType );
+				if( FieldNumber == 1 && WireType == WireType_LengthDelimited )		// type
+				{
+					BlobType = HeaderReader.ReadString();
+				}
+				else if( FieldNumber == 3 && WireType == WireType_Varint )			// datasize
+				{
+					BlobSize = (int32)HeaderReader.ReadVarint();
+				}
+				else
+				{
+					HeaderReader.SkipField( WireType );
+				}
+			}
+			if( HeaderReader.bHasError || BlobSize < 0 || BlobSize > MaxBlobSize || Offset + BlobSize > FileSize )
+			{
+				OutErrorMessage = TEXT( "Malformed PBF blob header" );
+				return false;
+			}
+
+			if( BlobType.Equals( "OSMData" ) )
+			{
+				FBlobLocation& BlobLocation = DataBlobs[ DataBlobs.AddUninitialized() ];
+				BlobLocation.Offset = Offset;
+				BlobLocation.Size = BlobSize;
+			}
+			else if( BlobType.Equals( "OSMHeader" ) )
+			{
+				// The header block is tiny, so we just deal with it right here
+				TArray<uint8> BlobBuffer;
+				const uint8* BlobBytes = GetFileBytes( Offset, BlobSize, BlobBuffer );
+				const uint8* Message = nullptr;
+				int32 MessageSize = 0;
+				if( BlobBytes == nullptr ||
+					!DecompressBlob( BlobBytes, BlobSize, DecompressionBuffer, Message, MessageSize, OutErrorMessage ) ||
+					!CheckHeaderBlock( Message, MessageSize, OutErrorMessage ) )
+				{
+					return false;
+				}
+			}
+			else
+			{
+				// Unknown blob types are skipped, as the format requires
+			}
+			Offset += BlobSize;
+		}
+	}
+
+	const int32 BlobsPerBatch = FMath::Max( 1, FPlatformMisc::NumberOfCoresIncludingHyperthreads() * BlobsPerBatchPerThread );
+	const int32 BatchCount = FMath::DivideAndRoundUp( DataBlobs.Num(), BlobsPerBatch );
+
+	const bool bShowCancelButton = true;
+	FScopedSlowTask SlowTask( (float)BatchCount, LOCTEXT( "ParsingOSMPbfFile", "Decoding OpenStreetMap PBF file" ), true, FeedbackContext != nullptr ? *FeedbackContext : *GWarn );
+	SlowTask.MakeDialog( bShowCancelButton );
+
+	TArray<FDecodedBlock> DecodedBlocks;
+	TArray<TArray<uint8>> ReadBuffers;
+	for( int32 BatchIndex = 0; BatchIndex < BatchCount; ++BatchIndex )
+	{
+		const int32 FirstBlobIndex = BatchIndex * BlobsPerBatch;
+		const int32 BatchBlobCount = FMath::Min( BlobsPerBatch, DataBlobs.Num() - FirstBlobIndex );
+
+		// If the file isn't mapped, we need to read this batch's blobs from disk before we go wide
+		TArray<const uint8*> BlobBytes;
+		BlobBytes.SetNumZeroed( BatchBlobCount );
+		ReadBuffers.SetNum( BatchBlobCount );
+		for( int32 BatchBlobIndex = 0; BatchBlobIndex < BatchBlobCount; ++BatchBlobIndex )
+		{
+			const FBlobLocation& BlobLocation = DataBlobs[ FirstBlobIndex + BatchBlobIndex ];
+			BlobBytes[ BatchBlobIndex ] = GetFileBytes( BlobLocation.Offset, BlobLocation.Size, ReadBuffers[ BatchBlobIndex ] );
+			if( BlobBytes[ BatchBlobIndex ] == nullptr )
+			{
+				OutErrorMessage = FString::Printf( TEXT( "Error reading '%s'" ), *OSMFilePath );
+				return false;
+			}
+		}
+
+		DecodedBlocks.Reset();
+		DecodedBlocks.SetNum( BatchBlobCount );
+		ParallelFor( BatchBlobCount, [&]( const int32 BatchBlobIndex )
+		{
+			FDecodedBlock& DecodedBlock = DecodedBlocks[ BatchBlobIndex ];
+
+			TArray<uint8> DecompressionBuffer;
+			const uint8* Message = nullptr;
+			int32 MessageSize = 0;
+			if( DecompressBlob( BlobBytes[ BatchBlobIndex ], DataBlobs[ FirstBlobIndex + BatchBlobIndex ].Size, DecompressionBuffer, Message, MessageSize, DecodedBlock.ErrorMessage ) )
+			{
+				DecodePrimitiveBlock( Message, MessageSize, bLoadNodes, bLoadWays, TagFilter, DecodedBlock );
+			}
+		} );
+
+		// Merge the results in file order, so that we end up with exactly what a serial decode would have produced
+		bool bHasError = false;
+		for( FDecodedBlock& DecodedBlock : DecodedBlocks )
+		{
+			if( !DecodedBlock.ErrorMessage.IsEmpty() )
+			{
+				OutErrorMessage = DecodedBlock.ErrorMessage;
+				bHasError = true;
+			}
+
+			for( int32 NodeIndex = 0; NodeIndex < DecodedBlock.NodeIDs.Num(); ++NodeIndex )
+			{
+				AddNode( DecodedBlock.NodeIDs[ NodeIndex ], DecodedBlock.NodeLatitudes[ NodeIndex ], DecodedBlock.NodeLongitudes[ NodeIndex ] );
+			}
+
+			int32 WayNodeIDOffset = 0;
+			for( int32 WayIndex = 0; WayIndex < DecodedBlock.Ways.Num(); ++WayIndex )
+			{
+				AddWay( MoveTemp( DecodedBlock.Ways[ WayIndex ] ), DecodedBlock.WayNodeIDs.GetData() + WayNodeIDOffset, DecodedBlock.WayNodeCounts[ WayIndex ] );
+				WayNodeIDOffset += DecodedBlock.WayNodeCounts[ WayIndex ];
+			}
+		}
+
+		if( bHasError )
+		{
+			return false;
+		}
+
+		SlowTask.EnterProgressFrame( 1.0f );
+		if( SlowTask.ShouldCancel() )
+		{
+			OutErrorMessage = TEXT( "Cancelled by user" );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+#undef LOCTEXT_NAMESPACE
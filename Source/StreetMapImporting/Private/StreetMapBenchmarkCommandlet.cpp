@@ -0,0 +1,954 @@
+// Copyright 2017 Mike Fricker. All Rights Reserved.
+
+#include "StreetMapBenchmarkCommandlet.h"
+#include "StreetMapImporting.h"
+#include "StreetMapFactory.h"
+#include "StreetMap.h"
+#include "StreetMapComponent.h"
+#include "OSMFile.h"
+#include "SyntheticOSMGenerator.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+#include "UObject/Package.h"
+
+DEFINE_LOG_CATEGORY_STATIC( LogStreetMapBenchmark, Log, All );
+
+
+namespace StreetMapBenchmarkCommandlet
+{
+	/** Largest map we'll generate.  Even this one takes a few gigabytes of memory to import. */
+	static const int64 MaxNodeCount = 50000000;
+
+	/** How many nodes each graph query settles before giving up, so that queries take about as long on every map size */
+	static const int32 MaxSettledNodesPerQuery = 256;
+
+	/** How many times the name dispatch benchmark goes over its sample document */
+	static const int32 DefaultDispatchPassCount = 200000;
+
+
+	/** Everything we measured for one map size */
+	struct FBenchmarkResult
+	{
+		int64 TargetNodeCount = 0;
+
+		// What the generator wrote.  Only known when the file was generated by this run rather than reused.
+		int64 GeneratedNodeCount = 0;
+		int64 GeneratedWayCount = 0;
+		int64 SourceFileSize = 0;
+		double GenerateSeconds = 0.0;
+
+		bool bImported = false;
+		double ImportSeconds = 0.0;
+		int32 RoadCount = 0;
+		int32 NodeCount = 0;
+		int32 BuildingCount = 0;
+
+		double BuildMeshSeconds = 0.0;
+		int32 VertexCount = 0;
+		int32 TriangleCount = 0;
+
+		double RoadLengthSeconds = 0.0;
+		double TotalRoadLength = 0.0;
+
+		int32 QueryCount = 0;
+		double QuerySeconds = 0.0;
+		int64 SettledNodeCount = 0;
+
+		// Saving the map to memory and loading it back, as tagged properties (the old format) and as flat blocks
+		int64 TaggedSavedSize = 0;
+		double TaggedLoadSeconds = 0.0;
+		int64 BulkSavedSize = 0;
+		double BulkLoadSeconds = 0.0;
+
+		double PeakUsedPhysicalMB = 0.0;
+
+		// Cost of working out what each XML element, attribute and tag is, the old way and the new way.  This doesn't
+		// depend on the map, so it is measured once per run and written on every row.
+		double CompareChainNanosecondsPerAttribute = 0.0;
+		double HashedNanosecondsPerAttribute = 0.0;
+	};
+
+
+	/** Column names for the CSV file, in the same order as FormatCSVRow() writes them */
+	static const TCHAR* CSVHeader = TEXT( "Date,Seed,TargetNodes,OSMNodes,OSMWays,SourceMB,GenerateSeconds,Imported,ImportSeconds,Roads,Nodes,Buildings,BuildMeshSeconds,Vertices,Triangles,RoadLengthSeconds,Queries,QuerySeconds,SettledNodes,PeakUsedPhysicalMB,TaggedSavedMB,TaggedLoadSeconds,BulkSavedMB,BulkLoadSeconds,CompareChainNsPerAttribute,HashedNsPerAttribute" );
+
+	static FString FormatCSVRow( const FBenchmarkResult& Result, const int32 Seed )
+	{
+		return FString::Printf(
+			TEXT( "%s,%i,%lld,%lld,%lld,%.2f,%.3f,%i,%.3f,%i,%i,%i,%.3f,%i,%i,%.4f,%i,%.4f,%lld,%.1f,%.2f,%.4f,%.2f,%.4f,%.2f,%.2f" ),
+			*FDateTime::UtcNow().ToIso8601(),
+			Seed,
+			Result.TargetNodeCount,
+			Result.GeneratedNodeCount,
+			Result.GeneratedWayCount,
+			(double)Result.SourceFileSize / ( 1024.0 * 1024.0 ),
+			Result.GenerateSeconds,
+			Result.bImported ? 1 : 0,
+			Result.ImportSeconds,
+			Result.RoadCount,
+			Result.NodeCount,
+			Result.BuildingCount,
+			Result.BuildMeshSeconds,
+			Result.VertexCount,
+			Result.TriangleCount,
+			Result.RoadLengthSeconds,
+			Result.QueryCount,
+			Result.QuerySeconds,
+			Result.SettledNodeCount,
+			Result.PeakUsedPhysicalMB,
+			(double)Result.TaggedSavedSize / ( 1024.0 * 1024.0 ),
+			Result.TaggedLoadSeconds,
+			(double)Result.BulkSavedSize / ( 1024.0 * 1024.0 ),
+			Result.BulkLoadSeconds,
+			Result.CompareChainNanosecondsPerAttribute,
+			Result.HashedNanosecondsPerAttribute );
+	}
+
+
+	/** One thing the XML parser hands to the element and attribute handlers, in the order it does so */
+	struct FDispatchEvent
+	{
+		enum class EType : uint8
+		{
+			Open,
+			Attribute,
+			Close
+		};
+		EType Type;
+
+		// The element or attribute name, and the attribute value, as the old parser saw them
+		FString Name;
+		FString Value;
+
+		// The same strings as the parser sees them now, pointing into the UTF-8 copy of the document
+		FOSMStringView AnsiName;
+		FOSMStringView AnsiValue;
+	};
+
+
+	/** Builds a small document that looks like a typical city extract: nodes with all of the attributes the
+	    OpenStreetMap servers write, a road and a building, each with a few node references and a mix of tags */
+	static void MakeDispatchSampleDocument( TArray<FDispatchEvent>& Events, TArray<ANSICHAR>& AnsiStorage )
+	{
+		auto Add = [ &Events ]( const FDispatchEvent::EType Type, const TCHAR* Name, const TCHAR* Value )
+		{
+			FDispatchEvent& Event = Events[ Events.AddDefaulted() ];
+			Event.Type = Type;
+			Event.Name = Name;
+			Event.Value = Value;
+		};
+		auto Open = [ &Add ]( const TCHAR* Name ) { Add( FDispatchEvent::EType::Open, Name, TEXT( "" ) ); };
+		auto Attribute = [ &Add ]( const TCHAR* Name, const TCHAR* Value ) { Add( FDispatchEvent::EType::Attribute, Name, Value ); };
+		auto Close = [ &Add ]() { Add( FDispatchEvent::EType::Close, TEXT( "" ), TEXT( "" ) ); };
+		auto CommonAttributes = [ &Attribute ]( const TCHAR* ID )
+		{
+			Attribute( TEXT( "id" ), ID );
+			Attribute( TEXT( "visible" ), TEXT( "true" ) );
+			Attribute( TEXT( "version" ), TEXT( "3" ) );
+			Attribute( TEXT( "changeset" ), TEXT( "48151623" ) );
+			Attribute( TEXT( "timestamp" ), TEXT( "2017-06-01T12:00:00Z" ) );
+			Attribute( TEXT( "user" ), TEXT( "mapper" ) );
+			Attribute( TEXT( "uid" ), TEXT( "42" ) );
+		};
+		auto Tag = [ &Open, &Attribute, &Close ]( const TCHAR* Key, const TCHAR* Value )
+		{
+			Open( TEXT( "tag" ) );
+			Attribute( TEXT( "k" ), Key );
+			Attribute( TEXT( "v" ), Value );
+			Close();
+		};
+		auto NodeRef = [ &Open, &Attribute, &Close ]( const TCHAR* ID )
+		{
+			Open( TEXT( "nd" ) );
+			Attribute( TEXT( "ref" ), ID );
+			Close();
+		};
+
+		for( int32 NodeIndex = 0; NodeIndex < 4; ++NodeIndex )
+		{
+			Open( TEXT( "node" ) );
+			CommonAttributes( TEXT( "1001" ) );
+			Attribute( TEXT( "lat" ), TEXT( "51.5072178" ) );
+			Attribute( TEXT( "lon" ), TEXT( "-0.1275862" ) );
+			if( NodeIndex == 0 )
+			{
+				Tag( TEXT( "highway" ), TEXT( "crossing" ) );
+			}
+			Close();
+		}
+
+		Open( TEXT( "way" ) );
+		CommonAttributes( TEXT( "2001" ) );
+		for( const TCHAR* ID : { TEXT( "1001" ), TEXT( "1002" ), TEXT( "1003" ), TEXT( "1004" ), TEXT( "1005" ) } )
+		{
+			NodeRef( ID );
+		}
+		Tag( TEXT( "highway" ), TEXT( "residential" ) );
+		Tag( TEXT( "name" ), TEXT( "Main Street" ) );
+		Tag( TEXT( "oneway" ), TEXT( "yes" ) );
+		Tag( TEXT( "surface" ), TEXT( "asphalt" ) );
+		Tag( TEXT( "maxspeed" ), TEXT( "30" ) );
+		Close();
+
+		Open( TEXT( "way" ) );
+		CommonAttributes( TEXT( "2002" ) );
+		for( const TCHAR* ID : { TEXT( "1006" ), TEXT( "1007" ), TEXT( "1008" ), TEXT( "1009" ), TEXT( "1006" ) } )
+		{
+			NodeRef( ID );
+		}
+		Tag( TEXT( "building" ), TEXT( "yes" ) );
+		Tag( TEXT( "building:levels" ), TEXT( "3" ) );
+		Tag( TEXT( "height" ), TEXT( "12.5" ) );
+		Tag( TEXT( "addr:street" ), TEXT( "Main Street" ) );
+		Tag( TEXT( "source" ), TEXT( "survey" ) );
+		Close();
+
+		// Copy all of the strings into one buffer first, so that the views don't move when it grows
+		TArray<TPair<int32, int32>> NameAndValueOffsets;
+		for( const FDispatchEvent& Event : Events )
+		{
+			// The sample is all ASCII, so the UTF-8 strings are the same length
+			const int32 NameOffset = AnsiStorage.Num();
+			AnsiStorage.Append( TCHAR_TO_UTF8( *Event.Name ), Event.Name.Len() );
+			const int32 ValueOffset = AnsiStorage.Num();
+			AnsiStorage.Append( TCHAR_TO_UTF8( *Event.Value ), Event.Value.Len() );
+			NameAndValueOffsets.Emplace( NameOffset, ValueOffset );
+		}
+		for( int32 EventIndex = 0; EventIndex < Events.Num(); ++EventIndex )
+		{
+			FDispatchEvent& Event = Events[ EventIndex ];
+			Event.AnsiName = FOSMStringView( AnsiStorage.GetData() + NameAndValueOffsets[ EventIndex ].Key, Event.Name.Len() );
+			Event.AnsiValue = FOSMStringView( AnsiStorage.GetData() + NameAndValueOffsets[ EventIndex ].Value, Event.Value.Len() );
+		}
+	}
+
+
+	/** Works out what everything in the document is with the chain of FCString::Stricmp() calls that the importer used
+	    before names were hashed, in the same order and with the same parsing states.  Only the dispatch is kept: the
+	    values aren't parsed.  Returns a number that depends on what was found, so that none of the work can be skipped. */
+	static uint32 DispatchWithCompareChain( const TArray<FDispatchEvent>& Events )
+	{
+		enum class EParsingState : uint8
+		{
+			Root,
+			Node,
+			Way,
+			Way_NodeRef,
+			Way_Tag
+		};
+
+		// Highway values in the order the old importer tested them
+		static const TCHAR* const HighwayValues[] =
+		{
+			TEXT( "motorway" ), TEXT( "motorway_link" ), TEXT( "trunk" ), TEXT( "trunk_link" ), TEXT( "primary" ),
+			TEXT( "primary_link" ), TEXT( "secondary" ), TEXT( "secondary_link" ), TEXT( "tertiary" ), TEXT( "tertiary_link" ),
+			TEXT( "residential" ), TEXT( "service" ), TEXT( "unclassified" ), TEXT( "living_street" ), TEXT( "pedestrian" ),
+			TEXT( "track" ), TEXT( "bus_guideway" ), TEXT( "raceway" ), TEXT( "road" ), TEXT( "footway" ), TEXT( "cycleway" ),
+			TEXT( "bridleway" ), TEXT( "steps" ), TEXT( "path" ), TEXT( "proposed" ), TEXT( "construction" )
+		};
+
+		EParsingState ParsingState = EParsingState::Root;
+		const TCHAR* CurrentWayTagKey = TEXT( "" );
+		uint32 Found = 0;
+		for( const FDispatchEvent& Event : Events )
+		{
+			const TCHAR* Name = *Event.Name;
+			const TCHAR* Value = *Event.Value;
+			if( Event.Type == FDispatchEvent::EType::Open )
+			{
+				if( ParsingState == EParsingState::Root )
+				{
+					if( !FCString::Stricmp( Name, TEXT( "node" ) ) )
+					{
+						ParsingState = EParsingState::Node;
+					}
+					else if( !FCString::Stricmp( Name, TEXT( "way" ) ) )
+					{
+						ParsingState = EParsingState::Way;
+					}
+				}
+				else if( ParsingState == EParsingState::Way )
+				{
+					if( !FCString::Stricmp( Name, TEXT( "nd" ) ) )
+					{
+						ParsingState = EParsingState::Way_NodeRef;
+					}
+					else if( !FCString::Stricmp( Name, TEXT( "tag" ) ) )
+					{
+						ParsingState = EParsingState::Way_Tag;
+					}
+				}
+			}
+			else if( Event.Type == FDispatchEvent::EType::Attribute )
+			{
+				if( ParsingState == EParsingState::Node )
+				{
+					if( !FCString::Stricmp( Name, TEXT( "id" ) ) )
+					{
+						Found += 1;
+					}
+					else if( !FCString::Stricmp( Name, TEXT( "lat" ) ) )
+					{
+						Found += 2;
+					}
+					else if( !FCString::Stricmp( Name, TEXT( "lon" ) ) )
+					{
+						Found += 3;
+					}
+				}
+				else if( ParsingState == EParsingState::Way_NodeRef )
+				{
+					if( !FCString::Stricmp( Name, TEXT( "ref" ) ) )
+					{
+						Found += 4;
+					}
+				}
+				else if( ParsingState == EParsingState::Way_Tag )
+				{
+					if( !FCString::Stricmp( Name, TEXT( "k" ) ) )
+					{
+						CurrentWayTagKey = Value;
+					}
+					else if( !FCString::Stricmp( Name, TEXT( "v" ) ) )
+					{
+						if( !FCString::Stricmp( CurrentWayTagKey, TEXT( "name" ) ) )
+						{
+							Found += 5;
+						}
+						else if( !FCString::Stricmp( CurrentWayTagKey, TEXT( "ref" ) ) )
+						{
+							Found += 6;
+						}
+						else if( !FCString::Stricmp( CurrentWayTagKey, TEXT( "highway" ) ) )
+						{
+							uint32 WayType = 0;
+							for( const TCHAR* HighwayValue : HighwayValues )
+							{
+								++WayType;
+								if( !FCString::Stricmp( Value, HighwayValue ) )
+								{
+									break;
+								}
+							}
+							Found += 7 + WayType;
+						}
+						else if( !FCString::Stricmp( CurrentWayTagKey, TEXT( "building" ) ) )
+						{
+							Found += !FCString::Stricmp( Value, TEXT( "yes" ) ) ? 8 : 9;
+						}
+						else if( !FCString::Stricmp( CurrentWayTagKey, TEXT( "height" ) ) )
+						{
+							Found += 10;
+						}
+						else if( !FCString::Stricmp( CurrentWayTagKey, TEXT( "building:levels" ) ) )
+						{
+							Found += 11;
+						}
+						else if( !FCString::Stricmp( CurrentWayTagKey, TEXT( "oneway" ) ) )
+						{
+							Found += !FCString::Stricmp( Value, TEXT( "yes" ) ) ? 12 : 13;
+						}
+					}
+				}
+			}
+			else
+			{
+				if( ParsingState == EParsingState::Node || ParsingState == EParsingState::Way )
+				{
+					ParsingState = EParsingState::Root;
+				}
+				else if( ParsingState == EParsingState::Way_NodeRef )
+				{
+					ParsingState = EParsingState::Way;
+				}
+				else if( ParsingState == EParsingState::Way_Tag )
+				{
+					CurrentWayTagKey = TEXT( "" );
+					ParsingState = EParsingState::Way;
+				}
+			}
+		}
+		return Found;
+	}
+
+
+	/** Works out what everything in the document is the way the importer does now, with the parser's hashed lookups
+	    and parsing states.  Returns the same kind of number as DispatchWithCompareChain(). */
+	static uint32 DispatchWithHashedLookups( const TArray<FDispatchEvent>& Events )
+	{
+		enum class EParsingState : uint8
+		{
+			Root,
+			Node,
+			Node_Tag,
+			Way,
+			Way_NodeRef,
+			Way_Tag,
+			Way_Other
+		};
+
+		auto ClassifyLiteral = []( const ANSICHAR* Literal )
+		{
+			return FOSMFile::ClassifyName( FOSMStringView( Literal, FCStringAnsi::Strlen( Literal ) ) );
+		};
+		static const uint8 NodeName = ClassifyLiteral( "node" );
+		static const uint8 WayName = ClassifyLiteral( "way" );
+		static const uint8 NdName = ClassifyLiteral( "nd" );
+		static const uint8 TagName = ClassifyLiteral( "tag" );
+		static const uint8 IdName = ClassifyLiteral( "id" );
+		static const uint8 LatName = ClassifyLiteral( "lat" );
+		static const uint8 LonName = ClassifyLiteral( "lon" );
+		static const uint8 RefName = ClassifyLiteral( "ref" );
+		static const uint8 KName = ClassifyLiteral( "k" );
+		static const uint8 VName = ClassifyLiteral( "v" );
+		static const uint8 NameName = ClassifyLiteral( "name" );
+		static const uint8 HighwayName = ClassifyLiteral( "highway" );
+		static const uint8 BuildingName = ClassifyLiteral( "building" );
+		static const uint8 HeightName = ClassifyLiteral( "height" );
+		static const uint8 BuildingLevelsName = ClassifyLiteral( "building:levels" );
+		static const uint8 OneWayName = ClassifyLiteral( "oneway" );
+
+		EParsingState ParsingState = EParsingState::Root;
+		FOSMStringView CurrentWayTagKey;
+		uint32 Found = 0;
+		for( const FDispatchEvent& Event : Events )
+		{
+			if( Event.Type == FDispatchEvent::EType::Open )
+			{
+				if( ParsingState == EParsingState::Root )
+				{
+					const uint8 Name = FOSMFile::ClassifyName( Event.AnsiName );
+					if( Name == NodeName )
+					{
+						ParsingState = EParsingState::Node;
+					}
+					else if( Name == WayName )
+					{
+						ParsingState = EParsingState::Way;
+					}
+				}
+				else if( ParsingState == EParsingState::Way )
+				{
+					const uint8 Name = FOSMFile::ClassifyName( Event.AnsiName );
+					ParsingState = Name == NdName ? EParsingState::Way_NodeRef : Name == TagName ? EParsingState::Way_Tag : EParsingState::Way_Other;
+				}
+				else if( ParsingState == EParsingState::Node )
+				{
+					ParsingState = EParsingState::Node_Tag;
+				}
+			}
+			else if( Event.Type == FDispatchEvent::EType::Attribute )
+			{
+				if( ParsingState == EParsingState::Node )
+				{
+					const uint8 Name = FOSMFile::ClassifyName( Event.AnsiName );
+					Found += Name == IdName ? 1 : Name == LatName ? 2 : Name == LonName ? 3 : 0;
+				}
+				else if( ParsingState == EParsingState::Way )
+				{
+					// The importer keeps way IDs now, which the old one didn't look at
+					Found += FOSMFile::ClassifyName( Event.AnsiName ) == IdName ? 1 : 0;
+				}
+				else if( ParsingState == EParsingState::Way_NodeRef )
+				{
+					Found += FOSMFile::ClassifyName( Event.AnsiName ) == RefName ? 4 : 0;
+				}
+				else if( ParsingState == EParsingState::Way_Tag )
+				{
+					const uint8 Name = FOSMFile::ClassifyName( Event.AnsiName );
+					if( Name == KName )
+					{
+						CurrentWayTagKey = Event.AnsiValue;
+					}
+					else if( Name == VName )
+					{
+						const uint8 Key = FOSMFile::ClassifyName( CurrentWayTagKey );
+						if( Key == NameName )
+						{
+							Found += 5;
+						}
+						else if( Key == RefName )
+						{
+							Found += 6;
+						}
+						else if( Key == HighwayName )
+						{
+							Found += 7 + (uint32)FOSMFile::ClassifyHighwayType( Event.AnsiValue );
+						}
+						else if( Key == BuildingName )
+						{
+							Found += 8;
+						}
+						else if( Key == HeightName )
+						{
+							Found += 10;
+						}
+						else if( Key == BuildingLevelsName )
+						{
+							Found += 11;
+						}
+						else if( Key == OneWayName )
+						{
+							Found += Event.AnsiValue.Equals( "yes" ) ? 12 : 13;
+						}
+					}
+				}
+			}
+			else
+			{
+				if( ParsingState == EParsingState::Node || ParsingState == EParsingState::Way )
+				{
+					ParsingState = EParsingState::Root;
+				}
+				else if( ParsingState == EParsingState::Node_Tag )
+				{
+					ParsingState = EParsingState::Node;
+				}
+				else
+				{
+					ParsingState = ParsingState == EParsingState::Root ? EParsingState::Root : EParsingState::Way;
+				}
+			}
+		}
+		return Found;
+	}
+
+
+	/** Times working out what each element, attribute and tag in a typical document is, with the compare chain the
+	    importer used to have and with the hashed lookups it has now.  The results are in nanoseconds per attribute, with
+	    the element names counted in with the attributes of their element. */
+	static void RunDispatchBenchmark( const int32 PassCount, double& OutCompareChainNanosecondsPerAttribute, double& OutHashedNanosecondsPerAttribute )
+	{
+		TArray<FDispatchEvent> Events;
+		TArray<ANSICHAR> AnsiStorage;
+		MakeDispatchSampleDocument( Events, AnsiStorage );
+
+		int32 AttributeCount = 0;
+		for( const FDispatchEvent& Event : Events )
+		{
+			AttributeCount += Event.Type == FDispatchEvent::EType::Attribute ? 1 : 0;
+		}
+
+		uint32 CompareChainFound = 0;
+		double StartTime = FPlatformTime::Seconds();
+		for( int32 PassIndex = 0; PassIndex < PassCount; ++PassIndex )
+		{
+			CompareChainFound += DispatchWithCompareChain( Events );
+		}
+		const double CompareChainSeconds = FPlatformTime::Seconds() - StartTime;
+
+		uint32 HashedFound = 0;
+		StartTime = FPlatformTime::Seconds();
+		for( int32 PassIndex = 0; PassIndex < PassCount; ++PassIndex )
+		{
+			HashedFound += DispatchWithHashedLookups( Events );
+		}
+		const double HashedSeconds = FPlatformTime::Seconds() - StartTime;
+
+		const double AttributesDispatched = (double)AttributeCount * FMath::Max( PassCount, 1 );
+		OutCompareChainNanosecondsPerAttribute = CompareChainSeconds * 1e9 / AttributesDispatched;
+		OutHashedNanosecondsPerAttribute = HashedSeconds * 1e9 / AttributesDispatched;
+
+		// The totals are logged so that the optimizer has to do all of the work
+		UE_LOG(
+			LogStreetMapBenchmark,
+			Display,
+			TEXT( "Name dispatch over %i attributes: compare chain %.2f ns/attribute, hashed %.2f ns/attribute (checks %u, %u)" ),
+			AttributeCount * PassCount,
+			OutCompareChainNanosecondsPerAttribute,
+			OutHashedNanosecondsPerAttribute,
+			CompareChainFound,
+			HashedFound );
+	}
+
+
+	/** An entry in the open list of a graph query */
+	struct FQueryEntry
+	{
+		int32 NodeIndex;
+		float Cost;
+
+		bool operator<( const FQueryEntry& Other ) const
+		{
+			return Cost < Other.Cost;
+		}
+	};
+
+
+	/** Runs a cheapest-path search outwards from a node, in the same way a route finder would, until it has settled
+	    MaxSettledNodesPerQuery nodes or run out of road.  NodeCosts must be filled with MAX_FLT, and is left that way.
+	    Returns the number of nodes that were settled. */
+	static int32 RunGraphQuery( const UStreetMap& StreetMap, const int32 StartNodeIndex, TArray<float>& NodeCosts, TArray<int32>& TouchedNodeIndices, TArray<FQueryEntry>& OpenList )
+	{
+		TouchedNodeIndices.Reset();
+		OpenList.Reset();
+
+		NodeCosts[ StartNodeIndex ] = 0.0f;
+		TouchedNodeIndices.Add( StartNodeIndex );
+		OpenList.HeapPush( FQueryEntry{ StartNodeIndex, 0.0f } );
+
+		int32 SettledNodeCount = 0;
+		while( OpenList.Num() > 0 && SettledNodeCount < MaxSettledNodesPerQuery )
+		{
+			FQueryEntry Entry;
+			OpenList.HeapPop( Entry, false );
+			if( Entry.Cost > NodeCosts[ Entry.NodeIndex ] )
+			{
+				// We already found a cheaper way here
+				continue;
+			}
+			++SettledNodeCount;
+
+			const bool bIsTravelingForward = true;
+			for( const FStreetMapConnection& Connection : StreetMap.GetConnections( Entry.NodeIndex, bIsTravelingForward ) )
+			{
+				const int32 ConnectedNodeIndex = Connection.NodeIndex;
+				const float Cost = Entry.Cost + Connection.Cost;
+				if( Cost < NodeCosts[ ConnectedNodeIndex ] )
+				{
+					if( NodeCosts[ ConnectedNodeIndex ] == MAX_FLT )
+					{
+						TouchedNodeIndices.Add( ConnectedNodeIndex );
+					}
+					NodeCosts[ ConnectedNodeIndex ] = Cost;
+					OpenList.HeapPush( FQueryEntry{ ConnectedNodeIndex, Cost } );
+				}
+			}
+		}
+
+		for( const int32 TouchedNodeIndex : TouchedNodeIndices )
+		{
+			NodeCosts[ TouchedNodeIndex ] = MAX_FLT;
+		}
+
+		return SettledNodeCount;
+	}
+
+
+	/** Saves a map to memory and times loading it into a new map, including PostLoad() since that is where the cached
+	    road data gets built.  With bTagged, the map is saved the way it was before its geometry was saved in flat
+	    blocks, with every road, node and building as tagged properties.  Returns the size of the saved map. */
+	static int64 MeasureLoading( UStreetMap& StreetMap, const bool bTagged, double& OutLoadSeconds )
+	{
+		TArray<uint8> Bytes;
+		{
+			FMemoryWriter MemoryWriter( Bytes, true );
+			FObjectAndNameAsStringProxyArchive Writer( MemoryWriter, false );
+			if( bTagged )
+			{
+				// Skip UStreetMap::Serialize(), so that only the tagged properties are saved
+				StreetMap.ExpandGeometry();
+				StreetMap.UObject::Serialize( Writer );
+				StreetMap.CompactGeometry();
+			}
+			else
+			{
+				StreetMap.Serialize( Writer );
+			}
+		}
+
+		UStreetMap* LoadedStreetMap = NewObject<UStreetMap>( GetTransientPackage() );
+		FMemoryReader MemoryReader( Bytes, true );
+		FObjectAndNameAsStringProxyArchive Reader( MemoryReader, true );
+
+		const double StartTime = FPlatformTime::Seconds();
+		if( bTagged )
+		{
+			LoadedStreetMap->UObject::Serialize( Reader );
+		}
+		else
+		{
+			LoadedStreetMap->Serialize( Reader );
+		}
+		LoadedStreetMap->PostLoad();
+		OutLoadSeconds = FPlatformTime::Seconds() - StartTime;
+
+		if( Reader.IsError() || LoadedStreetMap->GetNodeCount() != StreetMap.GetNodeCount() )
+		{
+			UE_LOG( LogStreetMapBenchmark, Error, TEXT( "Street map didn't load back the same as it was saved" ) );
+		}
+
+		return Bytes.Num();
+	}
+
+
+	/** Imports a map, builds its mesh and queries it, filling in the rest of the result */
+	static void RunBenchmark( const FString& OSMFilePath, const FStreetMapImportOptions& ImportOptions, const int32 QueryCount, const int32 Seed, FBenchmarkResult& Result )
+	{
+		// Splitting into tiles would save packages, and a cached import would skip the work we want to measure
+		UStreetMapFactory* Factory = NewObject<UStreetMapFactory>();
+		Factory->ImportOptions = ImportOptions;
+		Factory->ImportOptions.bSplitIntoTiles = false;
+		Factory->bUseImportCache = false;
+
+		UStreetMap* StreetMap = NewObject<UStreetMap>( GetTransientPackage() );
+
+		double StartTime = FPlatformTime::Seconds();
+		const bool bIsFilePathActuallyTextBuffer = false;
+		Result.bImported = Factory->LoadFromOpenStreetMapXMLFile( StreetMap, OSMFilePath, bIsFilePathActuallyTextBuffer, GWarn );
+		Result.ImportSeconds = FPlatformTime::Seconds() - StartTime;
+		if( !Result.bImported )
+		{
+			return;
+		}
+		Result.RoadCount = StreetMap->GetRoadCount();
+		Result.NodeCount = StreetMap->GetNodeCount();
+		Result.BuildingCount = StreetMap->GetBuildingCount();
+
+		// Mesh.  The component is never registered, so this is just the mesh generation and collision setup.
+		UStreetMapComponent* StreetMapComponent = NewObject<UStreetMapComponent>( GetTransientPackage() );
+		StreetMapComponent->SetStreetMap( StreetMap, false, false );
+		StartTime = FPlatformTime::Seconds();
+		StreetMapComponent->BuildMesh();
+		Result.BuildMeshSeconds = FPlatformTime::Seconds() - StartTime;
+		Result.VertexCount = StreetMapComponent->GetRawMeshVertices().Num();
+		Result.TriangleCount = StreetMapComponent->GetRawMeshIndices().Num() / 3;
+
+		// Road lengths
+		StartTime = FPlatformTime::Seconds();
+		for( const FStreetMapRoad& Road : StreetMap->GetRoads() )
+		{
+			Result.TotalRoadLength += Road.ComputeLengthOfRoad( *StreetMap );
+		}
+		Result.RoadLengthSeconds = FPlatformTime::Seconds() - StartTime;
+
+		// Graph queries from random nodes
+		if( Result.NodeCount > 0 )
+		{
+			TArray<float> NodeCosts;
+			NodeCosts.Init( MAX_FLT, Result.NodeCount );
+			TArray<int32> TouchedNodeIndices;
+			TArray<FQueryEntry> OpenList;
+			FRandomStream RandomStream( Seed );
+
+			StartTime = FPlatformTime::Seconds();
+			for( int32 QueryIndex = 0; QueryIndex < QueryCount; ++QueryIndex )
+			{
+				const int32 StartNodeIndex = RandomStream.RandRange( 0, Result.NodeCount - 1 );
+				Result.SettledNodeCount += RunGraphQuery( *StreetMap, StartNodeIndex, NodeCosts, TouchedNodeIndices, OpenList );
+			}
+			Result.QuerySeconds = FPlatformTime::Seconds() - StartTime;
+			Result.QueryCount = QueryCount;
+		}
+
+		// Loading
+		Result.TaggedSavedSize = MeasureLoading( *StreetMap, true, Result.TaggedLoadSeconds );
+		Result.BulkSavedSize = MeasureLoading( *StreetMap, false, Result.BulkLoadSeconds );
+	}
+}
+
+
+UStreetMapBenchmarkCommandlet::UStreetMapBenchmarkCommandlet( const FObjectInitializer& ObjectInitializer )
+	: Super( ObjectInitializer )
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+
+	HelpDescription = TEXT( "Generates synthetic OpenStreetMap files and measures importing, meshing, querying and loading them" );
+	HelpUsage = TEXT( "-run=StreetMapBenchmark -nullrhi [-Nodes=1000,10000,...] [-Seed=1] [-Directory=<Dir>] [-Csv=<File>] [-Queries=1000] [-DispatchPasses=200000] [-Options=\"(...)\"] [-GenerateOnly] [-Regenerate]" );
+	HelpParamNames.Add( TEXT( "Nodes" ) );
+	HelpParamDescriptions.Add( TEXT( "Comma separated sizes of map to generate, in nodes.  Defaults to 1000,10000,100000,1000000." ) );
+	HelpParamNames.Add( TEXT( "Seed" ) );
+	HelpParamDescriptions.Add( TEXT( "Seed for the generated maps and the graph queries.  Defaults to 1." ) );
+	HelpParamNames.Add( TEXT( "Directory" ) );
+	HelpParamDescriptions.Add( TEXT( "Where to put the generated files.  Defaults to Saved/StreetMap/Benchmark." ) );
+	HelpParamNames.Add( TEXT( "Csv" ) );
+	HelpParamDescriptions.Add( TEXT( "CSV file to append the timings to.  Defaults to Results.csv in the directory." ) );
+	HelpParamNames.Add( TEXT( "Queries" ) );
+	HelpParamDescriptions.Add( TEXT( "How many graph queries to run on each map.  Defaults to 1000." ) );
+	HelpParamNames.Add( TEXT( "DispatchPasses" ) );
+	HelpParamDescriptions.Add( TEXT( "How many times to go over the sample document when timing XML name dispatch.  Defaults to 200000." ) );
+	HelpParamNames.Add( TEXT( "Options" ) );
+	HelpParamDescriptions.Add( TEXT( "Import options, in FStreetMapImportOptions text form." ) );
+	HelpParamNames.Add( TEXT( "GenerateOnly" ) );
+	HelpParamDescriptions.Add( TEXT( "Just write the files, without benchmarking anything." ) );
+	HelpParamNames.Add( TEXT( "Regenerate" ) );
+	HelpParamDescriptions.Add( TEXT( "Write the files again even if they already exist." ) );
+}
+
+
+int32 UStreetMapBenchmarkCommandlet::Main( const FString& Params )
+{
+	using namespace StreetMapBenchmarkCommandlet;
+
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> SwitchParams;
+	ParseCommandLine( *Params, Tokens, Switches, SwitchParams );
+
+	TArray<int64> TargetNodeCounts;
+	if( const FString* NodesParam = SwitchParams.Find( TEXT( "Nodes" ) ) )
+	{
+		TArray<FString> NodeCountStrings;
+		NodesParam->ParseIntoArray( NodeCountStrings, TEXT( "," ) );
+		for( const FString& NodeCountString : NodeCountStrings )
+		{
+			const int64 TargetNodeCount = FCString::Atoi64( *NodeCountString );
+			if( TargetNodeCount <= 0 || TargetNodeCount > MaxNodeCount )
+			{
+				UE_LOG( LogStreetMapBenchmark, Error, TEXT( "Map size '%s' must be between 1 and %lld nodes" ), *NodeCountString, MaxNodeCount );
+				return 1;
+			}
+			TargetNodeCounts.Add( TargetNodeCount );
+		}
+	}
+	else
+	{
+		TargetNodeCounts = { 1000, 10000, 100000, 1000000 };
+	}
+
+	int32 Seed = 1;
+	if( const FString* SeedParam = SwitchParams.Find( TEXT( "Seed" ) ) )
+	{
+		Seed = FCString::Atoi( **SeedParam );
+	}
+
+	int32 QueryCount = 1000;
+	if( const FString* QueriesParam = SwitchParams.Find( TEXT( "Queries" ) ) )
+	{
+		QueryCount = FMath::Max( 0, FCString::Atoi( **QueriesParam ) );
+	}
+
+	int32 DispatchPassCount = DefaultDispatchPassCount;
+	if( const FString* DispatchPassesParam = SwitchParams.Find( TEXT( "DispatchPasses" ) ) )
+	{
+		DispatchPassCount = FMath::Max( 1, FCString::Atoi( **DispatchPassesParam ) );
+	}
+
+	FString Directory = FPaths::ProjectSavedDir() / TEXT( "StreetMap" ) / TEXT( "Benchmark" );
+	if( const FString* DirectoryParam = SwitchParams.Find( TEXT( "Directory" ) ) )
+	{
+		Directory = *DirectoryParam;
+	}
+	Directory = FPaths::ConvertRelativePathToFull( Directory );
+	if( !IFileManager::Get().MakeDirectory( *Directory, true ) )
+	{
+		UE_LOG( LogStreetMapBenchmark, Error, TEXT( "Unable to create directory '%s'" ), *Directory );
+		return 1;
+	}
+
+	FString CSVFilePath = Directory / TEXT( "Results.csv" );
+	if( const FString* CSVParam = SwitchParams.Find( TEXT( "Csv" ) ) )
+	{
+		CSVFilePath = FPaths::ConvertRelativePathToFull( *CSVParam );
+	}
+
+	FStreetMapImportOptions ImportOptions;
+	if( const FString* OptionsParam = SwitchParams.Find( TEXT( "Options" ) ) )
+	{
+		if( FStreetMapImportOptions::StaticStruct()->ImportText( **OptionsParam, &ImportOptions, nullptr, PPF_None, GWarn, TEXT( "Options" ) ) == nullptr )
+		{
+			UE_LOG( LogStreetMapBenchmark, Error, TEXT( "Unable to parse import options '%s'" ), **OptionsParam );
+			return 1;
+		}
+	}
+
+	const bool bGenerateOnly = Switches.Contains( TEXT( "GenerateOnly" ) );
+	const bool bRegenerate = Switches.Contains( TEXT( "Regenerate" ) );
+
+	// Start a new CSV file with a header, or keep adding to the one from earlier runs so that trends show up
+	if( !bGenerateOnly && !IFileManager::Get().FileExists( *CSVFilePath ) )
+	{
+		if( !FFileHelper::SaveStringToFile( FString( CSVHeader ) + LINE_TERMINATOR, *CSVFilePath ) )
+		{
+			UE_LOG( LogStreetMapBenchmark, Error, TEXT( "Unable to write '%s'" ), *CSVFilePath );
+			return 1;
+		}
+	}
+
+	double CompareChainNanosecondsPerAttribute = 0.0;
+	double HashedNanosecondsPerAttribute = 0.0;
+	if( !bGenerateOnly )
+	{
+		RunDispatchBenchmark( DispatchPassCount, CompareChainNanosecondsPerAttribute, HashedNanosecondsPerAttribute );
+	}
+
+	int32 FailedCount = 0;
+	for( const int64 TargetNodeCount : TargetNodeCounts )
+	{
+		FBenchmarkResult Result;
+		Result.TargetNodeCount = TargetNodeCount;
+		Result.CompareChainNanosecondsPerAttribute = CompareChainNanosecondsPerAttribute;
+		Result.HashedNanosecondsPerAttribute = HashedNanosecondsPerAttribute;
+
+		const FString OSMFilePath = Directory / FString::Printf( TEXT( "Synthetic_%lld_%i.osm" ), TargetNodeCount, Seed );
+		if( bRegenerate || !IFileManager::Get().FileExists( *OSMFilePath ) )
+		{
+			FSyntheticOSMGenerator Generator;
+			Generator.TargetNodeCount = TargetNodeCount;
+			Generator.Seed = Seed;
+
+			const double StartTime = FPlatformTime::Seconds();
+			if( !Generator.WriteToFile( OSMFilePath, GWarn ) )
+			{
+				UE_LOG( LogStreetMapBenchmark, Error, TEXT( "Unable to write '%s'" ), *OSMFilePath );
+				++FailedCount;
+				continue;
+			}
+			Result.GenerateSeconds = FPlatformTime::Seconds() - StartTime;
+			Result.GeneratedNodeCount = Generator.GetNodeCount();
+			Result.GeneratedWayCount = Generator.GetWayCount();
+		}
+		Result.SourceFileSize = FMath::Max( IFileManager::Get().FileSize( *OSMFilePath ), (int64)0 );
+
+		if( bGenerateOnly )
+		{
+			continue;
+		}
+
+		UE_LOG( LogStreetMapBenchmark, Display, TEXT( "Benchmarking '%s' (%.1f MB)" ), *OSMFilePath, (double)Result.SourceFileSize / ( 1024.0 * 1024.0 ) );
+		RunBenchmark( OSMFilePath, ImportOptions, QueryCount, Seed, Result );
+		Result.PeakUsedPhysicalMB = (double)FPlatformMemory::GetStats().PeakUsedPhysical / ( 1024.0 * 1024.0 );
+
+		if( Result.bImported )
+		{
+			UE_LOG(
+				LogStreetMapBenchmark,
+				Display,
+				TEXT( "%lld nodes: import %.2fs, mesh %.2fs (%i triangles), road lengths %.3fs, %i queries %.3fs, load %.3fs (was %.3fs), peak memory %.0f MB" ),
+				TargetNodeCount,
+				Result.ImportSeconds,
+				Result.BuildMeshSeconds,
+				Result.TriangleCount,
+				Result.RoadLengthSeconds,
+				Result.QueryCount,
+				Result.QuerySeconds,
+				Result.BulkLoadSeconds,
+				Result.TaggedLoadSeconds,
+				Result.PeakUsedPhysicalMB );
+		}
+		else
+		{
+			UE_LOG( LogStreetMapBenchmark, Error, TEXT( "Failed to import '%s'" ), *OSMFilePath );
+			++FailedCount;
+		}
+
+		// A failed import still gets a row, so that a broken importer shows up in the results rather than as a gap
+		if( !FFileHelper::SaveStringToFile( FormatCSVRow( Result, Seed ) + LINE_TERMINATOR, *CSVFilePath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append ) )
+		{
+			UE_LOG( LogStreetMapBenchmark, Error, TEXT( "Unable to write '%s'" ), *CSVFilePath );
+			++FailedCount;
+		}
+
+		// Get rid of this map before we generate the next (bigger) one.  Peak memory is for the whole process, so it
+		// only ever goes up, but each size is bigger than the last so it's still mostly this map's.
+		CollectGarbage( GARBAGE_COLLECTION_KEEPFLAGS );
+	}
+
+	if( !bGenerateOnly )
+	{
+		UE_LOG( LogStreetMapBenchmark, Display, TEXT( "Wrote results to '%s'" ), *CSVFilePath );
+	}
+
+	return FailedCount == 0 ? 0 : 1;
+}
@@ -3,436 +3,2578 @@
 #include "StreetMapFactory.h"
 #include "StreetMapImporting.h"
 #include "OSMFile.h"
+#include "StreetMapImportProfiler.h"
 #include "StreetMap.h"
-
+#include "PolygonTools.h"
+#include "Async/ParallelFor.h"
+#include "Algo/Reverse.h"
+#include "Algo/BinarySearch.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "AssetRegistryModule.h"
+#include "DerivedDataCacheInterface.h"
+#include "Misc/SecureHash.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+
+// The factory builds and edits roads and buildings in their own point arrays, which are deprecated for everyone else
+// because they're empty once the map has compacted its geometry
+PRAGMA_DISABLE_DEPRECATION_WARNINGS
 
 // Latitude/longitude scale factor
 //			- https://en.wikipedia.org/wiki/Equator#Exact_length
 static const double EarthCircumference = 40075036.0;
 const double UStreetMapFactory::LatitudeLongitudeScale = EarthCircumference / 360.0; // meters per degree
 
+// How many nodes or ways each worker converts at a time
+static const int32 ConversionChunkSize = 4096;
 
-UStreetMapFactory::UStreetMapFactory(const FObjectInitializer& ObjectInitializer)
-	: Super(ObjectInitializer)
-{
-	SupportedClass = UStreetMap::StaticClass();
-
-	Formats.Add( TEXT( "osm;OpenStreetMap XML" ) );
-	bCreateNew = false;
-	bEditorImport = true;
-	bEditAfterNew = false;
-	bText = true;
-}
-
+// OSM data is stored in meters.  This is the scale factor to convert those units into UE4's native units (cm)
+// Keep in mind that if this is changed, UStreetMapComponent sizes for roads may need to be updated too!
+// @todo: We should make this scale factor customizable as an import option
+static const float OSMToCentimetersScaleFactor = 100.0f;
 
-UObject* UStreetMapFactory::FactoryCreateText( UClass* Class, UObject* Parent, FName Name, EObjectFlags Flags, UObject* Context, const TCHAR* Type, const TCHAR*& Buffer, const TCHAR* BufferEnd, FFeedbackContext* Warn )
-{
-	UStreetMap* StreetMap = NewObject<UStreetMap>( Parent, Name, Flags | RF_Transactional );
+// Fixed point scale of the node locations we store in FStreetMapOSMSourceData.  This matches FOSMFile.
+static const double SourceCoordinateScale = 10000000.0;
 
-	StreetMap->AssetImportData->Update( this->GetCurrentFilename() );
+// Version of the street maps we store in the derived data cache.  Change this to a new GUID whenever a change to the
+// importer makes it produce different results for the same file and options, so that we don't load stale maps.
+static const TCHAR* ImportCacheVersion = TEXT( "3B7D2E91C4F04A6E9A5D8C1F60E2B7A4" );
 
-	// @todo: Performance: This will copy the entire text buffer into an FString.  We need to do this
-	//        because the FFastXml parser is expecting a buffer that it can mutate as it parses.
-	const int32 CharacterCount = BufferEnd - Buffer;
-	FString MutableTextBuffer( CharacterCount, Buffer );
+DECLARE_CYCLE_STAT( TEXT( "Derived data cache lookup" ), STAT_StreetMapImport_CacheLookup, STATGROUP_StreetMapImport );
+DECLARE_CYCLE_STAT( TEXT( "Project nodes" ), STAT_StreetMapImport_ProjectNodes, STATGROUP_StreetMapImport );
+DECLARE_CYCLE_STAT( TEXT( "Convert ways" ), STAT_StreetMapImport_ConvertWays, STATGROUP_StreetMapImport );
+DECLARE_CYCLE_STAT( TEXT( "Record source data" ), STAT_StreetMapImport_RecordSourceData, STATGROUP_StreetMapImport );
+DECLARE_CYCLE_STAT( TEXT( "Build map nodes" ), STAT_StreetMapImport_BuildMapNodes, STATGROUP_StreetMapImport );
+DECLARE_CYCLE_STAT( TEXT( "Merge road chains" ), STAT_StreetMapImport_MergeRoadChains, STATGROUP_StreetMapImport );
+DECLARE_CYCLE_STAT( TEXT( "Simplify roads" ), STAT_StreetMapImport_SimplifyRoads, STATGROUP_StreetMapImport );
+DECLARE_CYCLE_STAT( TEXT( "Validate roads" ), STAT_StreetMapImport_ValidateRoads, STATGROUP_StreetMapImport );
+DECLARE_CYCLE_STAT( TEXT( "Derived data cache store" ), STAT_StreetMapImport_CacheStore, STATGROUP_StreetMapImport );
+DECLARE_CYCLE_STAT( TEXT( "Split into tiles" ), STAT_StreetMapImport_SplitIntoTiles, STATGROUP_StreetMapImport );
 
-	const bool bIsFilePathActuallyTextBuffer = true;
-	const bool bLoadedOkay = LoadFromOpenStreetMapXMLFile( StreetMap, MutableTextBuffer, bIsFilePathActuallyTextBuffer, Warn );
 
-	if( !bLoadedOkay )
+/** Serializes an array of structs using their tagged properties, so the data stays readable when fields are added */
+template<typename StructType>
+static void SerializeStructArray( FArchive& Ar, TArray<StructType>& Array )
+{
+	int32 Count = Array.Num();
+	Ar << Count;
+	if( Ar.IsLoading() )
 	{
-		StreetMap->MarkPendingKill();
-		StreetMap = nullptr;
+		Array.Reset();
+		Array.SetNum( Count );
+	}
+	for( StructType& Element : Array )
+	{
+		StructType::StaticStruct()->SerializeItem( Ar, &Element, nullptr );
 	}
-
-	return StreetMap;
 }
 
 
-bool UStreetMapFactory::LoadFromOpenStreetMapXMLFile( UStreetMap* StreetMap, FString& OSMFilePath, const bool bIsFilePathActuallyTextBuffer, FFeedbackContext* FeedbackContext )
+/** Compiles the tag filter rules from the import options into a lookup table for FOSMFile */
+static void CompileTagFilter( const TArray<FStreetMapTagFilterRule>& TagFilterRules, FOSMTagFilter& OutTagFilter )
 {
-	// OSM data is stored in meters.  This is the scale factor to convert those units into UE4's native units (cm)
-	// Keep in mind that if this is changed, UStreetMapComponent sizes for roads may need to be updated too!
-	// @todo: We should make this scale factor customizable as an import option
-	const float OSMToCentimetersScaleFactor = 100.0f;
+	for( const FStreetMapTagFilterRule& Rule : TagFilterRules )
+	{
+		OutTagFilter.AddRule( Rule.Key, Rule.Value, Rule.Action == EStreetMapTagFilterAction::Keep );
+	}
+	OutTagFilter.Compile();
+}
 
 
-	// Converts latitude to meters
-	auto ConvertLatitudeToMeters = []( const double Latitude ) -> double
+/** Returns the type of road we'll create for the specified way, or EStreetMapRoadType::Other if it isn't a road we want.
+    A tag filter rule that kept the way can choose the type. */
+static EStreetMapRoadType GetRoadTypeForWay( const FOSMFile::FOSMWayInfo& OSMWay, const TArray<FStreetMapTagFilterRule>& TagFilterRules )
+{
+	if( TagFilterRules.IsValidIndex( OSMWay.TagRuleIndex ) )
 	{
-		return -Latitude * LatitudeLongitudeScale;
-	};
+		const FStreetMapTagFilterRule& Rule = TagFilterRules[ OSMWay.TagRuleIndex ];
+		if( Rule.Action == EStreetMapTagFilterAction::Keep && Rule.RoadType != EStreetMapRoadType::Other )
+		{
+			return Rule.RoadType;
+		}
+	}
 
-	// Converts longitude to meters
-	auto ConvertLongitudeToMeters = []( const double Longitude, const double Latitude ) -> double
+	EStreetMapRoadType RoadType = EStreetMapRoadType::Other;
+	switch( OSMWay.WayType )
 	{
-		return Longitude * LatitudeLongitudeScale * FMath::Cos( FMath::DegreesToRadians( Latitude ) );
-	};
+		case FOSMFile::EOSMWayType::Motorway:
+		case FOSMFile::EOSMWayType::Motorway_Link:
+		case FOSMFile::EOSMWayType::Trunk:
+		case FOSMFile::EOSMWayType::Trunk_Link:
+		case FOSMFile::EOSMWayType::Primary:
+		case FOSMFile::EOSMWayType::Primary_Link:
+			RoadType = EStreetMapRoadType::Highway;
+			break;
+
+		case FOSMFile::EOSMWayType::Secondary:
+		case FOSMFile::EOSMWayType::Secondary_Link:
+		case FOSMFile::EOSMWayType::Tertiary:
+		case FOSMFile::EOSMWayType::Tertiary_Link:
+			RoadType = EStreetMapRoadType::MajorRoad;
+			break;
+
+		case FOSMFile::EOSMWayType::Residential:
+		case FOSMFile::EOSMWayType::Service:
+		case FOSMFile::EOSMWayType::Unclassified:
+		case FOSMFile::EOSMWayType::Road:	// @todo: Consider excluding "Road" from our data set, as it could be a highway that wasn't properly tagged in OSM yet
+			RoadType = EStreetMapRoadType::Street;
+			break;
+	}
+	return RoadType;
+}
 
-	// Converts latitude and longitude to X/Y coordinates, relative to some other latitude/longitude
-	auto ConvertLatLongToMetersRelative = [ConvertLatitudeToMeters, ConvertLongitudeToMeters]( 
-		const double Latitude, 
-		const double Longitude, 
-		const double RelativeToLatitude, 
-		const double RelativeToLongitude ) -> FVector2D
-	{
-		// Applies Sanson-Flamsteed (sinusoidal) Projection (see http://www.progonos.com/furuti/MapProj/Normal/CartHow/HowSanson/howSanson.html)
-		return FVector2D(
-			(float)( ConvertLongitudeToMeters( Longitude, Latitude ) - ConvertLongitudeToMeters( RelativeToLongitude, Latitude ) ),
-			(float)( ConvertLatitudeToMeters( Latitude ) - ConvertLatitudeToMeters( RelativeToLatitude ) ) );
-	};
 
-	// Adds a road to the street map using the OpenStreetMap data, flattening the road's coordinates into our map's space
-	auto AddRoadForWay = [ConvertLatLongToMetersRelative, OSMToCentimetersScaleFactor]( 
-		const FOSMFile& OSMFile, 
-		UStreetMap& StreetMapRef, 
-		const FOSMFile::FOSMWayInfo& OSMWay, 
-		int32& OutRoadIndex ) -> bool
-	{
-		EStreetMapRoadType RoadType = EStreetMapRoadType::Other;
-		switch( OSMWay.WayType )
-		{
-			case FOSMFile::EOSMWayType::Motorway:
-			case FOSMFile::EOSMWayType::Motorway_Link:
-			case FOSMFile::EOSMWayType::Trunk:
-			case FOSMFile::EOSMWayType::Trunk_Link:
-			case FOSMFile::EOSMWayType::Primary:
-			case FOSMFile::EOSMWayType::Primary_Link:
-				RoadType = EStreetMapRoadType::Highway;
-				break;
+/** Returns true for ways that we turn into roads or buildings */
+static bool ShouldImportWay( const FOSMFile::FOSMWayInfo& OSMWay, const TArray<FStreetMapTagFilterRule>& TagFilterRules )
+{
+	return OSMWay.WayType == FOSMFile::EOSMWayType::Building || GetRoadTypeForWay( OSMWay, TagFilterRules ) != EStreetMapRoadType::Other;
+}
 
-			case FOSMFile::EOSMWayType::Secondary:
-			case FOSMFile::EOSMWayType::Secondary_Link:
-			case FOSMFile::EOSMWayType::Tertiary:
-			case FOSMFile::EOSMWayType::Tertiary_Link:
-				RoadType = EStreetMapRoadType::MajorRoad;
-				break;
 
-			case FOSMFile::EOSMWayType::Residential:
-			case FOSMFile::EOSMWayType::Service:
-			case FOSMFile::EOSMWayType::Unclassified:
-			case FOSMFile::EOSMWayType::Road:	// @todo: Consider excluding "Road" from our data set, as it could be a highway that wasn't properly tagged in OSM yet
-				RoadType = EStreetMapRoadType::Street;
-				break;
-		}
+/** Adds a road for the OpenStreetMap way, using node positions that have already been flattened into our map's space.
+    This only touches the output arrays and bounds that are passed in, so it's safe to call for many ways at once. */
+static bool AddRoadForWay( 
+	const FOSMFile& OSMFile, 
+	const TArray<FVector2D>& NodePositions, 
+	const FOSMFile::FOSMWayInfo& OSMWay, 
+	const TArray<FStreetMapTagFilterRule>& TagFilterRules, 
+	TArray<FStreetMapRoad>& OutRoads, 
+	FVector2D& InOutMapBoundsMin, 
+	FVector2D& InOutMapBoundsMax )
+{
+	const EStreetMapRoadType RoadType = GetRoadTypeForWay( OSMWay, TagFilterRules );
 
-		if( RoadType != EStreetMapRoadType::Other )
+	if( RoadType != EStreetMapRoadType::Other )
+	{
+		// Require at least two points!
+		const TArrayView<const int32> OSMWayNodes = OSMFile.GetWayNodes( OSMWay );
+		if( OSMWayNodes.Num() > 1 )
 		{
-			// Require at least two points!
-			if( OSMWay.Nodes.Num() > 1 )
+			// Create a road for this way
+			FStreetMapRoad& NewRoad = *new( OutRoads )FStreetMapRoad();
+
+			FVector2D BoundsMin( TNumericLimits<float>::Max(), TNumericLimits<float>::Max() );
+			FVector2D BoundsMax( TNumericLimits<float>::Lowest(), TNumericLimits<float>::Lowest() );
+
+			NewRoad.RoadPoints.AddUninitialized( OSMWayNodes.Num() );
+			int32 CurRoadPoint = 0;
+
+			// Set defaults for each node index on this road.  INDEX_NONE means the node is not valid, which may be the case
+			// for nodes that we filter out entirely.  This will be filled in by valid indices to nodes later on.
+			NewRoad.NodeIndices.AddUninitialized( OSMWayNodes.Num() );
+			for( int32& NodeIndex : NewRoad.NodeIndices )
 			{
-				// Create a road for this way
-				OutRoadIndex = StreetMapRef.Roads.Num();
-				FStreetMapRoad& NewRoad = *new( StreetMapRef.Roads )FStreetMapRoad();
+				NodeIndex = INDEX_NONE;
+			}
 
-				FVector2D BoundsMin( TNumericLimits<float>::Max(), TNumericLimits<float>::Max() );
-				FVector2D BoundsMax( TNumericLimits<float>::Lowest(), TNumericLimits<float>::Lowest() );
 
-				NewRoad.RoadPoints.AddUninitialized( OSMWay.Nodes.Num() );
-				int32 CurRoadPoint = 0;
+			for( const int32 OSMNodeIndex : OSMWayNodes )
+			{
+				const FVector2D NodePos = NodePositions[ OSMNodeIndex ];
 
-				// Set defaults for each node index on this road.  INDEX_NONE means the node is not valid, which may be the case
-				// for nodes that we filter out entirely.  This will be filled in by valid indices to nodes later on.
-				NewRoad.NodeIndices.AddUninitialized( OSMWay.Nodes.Num() );
-				for( int32& NodeIndex : NewRoad.NodeIndices )
+				// Update bounding box
 				{
-					NodeIndex = INDEX_NONE;
+					if( NodePos.X < BoundsMin.X )
+					{
+						BoundsMin.X = NodePos.X;
+					}
+					if( NodePos.Y < BoundsMin.Y )
+					{
+						BoundsMin.Y = NodePos.Y;
+					}
+					if( NodePos.X > BoundsMax.X )
+					{
+						BoundsMax.X = NodePos.X;
+					}
+					if( NodePos.Y > BoundsMax.Y )
+					{
+						BoundsMax.Y = NodePos.Y;
+					}
 				}
 
+				// Fill in the points
+				NewRoad.RoadPoints[ CurRoadPoint++ ] = NodePos;
+			}
 
-				for( const FOSMFile::FOSMNodeInfo* OSMNodePtr : OSMWay.Nodes )
-				{
-					const FOSMFile::FOSMNodeInfo& OSMNode = *OSMNodePtr;
 
-					// Transform all points relative to the center of the latitude/longitude bounds, so that
-					// we get as much precision as possible.
-					const double RelativeToLatitude = OSMFile.AverageLatitude;
-					const double RelativeToLongitude = OSMFile.AverageLongitude;
-					const FVector2D NodePos = ConvertLatLongToMetersRelative(
-						OSMNode.Latitude,
-						OSMNode.Longitude,
-						RelativeToLatitude,
-						RelativeToLongitude ) * OSMToCentimetersScaleFactor;
+			NewRoad.RoadName = OSMWay.Name;
+			if( NewRoad.RoadName.IsEmpty() )
+			{
+				NewRoad.RoadName = OSMWay.Ref;
+			}
+			NewRoad.RoadType = RoadType;
+			NewRoad.BoundsMin = BoundsMin;
+			NewRoad.BoundsMax = BoundsMax;
 
-					// Update bounding box
-					{
-						if( NodePos.X < BoundsMin.X )
-						{
-							BoundsMin.X = NodePos.X;
-						}
-						if( NodePos.Y < BoundsMin.Y )
-						{
-							BoundsMin.Y = NodePos.Y;
-						}
-						if( NodePos.X > BoundsMax.X )
-						{
-							BoundsMax.X = NodePos.X;
-						}
-						if( NodePos.Y > BoundsMax.Y )
-						{
-							BoundsMax.Y = NodePos.Y;
-						}
-					}
+			NewRoad.bIsOneWay = OSMWay.bIsOneWay;
 
-					// Fill in the points
-					NewRoad.RoadPoints[ CurRoadPoint++ ] = NodePos;
-				}
+			InOutMapBoundsMin.X = FMath::Min( InOutMapBoundsMin.X, BoundsMin.X );
+			InOutMapBoundsMin.Y = FMath::Min( InOutMapBoundsMin.Y, BoundsMin.Y );
+			InOutMapBoundsMax.X = FMath::Max( InOutMapBoundsMax.X, BoundsMax.X );
+			InOutMapBoundsMax.Y = FMath::Max( InOutMapBoundsMax.Y, BoundsMax.Y );
+
+			return true;
+		}
+		else
+		{
+			// NOTE: Skipped adding road for way because it has less than 2 points
+			// @todo: Log this for the user as an import warning
+		}
+	}
+
+	return false;
+}
 
 
-				NewRoad.RoadName = OSMWay.Name;
-				if( NewRoad.RoadName.IsEmpty() )
-				{
-					NewRoad.RoadName = OSMWay.Ref;
-				}
-				NewRoad.RoadType = RoadType;
-				NewRoad.BoundsMin = BoundsMin;
-				NewRoad.BoundsMax = BoundsMax;
+/** Makes the building's points wind counter-clockwise, then triangulates its outline so that the mesh doesn't have to
+    be triangulated every time it's built.  Returns true if the points had to be reversed. */
+static bool TriangulateBuilding( FStreetMapBuilding& Building )
+{
+	const bool bWasClockwise = FPolygonTools::Area( Building.BuildingPoints ) < 0.0f;
+	if( bWasClockwise )
+	{
+		Algo::Reverse( Building.BuildingPoints );
+	}
 
-				NewRoad.bIsOneWay = OSMWay.bIsOneWay;
+	TArray<int32> TempIndices;
+	bool bWindsClockwise;
+	if( !FPolygonTools::TriangulatePolygon( Building.BuildingPoints, TempIndices, /* Out */ Building.FillTriangleIndices, /* Out */ bWindsClockwise ) )
+	{
+		// @todo: Triangulation failed for some reason, possibly due to degenerate polygons.  The mesh won't have a
+		//        roof or walls for the building (the walls are joined to the roof), only its border on the ground
+		//        when buildings are flat.
+		Building.FillTriangleIndices.Reset();
+	}
+	Building.bPointsWindCounterClockwise = true;
 
-				StreetMapRef.BoundsMin.X = FMath::Min( StreetMapRef.BoundsMin.X, BoundsMin.X );
-				StreetMapRef.BoundsMin.Y = FMath::Min( StreetMapRef.BoundsMin.Y, BoundsMin.Y );
-				StreetMapRef.BoundsMax.X = FMath::Max( StreetMapRef.BoundsMax.X, BoundsMax.X );
-				StreetMapRef.BoundsMax.Y = FMath::Max( StreetMapRef.BoundsMax.Y, BoundsMax.Y );
+	return bWasClockwise;
+}
 
-				return true;
-			}
-			else
+
+/** Marks the points between FirstIndex and LastIndex that are needed to keep the line within Tolerance of its original
+    shape (Douglas-Peucker).  The points at FirstIndex and LastIndex should already be marked.  Indices past the end
+    wrap around to the start, so that closed outlines can be simplified too. */
+static void SimplifyLineSection( const TArrayView<const FVector2D> Points, const int32 FirstIndex, const int32 LastIndex, const float Tolerance, TBitArray<>& InOutKeepPoints )
+{
+	TArray<TPair<int32, int32>, TInlineAllocator<32>> Sections;
+	Sections.Add( TPair<int32, int32>( FirstIndex, LastIndex ) );
+	while( Sections.Num() > 0 )
+	{
+		const TPair<int32, int32> Section = Sections.Pop( false );
+		const FVector2D& SectionStart = Points[ Section.Key % Points.Num() ];
+		const FVector2D& SectionEnd = Points[ Section.Value % Points.Num() ];
+
+		// Find the point that strays furthest from a straight line between the ends of the section
+		float FurthestDistanceSquared = Tolerance * Tolerance;
+		int32 FurthestIndex = INDEX_NONE;
+		for( int32 PointIndex = Section.Key + 1; PointIndex < Section.Value; ++PointIndex )
+		{
+			const FVector2D& Point = Points[ PointIndex % Points.Num() ];
+			const float DistanceSquared = FVector2D::DistSquared( Point, FMath::ClosestPointOnSegment2D( Point, SectionStart, SectionEnd ) );
+			if( DistanceSquared > FurthestDistanceSquared )
 			{
-				// NOTE: Skipped adding road for way because it has less than 2 points
-				// @todo: Log this for the user as an import warning
+				FurthestDistanceSquared = DistanceSquared;
+				FurthestIndex = PointIndex;
 			}
 		}
 
-		return false;
-	};
+		// If it's too far away to leave out, keep it, and look at the sections on either side of it
+		if( FurthestIndex != INDEX_NONE )
+		{
+			InOutKeepPoints[ FurthestIndex % Points.Num() ] = true;
+			Sections.Add( TPair<int32, int32>( Section.Key, FurthestIndex ) );
+			Sections.Add( TPair<int32, int32>( FurthestIndex, Section.Value ) );
+		}
+	}
+}
 
 
-	// Adds a building to the street map using the OpenStreetMap data, flattening the road's coordinates into our map's space
-	auto AddBuildingForWay = [ConvertLatLongToMetersRelative, OSMToCentimetersScaleFactor]( 
-		const FOSMFile& OSMFile, 
-		UStreetMap& StreetMapRef, 
-		const FOSMFile::FOSMWayInfo& OSMWay ) -> bool
+/** Removes points from a building outline that hardly change its shape.  Outlines are never simplified to fewer than
+    three points. */
+static void SimplifyBuildingOutline( const TArray<FVector2D>& NodePositions, TArray<int32, TInlineAllocator<64>>& InOutRingNodes, const float Tolerance )
+{
+	TArray<FVector2D, TInlineAllocator<64>> Points;
+	Points.Reserve( InOutRingNodes.Num() );
+	for( const int32 OSMNodeIndex : InOutRingNodes )
+	{
+		Points.Add( NodePositions[ OSMNodeIndex ] );
+	}
+
+	// Closed outlines don't have ends to start from, so we use the first point and the point furthest from it
+	int32 FurthestIndex = 1;
+	for( int32 PointIndex = 2; PointIndex < Points.Num(); ++PointIndex )
 	{
-		if( OSMWay.WayType == FOSMFile::EOSMWayType::Building )
+		if( FVector2D::DistSquared( Points[ 0 ], Points[ PointIndex ] ) > FVector2D::DistSquared( Points[ 0 ], Points[ FurthestIndex ] ) )
 		{
-			// Require at least three points so that we don't have degenerate polygon!
-			if( OSMWay.Nodes.Num() > 2 )
-			{
-				// Create a building for this way
-				FStreetMapBuilding& NewBuilding = *new( StreetMapRef.Buildings )FStreetMapBuilding();
+			FurthestIndex = PointIndex;
+		}
+	}
 
-				FVector2D BoundsMin( TNumericLimits<float>::Max(), TNumericLimits<float>::Max() );
-				FVector2D BoundsMax( TNumericLimits<float>::Lowest(), TNumericLimits<float>::Lowest() );
+	TBitArray<> KeepPoints( false, Points.Num() );
+	KeepPoints[ 0 ] = true;
+	KeepPoints[ FurthestIndex ] = true;
+	SimplifyLineSection( Points, 0, FurthestIndex, Tolerance, KeepPoints );
+	SimplifyLineSection( Points, FurthestIndex, Points.Num(), Tolerance, KeepPoints );
 
-				NewBuilding.BuildingPoints.AddUninitialized( OSMWay.Nodes.Num() );
-				int32 CurBuildingPoint = 0;
+	int32 KeptPointCount = 0;
+	for( int32 PointIndex = 0; PointIndex < Points.Num(); ++PointIndex )
+	{
+		KeptPointCount += KeepPoints[ PointIndex ] ? 1 : 0;
+	}
+	if( KeptPointCount < 3 || KeptPointCount == Points.Num() )
+	{
+		return;
+	}
 
-				for( const FOSMFile::FOSMNodeInfo* OSMNodePtr : OSMWay.Nodes )
-				{
-					const FOSMFile::FOSMNodeInfo& OSMNode = *OSMNodePtr;
+	int32 WriteIndex = 0;
+	for( int32 PointIndex = 0; PointIndex < Points.Num(); ++PointIndex )
+	{
+		if( KeepPoints[ PointIndex ] )
+		{
+			InOutRingNodes[ WriteIndex++ ] = InOutRingNodes[ PointIndex ];
+		}
+	}
+	InOutRingNodes.SetNum( WriteIndex, false );
+}
 
-					// Transform all points relative to the center of the latitude/longitude bounds, so that
-					// we get as much precision as possible.
-					const double RelativeToLatitude = OSMFile.AverageLatitude;
-					const double RelativeToLongitude = OSMFile.AverageLongitude;
-					const FVector2D NodePos = ConvertLatLongToMetersRelative(
-						OSMNode.Latitude,
-						OSMNode.Longitude,
-						RelativeToLatitude,
-						RelativeToLongitude ) * OSMToCentimetersScaleFactor;
 
-					// Update bounding box
-					{
-						if( NodePos.X < BoundsMin.X )
-						{
-							BoundsMin.X = NodePos.X;
-						}
-						if( NodePos.Y < BoundsMin.Y )
-						{
-							BoundsMin.Y = NodePos.Y;
-						}
-						if( NodePos.X > BoundsMax.X )
-						{
-							BoundsMax.X = NodePos.X;
-						}
-						if( NodePos.Y > BoundsMax.Y )
-						{
-							BoundsMax.Y = NodePos.Y;
-						}
-					}
+/** Removes points from roads that hardly change their shape, starting at FirstRoadIndex.  Points that have a map node
+    are never removed.  The map nodes' road refs and the roads' OpenStreetMap node IDs are updated to match.  Returns
+    how many points were removed. */
+static int32 SimplifyRoads( TArray<FStreetMapRoad>& Roads, TArray<FStreetMapNode>& Nodes, TArray<int64>& RoadPointNodeIDs, const int32 FirstRoadIndex, const float Tolerance )
+{
+	// Where each point of each road ended up, or INDEX_NONE if it was removed.  Empty for roads that didn't change.
+	TArray<TArray<int32>> RoadPointRemaps;
+	RoadPointRemaps.SetNum( Roads.Num() - FirstRoadIndex );
+	ParallelFor( FMath::DivideAndRoundUp( RoadPointRemaps.Num(), ConversionChunkSize ), [&]( const int32 ChunkIndex )
+	{
+		const int32 ChunkEnd = FMath::Min( ( ChunkIndex + 1 ) * ConversionChunkSize, RoadPointRemaps.Num() );
+		for( int32 RemapIndex = ChunkIndex * ConversionChunkSize; RemapIndex < ChunkEnd; ++RemapIndex )
+		{
+			FStreetMapRoad& Road = Roads[ FirstRoadIndex + RemapIndex ];
+			const int32 PointCount = Road.RoadPoints.Num();
+			if( PointCount < 3 )
+			{
+				continue;
+			}
 
-					// Fill in the points
-					NewBuilding.BuildingPoints[ CurBuildingPoint++ ] = NodePos;
+			// Simplify each stretch of road between points that we have to keep
+			TBitArray<> KeepPoints( false, PointCount );
+			int32 SectionStartIndex = 0;
+			KeepPoints[ 0 ] = true;
+			for( int32 PointIndex = 1; PointIndex < PointCount; ++PointIndex )
+			{
+				if( PointIndex == PointCount - 1 || Road.NodeIndices[ PointIndex ] != INDEX_NONE )
+				{
+					KeepPoints[ PointIndex ] = true;
+					SimplifyLineSection( Road.RoadPoints, SectionStartIndex, PointIndex, Tolerance, KeepPoints );
+					SectionStartIndex = PointIndex;
 				}
+			}
 
-				// Make sure the building ended up with a closed polygon, then remove the final (redundant) point
-				const bool bIsClosed = NewBuilding.BuildingPoints[ 0 ].Equals( NewBuilding.BuildingPoints[ NewBuilding.BuildingPoints.Num() - 1 ], KINDA_SMALL_NUMBER );
-				if( bIsClosed )
+			TArray<int32>& PointRemap = RoadPointRemaps[ RemapIndex ];
+			PointRemap.SetNumUninitialized( PointCount );
+			int32 KeptPointCount = 0;
+			for( int32 PointIndex = 0; PointIndex < PointCount; ++PointIndex )
+			{
+				if( KeepPoints[ PointIndex ] )
 				{
-					// Remove the final redundant point
-					NewBuilding.BuildingPoints.Pop();
+					Road.RoadPoints[ KeptPointCount ] = Road.RoadPoints[ PointIndex ];
+					Road.NodeIndices[ KeptPointCount ] = Road.NodeIndices[ PointIndex ];
+					PointRemap[ PointIndex ] = KeptPointCount++;
 				}
 				else
 				{
-					// Wasn't expecting to have an unclosed shape.  Our tolerances might be off, or the data was malformed.
-					// Either way, it shouldn't be a problem as we'll close the shape ourselves below.
-					// @todo: Log this for the user as an import warning
-				}
-
-				NewBuilding.BuildingName = OSMWay.Name;
-				if( NewBuilding.BuildingName.IsEmpty() )
-				{
-					NewBuilding.BuildingName = OSMWay.Ref;
+					PointRemap[ PointIndex ] = INDEX_NONE;
 				}
+			}
 
-				NewBuilding.Height = OSMWay.Height * OSMToCentimetersScaleFactor;
-				NewBuilding.BuildingLevels = OSMWay.BuildingLevels;
-
-				NewBuilding.BoundsMin = BoundsMin;
-				NewBuilding.BoundsMax = BoundsMax;
+			if( KeptPointCount == PointCount )
+			{
+				PointRemap.Empty();
+				continue;
+			}
+			Road.RoadPoints.SetNum( KeptPointCount );
+			Road.NodeIndices.SetNum( KeptPointCount );
 
-				StreetMapRef.BoundsMin.X = FMath::Min( StreetMapRef.BoundsMin.X, BoundsMin.X );
-				StreetMapRef.BoundsMin.Y = FMath::Min( StreetMapRef.BoundsMin.Y, BoundsMin.Y );
-				StreetMapRef.BoundsMax.X = FMath::Max( StreetMapRef.BoundsMax.X, BoundsMax.X );
-				StreetMapRef.BoundsMax.Y = FMath::Max( StreetMapRef.BoundsMax.Y, BoundsMax.Y );
+			Road.BoundsMin = FVector2D( TNumericLimits<float>::Max(), TNumericLimits<float>::Max() );
+			Road.BoundsMax = FVector2D( TNumericLimits<float>::Lowest(), TNumericLimits<float>::Lowest() );
+			for( const FVector2D& RoadPoint : Road.RoadPoints )
+			{
+				Road.BoundsMin.X = FMath::Min( Road.BoundsMin.X, RoadPoint.X );
+				Road.BoundsMin.Y = FMath::Min( Road.BoundsMin.Y, RoadPoint.Y );
+				Road.BoundsMax.X = FMath::Max( Road.BoundsMax.X, RoadPoint.X );
+				Road.BoundsMax.Y = FMath::Max( Road.BoundsMax.Y, RoadPoint.Y );
+			}
+		}
+	} );
 
-				return true;
+	// Drop the node IDs of the points we removed.  These are stored back to back for all of the roads.
+	int32 ReadIndex = 0;
+	for( int32 RoadIndex = 0; RoadIndex < FirstRoadIndex; ++RoadIndex )
+	{
+		ReadIndex += Roads[ RoadIndex ].RoadPoints.Num();
+	}
+	int32 WriteIndex = ReadIndex;
+	for( const TArray<int32>& PointRemap : RoadPointRemaps )
+	{
+		const int32 RoadIndex = FirstRoadIndex + ( &PointRemap - RoadPointRemaps.GetData() );
+		const int32 OriginalPointCount = PointRemap.Num() > 0 ? PointRemap.Num() : Roads[ RoadIndex ].RoadPoints.Num();
+		for( int32 PointIndex = 0; PointIndex < OriginalPointCount; ++PointIndex, ++ReadIndex )
+		{
+			if( PointRemap.Num() == 0 || PointRemap[ PointIndex ] != INDEX_NONE )
+			{
+				RoadPointNodeIDs[ WriteIndex++ ] = RoadPointNodeIDs[ ReadIndex ];
 			}
-			else
+		}
+	}
+	const int32 RemovedPointCount = ReadIndex - WriteIndex;
+	RoadPointNodeIDs.SetNum( WriteIndex, false );
+
+	// Point the map nodes at the new indices of their road points
+	if( RemovedPointCount > 0 )
+	{
+		for( FStreetMapNode& Node : Nodes )
+		{
+			for( FStreetMapRoadRef& RoadRef : Node.RoadRefs )
 			{
-				// NOTE: Skipped adding building for way because it has less than 3 points
-				// @todo: Log this for the user as an import warning
+				if( RoadRef.RoadIndex >= FirstRoadIndex && RoadPointRemaps[ RoadRef.RoadIndex - FirstRoadIndex ].Num() > 0 )
+				{
+					RoadRef.RoadPointIndex = RoadPointRemaps[ RoadRef.RoadIndex - FirstRoadIndex ][ RoadRef.RoadPointIndex ];
+					check( RoadRef.RoadPointIndex != INDEX_NONE );
+				}
 			}
 		}
+	}
 
-		return false;
-	};
+	return RemovedPointCount;
+}
 
 
-	// Load up the OSM file.  It's in XML format.
-	FOSMFile OSMFile;
-	if( !OSMFile.LoadOpenStreetMapFile( OSMFilePath, bIsFilePathActuallyTextBuffer, FeedbackContext ) )
+/** Joins roads that meet end to end at a map node that connects nothing else, when they have the same type, name and
+    direction.  The nodes between joined roads are removed.  The source data is kept lined up with the new roads, with
+    each joined road taking the way ID of its first piece.  Returns how many roads were joined onto others. */
+static int32 MergeRoadChains( TArray<FStreetMapRoad>& Roads, TArray<FStreetMapNode>& Nodes, FStreetMapOSMSourceData& OSMSourceData )
+{
+	// Road ends are numbered RoadIndex * 2 for the start of the road, and RoadIndex * 2 + 1 for the end.  This is the
+	// end of another road that each end gets joined to, if any.
+	TArray<int32> JoinedEnds;
+	JoinedEnds.Init( INDEX_NONE, Roads.Num() * 2 );
+	auto GetRoadEnd = [ &Roads ]( const FStreetMapRoadRef& RoadRef ) -> int32
 	{
-		// Loading failed.  The actual error message will be sent to the FeedbackContext's log.
-		return false;
-	}
+		if( RoadRef.RoadPointIndex == 0 )
+		{
+			return RoadRef.RoadIndex * 2;
+		}
+		if( RoadRef.RoadPointIndex == Roads[ RoadRef.RoadIndex ].NodeIndices.Num() - 1 )
+		{
+			return RoadRef.RoadIndex * 2 + 1;
+		}
+		return INDEX_NONE;
+	};
 
-	// @todo: The loaded OSMFile stores data in double precision, but our runtime representation (UStreetMap)
-	//        truncates everything to single precision, after transposing coordinates to be relative to the
-	//        center of the map's 2D bounds.  Large maps will suffer from floating point precision issues.
-	//        To solve this we'd need to either store everything in double precision, or store map elements
-	//        in integral grid cells with coordinates relative to their cell.  Of course, there will be many
-	//        other considerations for handling huge maps (loading, rendering, collision, etc.)
+	int32 JoinCount = 0;
+	for( const FStreetMapNode& Node : Nodes )
+	{
+		if( Node.RoadRefs.Num() != 2 || Node.RoadRefs[ 0 ].RoadIndex == Node.RoadRefs[ 1 ].RoadIndex )
+		{
+			continue;
+		}
+
+		const int32 EndA = GetRoadEnd( Node.RoadRefs[ 0 ] );
+		const int32 EndB = GetRoadEnd( Node.RoadRefs[ 1 ] );
+		if( EndA == INDEX_NONE || EndB == INDEX_NONE )
+		{
+			continue;
+		}
 
-	// Maps OSMWayInfos to the RoadIndex we created for that way
-	TMap< const FOSMFile::FOSMWayInfo*, int32 > OSMWayToRoadIndexMap;
+		const FStreetMapRoad& RoadA = Roads[ EndA / 2 ];
+		const FStreetMapRoad& RoadB = Roads[ EndB / 2 ];
+		if( RoadA.RoadType != RoadB.RoadType || RoadA.bIsOneWay != RoadB.bIsOneWay || RoadA.RoadName != RoadB.RoadName )
+		{
+			continue;
+		}
 
-	StreetMap->BoundsMin = FVector2D( TNumericLimits<float>::Max(), TNumericLimits<float>::Max() );
-	StreetMap->BoundsMax = FVector2D( TNumericLimits<float>::Lowest(), TNumericLimits<float>::Lowest() );
+		// One way roads can't be turned around, so one of them has to end where the other one starts
+		if( RoadA.bIsOneWay && ( EndA % 2 ) == ( EndB % 2 ) )
+		{
+			continue;
+		}
+
+		JoinedEnds[ EndA ] = EndB;
+		JoinedEnds[ EndB ] = EndA;
+		++JoinCount;
+	}
 
-	for( const FOSMFile::FOSMWayInfo* OSMWay : OSMFile.Ways )
+	if( JoinCount == 0 )
 	{
-		// Handle buildings differently than roads
-		if( OSMWay->WayType == FOSMFile::EOSMWayType::Building )
+		return 0;
+	}
+
+	int32 RoadPointNodeIDCount = 0;
+	TArray<int32> FirstRoadPointNodeIDs;
+	FirstRoadPointNodeIDs.SetNumUninitialized( Roads.Num() );
+	for( int32 RoadIndex = 0; RoadIndex < Roads.Num(); ++RoadIndex )
+	{
+		FirstRoadPointNodeIDs[ RoadIndex ] = RoadPointNodeIDCount;
+		RoadPointNodeIDCount += Roads[ RoadIndex ].RoadPoints.Num();
+	}
+	const bool bHasRoadPointNodeIDs = OSMSourceData.RoadPointNodeIDs.Num() == RoadPointNodeIDCount;
+	const bool bHasRoadWayIDs = OSMSourceData.RoadWayIDs.Num() == Roads.Num();
+
+	TArray<FStreetMapRoad> MergedRoads;
+	TArray<int64> MergedRoadWayIDs;
+	TArray<int64> MergedRoadPointNodeIDs;
+	MergedRoads.Reserve( Roads.Num() - JoinCount );
+	MergedRoadPointNodeIDs.Reserve( OSMSourceData.RoadPointNodeIDs.Num() );
+
+	TBitArray<> IsRoadMerged( false, Roads.Num() );
+	TBitArray<> IsNodeRemoved( false, Nodes.Num() );
+	TArray<TPair<int32, bool>> Chain;
+	for( int32 RoadIndex = 0; RoadIndex < Roads.Num(); ++RoadIndex )
+	{
+		if( IsRoadMerged[ RoadIndex ] )
+		{
+			continue;
+		}
+
+		// Walk backwards to the first road in the chain.  Roads that are joined start to start or end to end have to be
+		// turned around to follow on from each other.  Chains that loop around start with this road.
+		int32 FirstRoadIndex = RoadIndex;
+		bool bIsFirstRoadReversed = false;
+		while( true )
 		{
-			if( AddBuildingForWay( OSMFile, *StreetMap, *OSMWay ) )
+			const int32 PreviousEnd = JoinedEnds[ FirstRoadIndex * 2 + ( bIsFirstRoadReversed ? 1 : 0 ) ];
+			if( PreviousEnd == INDEX_NONE )
+			{
+				break;
+			}
+			if( PreviousEnd / 2 == RoadIndex )
 			{
-				// ...
+				FirstRoadIndex = RoadIndex;
+				bIsFirstRoadReversed = false;
+				break;
 			}
+			FirstRoadIndex = PreviousEnd / 2;
+			bIsFirstRoadReversed = ( PreviousEnd % 2 ) == 0;
 		}
-		else
+
+		// Then walk forwards, gathering up the roads in order
+		Chain.Reset();
+		int32 ChainRoadIndex = FirstRoadIndex;
+		bool bIsChainRoadReversed = bIsFirstRoadReversed;
+		while( true )
 		{
-			int32 RoadIndex = INDEX_NONE;
-			if( AddRoadForWay( OSMFile, *StreetMap, *OSMWay, RoadIndex ) )
+			Chain.Add( TPair<int32, bool>( ChainRoadIndex, bIsChainRoadReversed ) );
+			IsRoadMerged[ ChainRoadIndex ] = true;
+
+			const int32 NextEnd = JoinedEnds[ ChainRoadIndex * 2 + ( bIsChainRoadReversed ? 0 : 1 ) ];
+			if( NextEnd == INDEX_NONE || IsRoadMerged[ NextEnd / 2 ] )
 			{
-				OSMWayToRoadIndexMap.Add( OSMWay, RoadIndex );
+				break;
 			}
+			ChainRoadIndex = NextEnd / 2;
+			bIsChainRoadReversed = ( NextEnd % 2 ) == 1;
 		}
-	}
 
-	for( const auto& NodeMapHashPair : OSMFile.NodeMap )
-	{
-		const FOSMFile::FOSMNodeInfo& OSMNode = *NodeMapHashPair.Value;
+		FStreetMapRoad& MergedRoad = MergedRoads[ MergedRoads.Add( FStreetMapRoad() ) ];
+		const FStreetMapRoad& FirstRoad = Roads[ FirstRoadIndex ];
+		MergedRoad.RoadName = FirstRoad.RoadName;
+		MergedRoad.RoadType = FirstRoad.RoadType;
+		MergedRoad.bIsOneWay = FirstRoad.bIsOneWay;
+		MergedRoad.BoundsMin = FirstRoad.BoundsMin;
+		MergedRoad.BoundsMax = FirstRoad.BoundsMax;
+		if( bHasRoadWayIDs )
+		{
+			MergedRoadWayIDs.Add( OSMSourceData.RoadWayIDs[ FirstRoadIndex ] );
+		}
 
-		// Any ways touching this node?
-		if( OSMNode.WayRefs.Num() > 0 )
+		for( int32 ChainIndex = 0; ChainIndex < Chain.Num(); ++ChainIndex )
 		{
-			FStreetMapNode NewNode;
+			const int32 PieceRoadIndex = Chain[ ChainIndex ].Key;
+			const bool bIsReversed = Chain[ ChainIndex ].Value;
+			const FStreetMapRoad& Road = Roads[ PieceRoadIndex ];
 
-			for( const FOSMFile::FOSMWayRef& OSMWayRef : OSMNode.WayRefs )
+			// The node where this road joins the previous one goes away, and the point is only needed once
+			int32 FirstPointIndex = 0;
+			if( ChainIndex > 0 )
 			{
-				const int32* FoundRoundIndexPtr = OSMWayToRoadIndexMap.Find( OSMWayRef.Way );
-				if( FoundRoundIndexPtr != nullptr )
-				{
-					const int32 FoundRoadIndex = *FoundRoundIndexPtr;
-
-					FStreetMapRoadRef RoadRef;
-					RoadRef.RoadIndex = FoundRoadIndex;
+				IsNodeRemoved[ MergedRoad.NodeIndices.Last() ] = true;
+				MergedRoad.NodeIndices.Last() = INDEX_NONE;
+				FirstPointIndex = 1;
+			}
 
-					const int32 RoadPointIndex = OSMWayRef.NodeIndex;
-					RoadRef.RoadPointIndex = RoadPointIndex;
-					NewNode.RoadRefs.Add( RoadRef );
-				}
-				else
+			const int32 PointCount = Road.RoadPoints.Num();
+			for( int32 PointIndex = FirstPointIndex; PointIndex < PointCount; ++PointIndex )
+			{
+				const int32 SourcePointIndex = bIsReversed ? ( PointCount - 1 - PointIndex ) : PointIndex;
+				MergedRoad.RoadPoints.Add( Road.RoadPoints[ SourcePointIndex ] );
+				MergedRoad.NodeIndices.Add( Road.NodeIndices[ SourcePointIndex ] );
+				if( bHasRoadPointNodeIDs )
 				{
-					// Skipped ref because we didn't keep this road in our data set							
+					MergedRoadPointNodeIDs.Add( OSMSourceData.RoadPointNodeIDs[ FirstRoadPointNodeIDs[ PieceRoadIndex ] + SourcePointIndex ] );
 				}
 			}
 
-			// Only store nodes that are attached to at least one road.  We must have at least a connection to a single
-			// road, otherwise we've filtered this node's road out and there's no point in wasting memory on the node itself.
-			if( NewNode.RoadRefs.Num() > 0 )
-			{
-				// Most nodes from OpenStreetMap will only be touching a single road.  These nodes usually make up the points
-				// along the length of the road, even for roads with no intersections except at the beginning and end.  We
-				// don't need to store these points unless they are at the ends of the road.  Keeping the points at the
-				// beginning and end of the road is useful when calculating navigation data, but the other nodes can go!
-				// In the road's NodeIndices array, any nodes we filter out here will simply have an INDEX_NONE value in that
-				// array, and we'll only store the positions of the road at these points in the road's RoadPoints array.
+			MergedRoad.BoundsMin.X = FMath::Min( MergedRoad.BoundsMin.X, Road.BoundsMin.X );
+			MergedRoad.BoundsMin.Y = FMath::Min( MergedRoad.BoundsMin.Y, Road.BoundsMin.Y );
+			MergedRoad.BoundsMax.X = FMath::Max( MergedRoad.BoundsMax.X, Road.BoundsMax.X );
+			MergedRoad.BoundsMax.Y = FMath::Max( MergedRoad.BoundsMax.Y, Road.BoundsMax.Y );
+		}
+	}
 
-				const FStreetMapRoadRef& FirstRoadRef = NewNode.RoadRefs[ 0 ];
-				const FStreetMapRoad& FirstRoad = StreetMap->Roads[ FirstRoadRef.RoadIndex ];
+	// Remove the nodes between joined roads, and point the rest at the new roads
+	const bool bHasMapNodeIDs = OSMSourceData.MapNodeIDs.Num() == Nodes.Num();
+	TArray<int32> NodeRemap;
+	NodeRemap.SetNumUninitialized( Nodes.Num() );
+	int32 KeptNodeCount = 0;
+	for( int32 NodeIndex = 0; NodeIndex < Nodes.Num(); ++NodeIndex )
+	{
+		if( IsNodeRemoved[ NodeIndex ] )
+		{
+			NodeRemap[ NodeIndex ] = INDEX_NONE;
+			continue;
+		}
 
-				if( NewNode.RoadRefs.Num() > 1 ||					// Does the node connect to more than one road?
-					FirstRoadRef.RoadPointIndex == 0 ||				// Does the node connect to the beginning of the road?
-					FirstRoadRef.RoadPointIndex == ( FirstRoad.NodeIndices.Num() - 1 ) )	// Does the node connect to the end of the road?
-				{
-					const int32 NewNodeIndex = StreetMap->Nodes.Num();
-					StreetMap->Nodes.Add( NewNode );
+		NodeRemap[ NodeIndex ] = KeptNodeCount;
+		Nodes[ KeptNodeCount ].RoadRefs.Reset();
+		if( bHasMapNodeIDs )
+		{
+			OSMSourceData.MapNodeIDs[ KeptNodeCount ] = OSMSourceData.MapNodeIDs[ NodeIndex ];
+		}
+		++KeptNodeCount;
+	}
+	Nodes.SetNum( KeptNodeCount );
+	if( bHasMapNodeIDs )
+	{
+		OSMSourceData.MapNodeIDs.SetNum( KeptNodeCount );
+	}
 
-					// Update the roads that are overlapping this node
-					for( const FStreetMapRoadRef& RoadRef : NewNode.RoadRefs )
-					{
-						FStreetMapRoad& Road = StreetMap->Roads[ RoadRef.RoadIndex ];
-						check( Road.NodeIndices[ RoadRef.RoadPointIndex ] == INDEX_NONE );
-						Road.NodeIndices[ RoadRef.RoadPointIndex ] = NewNodeIndex;
-					}
-				}
-				else
-				{
-					// Node has only one road that is references, and it wasn't the beginning or end of the road, so filter it out!
-				}
-			}
-			else
+	for( int32 RoadIndex = 0; RoadIndex < MergedRoads.Num(); ++RoadIndex )
+	{
+		FStreetMapRoad& Road = MergedRoads[ RoadIndex ];
+		for( int32 PointIndex = 0; PointIndex < Road.NodeIndices.Num(); ++PointIndex )
+		{
+			int32& NodeIndex = Road.NodeIndices[ PointIndex ];
+			if( NodeIndex != INDEX_NONE )
 			{
-				// Node doesn't reference any roads that we kept, or the data was malformed.  Filter it out.
+				NodeIndex = NodeRemap[ NodeIndex ];
+
+				FStreetMapRoadRef RoadRef;
+				RoadRef.RoadIndex = RoadIndex;
+				RoadRef.RoadPointIndex = PointIndex;
+				Nodes[ NodeIndex ].RoadRefs.Add( RoadRef );
 			}
 		}
 	}
 
-	// Validation test: Make sure that all roads have at least two nodes referencing them, one at the beginning and
-	// one at the end.
-	for( const FStreetMapRoad& Road : StreetMap->Roads )
+	Roads = MoveTemp( MergedRoads );
+	if( bHasRoadWayIDs )
 	{
-		const bool bHasNodeAtBeginning = Road.NodeIndices[ 0 ] != INDEX_NONE;
-		const bool bHasNodeAtEnd = Road.NodeIndices[ Road.NodeIndices.Num() - 1 ] != INDEX_NONE;
-
-		// All roads should have at least two nodes referencing them, one at the beginning and one at the end
-		ensure( bHasNodeAtBeginning && bHasNodeAtEnd );
+		OSMSourceData.RoadWayIDs = MoveTemp( MergedRoadWayIDs );
+	}
+	if( bHasRoadPointNodeIDs )
+	{
+		OSMSourceData.RoadPointNodeIDs = MoveTemp( MergedRoadPointNodeIDs );
+	}
+
+	return JoinCount;
+}
+
+
+/** Adds a building for the OpenStreetMap way, using node positions that have already been flattened into our map's space.
+    The OSM node index for each of the building's points is added to OutBuildingPointNodes.  If SimplifyTolerance is
+    above zero, points that hardly change the outline are left out, and counted in InOutRemovedPointCount.  This only
+    touches the output arrays and bounds that are passed in, so it's safe to call for many ways at once. */
+static bool AddBuildingForWay( 
+	const FOSMFile& OSMFile, 
+	const TArray<FVector2D>& NodePositions, 
+	const FOSMFile::FOSMWayInfo& OSMWay, 
+	const float SimplifyTolerance,
+	TArray<FStreetMapBuilding>& OutBuildings, 
+	TArray<int32>& OutBuildingPointNodes,
+	int32& InOutRemovedPointCount,
+	FVector2D& InOutMapBoundsMin, 
+	FVector2D& InOutMapBoundsMax )
+{
+	if( OSMWay.WayType == FOSMFile::EOSMWayType::Building )
+	{
+		// Build the outline.  The OSM file has already welded nodes that were in the same place, so there are no points
+		// right on top of the previous point to trip up triangulation.
+		const TArrayView<const int32> OSMWayNodes = OSMFile.GetWayNodes( OSMWay );
+		TArray<int32, TInlineAllocator<64>> RingNodes;
+		RingNodes.Append( OSMWayNodes.GetData(), OSMWayNodes.Num() );
+
+		// Make sure the building ended up with a closed polygon, then remove the final (redundant) point
+		if( RingNodes.Num() > 1 && RingNodes[ 0 ] == RingNodes.Last() )
+		{
+			RingNodes.Pop();
+		}
+		else
+		{
+			// Wasn't expecting to have an unclosed shape.  Our tolerances might be off, or the data was malformed.
+			// Either way, it shouldn't be a problem as we'll close the shape ourselves below.
+			// @todo: Log this for the user as an import warning
+		}
+
+		if( SimplifyTolerance > 0.0f && RingNodes.Num() > 3 )
+		{
+			const int32 OriginalPointCount = RingNodes.Num();
+			SimplifyBuildingOutline( NodePositions, RingNodes, SimplifyTolerance );
+			InOutRemovedPointCount += OriginalPointCount - RingNodes.Num();
+		}
+
+		// Require at least three points so that we don't have degenerate polygon!
+		if( RingNodes.Num() > 2 )
+		{
+			// Create a building for this way
+			FStreetMapBuilding& NewBuilding = *new( OutBuildings )FStreetMapBuilding();
+
+			FVector2D BoundsMin( TNumericLimits<float>::Max(), TNumericLimits<float>::Max() );
+			FVector2D BoundsMax( TNumericLimits<float>::Lowest(), TNumericLimits<float>::Lowest() );
+
+			NewBuilding.BuildingPoints.AddUninitialized( RingNodes.Num() );
+			int32 CurBuildingPoint = 0;
+
+			for( const int32 OSMNodeIndex : RingNodes )
+			{
+				const FVector2D NodePos = NodePositions[ OSMNodeIndex ];
+
+				// Update bounding box
+				{
+					if( NodePos.X < BoundsMin.X )
+					{
+						BoundsMin.X = NodePos.X;
+					}
+					if( NodePos.Y < BoundsMin.Y )
+					{
+						BoundsMin.Y = NodePos.Y;
+					}
+					if( NodePos.X > BoundsMax.X )
+					{
+						BoundsMax.X = NodePos.X;
+					}
+					if( NodePos.Y > BoundsMax.Y )
+					{
+						BoundsMax.Y = NodePos.Y;
+					}
+				}
+
+				// Fill in the points
+				NewBuilding.BuildingPoints[ CurBuildingPoint++ ] = NodePos;
+			}
+
+			if( TriangulateBuilding( NewBuilding ) )
+			{
+				Algo::Reverse( RingNodes );
+			}
+
+			// Report the node that each point started out as before welding, so that changes to that node find it
+			if( OSMFile.GetWeldedNodeCount() > 0 )
+			{
+				const TArrayView<const int32> UnweldedWayNodes = OSMFile.GetUnweldedWayNodes( OSMWay );
+				for( int32& RingNode : RingNodes )
+				{
+					RingNode = UnweldedWayNodes[ OSMWayNodes.Find( RingNode ) ];
+				}
+			}
+			OutBuildingPointNodes.Append( RingNodes );
+
+			NewBuilding.BuildingName = OSMWay.Name;
+			if( NewBuilding.BuildingName.IsEmpty() )
+			{
+				NewBuilding.BuildingName = OSMWay.Ref;
+			}
+
+			NewBuilding.Height = OSMWay.Height * OSMToCentimetersScaleFactor;
+			NewBuilding.BuildingLevels = OSMWay.BuildingLevels;
+
+			NewBuilding.BoundsMin = BoundsMin;
+			NewBuilding.BoundsMax = BoundsMax;
+
+			InOutMapBoundsMin.X = FMath::Min( InOutMapBoundsMin.X, BoundsMin.X );
+			InOutMapBoundsMin.Y = FMath::Min( InOutMapBoundsMin.Y, BoundsMin.Y );
+			InOutMapBoundsMax.X = FMath::Max( InOutMapBoundsMax.X, BoundsMax.X );
+			InOutMapBoundsMax.Y = FMath::Max( InOutMapBoundsMax.Y, BoundsMax.Y );
+
+			return true;
+		}
+		else
+		{
+			// NOTE: Skipped adding building for way because it has less than 3 points
+			// @todo: Log this for the user as an import warning
+		}
+	}
+
+	return false;
+}
+
+
+/** A point on a road after the road has been cut up into tiles */
+struct FTileRoadPoint
+{
+	/** Position of the point on the map */
+	FVector2D Position;
+
+	/** The node at this point in the map we're splitting up, or INDEX_NONE */
+	int32 NodeIndex;
+
+	/** If the road crosses into another tile at this point, the ID that both tiles use for it.  Otherwise zero. */
+	int64 BoundaryNodeID;
+};
+
+
+/** The part of a road that is inside of a single tile */
+struct FTileRoadPiece
+{
+	/** Index of the tile in the grid */
+	int32 TileIndex;
+
+	/** The road that this piece was cut from */
+	int32 RoadIndex;
+
+	/** Points along this piece of the road */
+	TArray<FTileRoadPoint> Points;
+};
+
+
+/** Grid of tiles that a street map is being split into */
+struct FStreetMapTileGrid
+{
+	/** Corner of the first tile */
+	FVector2D Origin;
+
+	/** Width and height of each tile */
+	float TileSize;
+
+	/** Number of columns and rows of tiles */
+	int32 TileCountX;
+	int32 TileCountY;
+
+	/** Returns the column or row of the tile that contains the specified coordinate */
+	int32 GetTileCoordinate( const float Position, const float OriginPosition, const int32 TileCount ) const
+	{
+		return FMath::Clamp( FMath::FloorToInt( ( Position - OriginPosition ) / TileSize ), 0, TileCount - 1 );
+	}
+
+	/** Returns the index of the tile that contains the specified point.  Points outside of the grid are put in the
+	    closest tile. */
+	int32 GetTileIndex( const FVector2D Point ) const
+	{
+		return GetTileCoordinate( Point.Y, Origin.Y, TileCountY ) * TileCountX + GetTileCoordinate( Point.X, Origin.X, TileCountX );
+	}
+
+	/** Adds the positions (from 0 to 1) where the line from A to B crosses the edge between two tiles, along one axis */
+	void AddTileEdgeCrossings( const float A, const float B, const float OriginPosition, const int32 TileCount, TArray<float, TInlineAllocator<16>>& OutCrossings ) const
+	{
+		if( A == B )
+		{
+			return;
+		}
+
+		// Only the edges between tiles matter.  Anything past the outer edges of the grid stays in the closest tile.
+		const int32 FirstEdge = FMath::Max( 1, FMath::FloorToInt( ( FMath::Min( A, B ) - OriginPosition ) / TileSize ) + 1 );
+		const int32 LastEdge = FMath::Min( TileCount - 1, FMath::CeilToInt( ( FMath::Max( A, B ) - OriginPosition ) / TileSize ) - 1 );
+		for( int32 Edge = FirstEdge; Edge <= LastEdge; ++Edge )
+		{
+			const float Crossing = ( OriginPosition + Edge * TileSize - A ) / ( B - A );
+			if( Crossing > 0.0f && Crossing < 1.0f )
+			{
+				OutCrossings.Add( Crossing );
+			}
+		}
+	}
+};
+
+
+/** Cuts a road into pieces wherever it crosses from one tile into another.  Each place the road is cut gets a boundary
+    node ID, which is the same for the pieces on both sides. */
+static void SplitRoadIntoTiles( const FStreetMapRoad& Road, const int32 RoadIndex, const FStreetMapTileGrid& Grid, TArray<FTileRoadPiece>& OutPieces )
+{
+	// Boundary node IDs are unique to each road, and are numbered along it
+	int64 NextBoundaryNodeID = (int64)( RoadIndex + 1 ) << 24;
+
+	int32 PieceIndex = INDEX_NONE;
+	TArray<float, TInlineAllocator<16>> Crossings;
+	for( int32 PointIndex = 0; PointIndex < Road.RoadPoints.Num() - 1; ++PointIndex )
+	{
+		const FVector2D A = Road.RoadPoints[ PointIndex ];
+		const FVector2D B = Road.RoadPoints[ PointIndex + 1 ];
+
+		Crossings.Reset();
+		Crossings.Add( 0.0f );
+		Grid.AddTileEdgeCrossings( A.X, B.X, Grid.Origin.X, Grid.TileCountX, Crossings );
+		Grid.AddTileEdgeCrossings( A.Y, B.Y, Grid.Origin.Y, Grid.TileCountY, Crossings );
+		Crossings.Add( 1.0f );
+		Crossings.Sort();
+
+		for( int32 CrossingIndex = 0; CrossingIndex < Crossings.Num() - 1; ++CrossingIndex )
+		{
+			// Which tile is this stretch of the road in?  Testing the middle of it means we don't have to worry about
+			// which side of a tile edge the crossing point itself ended up on.
+			const float Start = Crossings[ CrossingIndex ];
+			const float End = Crossings[ CrossingIndex + 1 ];
+			const int32 TileIndex = Grid.GetTileIndex( FMath::Lerp( A, B, ( Start + End ) * 0.5f ) );
+			if( PieceIndex != INDEX_NONE && OutPieces[ PieceIndex ].TileIndex == TileIndex )
+			{
+				continue;
+			}
+
+			FTileRoadPoint FirstPoint;
+			if( PieceIndex == INDEX_NONE )
+			{
+				FirstPoint.Position = A;
+				FirstPoint.NodeIndex = Road.NodeIndices[ PointIndex ];
+				FirstPoint.BoundaryNodeID = 0;
+			}
+			else
+			{
+				// The road crosses into another tile here, so end the current piece
+				TArray<FTileRoadPoint>& PiecePoints = OutPieces[ PieceIndex ].Points;
+				if( Start > 0.0f )
+				{
+					FTileRoadPoint& CrossingPoint = PiecePoints[ PiecePoints.AddUninitialized() ];
+					CrossingPoint.Position = FMath::Lerp( A, B, Start );
+					CrossingPoint.NodeIndex = INDEX_NONE;
+				}
+				PiecePoints.Last().BoundaryNodeID = NextBoundaryNodeID++;
+				FirstPoint = PiecePoints.Last();
+			}
+
+			PieceIndex = OutPieces.AddDefaulted();
+			OutPieces[ PieceIndex ].TileIndex = TileIndex;
+			OutPieces[ PieceIndex ].RoadIndex = RoadIndex;
+			OutPieces[ PieceIndex ].Points.Add( FirstPoint );
+		}
+
+		FTileRoadPoint& EndPoint = OutPieces[ PieceIndex ].Points[ OutPieces[ PieceIndex ].Points.AddUninitialized() ];
+		EndPoint.Position = B;
+		EndPoint.NodeIndex = Road.NodeIndices[ PointIndex + 1 ];
+		EndPoint.BoundaryNodeID = 0;
+	}
+}
+
+
+/** Stores which nodes were welded onto which in a map's source data, sorted by the ID of the welded node */
+static void SetWeldedNodes( FStreetMapOSMSourceData& OSMSourceData, TMap<int64, int64>& WeldedOntoNodeIDs )
+{
+	WeldedOntoNodeIDs.KeySort( TLess<int64>() );
+	OSMSourceData.WeldedNodeIDs.Reset( WeldedOntoNodeIDs.Num() );
+	OSMSourceData.WeldedOntoNodeIDs.Reset( WeldedOntoNodeIDs.Num() );
+	for( const TPair<int64, int64>& WeldedNode : WeldedOntoNodeIDs )
+	{
+		OSMSourceData.WeldedNodeIDs.Add( WeldedNode.Key );
+		OSMSourceData.WeldedOntoNodeIDs.Add( WeldedNode.Value );
+	}
+}
+
+
+/** Looks up nodes in the OpenStreetMap files that a street map was made from, in the order they were loaded in (the file
+    it was imported from, then each change file that was applied to it since) so that later files win.  Nodes that a
+    change file deleted are forgotten again.  Files that no longer exist are skipped.  Returns how many of the nodes were
+    found. */
+static int32 LoadNodesFromSourceFiles( const TArray<FString>& SourceFilePaths, const FString& StreetMapName, const TArray<int64>& NodeIDs, TMap<int64, FOSMFile::FOSMCoordinate>& OutNodes, FFeedbackContext* FeedbackContext )
+{
+	for( const FString& SourceFilePath : SourceFilePaths )
+	{
+		if( !IFileManager::Get().FileExists( *SourceFilePath ) )
+		{
+			if( FeedbackContext != nullptr )
+			{
+				FeedbackContext->Logf(
+					ELogVerbosity::Warning,
+					TEXT( "Couldn't look up nodes in '%s', which street map '%s' was made from, because the file no longer exists." ),
+					*SourceFilePath,
+					*StreetMapName );
+			}
+			continue;
+		}
+
+		FOSMFile SourceFile;
+		SourceFile.NodeIDsToLoad = NodeIDs;
+		const bool bIsFilePathActuallyTextBuffer = false;
+		if( !SourceFile.LoadOpenStreetMapFile( SourceFilePath, bIsFilePathActuallyTextBuffer, FeedbackContext ) )
+		{
+			// Loading failed.  The actual error message will be sent to the FeedbackContext's log.
+			continue;
+		}
+
+		for( int32 SourceNodeIndex = 0; SourceNodeIndex < SourceFile.GetNodeCount(); ++SourceNodeIndex )
+		{
+			FOSMFile::FOSMCoordinate& Coordinate = OutNodes.FindOrAdd( SourceFile.GetNodeID( SourceNodeIndex ) );
+			Coordinate.Latitude = SourceFile.GetNodeLatitude( SourceNodeIndex );
+			Coordinate.Longitude = SourceFile.GetNodeLongitude( SourceNodeIndex );
+		}
+		for( const int64 DeletedNodeID : SourceFile.DeletedNodeIDs )
+		{
+			OutNodes.Remove( DeletedNodeID );
+		}
+	}
+
+	int32 FoundNodeCount = 0;
+	for( const int64 NodeID : NodeIDs )
+	{
+		if( OutNodes.Contains( NodeID ) )
+		{
+			++FoundNodeCount;
+		}
+	}
+	return FoundNodeCount;
+}
+
+
+/** Returns the folder that the tiles of a street map are kept in, next to the map itself */
+static FString GetTileFolder( const UStreetMap* StreetMap )
+{
+	return FPackageName::GetLongPackagePath( StreetMap->GetOutermost()->GetName() ) / ( StreetMap->GetName() + TEXT( "_Tiles" ) );
+}
+
+
+UStreetMapFactory::UStreetMapFactory(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	SupportedClass = UStreetMap::StaticClass();
+
+	Formats.Add( TEXT( "osm;OpenStreetMap XML" ) );
+	Formats.Add( TEXT( "pbf;OpenStreetMap PBF" ) );
+	Formats.Add( TEXT( "gz;OpenStreetMap XML (gzip compressed)" ) );
+	bCreateNew = false;
+	bEditorImport = true;
+	bEditAfterNew = false;
+	bText = true;
+	bUseImportCache = true;
+}
+
+
+UObject* UStreetMapFactory::FactoryCreateFile( UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, const FString& Filename, const TCHAR* Parms, FFeedbackContext* Warn, bool& bOutOperationCanceled )
+{
+	UStreetMap* StreetMap = NewObject<UStreetMap>( InParent, InName, Flags | RF_Transactional );
+
+	StreetMap->AssetImportData->Update( Filename );
+
+	// We parse straight out of the file rather than letting UFactory load the whole thing into a string for us.  That
+	// keeps our memory usage down to roughly the size of the parsed map, and allows files larger than 2 GB.
+	const bool bIsFilePathActuallyTextBuffer = false;
+	const bool bLoadedOkay = LoadFromOpenStreetMapXMLFile( StreetMap, Filename, bIsFilePathActuallyTextBuffer, Warn );
+
+	if( !bLoadedOkay )
+	{
+		StreetMap->MarkPendingKill();
+		StreetMap = nullptr;
+	}
+
+	return StreetMap;
+}
+
+
+UObject* UStreetMapFactory::FactoryCreateText( UClass* Class, UObject* Parent, FName Name, EObjectFlags Flags, UObject* Context, const TCHAR* Type, const TCHAR*& Buffer, const TCHAR* BufferEnd, FFeedbackContext* Warn )
+{
+	UStreetMap* StreetMap = NewObject<UStreetMap>( Parent, Name, Flags | RF_Transactional );
+
+	StreetMap->AssetImportData->Update( this->GetCurrentFilename() );
+
+	// NOTE: Imports from disk go through FactoryCreateFile() instead.  This is only used when we're handed text directly.
+	const int32 CharacterCount = BufferEnd - Buffer;
+	const FString TextBuffer( CharacterCount, Buffer );
+
+	const bool bIsFilePathActuallyTextBuffer = true;
+	const bool bLoadedOkay = LoadFromOpenStreetMapXMLFile( StreetMap, TextBuffer, bIsFilePathActuallyTextBuffer, Warn );
+
+	if( !bLoadedOkay )
+	{
+		StreetMap->MarkPendingKill();
+		StreetMap = nullptr;
+	}
+
+	return StreetMap;
+}
+
+
+FVector2D UStreetMapFactory::ConvertLatLongToMapPosition( const double Latitude, const double Longitude, const double OriginLatitude, const double OriginLongitude )
+{
+	// Converts latitude to meters
+	auto ConvertLatitudeToMeters = []( const double InLatitude ) -> double
+	{
+		return -InLatitude * LatitudeLongitudeScale;
+	};
+
+	// Converts longitude to meters
+	auto ConvertLongitudeToMeters = []( const double InLongitude, const double InLatitude ) -> double
+	{
+		return InLongitude * LatitudeLongitudeScale * FMath::Cos( FMath::DegreesToRadians( InLatitude ) );
+	};
+
+	// Applies Sanson-Flamsteed (sinusoidal) Projection (see http://www.progonos.com/furuti/MapProj/Normal/CartHow/HowSanson/howSanson.html)
+	return FVector2D(
+		(float)( ConvertLongitudeToMeters( Longitude, Latitude ) - ConvertLongitudeToMeters( OriginLongitude, Latitude ) ),
+		(float)( ConvertLatitudeToMeters( Latitude ) - ConvertLatitudeToMeters( OriginLatitude ) ) ) * OSMToCentimetersScaleFactor;
+}
+
+
+FString UStreetMapFactory::GetImportCacheKey( const FString& OSMFilePath ) const
+{
+	const FMD5Hash FileHash = FMD5Hash::HashFile( *OSMFilePath );
+	if( !FileHash.IsValid() )
+	{
+		return FString();
+	}
+
+	TArray<uint8> OptionsData;
+	FMemoryWriter OptionsWriter( OptionsData );
+	FStreetMapImportOptions::StaticStruct()->SerializeItem( OptionsWriter, const_cast<FStreetMapImportOptions*>( &ImportOptions ), nullptr );
+	uint8 OptionsHash[ 20 ];
+	FSHA1::HashBuffer( OptionsData.GetData(), OptionsData.Num(), OptionsHash );
+
+	const FString KeySuffix = LexToString( FileHash ) + TEXT( "_" ) + BytesToHex( OptionsHash, 20 );
+	return FDerivedDataCacheInterface::BuildCacheKey( TEXT( "STREETMAP" ), ImportCacheVersion, *KeySuffix );
+}
+
+
+void UStreetMapFactory::SerializeImportCacheData( FArchive& Ar, UStreetMap* StreetMap )
+{
+	SerializeStructArray( Ar, StreetMap->Roads );
+	SerializeStructArray( Ar, StreetMap->Nodes );
+	SerializeStructArray( Ar, StreetMap->Buildings );
+	Ar << StreetMap->BoundsMin;
+	Ar << StreetMap->BoundsMax;
+	FStreetMapOSMSourceData::StaticStruct()->SerializeItem( Ar, &StreetMap->OSMSourceData, nullptr );
+}
+
+
+bool UStreetMapFactory::LoadFromOpenStreetMapXMLFile( UStreetMap* StreetMap, const FString& OSMFilePath, const bool bIsFilePathActuallyTextBuffer, FFeedbackContext* FeedbackContext )
+{
+	StreetMap->ImportOptions = ImportOptions;
+
+	// A full import starts over, so none of the change files applied since the last one are part of the map any more
+	StreetMap->AppliedChangeFiles.Reset();
+
+	// Measure every phase of the import, so that we can report where the time and memory went once it's done
+	FStreetMapImportProfiler Profiler;
+	const FString ProfileSourceName = bIsFilePathActuallyTextBuffer ? FString( TEXT( "(text buffer)" ) ) : OSMFilePath;
+
+	// If we've imported this exact file with the same options before, we can skip straight to the result
+	const FString CacheKey = ( bIsFilePathActuallyTextBuffer || !bUseImportCache ) ? FString() : GetImportCacheKey( OSMFilePath );
+	if( !CacheKey.IsEmpty() )
+	{
+		bool bLoadedFromCache = false;
+		{
+			FStreetMapImportProfiler::FScopedPhase Phase( &Profiler, TEXT( "Derived data cache lookup" ), GET_STATID( STAT_StreetMapImport_CacheLookup ) );
+			TArray<uint8> CachedData;
+			if( GetDerivedDataCacheRef().GetSynchronous( *CacheKey, CachedData ) )
+			{
+				FMemoryReader CacheReader( CachedData, true );
+				SerializeImportCacheData( CacheReader, StreetMap );
+				bLoadedFromCache = !CacheReader.IsError();
+				if( !bLoadedFromCache )
+				{
+					// Couldn't read what was cached, so import the file like usual
+					StreetMap->Roads.Empty();
+					StreetMap->Nodes.Empty();
+					StreetMap->Buildings.Empty();
+					StreetMap->OSMSourceData = FStreetMapOSMSourceData();
+				}
+			}
+			Phase.SetByteCount( CachedData.Num() );
+		}
+
+		if( bLoadedFromCache )
+		{
+			if( FeedbackContext != nullptr )
+			{
+				FeedbackContext->Logf( ELogVerbosity::Log, TEXT( "Loaded street map '%s' from the derived data cache" ), *StreetMap->GetName() );
+			}
+			StreetMap->BuildCachedRoadData();
+			const bool bSucceeded = !ImportOptions.bSplitIntoTiles || SplitStreetMapIntoTiles( StreetMap, FeedbackContext, &Profiler );
+			StreetMap->CompactGeometry();
+			Profiler.Report( StreetMap->GetPathName(), ProfileSourceName, FeedbackContext );
+			return bSucceeded;
+		}
+	}
+
+	// Load up the OSM file.  We only keep the ways that will become roads or buildings, so that we don't waste memory
+	// on the rest.
+	FOSMTagFilter TagFilter;
+	CompileTagFilter( ImportOptions.TagFilterRules, TagFilter );
+	FOSMFile OSMFile;
+	OSMFile.TagFilter = &TagFilter;
+	OSMFile.WayFilter = [this]( const FOSMFile::FOSMWayInfo& OSMWay )
+	{
+		return ShouldImportWay( OSMWay, ImportOptions.TagFilterRules );
+	};
+	OSMFile.bOnlyLoadReferencedNodes = ImportOptions.bPruneUnreferencedNodes;
+	OSMFile.Profiler = &Profiler;
+	OSMFile.WeldDistance = ImportOptions.WeldTolerance / OSMToCentimetersScaleFactor;
+	if( ImportOptions.bClipToRegion )
+	{
+		if( ImportOptions.ClipPolygon.Num() > 0 )
+		{
+			for( const FVector2D& ClipPoint : ImportOptions.ClipPolygon )
+			{
+				OSMFile.ClipRegion.Add( { ClipPoint.Y, ClipPoint.X } );
+			}
+		}
+		else
+		{
+			OSMFile.ClipRegion.Add( { ImportOptions.ClipMinLatitude, ImportOptions.ClipMinLongitude } );
+			OSMFile.ClipRegion.Add( { ImportOptions.ClipMinLatitude, ImportOptions.ClipMaxLongitude } );
+			OSMFile.ClipRegion.Add( { ImportOptions.ClipMaxLatitude, ImportOptions.ClipMaxLongitude } );
+			OSMFile.ClipRegion.Add( { ImportOptions.ClipMaxLatitude, ImportOptions.ClipMinLongitude } );
+		}
+		OSMFile.ClipMargin = ImportOptions.ClipMargin;
+	}
+	if( !OSMFile.LoadOpenStreetMapFile( OSMFilePath, bIsFilePathActuallyTextBuffer, FeedbackContext ) )
+	{
+		// Loading failed.  The actual error message will be sent to the FeedbackContext's log.
+		return false;
+	}
+
+	// @todo: The loaded OSMFile stores data in double precision, but our runtime representation (UStreetMap)
+	//        truncates everything to single precision, after transposing coordinates to be relative to the
+	//        center of the map's 2D bounds.  Large maps will suffer from floating point precision issues.
+	//        To solve this we'd need to either store everything in double precision, or store map elements
+	//        in integral grid cells with coordinates relative to their cell.  Of course, there will be many
+	//        other considerations for handling huge maps (loading, rendering, collision, etc.)
+
+	// Maps each OSM way to the RoadIndex we created for that way, or INDEX_NONE if we didn't make a road for it
+	TArray<int32> OSMWayToRoadIndex;
+	OSMWayToRoadIndex.Init( INDEX_NONE, OSMFile.Ways.Num() );
+
+	StreetMap->BoundsMin = FVector2D( TNumericLimits<float>::Max(), TNumericLimits<float>::Max() );
+	StreetMap->BoundsMax = FVector2D( TNumericLimits<float>::Lowest(), TNumericLimits<float>::Lowest() );
+
+	// All points are transformed relative to the center of the map, so that we get as much precision as possible.  When
+	// we've clipped the map to a region, that's the center of the region, otherwise it's the average of all the nodes.
+	double MapCenterLatitude = OSMFile.AverageLatitude;
+	double MapCenterLongitude = OSMFile.AverageLongitude;
+	if( OSMFile.ClipRegion.Num() > 0 )
+	{
+		double RegionMinLatitude = MAX_dbl, RegionMinLongitude = MAX_dbl;
+		double RegionMaxLatitude = -MAX_dbl, RegionMaxLongitude = -MAX_dbl;
+		for( const FOSMFile::FOSMCoordinate& Coordinate : OSMFile.ClipRegion )
+		{
+			RegionMinLatitude = FMath::Min( RegionMinLatitude, Coordinate.Latitude );
+			RegionMinLongitude = FMath::Min( RegionMinLongitude, Coordinate.Longitude );
+			RegionMaxLatitude = FMath::Max( RegionMaxLatitude, Coordinate.Latitude );
+			RegionMaxLongitude = FMath::Max( RegionMaxLongitude, Coordinate.Longitude );
+		}
+		MapCenterLatitude = ( RegionMinLatitude + RegionMaxLatitude ) * 0.5;
+		MapCenterLongitude = ( RegionMinLongitude + RegionMaxLongitude ) * 0.5;
+	}
+
+	// Flatten every node into our map's space up front, so that nodes shared by several ways are only projected once.
+	TArray<FVector2D> NodePositions;
+	NodePositions.SetNumUninitialized( OSMFile.GetNodeCount() );
+	{
+		FStreetMapImportProfiler::FScopedPhase Phase( &Profiler, TEXT( "Project nodes" ), GET_STATID( STAT_StreetMapImport_ProjectNodes ) );
+		Phase.SetItemCount( OSMFile.GetNodeCount(), TEXT( "nodes" ) );
+		ParallelFor( FMath::DivideAndRoundUp( OSMFile.GetNodeCount(), ConversionChunkSize ), [&]( const int32 ChunkIndex )
+		{
+			const int32 ChunkEnd = FMath::Min( ( ChunkIndex + 1 ) * ConversionChunkSize, OSMFile.GetNodeCount() );
+			for( int32 OSMNodeIndex = ChunkIndex * ConversionChunkSize; OSMNodeIndex < ChunkEnd; ++OSMNodeIndex )
+			{
+				// Nodes that aren't on any of our ways will never be looked at
+				if( OSMFile.GetNodeWayRefs( OSMNodeIndex ).Num() == 0 )
+				{
+					continue;
+				}
+
+				NodePositions[ OSMNodeIndex ] = ConvertLatLongToMapPosition(
+					OSMFile.GetNodeLatitude( OSMNodeIndex ),
+					OSMFile.GetNodeLongitude( OSMNodeIndex ),
+					MapCenterLatitude,
+					MapCenterLongitude );
+			}
+		} );
+	}
+
+	// Which OSM way each road and building came from, and which OSM node each building point came from
+	TArray<int32> RoadOSMWayIndices;
+	TArray<int32> BuildingOSMWayIndices;
+	TArray<int32> BuildingPointOSMNodeIndices;
+
+	// How far simplified roads and buildings may stray from their original shape, or zero to leave them alone
+	const float SimplifyTolerance = ImportOptions.bSimplifyLines ? ImportOptions.SimplifyTolerance : 0.0f;
+	int32 RemovedBuildingPointCount = 0;
+
+	{
+		FStreetMapImportProfiler::FScopedPhase Phase( &Profiler, TEXT( "Convert ways" ), GET_STATID( STAT_StreetMapImport_ConvertWays ) );
+		Phase.SetItemCount( OSMFile.Ways.Num(), TEXT( "ways" ) );
+
+		// Convert the ways in parallel.  Each chunk of ways gets its own output, and the chunks are stitched together in order
+		// afterwards, so we end up with exactly the same roads and buildings (in the same order) as converting them one by one.
+		struct FConvertedWayChunk
+		{
+			TArray<FStreetMapRoad> Roads;
+			TArray<int32> RoadOSMWayIndices;
+			TArray<FStreetMapBuilding> Buildings;
+			TArray<int32> BuildingOSMWayIndices;
+			TArray<int32> BuildingPointOSMNodeIndices;
+			int32 RemovedBuildingPointCount = 0;
+			FVector2D BoundsMin;
+			FVector2D BoundsMax;
+		};
+		TArray<FConvertedWayChunk> ConvertedWayChunks;
+		ConvertedWayChunks.SetNum( FMath::DivideAndRoundUp( OSMFile.Ways.Num(), ConversionChunkSize ) );
+		ParallelFor( ConvertedWayChunks.Num(), [&]( const int32 ChunkIndex )
+		{
+			FConvertedWayChunk& Chunk = ConvertedWayChunks[ ChunkIndex ];
+			Chunk.BoundsMin = StreetMap->BoundsMin;
+			Chunk.BoundsMax = StreetMap->BoundsMax;
+
+			const int32 ChunkEnd = FMath::Min( ( ChunkIndex + 1 ) * ConversionChunkSize, OSMFile.Ways.Num() );
+			for( int32 OSMWayIndex = ChunkIndex * ConversionChunkSize; OSMWayIndex < ChunkEnd; ++OSMWayIndex )
+			{
+				const FOSMFile::FOSMWayInfo* OSMWay = OSMFile.Ways[ OSMWayIndex ];
+
+				// Handle buildings differently than roads
+				if( OSMWay->WayType == FOSMFile::EOSMWayType::Building )
+				{
+					if( AddBuildingForWay( OSMFile, NodePositions, *OSMWay, SimplifyTolerance, Chunk.Buildings, Chunk.BuildingPointOSMNodeIndices, Chunk.RemovedBuildingPointCount, Chunk.BoundsMin, Chunk.BoundsMax ) )
+					{
+						Chunk.BuildingOSMWayIndices.Add( OSMWayIndex );
+					}
+				}
+				else
+				{
+					if( AddRoadForWay( OSMFile, NodePositions, *OSMWay, ImportOptions.TagFilterRules, Chunk.Roads, Chunk.BoundsMin, Chunk.BoundsMax ) )
+					{
+						Chunk.RoadOSMWayIndices.Add( OSMWayIndex );
+					}
+				}
+			}
+		} );
+
+		int32 TotalRoadCount = 0;
+		int32 TotalBuildingCount = 0;
+		for( const FConvertedWayChunk& Chunk : ConvertedWayChunks )
+		{
+			TotalRoadCount += Chunk.Roads.Num();
+			TotalBuildingCount += Chunk.Buildings.Num();
+			RemovedBuildingPointCount += Chunk.RemovedBuildingPointCount;
+		}
+		StreetMap->Roads.Reserve( TotalRoadCount );
+		StreetMap->Buildings.Reserve( TotalBuildingCount );
+
+		RoadOSMWayIndices.Reserve( TotalRoadCount );
+		BuildingOSMWayIndices.Reserve( TotalBuildingCount );
+
+		for( FConvertedWayChunk& Chunk : ConvertedWayChunks )
+		{
+			for( int32 ChunkRoadIndex = 0; ChunkRoadIndex < Chunk.Roads.Num(); ++ChunkRoadIndex )
+			{
+				OSMWayToRoadIndex[ Chunk.RoadOSMWayIndices[ ChunkRoadIndex ] ] = StreetMap->Roads.Num() + ChunkRoadIndex;
+			}
+			RoadOSMWayIndices.Append( Chunk.RoadOSMWayIndices );
+			BuildingOSMWayIndices.Append( Chunk.BuildingOSMWayIndices );
+			BuildingPointOSMNodeIndices.Append( Chunk.BuildingPointOSMNodeIndices );
+			StreetMap->Roads.Append( MoveTemp( Chunk.Roads ) );
+			StreetMap->Buildings.Append( MoveTemp( Chunk.Buildings ) );
+
+			StreetMap->BoundsMin.X = FMath::Min( StreetMap->BoundsMin.X, Chunk.BoundsMin.X );
+			StreetMap->BoundsMin.Y = FMath::Min( StreetMap->BoundsMin.Y, Chunk.BoundsMin.Y );
+			StreetMap->BoundsMax.X = FMath::Max( StreetMap->BoundsMax.X, Chunk.BoundsMax.X );
+			StreetMap->BoundsMax.Y = FMath::Max( StreetMap->BoundsMax.Y, Chunk.BoundsMax.Y );
+		}
+		ConvertedWayChunks.Empty();
+	}
+
+	// Remember which OpenStreetMap nodes and ways everything came from, so that osmChange files can be applied later on
+	FStreetMapOSMSourceData& OSMSourceData = StreetMap->OSMSourceData;
+	OSMSourceData = FStreetMapOSMSourceData();
+	OSMSourceData.OriginLatitude = MapCenterLatitude;
+	OSMSourceData.OriginLongitude = MapCenterLongitude;
+	{
+		FStreetMapImportProfiler::FScopedPhase Phase( &Profiler, TEXT( "Record source data" ), GET_STATID( STAT_StreetMapImport_RecordSourceData ) );
+
+		TBitArray<> IsNodeUsed( false, OSMFile.GetNodeCount() );
+
+		OSMSourceData.RoadWayIDs.Reserve( StreetMap->Roads.Num() );
+		for( int32 RoadIndex = 0; RoadIndex < StreetMap->Roads.Num(); ++RoadIndex )
+		{
+			const FOSMFile::FOSMWayInfo& OSMWay = *OSMFile.Ways[ RoadOSMWayIndices[ RoadIndex ] ];
+			OSMSourceData.RoadWayIDs.Add( OSMWay.ID );
+			for( const int32 OSMNodeIndex : OSMFile.GetUnweldedWayNodes( OSMWay ) )
+			{
+				OSMSourceData.RoadPointNodeIDs.Add( OSMFile.GetNodeID( OSMNodeIndex ) );
+				IsNodeUsed[ OSMNodeIndex ] = true;
+			}
+		}
+
+		OSMSourceData.BuildingWayIDs.Reserve( StreetMap->Buildings.Num() );
+		for( int32 BuildingIndex = 0; BuildingIndex < StreetMap->Buildings.Num(); ++BuildingIndex )
+		{
+			const FOSMFile::FOSMWayInfo& OSMWay = *OSMFile.Ways[ BuildingOSMWayIndices[ BuildingIndex ] ];
+			OSMSourceData.BuildingWayIDs.Add( OSMWay.ID );
+		}
+
+		OSMSourceData.BuildingPointNodeIDs.Reserve( BuildingPointOSMNodeIndices.Num() );
+		for( const int32 OSMNodeIndex : BuildingPointOSMNodeIndices )
+		{
+			OSMSourceData.BuildingPointNodeIDs.Add( OSMFile.GetNodeID( OSMNodeIndex ) );
+			IsNodeUsed[ OSMNodeIndex ] = true;
+		}
+
+		// Remember which nodes were welded onto which, so that changes to either of them can be applied later
+		if( OSMFile.GetWeldedNodeCount() > 0 )
+		{
+			TMap<int64, int64> WeldedOntoNodeIDs;
+			auto AddWeldedNodes = [&]( const FOSMFile::FOSMWayInfo& OSMWay )
+			{
+				const TArrayView<const int32> WayNodes = OSMFile.GetWayNodes( OSMWay );
+				const TArrayView<const int32> UnweldedWayNodes = OSMFile.GetUnweldedWayNodes( OSMWay );
+				for( int32 WayNodeIndex = 0; WayNodeIndex < WayNodes.Num(); ++WayNodeIndex )
+				{
+					if( UnweldedWayNodes[ WayNodeIndex ] != WayNodes[ WayNodeIndex ] )
+					{
+						WeldedOntoNodeIDs.Add( OSMFile.GetNodeID( UnweldedWayNodes[ WayNodeIndex ] ), OSMFile.GetNodeID( WayNodes[ WayNodeIndex ] ) );
+						IsNodeUsed[ WayNodes[ WayNodeIndex ] ] = true;
+					}
+				}
+			};
+			for( const int32 OSMWayIndex : RoadOSMWayIndices )
+			{
+				AddWeldedNodes( *OSMFile.Ways[ OSMWayIndex ] );
+			}
+			for( const int32 OSMWayIndex : BuildingOSMWayIndices )
+			{
+				AddWeldedNodes( *OSMFile.Ways[ OSMWayIndex ] );
+			}
+			SetWeldedNodes( OSMSourceData, WeldedOntoNodeIDs );
+		}
+
+		for( int32 OSMNodeIndex = 0; OSMNodeIndex < OSMFile.GetNodeCount(); ++OSMNodeIndex )
+		{
+			if( IsNodeUsed[ OSMNodeIndex ] )
+			{
+				OSMSourceData.NodeIDs.Add( OSMFile.GetNodeID( OSMNodeIndex ) );
+				OSMSourceData.NodeLatitudes.Add( (int32)FMath::FloorToDouble( OSMFile.GetNodeLatitude( OSMNodeIndex ) * SourceCoordinateScale + 0.5 ) );
+				OSMSourceData.NodeLongitudes.Add( (int32)FMath::FloorToDouble( OSMFile.GetNodeLongitude( OSMNodeIndex ) * SourceCoordinateScale + 0.5 ) );
+			}
+		}
+		Phase.SetItemCount( OSMSourceData.NodeIDs.Num(), TEXT( "nodes" ) );
+	}
+
+	{
+		FStreetMapImportProfiler::FScopedPhase Phase( &Profiler, TEXT( "Build map nodes" ), GET_STATID( STAT_StreetMapImport_BuildMapNodes ) );
+
+		for( int32 OSMNodeIndex = 0; OSMNodeIndex < OSMFile.GetNodeCount(); ++OSMNodeIndex )
+		{
+			const TArrayView<const FOSMFile::FOSMWayRef> OSMWayRefs = OSMFile.GetNodeWayRefs( OSMNodeIndex );
+
+			// Any ways touching this node?
+			if( OSMWayRefs.Num() > 0 )
+			{
+				FStreetMapNode NewNode;
+
+				for( const FOSMFile::FOSMWayRef& OSMWayRef : OSMWayRefs )
+				{
+					const int32 FoundRoadIndex = OSMWayToRoadIndex[ OSMWayRef.WayIndex ];
+					if( FoundRoadIndex != INDEX_NONE )
+					{
+						FStreetMapRoadRef RoadRef;
+						RoadRef.RoadIndex = FoundRoadIndex;
+
+						const int32 RoadPointIndex = OSMWayRef.NodeIndex;
+						RoadRef.RoadPointIndex = RoadPointIndex;
+						NewNode.RoadRefs.Add( RoadRef );
+					}
+					else
+					{
+						// Skipped ref because we didn't keep this road in our data set							
+					}
+				}
+
+				// Only store nodes that are attached to at least one road.  We must have at least a connection to a single
+				// road, otherwise we've filtered this node's road out and there's no point in wasting memory on the node itself.
+				if( NewNode.RoadRefs.Num() > 0 )
+				{
+					// Most nodes from OpenStreetMap will only be touching a single road.  These nodes usually make up the points
+					// along the length of the road, even for roads with no intersections except at the beginning and end.  We
+					// don't need to store these points unless they are at the ends of the road.  Keeping the points at the
+					// beginning and end of the road is useful when calculating navigation data, but the other nodes can go!
+					// In the road's NodeIndices array, any nodes we filter out here will simply have an INDEX_NONE value in that
+					// array, and we'll only store the positions of the road at these points in the road's RoadPoints array.
+
+					const FStreetMapRoadRef& FirstRoadRef = NewNode.RoadRefs[ 0 ];
+					const FStreetMapRoad& FirstRoad = StreetMap->Roads[ FirstRoadRef.RoadIndex ];
+
+					if( NewNode.RoadRefs.Num() > 1 ||					// Does the node connect to more than one road?
+						FirstRoadRef.RoadPointIndex == 0 ||				// Does the node connect to the beginning of the road?
+						FirstRoadRef.RoadPointIndex == ( FirstRoad.NodeIndices.Num() - 1 ) )	// Does the node connect to the end of the road?
+					{
+						const int32 NewNodeIndex = StreetMap->Nodes.Num();
+						StreetMap->Nodes.Add( NewNode );
+						OSMSourceData.MapNodeIDs.Add( OSMFile.GetNodeID( OSMNodeIndex ) );
+
+						// Update the roads that are overlapping this node
+						for( const FStreetMapRoadRef& RoadRef : NewNode.RoadRefs )
+						{
+							FStreetMapRoad& Road = StreetMap->Roads[ RoadRef.RoadIndex ];
+							check( Road.NodeIndices[ RoadRef.RoadPointIndex ] == INDEX_NONE );
+							Road.NodeIndices[ RoadRef.RoadPointIndex ] = NewNodeIndex;
+						}
+					}
+					else
+					{
+						// Node has only one road that is references, and it wasn't the beginning or end of the road, so filter it out!
+					}
+				}
+				else
+				{
+					// Node doesn't reference any roads that we kept, or the data was malformed.  Filter it out.
+				}
+			}
+		}
+		Phase.SetItemCount( StreetMap->Nodes.Num(), TEXT( "map nodes" ) );
+	}
+
+	// Join up roads that were split into several ways for no reason we keep, now that we know which nodes connect them
+	if( ImportOptions.bMergeRoadChains )
+	{
+		FStreetMapImportProfiler::FScopedPhase Phase( &Profiler, TEXT( "Merge road chains" ), GET_STATID( STAT_StreetMapImport_MergeRoadChains ) );
+
+		const int32 RoadCount = StreetMap->Roads.Num();
+		const int32 NodeCount = StreetMap->Nodes.Num();
+		Phase.SetItemCount( RoadCount, TEXT( "roads" ) );
+		MergeRoadChains( StreetMap->Roads, StreetMap->Nodes, OSMSourceData );
+
+		if( FeedbackContext != nullptr )
+		{
+			FeedbackContext->Logf(
+				ELogVerbosity::Log,
+				TEXT( "Merged %i roads into %i, removing %i map nodes" ),
+				RoadCount,
+				StreetMap->Roads.Num(),
+				NodeCount - StreetMap->Nodes.Num() );
+		}
+	}
+
+	// Now that we know which points have map nodes, we know which ones we're allowed to remove
+	if( SimplifyTolerance > 0.0f )
+	{
+		FStreetMapImportProfiler::FScopedPhase Phase( &Profiler, TEXT( "Simplify roads" ), GET_STATID( STAT_StreetMapImport_SimplifyRoads ) );
+
+		const int32 RoadPointCount = OSMSourceData.RoadPointNodeIDs.Num();
+		Phase.SetItemCount( RoadPointCount, TEXT( "road points" ) );
+		const int32 RemovedRoadPointCount = SimplifyRoads( StreetMap->Roads, StreetMap->Nodes, OSMSourceData.RoadPointNodeIDs, 0, SimplifyTolerance );
+
+		if( FeedbackContext != nullptr )
+		{
+			const int32 BuildingPointCount = BuildingPointOSMNodeIndices.Num() + RemovedBuildingPointCount;
+			FeedbackContext->Logf(
+				ELogVerbosity::Log,
+				TEXT( "Simplified roads and buildings to within %.0f cm: removed %i of %i road points (%.1f%%) and %i of %i building points (%.1f%%)" ),
+				SimplifyTolerance,
+				RemovedRoadPointCount,
+				RoadPointCount,
+				RoadPointCount > 0 ? 100.0 * RemovedRoadPointCount / RoadPointCount : 0.0,
+				RemovedBuildingPointCount,
+				BuildingPointCount,
+				BuildingPointCount > 0 ? 100.0 * RemovedBuildingPointCount / BuildingPointCount : 0.0 );
+		}
+	}
+
+	// Validation test: Make sure that all roads have at least two nodes referencing them, one at the beginning and
+	// one at the end.
+	{
+		FStreetMapImportProfiler::FScopedPhase Phase( &Profiler, TEXT( "Validate roads" ), GET_STATID( STAT_StreetMapImport_ValidateRoads ) );
+		Phase.SetItemCount( StreetMap->Roads.Num(), TEXT( "roads" ) );
+		for( const FStreetMapRoad& Road : StreetMap->Roads )
+		{
+			const bool bHasNodeAtBeginning = Road.NodeIndices[ 0 ] != INDEX_NONE;
+			const bool bHasNodeAtEnd = Road.NodeIndices[ Road.NodeIndices.Num() - 1 ] != INDEX_NONE;
+
+			// All roads should have at least two nodes referencing them, one at the beginning and one at the end
+			ensure( bHasNodeAtBeginning && bHasNodeAtEnd );
+		}
+	}
+
+	// Remember the result, so that importing the same file with the same options again is as quick as loading it
+	if( !CacheKey.IsEmpty() )
+	{
+		FStreetMapImportProfiler::FScopedPhase Phase( &Profiler, TEXT( "Derived data cache store" ), GET_STATID( STAT_StreetMapImport_CacheStore ) );
+		TArray<uint8> CachedData;
+		FMemoryWriter CacheWriter( CachedData, true );
+		SerializeImportCacheData( CacheWriter, StreetMap );
+		GetDerivedDataCacheRef().Put( *CacheKey, CachedData );
+		Phase.SetByteCount( CachedData.Num() );
+	}
+
+	StreetMap->BuildCachedRoadData();
+	const bool bSucceeded = !ImportOptions.bSplitIntoTiles || SplitStreetMapIntoTiles( StreetMap, FeedbackContext, &Profiler );
+
+	// Everything above works on the roads' and buildings' own arrays.  Now that we're done changing them, they can go
+	// into the map's pools.
+	StreetMap->CompactGeometry();
+	Profiler.Report( StreetMap->GetPathName(), ProfileSourceName, FeedbackContext );
+	return bSucceeded;
+}
+
+
+bool UStreetMapFactory::SplitStreetMapIntoTiles( UStreetMap* StreetMap, FFeedbackContext* FeedbackContext, FStreetMapImportProfiler* Profiler )
+{
+	FStreetMapImportProfiler::FScopedPhase Phase( Profiler, TEXT( "Split into tiles" ), GET_STATID( STAT_StreetMapImport_SplitIntoTiles ) );
+	Phase.SetItemCount( StreetMap->Roads.Num(), TEXT( "roads" ) );
+	const double StartTime = FPlatformTime::Seconds();
+
+	FStreetMapTileGrid Grid;
+	Grid.Origin = StreetMap->BoundsMin;
+	Grid.TileSize = FMath::Max( ImportOptions.TileSize, 1.0f ) * OSMToCentimetersScaleFactor;
+	Grid.TileCountX = FMath::Max( 1, FMath::CeilToInt( ( StreetMap->BoundsMax.X - StreetMap->BoundsMin.X ) / Grid.TileSize ) );
+	Grid.TileCountY = FMath::Max( 1, FMath::CeilToInt( ( StreetMap->BoundsMax.Y - StreetMap->BoundsMin.Y ) / Grid.TileSize ) );
+	const int32 TileCount = Grid.TileCountX * Grid.TileCountY;
+
+	// The tiles are cut from the roads' and buildings' own arrays, which are empty once the map has been compacted (as
+	// it is by the time the import commandlet splits it)
+	StreetMap->ExpandGeometry();
+
+	// Cut the roads up at the tile edges in parallel, then sort the pieces into their tiles (in road order, so that
+	// the tiles come out the same every time)
+	const TArray<FStreetMapRoad>& Roads = StreetMap->Roads;
+	TArray<TArray<FTileRoadPiece>> RoadPieceChunks;
+	RoadPieceChunks.SetNum( FMath::DivideAndRoundUp( Roads.Num(), ConversionChunkSize ) );
+	ParallelFor( RoadPieceChunks.Num(), [&]( const int32 ChunkIndex )
+	{
+		const int32 ChunkEnd = FMath::Min( ( ChunkIndex + 1 ) * ConversionChunkSize, Roads.Num() );
+		for( int32 RoadIndex = ChunkIndex * ConversionChunkSize; RoadIndex < ChunkEnd; ++RoadIndex )
+		{
+			SplitRoadIntoTiles( Roads[ RoadIndex ], RoadIndex, Grid, RoadPieceChunks[ ChunkIndex ] );
+		}
+	} );
+
+	TArray<TArray<const FTileRoadPiece*>> TileRoadPieces;
+	TileRoadPieces.SetNum( TileCount );
+	for( const TArray<FTileRoadPiece>& RoadPieces : RoadPieceChunks )
+	{
+		for( const FTileRoadPiece& RoadPiece : RoadPieces )
+		{
+			TileRoadPieces[ RoadPiece.TileIndex ].Add( &RoadPiece );
+		}
+	}
+
+	// Buildings aren't cut up.  They go in whichever tile the middle of the building is in.
+	TArray<TArray<int32>> TileBuildingIndices;
+	TileBuildingIndices.SetNum( TileCount );
+	for( int32 BuildingIndex = 0; BuildingIndex < StreetMap->Buildings.Num(); ++BuildingIndex )
+	{
+		const FStreetMapBuilding& Building = StreetMap->Buildings[ BuildingIndex ];
+		TileBuildingIndices[ Grid.GetTileIndex( ( Building.BoundsMin + Building.BoundsMax ) * 0.5f ) ].Add( BuildingIndex );
+	}
+
+	// Build all of the tiles in parallel
+	struct FTileContents
+	{
+		TArray<FStreetMapRoad> Roads;
+		TArray<FStreetMapNode> Nodes;
+		TArray<FStreetMapBuilding> Buildings;
+		TArray<FStreetMapBoundaryNode> BoundaryNodes;
+		FVector2D BoundsMin;
+		FVector2D BoundsMax;
+	};
+	TArray<FTileContents> Tiles;
+	Tiles.SetNum( TileCount );
+	ParallelFor( TileCount, [&]( const int32 TileIndex )
+	{
+		FTileContents& Tile = Tiles[ TileIndex ];
+		Tile.BoundsMin = FVector2D( TNumericLimits<float>::Max(), TNumericLimits<float>::Max() );
+		Tile.BoundsMax = FVector2D( TNumericLimits<float>::Lowest(), TNumericLimits<float>::Lowest() );
+
+		// Nodes are found by their index in the map we're splitting up.  Points where a road was cut at a tile edge
+		// don't have one of those, so they're found by their (negated) boundary node ID instead.
+		TMap<int64, int32> TileNodeIndices;
+
+		Tile.Roads.Reserve( TileRoadPieces[ TileIndex ].Num() );
+		for( const FTileRoadPiece* RoadPiece : TileRoadPieces[ TileIndex ] )
+		{
+			const FStreetMapRoad& Road = Roads[ RoadPiece->RoadIndex ];
+			const int32 TileRoadIndex = Tile.Roads.Num();
+			FStreetMapRoad& NewRoad = *new( Tile.Roads )FStreetMapRoad();
+			NewRoad.RoadName = Road.RoadName;
+			NewRoad.RoadType = Road.RoadType;
+			NewRoad.bIsOneWay = Road.bIsOneWay;
+			NewRoad.BoundsMin = FVector2D( TNumericLimits<float>::Max(), TNumericLimits<float>::Max() );
+			NewRoad.BoundsMax = FVector2D( TNumericLimits<float>::Lowest(), TNumericLimits<float>::Lowest() );
+			NewRoad.RoadPoints.Reserve( RoadPiece->Points.Num() );
+			NewRoad.NodeIndices.Reserve( RoadPiece->Points.Num() );
+
+			for( int32 PointIndex = 0; PointIndex < RoadPiece->Points.Num(); ++PointIndex )
+			{
+				const FTileRoadPoint& Point = RoadPiece->Points[ PointIndex ];
+				NewRoad.RoadPoints.Add( Point.Position );
+				NewRoad.BoundsMin = NewRoad.BoundsMin.ComponentMin( Point.Position );
+				NewRoad.BoundsMax = NewRoad.BoundsMax.ComponentMax( Point.Position );
+
+				int32 TileNodeIndex = INDEX_NONE;
+				if( Point.NodeIndex != INDEX_NONE || Point.BoundaryNodeID != 0 )
+				{
+					const int64 NodeKey = Point.NodeIndex != INDEX_NONE ? (int64)Point.NodeIndex : -Point.BoundaryNodeID;
+					const int32* FoundTileNodeIndex = TileNodeIndices.Find( NodeKey );
+					if( FoundTileNodeIndex != nullptr )
+					{
+						TileNodeIndex = *FoundTileNodeIndex;
+					}
+					else
+					{
+						TileNodeIndex = Tile.Nodes.AddDefaulted();
+						TileNodeIndices.Add( NodeKey, TileNodeIndex );
+					}
+
+					FStreetMapRoadRef RoadRef;
+					RoadRef.RoadIndex = TileRoadIndex;
+					RoadRef.RoadPointIndex = PointIndex;
+					Tile.Nodes[ TileNodeIndex ].RoadRefs.Add( RoadRef );
+
+					if( Point.BoundaryNodeID != 0 )
+					{
+						FStreetMapBoundaryNode BoundaryNode;
+						BoundaryNode.NodeIndex = TileNodeIndex;
+						BoundaryNode.BoundaryNodeID = Point.BoundaryNodeID;
+						Tile.BoundaryNodes.Add( BoundaryNode );
+					}
+				}
+				NewRoad.NodeIndices.Add( TileNodeIndex );
+			}
+
+			Tile.BoundsMin = Tile.BoundsMin.ComponentMin( NewRoad.BoundsMin );
+			Tile.BoundsMax = Tile.BoundsMax.ComponentMax( NewRoad.BoundsMax );
+		}
+
+		Tile.Buildings.Reserve( TileBuildingIndices[ TileIndex ].Num() );
+		for( const int32 BuildingIndex : TileBuildingIndices[ TileIndex ] )
+		{
+			const FStreetMapBuilding& Building = StreetMap->Buildings[ BuildingIndex ];
+			Tile.Buildings.Add( Building );
+			Tile.BoundsMin = Tile.BoundsMin.ComponentMin( Building.BoundsMin );
+			Tile.BoundsMax = Tile.BoundsMax.ComponentMax( Building.BoundsMax );
+		}
+	} );
+	RoadPieceChunks.Empty();
+
+	// Fill in the tiles that have anything in them.  Creating assets has to happen on this thread.  The tile assets are
+	// only marked dirty here; they are written to disk when the map is saved (or by the import commandlet).
+	StreetMap->Tiles.Reset();
+	for( int32 TileIndex = 0; TileIndex < TileCount; ++TileIndex )
+	{
+		FTileContents& Tile = Tiles[ TileIndex ];
+		if( Tile.Roads.Num() == 0 && Tile.Buildings.Num() == 0 )
+		{
+			continue;
+		}
+
+		const int32 TileX = TileIndex % Grid.TileCountX;
+		const int32 TileY = TileIndex / Grid.TileCountX;
+		UStreetMap* TileStreetMap = CreateTileStreetMap( StreetMap, TileX, TileY );
+		if( TileStreetMap == nullptr )
+		{
+			if( FeedbackContext != nullptr )
+			{
+				FeedbackContext->Logf( ELogVerbosity::Error, TEXT( "Unable to create tile %i, %i of street map '%s'" ), TileX, TileY, *StreetMap->GetName() );
+			}
+			return false;
+		}
+
+		TileStreetMap->Roads = MoveTemp( Tile.Roads );
+		TileStreetMap->Nodes = MoveTemp( Tile.Nodes );
+		TileStreetMap->Buildings = MoveTemp( Tile.Buildings );
+		TileStreetMap->BoundaryNodes = MoveTemp( Tile.BoundaryNodes );
+		TileStreetMap->BoundsMin = Tile.BoundsMin;
+		TileStreetMap->BoundsMax = Tile.BoundsMax;
+		TileStreetMap->TileSize = 0.0f;
+		TileStreetMap->Tiles.Reset();
+		TileStreetMap->OSMSourceData = FStreetMapOSMSourceData();
+		TileStreetMap->CompactGeometry();
+		TileStreetMap->BuildCachedRoadData();
+		TileStreetMap->MarkPackageDirty();
+
+		FStreetMapTile& NewTile = *new( StreetMap->Tiles )FStreetMapTile();
+		NewTile.TileX = TileX;
+		NewTile.TileY = TileY;
+		NewTile.StreetMap = TileStreetMap;
+		NewTile.BoundsMin = Grid.Origin + FVector2D( (float)TileX, (float)TileY ) * Grid.TileSize;
+		NewTile.BoundsMax = NewTile.BoundsMin + FVector2D( Grid.TileSize, Grid.TileSize );
+	}
+
+	// Tiles left over from an earlier import that are no longer part of the grid are not deleted, because levels may
+	// still refer to them, but they are no longer listed by the map
+	TArray<FAssetData> TileFolderAssets;
+	FModuleManager::LoadModuleChecked<FAssetRegistryModule>( "AssetRegistry" ).Get().GetAssetsByPath( FName( *GetTileFolder( StreetMap ) ), TileFolderAssets );
+	int32 StaleTileCount = 0;
+	for( const FAssetData& TileAsset : TileFolderAssets )
+	{
+		if( TileAsset.AssetClass != UStreetMap::StaticClass()->GetFName() ||
+			StreetMap->Tiles.ContainsByPredicate( [&TileAsset]( const FStreetMapTile& Tile ) { return Tile.StreetMap.ToSoftObjectPath() == TileAsset.ToSoftObjectPath(); } ) )
+		{
+			continue;
+		}
+
+		++StaleTileCount;
+		if( FeedbackContext != nullptr )
+		{
+			FeedbackContext->Logf( ELogVerbosity::Warning, TEXT( "Tile '%s' is no longer part of street map '%s' and can be deleted" ), *TileAsset.PackageName.ToString(), *StreetMap->GetName() );
+		}
+	}
+
+	// Everything lives in the tiles now
+	StreetMap->TileSize = Grid.TileSize;
+	StreetMap->Roads.Empty();
+	StreetMap->Nodes.Empty();
+	StreetMap->Buildings.Empty();
+	StreetMap->BoundaryNodes.Empty();
+	StreetMap->PointPool.Empty();
+	StreetMap->NodeIndexPool.Empty();
+	StreetMap->RoadPointRanges.Empty();
+	StreetMap->BuildingPointRanges.Empty();
+	StreetMap->OSMSourceData = FStreetMapOSMSourceData();
+	StreetMap->BuildCachedRoadData();
+
+	if( FeedbackContext != nullptr )
+	{
+		FeedbackContext->Logf(
+			ELogVerbosity::Log,
+			TEXT( "Split street map '%s' into %i tiles (%i x %i grid, %i stale tiles left over) in %.1f ms" ),
+			*StreetMap->GetName(),
+			StreetMap->Tiles.Num(),
+			Grid.TileCountX,
+			Grid.TileCountY,
+			StaleTileCount,
+			( FPlatformTime::Seconds() - StartTime ) * 1000.0 );
+	}
+
+	return true;
+}
+
+
+UStreetMap* UStreetMapFactory::CreateTileStreetMap( UStreetMap* StreetMap, const int32 TileX, const int32 TileY )
+{
+	// Tiles live in a folder next to the map, and are updated in place when the map is reimported.  A tile that was
+	// saved by an earlier import has to be loaded first, otherwise a new object would be created over it.
+	const FString TileName = FString::Printf( TEXT( "%s_%i_%i" ), *StreetMap->GetName(), TileX, TileY );
+	const FString TilePackageName = GetTileFolder( StreetMap ) / TileName;
+	UPackage* TilePackage = FindPackage( nullptr, *TilePackageName );
+	if( TilePackage == nullptr && FPackageName::DoesPackageExist( TilePackageName ) )
+	{
+		TilePackage = LoadPackage( nullptr, *TilePackageName, LOAD_None );
+		if( TilePackage == nullptr )
+		{
+			return nullptr;
+		}
+	}
+	if( TilePackage == nullptr )
+	{
+		TilePackage = CreatePackage( nullptr, *TilePackageName );
+		if( TilePackage == nullptr )
+		{
+			return nullptr;
+		}
+	}
+
+	// Something else with the same name is in the way
+	UObject* ExistingObject = StaticFindObjectFast( UObject::StaticClass(), TilePackage, FName( *TileName ) );
+	if( ExistingObject != nullptr && !ExistingObject->IsA<UStreetMap>() )
+	{
+		return nullptr;
+	}
+
+	UStreetMap* TileStreetMap = FindObject<UStreetMap>( TilePackage, *TileName );
+	if( TileStreetMap != nullptr )
+	{
+		TileStreetMap->Modify();
+	}
+	else
+	{
+		TileStreetMap = NewObject<UStreetMap>( TilePackage, *TileName, RF_Public | RF_Standalone | RF_Transactional );
+		FAssetRegistryModule::AssetCreated( TileStreetMap );
+	}
+	return TileStreetMap;
+}
+
+
+bool UStreetMapFactory::ApplyOpenStreetMapChangeFile( UStreetMap* StreetMap, const FString& OSCFilePath, FFeedbackContext* FeedbackContext )
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	FStreetMapOSMSourceData& OSMSourceData = StreetMap->OSMSourceData;
+	TArray<FStreetMapRoad>& Roads = StreetMap->Roads;
+	TArray<FStreetMapNode>& Nodes = StreetMap->Nodes;
+	TArray<FStreetMapBuilding>& Buildings = StreetMap->Buildings;
+
+	// Maps that were split into tiles don't have any roads or buildings of their own to change
+	if( StreetMap->Tiles.Num() > 0 )
+	{
+		if( FeedbackContext != nullptr )
+		{
+			FeedbackContext->Logf(
+				ELogVerbosity::Error,
+				TEXT( "Street map '%s' was split into tiles, so changes can't be applied to it.  Reimport it from an updated OpenStreetMap file instead." ),
+				*StreetMap->GetName() );
+		}
+		return false;
+	}
+
+	// We can only apply changes to maps that remember where all of their roads and buildings came from
+	int32 RoadPointCount = 0;
+	for( const FStreetMapRoad& Road : Roads )
+	{
+		RoadPointCount += Road.GetRoadPoints( *StreetMap ).Num();
+	}
+	int32 BuildingPointCount = 0;
+	for( const FStreetMapBuilding& Building : Buildings )
+	{
+		BuildingPointCount += Building.GetBuildingPoints( *StreetMap ).Num();
+	}
+	const bool bHasSourceData =
+		OSMSourceData.RoadWayIDs.Num() == Roads.Num() &&
+		OSMSourceData.RoadPointNodeIDs.Num() == RoadPointCount &&
+		OSMSourceData.BuildingWayIDs.Num() == Buildings.Num() &&
+		OSMSourceData.BuildingPointNodeIDs.Num() == BuildingPointCount &&
+		OSMSourceData.MapNodeIDs.Num() == Nodes.Num() &&
+		OSMSourceData.NodeLatitudes.Num() == OSMSourceData.NodeIDs.Num() &&
+		OSMSourceData.NodeLongitudes.Num() == OSMSourceData.NodeIDs.Num() &&
+		OSMSourceData.WeldedOntoNodeIDs.Num() == OSMSourceData.WeldedNodeIDs.Num();
+	if( !bHasSourceData || StreetMap->ImportOptions.bClipToRegion || StreetMap->ImportOptions.bMergeRoadChains )
+	{
+		if( FeedbackContext != nullptr )
+		{
+			FeedbackContext->Logf(
+				ELogVerbosity::Error,
+				!bHasSourceData ?
+					TEXT( "Street map '%s' doesn't know which OpenStreetMap nodes and ways it was made from.  Reimport it from an OpenStreetMap file before applying changes to it." ) :
+				StreetMap->ImportOptions.bClipToRegion ?
+					TEXT( "Street map '%s' was clipped to a region, so changes can't be applied to it.  Reimport it from an updated OpenStreetMap file instead." ) :
+					TEXT( "Street map '%s' had its road chains merged, so changes can't be applied to it.  Reimport it from an updated OpenStreetMap file instead." ),
+				*StreetMap->GetName() );
+		}
+		return false;
+	}
+
+	// Load the changes.  Ways in the change file only come with the nodes that changed, so we look the rest up in the map.
+	// Ways that we didn't import before (because their tags changed, say) can use nodes that the map never kept.  Those
+	// are looked up in the files the map was made from, and then the changes are loaded again.
+	const TArray<FStreetMapTagFilterRule>& TagFilterRules = StreetMap->ImportOptions.TagFilterRules;
+	FOSMTagFilter TagFilter;
+	CompileTagFilter( TagFilterRules, TagFilter );
+	TMap<int64, FOSMFile::FOSMCoordinate> SourceFileNodes;
+	TArray<int64> MissingNodeIDs;
+	TUniquePtr<FOSMFile> LoadedChangeFile;
+	for( int32 LoadAttempt = 0; LoadAttempt < 2; ++LoadAttempt )
+	{
+		LoadedChangeFile = MakeUnique<FOSMFile>();
+		LoadedChangeFile->TagFilter = &TagFilter;
+		LoadedChangeFile->WayFilter = [&TagFilterRules]( const FOSMFile::FOSMWayInfo& OSMWay )
+		{
+			return ShouldImportWay( OSMWay, TagFilterRules );
+		};
+		LoadedChangeFile->WeldDistance = StreetMap->ImportOptions.WeldTolerance / OSMToCentimetersScaleFactor;
+
+		// Nodes that were welded onto another node are still in our copy of the nodes, at their own location, so ways in
+		// the change file can use them.  The change file welds them again if they're still close enough.
+		MissingNodeIDs.Reset();
+		LoadedChangeFile->ExternalNodeLookup = [&OSMSourceData, &SourceFileNodes, &MissingNodeIDs]( const int64 NodeID, FOSMFile::FOSMCoordinate& OutCoordinate ) -> bool
+		{
+			const int32 SourceNodeIndex = Algo::BinarySearch( OSMSourceData.NodeIDs, NodeID );
+			if( SourceNodeIndex != INDEX_NONE )
+			{
+				OutCoordinate.Latitude = (double)OSMSourceData.NodeLatitudes[ SourceNodeIndex ] / SourceCoordinateScale;
+				OutCoordinate.Longitude = (double)OSMSourceData.NodeLongitudes[ SourceNodeIndex ] / SourceCoordinateScale;
+				return true;
+			}
+			if( const FOSMFile::FOSMCoordinate* SourceFileCoordinate = SourceFileNodes.Find( NodeID ) )
+			{
+				OutCoordinate = *SourceFileCoordinate;
+				return true;
+			}
+			MissingNodeIDs.Add( NodeID );
+			return false;
+		};
+		const bool bIsFilePathActuallyTextBuffer = false;
+		if( !LoadedChangeFile->LoadOpenStreetMapFile( OSCFilePath, bIsFilePathActuallyTextBuffer, FeedbackContext ) )
+		{
+			// Loading failed.  The actual error message will be sent to the FeedbackContext's log.
+			return false;
+		}
+		if( MissingNodeIDs.Num() == 0 || LoadAttempt > 0 )
+		{
+			break;
+		}
+
+		TArray<FString> SourceFilePaths;
+		const FString ImportFilePath = StreetMap->AssetImportData != nullptr ? StreetMap->AssetImportData->GetFirstFilename() : FString();
+		if( !ImportFilePath.IsEmpty() )
+		{
+			SourceFilePaths.Add( ImportFilePath );
+		}
+		SourceFilePaths.Append( StreetMap->AppliedChangeFiles );
+		const int32 FoundNodeCount = LoadNodesFromSourceFiles( SourceFilePaths, StreetMap->GetName(), MissingNodeIDs, SourceFileNodes, FeedbackContext );
+		if( FoundNodeCount == 0 )
+		{
+			break;
+		}
+		if( FeedbackContext != nullptr )
+		{
+			FeedbackContext->Logf(
+				ELogVerbosity::Display,
+				TEXT( "Found %i of the %i nodes that the changes use but street map '%s' didn't keep in the files it was made from." ),
+				FoundNodeCount,
+				MissingNodeIDs.Num(),
+				*StreetMap->GetName() );
+		}
+	}
+	const FOSMFile& ChangeFile = *LoadedChangeFile;
+	if( ChangeFile.GetMissingNodeCount() > 0 )
+	{
+		if( FeedbackContext != nullptr )
+		{
+			FeedbackContext->Logf(
+				ELogVerbosity::Error,
+				TEXT( "The changes use %i nodes that aren't in the change file, in street map '%s' or in the files it was made from (which have to still exist for this).  Reimport the map from an updated OpenStreetMap file instead." ),
+				ChangeFile.GetMissingNodeCount(),
+				*StreetMap->GetName() );
+		}
+		return false;
+	}
+
+	StreetMap->Modify();
+
+	// The changes are made to the roads' and buildings' own arrays, and then they go back into the pools at the end
+	StreetMap->ExpandGeometry();
+
+	// Points keep the ID of the node they started out as, but map nodes are made from the nodes they were welded onto
+	TMap<int64, int64> WeldedOntoNodeIDs;
+	WeldedOntoNodeIDs.Reserve( OSMSourceData.WeldedNodeIDs.Num() );
+	for( int32 WeldedNodeIndex = 0; WeldedNodeIndex < OSMSourceData.WeldedNodeIDs.Num(); ++WeldedNodeIndex )
+	{
+		WeldedOntoNodeIDs.Add( OSMSourceData.WeldedNodeIDs[ WeldedNodeIndex ], OSMSourceData.WeldedOntoNodeIDs[ WeldedNodeIndex ] );
+	}
+	auto GetMapNodeID = [&WeldedOntoNodeIDs]( const int64 NodeID ) -> int64
+	{
+		const int64* WeldedOntoNodeID = WeldedOntoNodeIDs.Find( NodeID );
+		return WeldedOntoNodeID != nullptr ? *WeldedOntoNodeID : NodeID;
+	};
+
+	// Flatten the nodes from the change file into our map's space
+	TArray<FVector2D> ChangeNodePositions;
+	ChangeNodePositions.SetNumUninitialized( ChangeFile.GetNodeCount() );
+	for( int32 ChangeNodeIndex = 0; ChangeNodeIndex < ChangeFile.GetNodeCount(); ++ChangeNodeIndex )
+	{
+		ChangeNodePositions[ ChangeNodeIndex ] = ConvertLatLongToMapPosition(
+			ChangeFile.GetNodeLatitude( ChangeNodeIndex ),
+			ChangeFile.GetNodeLongitude( ChangeNodeIndex ),
+			OSMSourceData.OriginLatitude,
+			OSMSourceData.OriginLongitude );
+	}
+
+	// Nodes that the change file's ways use, including the ones it welded onto other nodes
+	TBitArray<> IsChangeNodeUsed( false, ChangeFile.GetNodeCount() );
+	for( const FOSMFile::FOSMWayInfo* OSMWay : ChangeFile.Ways )
+	{
+		for( const int32 ChangeNodeIndex : ChangeFile.GetUnweldedWayNodes( *OSMWay ) )
+		{
+			IsChangeNodeUsed[ ChangeNodeIndex ] = true;
+		}
+	}
+
+	// Find the nodes that moved, and update our copy of every node the change file has
+	TMap<int64, FVector2D> MovedNodePositions;
+	TArray<int32> NewChangeNodeIndices;
+	for( int32 ChangeNodeIndex = 0; ChangeNodeIndex < ChangeFile.GetNodeCount(); ++ChangeNodeIndex )
+	{
+		const int64 NodeID = ChangeFile.GetNodeID( ChangeNodeIndex );
+		const int32 Latitude = (int32)FMath::FloorToDouble( ChangeFile.GetNodeLatitude( ChangeNodeIndex ) * SourceCoordinateScale + 0.5 );
+		const int32 Longitude = (int32)FMath::FloorToDouble( ChangeFile.GetNodeLongitude( ChangeNodeIndex ) * SourceCoordinateScale + 0.5 );
+
+		const int32 SourceNodeIndex = Algo::BinarySearch( OSMSourceData.NodeIDs, NodeID );
+		if( SourceNodeIndex != INDEX_NONE )
+		{
+			if( OSMSourceData.NodeLatitudes[ SourceNodeIndex ] != Latitude || OSMSourceData.NodeLongitudes[ SourceNodeIndex ] != Longitude )
+			{
+				OSMSourceData.NodeLatitudes[ SourceNodeIndex ] = Latitude;
+				OSMSourceData.NodeLongitudes[ SourceNodeIndex ] = Longitude;
+				MovedNodePositions.Add( NodeID, ChangeNodePositions[ ChangeNodeIndex ] );
+			}
+		}
+		else if( IsChangeNodeUsed[ ChangeNodeIndex ] )
+		{
+			NewChangeNodeIndices.Add( ChangeNodeIndex );
+		}
+	}
+
+	// Every way in the change file replaces whatever we made from that way before, if anything
+	TSet<int64> ReplacedWayIDs;
+	ReplacedWayIDs.Append( ChangeFile.ChangedWayIDs );
+	ReplacedWayIDs.Append( ChangeFile.DeletedWayIDs );
+
+	// Map nodes where roads were removed or added, or that were unwelded.  These are the only nodes whose connections can
+	// change.
+	TSet<int64> AffectedNodeIDs;
+
+	// Welded points are drawn where the node they were welded onto is, so they follow it when either node moves.  If the
+	// nodes aren't within the weld tolerance of each other anymore, they're unwelded, and the points go back to their own
+	// node's location.
+	int32 UnweldedNodeCount = 0;
+	if( MovedNodePositions.Num() > 0 && WeldedOntoNodeIDs.Num() > 0 )
+	{
+		auto GetSourceNodePosition = [&OSMSourceData]( const int64 NodeID ) -> FVector2D
+		{
+			const int32 SourceNodeIndex = Algo::BinarySearch( OSMSourceData.NodeIDs, NodeID );
+			return ConvertLatLongToMapPosition(
+				(double)OSMSourceData.NodeLatitudes[ SourceNodeIndex ] / SourceCoordinateScale,
+				(double)OSMSourceData.NodeLongitudes[ SourceNodeIndex ] / SourceCoordinateScale,
+				OSMSourceData.OriginLatitude,
+				OSMSourceData.OriginLongitude );
+		};
+
+		const float WeldToleranceSquared = FMath::Square( StreetMap->ImportOptions.WeldTolerance );
+		for( auto WeldedNodeIt = WeldedOntoNodeIDs.CreateIterator(); WeldedNodeIt; ++WeldedNodeIt )
+		{
+			const int64 WeldedNodeID = WeldedNodeIt.Key();
+			const int64 WeldedOntoNodeID = WeldedNodeIt.Value();
+			if( !MovedNodePositions.Contains( WeldedNodeID ) && !MovedNodePositions.Contains( WeldedOntoNodeID ) )
+			{
+				continue;
+			}
+
+			const FVector2D WeldedNodePosition = GetSourceNodePosition( WeldedNodeID );
+			const FVector2D WeldedOntoNodePosition = GetSourceNodePosition( WeldedOntoNodeID );
+			if( FVector2D::DistSquared( WeldedNodePosition, WeldedOntoNodePosition ) <= WeldToleranceSquared )
+			{
+				MovedNodePositions.Add( WeldedNodeID, WeldedOntoNodePosition );
+			}
+			else
+			{
+				MovedNodePositions.Add( WeldedNodeID, WeldedNodePosition );
+				AffectedNodeIDs.Add( WeldedNodeID );
+				AffectedNodeIDs.Add( WeldedOntoNodeID );
+				WeldedNodeIt.RemoveCurrent();
+				++UnweldedNodeCount;
+			}
+		}
+	}
+
+	// Remove the roads we're replacing, keeping the rest of the roads in the same order
+	int32 RemovedRoadCount = 0;
+	if( ReplacedWayIDs.Num() > 0 )
+	{
+		TArray<int32> RoadRemap;
+		RoadRemap.SetNumUninitialized( Roads.Num() );
+		int32 KeptRoadCount = 0;
+		int32 ReadPointIndex = 0;
+		int32 WritePointIndex = 0;
+		for( int32 RoadIndex = 0; RoadIndex < Roads.Num(); ++RoadIndex )
+		{
+			const int32 PointCount = Roads[ RoadIndex ].RoadPoints.Num();
+			if( ReplacedWayIDs.Contains( OSMSourceData.RoadWayIDs[ RoadIndex ] ) )
+			{
+				RoadRemap[ RoadIndex ] = INDEX_NONE;
+				for( int32 PointIndex = 0; PointIndex < PointCount; ++PointIndex )
+				{
+					AffectedNodeIDs.Add( GetMapNodeID( OSMSourceData.RoadPointNodeIDs[ ReadPointIndex + PointIndex ] ) );
+				}
+			}
+			else
+			{
+				RoadRemap[ RoadIndex ] = KeptRoadCount;
+				if( KeptRoadCount != RoadIndex )
+				{
+					Roads[ KeptRoadCount ] = MoveTemp( Roads[ RoadIndex ] );
+					OSMSourceData.RoadWayIDs[ KeptRoadCount ] = OSMSourceData.RoadWayIDs[ RoadIndex ];
+					for( int32 PointIndex = 0; PointIndex < PointCount; ++PointIndex )
+					{
+						OSMSourceData.RoadPointNodeIDs[ WritePointIndex + PointIndex ] = OSMSourceData.RoadPointNodeIDs[ ReadPointIndex + PointIndex ];
+					}
+				}
+				++KeptRoadCount;
+				WritePointIndex += PointCount;
+			}
+			ReadPointIndex += PointCount;
+		}
+
+		RemovedRoadCount = Roads.Num() - KeptRoadCount;
+		if( RemovedRoadCount > 0 )
+		{
+			Roads.SetNum( KeptRoadCount );
+			OSMSourceData.RoadWayIDs.SetNum( KeptRoadCount );
+			OSMSourceData.RoadPointNodeIDs.SetNum( WritePointIndex );
+
+			// Point the nodes at the roads' new indices.  Refs to roads we removed are dropped, and those nodes will be
+			// rebuilt below anyway.
+			for( FStreetMapNode& Node : Nodes )
+			{
+				int32 KeptRoadRefCount = 0;
+				for( const FStreetMapRoadRef& RoadRef : Node.RoadRefs )
+				{
+					if( RoadRemap[ RoadRef.RoadIndex ] != INDEX_NONE )
+					{
+						FStreetMapRoadRef& KeptRoadRef = Node.RoadRefs[ KeptRoadRefCount++ ];
+						KeptRoadRef.RoadIndex = RoadRemap[ RoadRef.RoadIndex ];
+						KeptRoadRef.RoadPointIndex = RoadRef.RoadPointIndex;
+					}
+				}
+				Node.RoadRefs.SetNum( KeptRoadRefCount );
+			}
+		}
+	}
+
+	// Remove the buildings we're replacing
+	int32 RemovedBuildingCount = 0;
+	if( ReplacedWayIDs.Num() > 0 )
+	{
+		int32 KeptBuildingCount = 0;
+		int32 ReadPointIndex = 0;
+		int32 WritePointIndex = 0;
+		for( int32 BuildingIndex = 0; BuildingIndex < Buildings.Num(); ++BuildingIndex )
+		{
+			const int32 PointCount = Buildings[ BuildingIndex ].BuildingPoints.Num();
+			if( !ReplacedWayIDs.Contains( OSMSourceData.BuildingWayIDs[ BuildingIndex ] ) )
+			{
+				if( KeptBuildingCount != BuildingIndex )
+				{
+					Buildings[ KeptBuildingCount ] = MoveTemp( Buildings[ BuildingIndex ] );
+					OSMSourceData.BuildingWayIDs[ KeptBuildingCount ] = OSMSourceData.BuildingWayIDs[ BuildingIndex ];
+					for( int32 PointIndex = 0; PointIndex < PointCount; ++PointIndex )
+					{
+						OSMSourceData.BuildingPointNodeIDs[ WritePointIndex + PointIndex ] = OSMSourceData.BuildingPointNodeIDs[ ReadPointIndex + PointIndex ];
+					}
+				}
+				++KeptBuildingCount;
+				WritePointIndex += PointCount;
+			}
+			ReadPointIndex += PointCount;
+		}
+
+		RemovedBuildingCount = Buildings.Num() - KeptBuildingCount;
+		Buildings.SetNum( KeptBuildingCount );
+		OSMSourceData.BuildingWayIDs.SetNum( KeptBuildingCount );
+		OSMSourceData.BuildingPointNodeIDs.SetNum( WritePointIndex );
+	}
+
+	// Move the points of nodes that moved along whatever roads and buildings we're keeping
+	if( MovedNodePositions.Num() > 0 )
+	{
+		auto UpdateBounds = []( const TArray<FVector2D>& Points, FVector2D& OutBoundsMin, FVector2D& OutBoundsMax )
+		{
+			OutBoundsMin = FVector2D( TNumericLimits<float>::Max(), TNumericLimits<float>::Max() );
+			OutBoundsMax = FVector2D( TNumericLimits<float>::Lowest(), TNumericLimits<float>::Lowest() );
+			for( const FVector2D& Point : Points )
+			{
+				OutBoundsMin.X = FMath::Min( OutBoundsMin.X, Point.X );
+				OutBoundsMin.Y = FMath::Min( OutBoundsMin.Y, Point.Y );
+				OutBoundsMax.X = FMath::Max( OutBoundsMax.X, Point.X );
+				OutBoundsMax.Y = FMath::Max( OutBoundsMax.Y, Point.Y );
+			}
+		};
+
+		int32 PointNodeIndex = 0;
+		for( FStreetMapRoad& Road : Roads )
+		{
+			bool bMoved = false;
+			for( FVector2D& RoadPoint : Road.RoadPoints )
+			{
+				const FVector2D* MovedNodePosition = MovedNodePositions.Find( OSMSourceData.RoadPointNodeIDs[ PointNodeIndex++ ] );
+				if( MovedNodePosition != nullptr )
+				{
+					RoadPoint = *MovedNodePosition;
+					bMoved = true;
+				}
+			}
+			if( bMoved )
+			{
+				UpdateBounds( Road.RoadPoints, Road.BoundsMin, Road.BoundsMax );
+			}
+		}
+
+		PointNodeIndex = 0;
+		for( FStreetMapBuilding& Building : Buildings )
+		{
+			const int32 FirstPointNodeIndex = PointNodeIndex;
+			bool bMoved = false;
+			for( FVector2D& BuildingPoint : Building.BuildingPoints )
+			{
+				const FVector2D* MovedNodePosition = MovedNodePositions.Find( OSMSourceData.BuildingPointNodeIDs[ PointNodeIndex++ ] );
+				if( MovedNodePosition != nullptr )
+				{
+					BuildingPoint = *MovedNodePosition;
+					bMoved = true;
+				}
+			}
+			if( bMoved )
+			{
+				UpdateBounds( Building.BuildingPoints, Building.BoundsMin, Building.BoundsMax );
+
+				// The outline changed shape, so it needs to be triangulated again.  Keep the node IDs lined up with
+				// the points if this flipped the winding.
+				if( TriangulateBuilding( Building ) )
+				{
+					Algo::Reverse( OSMSourceData.BuildingPointNodeIDs.GetData() + FirstPointNodeIndex, Building.BuildingPoints.Num() );
+				}
+			}
+		}
+	}
+
+	// Add roads and buildings for the ways that were created or modified.  They're simplified the same way as when the
+	// map was imported, and their points keep the ID of the node they started out as, like the rest of the map.
+	auto AddChangeFileWeldedNodes = [&]( const FOSMFile::FOSMWayInfo& OSMWay )
+	{
+		const TArrayView<const int32> WayNodes = ChangeFile.GetWayNodes( OSMWay );
+		const TArrayView<const int32> UnweldedWayNodes = ChangeFile.GetUnweldedWayNodes( OSMWay );
+		for( int32 WayNodeIndex = 0; WayNodeIndex < WayNodes.Num(); ++WayNodeIndex )
+		{
+			const int64 WeldedNodeID = ChangeFile.GetNodeID( UnweldedWayNodes[ WayNodeIndex ] );
+			if( UnweldedWayNodes[ WayNodeIndex ] != WayNodes[ WayNodeIndex ] && !WeldedOntoNodeIDs.Contains( WeldedNodeID ) )
+			{
+				WeldedOntoNodeIDs.Add( WeldedNodeID, GetMapNodeID( ChangeFile.GetNodeID( WayNodes[ WayNodeIndex ] ) ) );
+			}
+		}
+	};
+	const float SimplifyTolerance = StreetMap->ImportOptions.bSimplifyLines ? StreetMap->ImportOptions.SimplifyTolerance : 0.0f;
+	int32 RemovedBuildingPointCount = 0;
+	const int32 FirstNewRoadIndex = Roads.Num();
+	const int32 FirstNewBuildingIndex = Buildings.Num();
+	TArray<int32> BuildingPointChangeNodes;
+	for( const FOSMFile::FOSMWayInfo* OSMWay : ChangeFile.Ways )
+	{
+		FVector2D UnusedBoundsMin, UnusedBoundsMax;
+		if( OSMWay->WayType == FOSMFile::EOSMWayType::Building )
+		{
+			BuildingPointChangeNodes.Reset();
+			if( AddBuildingForWay( ChangeFile, ChangeNodePositions, *OSMWay, SimplifyTolerance, Buildings, BuildingPointChangeNodes, RemovedBuildingPointCount, UnusedBoundsMin, UnusedBoundsMax ) )
+			{
+				AddChangeFileWeldedNodes( *OSMWay );
+				OSMSourceData.BuildingWayIDs.Add( OSMWay->ID );
+				for( const int32 ChangeNodeIndex : BuildingPointChangeNodes )
+				{
+					OSMSourceData.BuildingPointNodeIDs.Add( ChangeFile.GetNodeID( ChangeNodeIndex ) );
+				}
+			}
+		}
+		else
+		{
+			if( AddRoadForWay( ChangeFile, ChangeNodePositions, *OSMWay, TagFilterRules, Roads, UnusedBoundsMin, UnusedBoundsMax ) )
+			{
+				AddChangeFileWeldedNodes( *OSMWay );
+				OSMSourceData.RoadWayIDs.Add( OSMWay->ID );
+				for( const int32 ChangeNodeIndex : ChangeFile.GetUnweldedWayNodes( *OSMWay ) )
+				{
+					const int64 NodeID = ChangeFile.GetNodeID( ChangeNodeIndex );
+					OSMSourceData.RoadPointNodeIDs.Add( NodeID );
+					AffectedNodeIDs.Add( GetMapNodeID( NodeID ) );
+				}
+			}
+		}
+	}
+
+	// Find everywhere the affected nodes are used by a road.  We'll decide which of them are still worth keeping as map
+	// nodes the same way as when importing: if they connect roads together, or are at the end of a road.
+	TMap<int64, TArray<FStreetMapRoadRef>> AffectedNodeRoadRefs;
+	if( AffectedNodeIDs.Num() > 0 )
+	{
+		int32 PointNodeIndex = 0;
+		for( int32 RoadIndex = 0; RoadIndex < Roads.Num(); ++RoadIndex )
+		{
+			FStreetMapRoad& Road = Roads[ RoadIndex ];
+			for( int32 RoadPointIndex = 0; RoadPointIndex < Road.NodeIndices.Num(); ++RoadPointIndex )
+			{
+				const int64 NodeID = GetMapNodeID( OSMSourceData.RoadPointNodeIDs[ PointNodeIndex++ ] );
+				if( AffectedNodeIDs.Contains( NodeID ) )
+				{
+					FStreetMapRoadRef RoadRef;
+					RoadRef.RoadIndex = RoadIndex;
+					RoadRef.RoadPointIndex = RoadPointIndex;
+					AffectedNodeRoadRefs.FindOrAdd( NodeID ).Add( RoadRef );
+
+					Road.NodeIndices[ RoadPointIndex ] = INDEX_NONE;
+				}
+			}
+		}
+	}
+
+	// Rebuild the affected map nodes, adding new ones and removing the ones we don't need anymore
+	int32 RemovedNodeCount = 0;
+	if( AffectedNodeIDs.Num() > 0 )
+	{
+		TMap<int64, int32> ExistingNodeIndices;
+		for( int32 NodeIndex = 0; NodeIndex < Nodes.Num(); ++NodeIndex )
+		{
+			if( AffectedNodeIDs.Contains( OSMSourceData.MapNodeIDs[ NodeIndex ] ) )
+			{
+				ExistingNodeIndices.Add( OSMSourceData.MapNodeIDs[ NodeIndex ], NodeIndex );
+			}
+		}
+
+		TBitArray<> IsNodeRemoved( false, Nodes.Num() );
+		for( const int64 NodeID : AffectedNodeIDs )
+		{
+			const TArray<FStreetMapRoadRef>* RoadRefs = AffectedNodeRoadRefs.Find( NodeID );
+			const int32* ExistingNodeIndex = ExistingNodeIndices.Find( NodeID );
+
+			const bool bKeepNode = RoadRefs != nullptr && (
+				RoadRefs->Num() > 1 ||
+				( *RoadRefs )[ 0 ].RoadPointIndex == 0 ||
+				( *RoadRefs )[ 0 ].RoadPointIndex == ( Roads[ ( *RoadRefs )[ 0 ].RoadIndex ].NodeIndices.Num() - 1 ) );
+			if( bKeepNode )
+			{
+				int32 NodeIndex;
+				if( ExistingNodeIndex != nullptr )
+				{
+					NodeIndex = *ExistingNodeIndex;
+				}
+				else
+				{
+					NodeIndex = Nodes.Add( FStreetMapNode() );
+					OSMSourceData.MapNodeIDs.Add( NodeID );
+				}
+
+				Nodes[ NodeIndex ].RoadRefs = *RoadRefs;
+				for( const FStreetMapRoadRef& RoadRef : *RoadRefs )
+				{
+					Roads[ RoadRef.RoadIndex ].NodeIndices[ RoadRef.RoadPointIndex ] = NodeIndex;
+				}
+			}
+			else if( ExistingNodeIndex != nullptr )
+			{
+				IsNodeRemoved[ *ExistingNodeIndex ] = true;
+				++RemovedNodeCount;
+			}
+		}
+
+		if( RemovedNodeCount > 0 )
+		{
+			TArray<int32> NodeRemap;
+			NodeRemap.SetNumUninitialized( Nodes.Num() );
+			int32 KeptNodeCount = 0;
+			for( int32 NodeIndex = 0; NodeIndex < Nodes.Num(); ++NodeIndex )
+			{
+				if( NodeIndex < IsNodeRemoved.Num() && IsNodeRemoved[ NodeIndex ] )
+				{
+					NodeRemap[ NodeIndex ] = INDEX_NONE;
+					continue;
+				}
+
+				NodeRemap[ NodeIndex ] = KeptNodeCount;
+				if( KeptNodeCount != NodeIndex )
+				{
+					Nodes[ KeptNodeCount ] = MoveTemp( Nodes[ NodeIndex ] );
+					OSMSourceData.MapNodeIDs[ KeptNodeCount ] = OSMSourceData.MapNodeIDs[ NodeIndex ];
+				}
+				++KeptNodeCount;
+			}
+			Nodes.SetNum( KeptNodeCount );
+			OSMSourceData.MapNodeIDs.SetNum( KeptNodeCount );
+
+			for( FStreetMapRoad& Road : Roads )
+			{
+				for( int32& NodeIndex : Road.NodeIndices )
+				{
+					if( NodeIndex != INDEX_NONE )
+					{
+						NodeIndex = NodeRemap[ NodeIndex ];
+					}
+				}
+			}
+		}
+	}
+
+	// The new roads know where their map nodes are now, so we can simplify them
+	if( SimplifyTolerance > 0.0f && FirstNewRoadIndex < Roads.Num() )
+	{
+		SimplifyRoads( Roads, Nodes, OSMSourceData.RoadPointNodeIDs, FirstNewRoadIndex, SimplifyTolerance );
+	}
+
+	// Keep our copy of the nodes up to date, so that later changes can find them
+	if( NewChangeNodeIndices.Num() > 0 || ChangeFile.DeletedNodeIDs.Num() > 0 )
+	{
+		for( const int32 ChangeNodeIndex : NewChangeNodeIndices )
+		{
+			OSMSourceData.NodeIDs.Add( ChangeFile.GetNodeID( ChangeNodeIndex ) );
+			OSMSourceData.NodeLatitudes.Add( (int32)FMath::FloorToDouble( ChangeFile.GetNodeLatitude( ChangeNodeIndex ) * SourceCoordinateScale + 0.5 ) );
+			OSMSourceData.NodeLongitudes.Add( (int32)FMath::FloorToDouble( ChangeFile.GetNodeLongitude( ChangeNodeIndex ) * SourceCoordinateScale + 0.5 ) );
+		}
+
+		TSet<int64> DeletedNodeIDs;
+		DeletedNodeIDs.Append( ChangeFile.DeletedNodeIDs );
+		TArray<int32> SortedOrder;
+		SortedOrder.Reserve( OSMSourceData.NodeIDs.Num() );
+		for( int32 SourceNodeIndex = 0; SourceNodeIndex < OSMSourceData.NodeIDs.Num(); ++SourceNodeIndex )
+		{
+			if( !DeletedNodeIDs.Contains( OSMSourceData.NodeIDs[ SourceNodeIndex ] ) )
+			{
+				SortedOrder.Add( SourceNodeIndex );
+			}
+		}
+		SortedOrder.Sort( [&OSMSourceData]( const int32 A, const int32 B )
+		{
+			return OSMSourceData.NodeIDs[ A ] < OSMSourceData.NodeIDs[ B ];
+		} );
+
+		TArray<int64> SortedNodeIDs;
+		TArray<int32> SortedNodeLatitudes;
+		TArray<int32> SortedNodeLongitudes;
+		SortedNodeIDs.Reserve( SortedOrder.Num() );
+		SortedNodeLatitudes.Reserve( SortedOrder.Num() );
+		SortedNodeLongitudes.Reserve( SortedOrder.Num() );
+		for( const int32 SourceNodeIndex : SortedOrder )
+		{
+			SortedNodeIDs.Add( OSMSourceData.NodeIDs[ SourceNodeIndex ] );
+			SortedNodeLatitudes.Add( OSMSourceData.NodeLatitudes[ SourceNodeIndex ] );
+			SortedNodeLongitudes.Add( OSMSourceData.NodeLongitudes[ SourceNodeIndex ] );
+		}
+		OSMSourceData.NodeIDs = MoveTemp( SortedNodeIDs );
+		OSMSourceData.NodeLatitudes = MoveTemp( SortedNodeLatitudes );
+		OSMSourceData.NodeLongitudes = MoveTemp( SortedNodeLongitudes );
+
+		// Welds to or from a deleted node don't mean anything anymore
+		for( auto WeldedNodeIt = WeldedOntoNodeIDs.CreateIterator(); WeldedNodeIt; ++WeldedNodeIt )
+		{
+			if( DeletedNodeIDs.Contains( WeldedNodeIt.Key() ) || DeletedNodeIDs.Contains( WeldedNodeIt.Value() ) )
+			{
+				WeldedNodeIt.RemoveCurrent();
+			}
+		}
+	}
+	SetWeldedNodes( OSMSourceData, WeldedOntoNodeIDs );
+
+	// Finally, update the map's bounds
+	StreetMap->BoundsMin = FVector2D( TNumericLimits<float>::Max(), TNumericLimits<float>::Max() );
+	StreetMap->BoundsMax = FVector2D( TNumericLimits<float>::Lowest(), TNumericLimits<float>::Lowest() );
+	for( const FStreetMapRoad& Road : Roads )
+	{
+		StreetMap->BoundsMin.X = FMath::Min( StreetMap->BoundsMin.X, Road.BoundsMin.X );
+		StreetMap->BoundsMin.Y = FMath::Min( StreetMap->BoundsMin.Y, Road.BoundsMin.Y );
+		StreetMap->BoundsMax.X = FMath::Max( StreetMap->BoundsMax.X, Road.BoundsMax.X );
+		StreetMap->BoundsMax.Y = FMath::Max( StreetMap->BoundsMax.Y, Road.BoundsMax.Y );
+	}
+	for( const FStreetMapBuilding& Building : Buildings )
+	{
+		StreetMap->BoundsMin.X = FMath::Min( StreetMap->BoundsMin.X, Building.BoundsMin.X );
+		StreetMap->BoundsMin.Y = FMath::Min( StreetMap->BoundsMin.Y, Building.BoundsMin.Y );
+		StreetMap->BoundsMax.X = FMath::Max( StreetMap->BoundsMax.X, Building.BoundsMax.X );
+		StreetMap->BoundsMax.Y = FMath::Max( StreetMap->BoundsMax.Y, Building.BoundsMax.Y );
+	}
+
+	StreetMap->CompactGeometry();
+	StreetMap->BuildCachedRoadData();
+	StreetMap->AppliedChangeFiles.Add( OSCFilePath );
+
+	if( FeedbackContext != nullptr )
+	{
+		FeedbackContext->Logf(
+			ELogVerbosity::Log,
+			TEXT( "Applied OpenStreetMap changes to '%s' in %.1f ms: removed %i roads and %i buildings, added %i roads and %i buildings, moved %i nodes, unwelded %i nodes and removed %i map nodes" ),
+			*StreetMap->GetName(),
+			( FPlatformTime::Seconds() - StartTime ) * 1000.0,
+			RemovedRoadCount,
+			RemovedBuildingCount,
+			Roads.Num() - FirstNewRoadIndex,
+			Buildings.Num() - FirstNewBuildingIndex,
+			MovedNodePositions.Num(),
+			UnweldedNodeCount,
+			RemovedNodeCount );
 	}
 
 	return true;
 }
 
-
+PRAGMA_ENABLE_DEPRECATION_WARNINGS
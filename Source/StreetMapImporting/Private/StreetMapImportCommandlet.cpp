@@ -0,0 +1,421 @@
+// Copyright 2017 Mike Fricker. All Rights Reserved.
+
+#include "StreetMapImportCommandlet.h"
+#include "StreetMapImporting.h"
+#include "StreetMapFactory.h"
+#include "StreetMap.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+#include "AssetRegistryModule.h"
+#include "ObjectTools.h"
+
+DEFINE_LOG_CATEGORY_STATIC( LogStreetMapImport, Log, All );
+
+
+namespace StreetMapImportCommandlet
+{
+	/** Passes everything an import logs on to the real log, and remembers the first error so it can go in the summary.
+	    Each import gets its own, so that imports running on different threads don't share any progress state. */
+	class FImportFeedbackContext : public FFeedbackContext
+	{
+
+	public:
+
+		virtual void Serialize( const TCHAR* V, ELogVerbosity::Type Verbosity, const FName& Category ) override
+		{
+			if( Verbosity <= ELogVerbosity::Error && FirstError.IsEmpty() )
+			{
+				FirstError = V;
+			}
+			GLog->Serialize( V, Verbosity, Category );
+		}
+
+		/** The first error the import logged, if any */
+		FString FirstError;
+	};
+
+
+	/** One file we're importing */
+	struct FImportJob
+	{
+		/** The OpenStreetMap file */
+		FString SourceFilePath;
+
+		/** Long name of the package the street map is saved in */
+		FString PackageName;
+
+		/** The street map we're importing into, and the factory doing the importing.  These are rooted while the import is
+		    running, because garbage is collected on the game thread whenever another import finishes. */
+		UStreetMap* StreetMap = nullptr;
+		UStreetMapFactory* Factory = nullptr;
+
+		/** Where the import logs to */
+		FImportFeedbackContext FeedbackContext;
+
+		/** Result of the import running on the worker thread */
+		TFuture<bool> Result;
+
+		/** When the import started, and how long it took (including saving) */
+		double StartTime = 0.0;
+		double Seconds = 0.0;
+
+		/** What we ended up with, for the summary */
+		bool bSucceeded = false;
+		int64 SourceFileSize = 0;
+		int64 SavedFileSize = 0;
+		int32 RoadCount = 0;
+		int32 NodeCount = 0;
+		int32 BuildingCount = 0;
+		int32 TileCount = 0;
+	};
+
+
+	/** Adds the files matching a path (which may contain wildcards) to the list of files to import */
+	static void AddSourceFiles( const FString& Path, TArray<FString>& OutSourceFilePaths )
+	{
+		const FString FullPath = FPaths::ConvertRelativePathToFull( Path.TrimStartAndEnd() );
+		if( FullPath.Contains( TEXT( "*" ) ) || FullPath.Contains( TEXT( "?" ) ) )
+		{
+			TArray<FString> FoundFileNames;
+			IFileManager::Get().FindFiles( FoundFileNames, *FullPath, true, false );
+			FoundFileNames.Sort();
+			for( const FString& FoundFileName : FoundFileNames )
+			{
+				OutSourceFilePaths.AddUnique( FPaths::GetPath( FullPath ) / FoundFileName );
+			}
+		}
+		else if( !Path.TrimStartAndEnd().IsEmpty() )
+		{
+			OutSourceFilePaths.AddUnique( FullPath );
+		}
+	}
+
+
+	/** Returns the name of the asset to import a file as.  Compressed and binary files (city.osm.gz, city.osm.pbf) lose
+	    both extensions. */
+	static FString GetAssetNameForFile( const FString& SourceFilePath )
+	{
+		FString BaseName = FPaths::GetBaseFilename( SourceFilePath );
+		const FString Extension = FPaths::GetExtension( SourceFilePath );
+		if( Extension.Equals( TEXT( "gz" ), ESearchCase::IgnoreCase ) || Extension.Equals( TEXT( "pbf" ), ESearchCase::IgnoreCase ) )
+		{
+			BaseName = FPaths::GetBaseFilename( BaseName );
+		}
+		return ObjectTools::SanitizeObjectName( BaseName );
+	}
+
+
+	/** Saves a street map's package to disk.  Returns the size of the saved file, or INDEX_NONE if it couldn't be saved. */
+	static int64 SaveStreetMapPackage( UStreetMap* StreetMap )
+	{
+		UPackage* Package = StreetMap->GetOutermost();
+		const FString PackageFileName = FPackageName::LongPackageNameToFilename( Package->GetName(), FPackageName::GetAssetPackageExtension() );
+		if( !UPackage::SavePackage( Package, StreetMap, RF_Public | RF_Standalone, *PackageFileName, GError, nullptr, false, true, SAVE_NoError ) )
+		{
+			return INDEX_NONE;
+		}
+		return IFileManager::Get().FileSize( *PackageFileName );
+	}
+}
+
+
+UStreetMapImportCommandlet::UStreetMapImportCommandlet( const FObjectInitializer& ObjectInitializer )
+	: Super( ObjectInitializer )
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+
+	HelpDescription = TEXT( "Imports OpenStreetMap files into street map assets, several at a time" );
+	HelpUsage = TEXT( "-run=StreetMapImport <Files...> [-FileList=<File>] [-Destination=/Game/StreetMaps] [-Jobs=<Count>] [-Options=\"(...)\"]" );
+	HelpParamNames.Add( TEXT( "FileList" ) );
+	HelpParamDescriptions.Add( TEXT( "Text file listing the files to import, one per line.  Wildcards are allowed." ) );
+	HelpParamNames.Add( TEXT( "Destination" ) );
+	HelpParamDescriptions.Add( TEXT( "Content folder to save the street maps in.  Defaults to /Game/StreetMaps." ) );
+	HelpParamNames.Add( TEXT( "Jobs" ) );
+	HelpParamDescriptions.Add( TEXT( "How many files to import at once.  Defaults to half the number of cores." ) );
+	HelpParamNames.Add( TEXT( "Options" ) );
+	HelpParamDescriptions.Add( TEXT( "Import options for every file, in FStreetMapImportOptions text form." ) );
+}
+
+
+int32 UStreetMapImportCommandlet::Main( const FString& Params )
+{
+	using namespace StreetMapImportCommandlet;
+
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> SwitchParams;
+	ParseCommandLine( *Params, Tokens, Switches, SwitchParams );
+
+	// Gather up the files to import
+	TArray<FString> SourceFilePaths;
+	for( const FString& Token : Tokens )
+	{
+		AddSourceFiles( Token, SourceFilePaths );
+	}
+	if( const FString* FileListPath = SwitchParams.Find( TEXT( "FileList" ) ) )
+	{
+		TArray<FString> FileListLines;
+		if( !FFileHelper::LoadFileToStringArray( FileListLines, **FileListPath ) )
+		{
+			UE_LOG( LogStreetMapImport, Error, TEXT( "Unable to read file list '%s'" ), **FileListPath );
+			return 1;
+		}
+		for( const FString& FileListLine : FileListLines )
+		{
+			AddSourceFiles( FileListLine, SourceFilePaths );
+		}
+	}
+	if( SourceFilePaths.Num() == 0 )
+	{
+		UE_LOG( LogStreetMapImport, Error, TEXT( "No files to import.  Usage: %s" ), *HelpUsage );
+		return 1;
+	}
+
+	FString Destination = TEXT( "/Game/StreetMaps" );
+	if( const FString* DestinationParam = SwitchParams.Find( TEXT( "Destination" ) ) )
+	{
+		Destination = *DestinationParam;
+		Destination.RemoveFromEnd( TEXT( "/" ) );
+	}
+	FText InvalidReason;
+	if( !FPackageName::IsValidLongPackageName( Destination / TEXT( "StreetMap" ), false, &InvalidReason ) )
+	{
+		UE_LOG( LogStreetMapImport, Error, TEXT( "Destination '%s' isn't a valid content folder: %s" ), *Destination, *InvalidReason.ToString() );
+		return 1;
+	}
+
+	FStreetMapImportOptions ImportOptions;
+	if( const FString* OptionsParam = SwitchParams.Find( TEXT( "Options" ) ) )
+	{
+		if( FStreetMapImportOptions::StaticStruct()->ImportText( **OptionsParam, &ImportOptions, nullptr, PPF_None, GWarn, TEXT( "Options" ) ) == nullptr )
+		{
+			UE_LOG( LogStreetMapImport, Error, TEXT( "Unable to parse import options '%s'" ), **OptionsParam );
+			return 1;
+		}
+	}
+
+	// Every import already spreads its own work across all of the cores, so by default we only run a few at once.  Each
+	// one also needs memory for a whole map, which is usually what limits how many we can run.
+	int32 MaxJobCount = FMath::Max( 1, FPlatformMisc::NumberOfCores() / 2 );
+	if( const FString* JobsParam = SwitchParams.Find( TEXT( "Jobs" ) ) )
+	{
+		MaxJobCount = FMath::Max( 1, FCString::Atoi( **JobsParam ) );
+	}
+	MaxJobCount = FMath::Min( MaxJobCount, SourceFilePaths.Num() );
+
+	UE_LOG( LogStreetMapImport, Display, TEXT( "Importing %i files into %s, %i at a time" ), SourceFilePaths.Num(), *Destination, MaxJobCount );
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<TUniquePtr<FImportJob>> Jobs;
+	for( const FString& SourceFilePath : SourceFilePaths )
+	{
+		TUniquePtr<FImportJob> Job( new FImportJob() );
+		Job->SourceFilePath = SourceFilePath;
+		Job->PackageName = Destination / GetAssetNameForFile( SourceFilePath );
+		Job->SourceFileSize = FMath::Max( IFileManager::Get().FileSize( *SourceFilePath ), (int64)0 );
+		Jobs.Add( MoveTemp( Job ) );
+	}
+
+	// Files with the same name in different folders (or city.osm next to city.osm.gz) would be imported into the same
+	// street map at the same time, so refuse to start until they're given different names
+	TMap<FString, TArray<FString>> SourceFilesByPackageName;
+	for( const TUniquePtr<FImportJob>& Job : Jobs )
+	{
+		SourceFilesByPackageName.FindOrAdd( Job->PackageName ).Add( Job->SourceFilePath );
+	}
+	bool bHasDuplicatePackageNames = false;
+	for( const TPair<FString, TArray<FString>>& PackageSourceFiles : SourceFilesByPackageName )
+	{
+		if( PackageSourceFiles.Value.Num() > 1 )
+		{
+			UE_LOG( LogStreetMapImport, Error, TEXT( "%i files would be imported as '%s': %s" ), PackageSourceFiles.Value.Num(), *PackageSourceFiles.Key, *FString::Join( PackageSourceFiles.Value, TEXT( ", " ) ) );
+			bHasDuplicatePackageNames = true;
+		}
+	}
+	if( bHasDuplicatePackageNames )
+	{
+		UE_LOG( LogStreetMapImport, Error, TEXT( "Every file has to import as a different street map.  Rename the files, or import them into different destinations one at a time." ) );
+		return 1;
+	}
+
+	// Objects are only ever created and saved on this thread.  The workers just do the conversion, which only touches the
+	// street map they were given.
+	auto StartJob = [ &ImportOptions ]( FImportJob& Job )
+	{
+		Job.StartTime = FPlatformTime::Seconds();
+
+		UPackage* Package = CreatePackage( nullptr, *Job.PackageName );
+		const FString AssetName = FPackageName::GetLongPackageAssetName( Job.PackageName );
+
+		Job.StreetMap = FindObject<UStreetMap>( Package, *AssetName );
+		if( Job.StreetMap == nullptr )
+		{
+			Job.StreetMap = NewObject<UStreetMap>( Package, *AssetName, RF_Public | RF_Standalone | RF_Transactional );
+			FAssetRegistryModule::AssetCreated( Job.StreetMap );
+		}
+		Job.StreetMap->AssetImportData->Update( Job.SourceFilePath );
+		Job.StreetMap->AddToRoot();
+
+		// Splitting into tiles creates more packages, so that's left until the import is back on this thread
+		Job.Factory = NewObject<UStreetMapFactory>();
+		Job.Factory->ImportOptions = ImportOptions;
+		Job.Factory->ImportOptions.bSplitIntoTiles = false;
+		Job.Factory->AddToRoot();
+
+		UStreetMap* StreetMap = Job.StreetMap;
+		UStreetMapFactory* Factory = Job.Factory;
+		FImportFeedbackContext* FeedbackContext = &Job.FeedbackContext;
+		const FString SourceFilePath = Job.SourceFilePath;
+		Job.Result = Async( EAsyncExecution::Thread, [ StreetMap, Factory, FeedbackContext, SourceFilePath ]()
+		{
+			const bool bIsFilePathActuallyTextBuffer = false;
+			return Factory->LoadFromOpenStreetMapXMLFile( StreetMap, SourceFilePath, bIsFilePathActuallyTextBuffer, FeedbackContext );
+		} );
+	};
+
+	auto FinishJob = [ &ImportOptions ]( FImportJob& Job )
+	{
+		Job.bSucceeded = Job.Result.Get();
+
+		UStreetMap* StreetMap = Job.StreetMap;
+		StreetMap->ImportOptions = ImportOptions;
+		Job.Factory->ImportOptions = ImportOptions;
+		if( Job.bSucceeded && ImportOptions.bSplitIntoTiles )
+		{
+			Job.bSucceeded = Job.Factory->SplitStreetMapIntoTiles( StreetMap, &Job.FeedbackContext, nullptr );
+		}
+
+		if( Job.bSucceeded )
+		{
+			Job.RoadCount = StreetMap->GetRoadCount();
+			Job.NodeCount = StreetMap->GetNodeCount();
+			Job.BuildingCount = StreetMap->GetBuildingCount();
+			Job.TileCount = StreetMap->GetTiles().Num();
+
+			for( const FStreetMapTile& Tile : StreetMap->GetTiles() )
+			{
+				UStreetMap* TileStreetMap = Tile.StreetMap.Get();
+				if( TileStreetMap == nullptr )
+				{
+					continue;
+				}
+				Job.RoadCount += TileStreetMap->GetRoadCount();
+				Job.NodeCount += TileStreetMap->GetNodeCount();
+				Job.BuildingCount += TileStreetMap->GetBuildingCount();
+
+				const int64 TileFileSize = SaveStreetMapPackage( TileStreetMap );
+				if( TileFileSize == INDEX_NONE )
+				{
+					Job.FeedbackContext.Logf( ELogVerbosity::Error, TEXT( "Unable to save '%s'" ), *TileStreetMap->GetOutermost()->GetName() );
+					Job.bSucceeded = false;
+					break;
+				}
+				Job.SavedFileSize += TileFileSize;
+			}
+		}
+
+		if( Job.bSucceeded )
+		{
+			const int64 FileSize = SaveStreetMapPackage( StreetMap );
+			if( FileSize == INDEX_NONE )
+			{
+				Job.FeedbackContext.Logf( ELogVerbosity::Error, TEXT( "Unable to save '%s'" ), *Job.PackageName );
+				Job.bSucceeded = false;
+			}
+			else
+			{
+				Job.SavedFileSize += FileSize;
+			}
+		}
+
+		Job.StreetMap->RemoveFromRoot();
+		Job.Factory->RemoveFromRoot();
+		Job.StreetMap = nullptr;
+		Job.Factory = nullptr;
+		Job.Seconds = FPlatformTime::Seconds() - Job.StartTime;
+
+		UE_LOG( LogStreetMapImport, Display, TEXT( "%s '%s' in %.1f seconds" ), Job.bSucceeded ? TEXT( "Imported" ) : TEXT( "Failed to import" ), *Job.SourceFilePath, Job.Seconds );
+	};
+
+	// Keep the pool full until we run out of files, saving each map as soon as it's done
+	int32 NextJobIndex = 0;
+	TArray<FImportJob*> RunningJobs;
+	while( NextJobIndex < Jobs.Num() || RunningJobs.Num() > 0 )
+	{
+		while( RunningJobs.Num() < MaxJobCount && NextJobIndex < Jobs.Num() )
+		{
+			FImportJob& Job = *Jobs[ NextJobIndex++ ];
+			StartJob( Job );
+			RunningJobs.Add( &Job );
+		}
+
+		bool bFinishedAnyJobs = false;
+		for( int32 RunningJobIndex = RunningJobs.Num() - 1; RunningJobIndex >= 0; --RunningJobIndex )
+		{
+			if( RunningJobs[ RunningJobIndex ]->Result.IsReady() )
+			{
+				FinishJob( *RunningJobs[ RunningJobIndex ] );
+				RunningJobs.RemoveAt( RunningJobIndex );
+				bFinishedAnyJobs = true;
+			}
+		}
+
+		if( bFinishedAnyJobs )
+		{
+			// Get rid of the maps we've saved, so that memory use doesn't keep growing with the number of files
+			CollectGarbage( GARBAGE_COLLECTION_KEEPFLAGS );
+		}
+		else
+		{
+			FPlatformProcess::Sleep( 0.01f );
+		}
+	}
+
+	// Summary
+	int32 FailedJobCount = 0;
+	int64 TotalSourceFileSize = 0;
+	int64 TotalSavedFileSize = 0;
+	UE_LOG( LogStreetMapImport, Display, TEXT( "" ) );
+	UE_LOG( LogStreetMapImport, Display, TEXT( "%-40s %8s %10s %10s %8s %8s %8s %6s  %s" ), TEXT( "File" ), TEXT( "Seconds" ), TEXT( "Source MB" ), TEXT( "Saved MB" ), TEXT( "Roads" ), TEXT( "Nodes" ), TEXT( "Bldgs" ), TEXT( "Tiles" ), TEXT( "Result" ) );
+	for( const TUniquePtr<FImportJob>& Job : Jobs )
+	{
+		UE_LOG(
+			LogStreetMapImport,
+			Display,
+			TEXT( "%-40s %8.1f %10.1f %10.1f %8i %8i %8i %6i  %s" ),
+			*FPaths::GetCleanFilename( Job->SourceFilePath ),
+			Job->Seconds,
+			(double)Job->SourceFileSize / ( 1024.0 * 1024.0 ),
+			(double)Job->SavedFileSize / ( 1024.0 * 1024.0 ),
+			Job->RoadCount,
+			Job->NodeCount,
+			Job->BuildingCount,
+			Job->TileCount,
+			Job->bSucceeded ? TEXT( "OK" ) : ( Job->FeedbackContext.FirstError.IsEmpty() ? TEXT( "Failed" ) : *Job->FeedbackContext.FirstError ) );
+
+		FailedJobCount += Job->bSucceeded ? 0 : 1;
+		TotalSourceFileSize += Job->SourceFileSize;
+		TotalSavedFileSize += Job->SavedFileSize;
+	}
+	UE_LOG(
+		LogStreetMapImport,
+		Display,
+		TEXT( "Imported %i of %i files (%.1f MB of source data, %.1f MB saved) in %.1f seconds" ),
+		Jobs.Num() - FailedJobCount,
+		Jobs.Num(),
+		(double)TotalSourceFileSize / ( 1024.0 * 1024.0 ),
+		(double)TotalSavedFileSize / ( 1024.0 * 1024.0 ),
+		FPlatformTime::Seconds() - StartTime );
+
+	return FailedJobCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+// Copyright 2017 Mike Fricker. All Rights Reserved.
+
+#include "StreetMapImportProfiler.h"
+#include "StreetMapImporting.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonWriter.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+
+
+FStreetMapImportProfiler::FScopedPhase::FScopedPhase( FStreetMapImportProfiler* InProfiler, const TCHAR* InName, TStatId StatId )
+	: CycleCounter( StatId ),
+	  Profiler( InProfiler ),
+	  Name( InName ),
+	  StartTime( FPlatformTime::Seconds() ),
+	  StartUsedPhysical( 0 ),
+	  StartPeakUsedPhysical( 0 ),
+	  ItemCount( 0 ),
+	  ItemName( TEXT( "" ) ),
+	  ByteCount( 0 )
+{
+	if( Profiler != nullptr )
+	{
+		const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+		StartUsedPhysical = MemoryStats.UsedPhysical;
+		StartPeakUsedPhysical = MemoryStats.PeakUsedPhysical;
+	}
+}
+
+
+FStreetMapImportProfiler::FScopedPhase::~FScopedPhase()
+{
+	if( Profiler != nullptr )
+	{
+		const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+
+		FPhase& Phase = Profiler->Phases[ Profiler->Phases.AddDefaulted() ];
+		Phase.Name = Name;
+		Phase.Seconds = FPlatformTime::Seconds() - StartTime;
+		Phase.ItemCount = ItemCount;
+		Phase.ItemName = ItemName;
+		Phase.ByteCount = ByteCount;
+		Phase.UsedPhysical = MemoryStats.UsedPhysical;
+		Phase.PeakUsedPhysical = MemoryStats.PeakUsedPhysical > StartPeakUsedPhysical ?
+			MemoryStats.PeakUsedPhysical :
+			FMath::Max( StartUsedPhysical, (uint64)MemoryStats.UsedPhysical );
+		Phase.ConcurrentImportCount = ActiveImportCount.GetValue();
+	}
+}
+
+
+FThreadSafeCounter FStreetMapImportProfiler::ActiveImportCount;
+
+
+FStreetMapImportProfiler::FStreetMapImportProfiler()
+	: StartTime( FPlatformTime::Seconds() )
+{
+	ActiveImportCount.Increment();
+}
+
+
+FStreetMapImportProfiler::~FStreetMapImportProfiler()
+{
+	ActiveImportCount.Decrement();
+}
+
+
+void FStreetMapImportProfiler::Report( const FString& AssetPathName, const FString& SourceFilePath, FFeedbackContext* FeedbackContext ) const
+{
+	const double TotalSeconds = FPlatformTime::Seconds() - StartTime;
+	const double BytesPerMB = 1024.0 * 1024.0;
+
+	uint64 PeakUsedPhysical = 0;
+	int32 MostConcurrentImports = 1;
+	for( const FPhase& Phase : Phases )
+	{
+		PeakUsedPhysical = FMath::Max( PeakUsedPhysical, Phase.PeakUsedPhysical );
+		MostConcurrentImports = FMath::Max( MostConcurrentImports, Phase.ConcurrentImportCount );
+	}
+
+	// The memory figures are always for the whole process, which only means much when nothing else was importing
+	const FString MemoryScope = MostConcurrentImports > 1 ?
+		FString::Printf( TEXT( "process-wide, shared with up to %i other imports" ), MostConcurrentImports - 1 ) :
+		FString( TEXT( "process-wide" ) );
+
+	if( FeedbackContext != nullptr )
+	{
+		FeedbackContext->Logf( ELogVerbosity::Log, TEXT( "Import profile for '%s': %.3f seconds, peak memory %.1f MB (%s)" ), *AssetPathName, TotalSeconds, (double)PeakUsedPhysical / BytesPerMB, *MemoryScope );
+		for( const FPhase& Phase : Phases )
+		{
+			FString Throughput;
+			if( Phase.ItemCount > 0 )
+			{
+				Throughput += FString::Printf( TEXT( ", %lld %s" ), Phase.ItemCount, *Phase.ItemName );
+				if( Phase.Seconds > 0.0 )
+				{
+					Throughput += FString::Printf( TEXT( " (%.0f/s)" ), (double)Phase.ItemCount / Phase.Seconds );
+				}
+			}
+			if( Phase.ByteCount > 0 && Phase.Seconds > 0.0 )
+			{
+				Throughput += FString::Printf( TEXT( ", %.1f MB/s" ), (double)Phase.ByteCount / BytesPerMB / Phase.Seconds );
+			}
+			FeedbackContext->Logf( ELogVerbosity::Log, TEXT( "    %s: %.3f seconds%s, peak memory %.1f MB" ), *Phase.Name, Phase.Seconds, *Throughput, (double)Phase.PeakUsedPhysical / BytesPerMB );
+		}
+	}
+
+	FString Json;
+	TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> JsonWriter = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create( &Json );
+	JsonWriter->WriteObjectStart();
+	JsonWriter->WriteValue( TEXT( "asset" ), AssetPathName );
+	JsonWriter->WriteValue( TEXT( "source" ), SourceFilePath );
+	JsonWriter->WriteValue( TEXT( "time" ), FDateTime::UtcNow().ToIso8601() );
+	JsonWriter->WriteValue( TEXT( "engineVersion" ), FEngineVersion::Current().ToString() );
+	JsonWriter->WriteValue( TEXT( "totalSeconds" ), TotalSeconds );
+	JsonWriter->WriteValue( TEXT( "peakUsedPhysicalMB" ), (double)PeakUsedPhysical / BytesPerMB );
+	JsonWriter->WriteValue( TEXT( "memoryScope" ), MemoryScope );
+	JsonWriter->WriteValue( TEXT( "concurrentImports" ), MostConcurrentImports );
+	JsonWriter->WriteArrayStart( TEXT( "phases" ) );
+	for( const FPhase& Phase : Phases )
+	{
+		JsonWriter->WriteObjectStart();
+		JsonWriter->WriteValue( TEXT( "name" ), Phase.Name );
+		JsonWriter->WriteValue( TEXT( "seconds" ), Phase.Seconds );
+		if( Phase.ItemCount > 0 )
+		{
+			JsonWriter->WriteValue( TEXT( "items" ), (double)Phase.ItemCount );
+			JsonWriter->WriteValue( TEXT( "itemName" ), Phase.ItemName );
+			JsonWriter->WriteValue( TEXT( "itemsPerSecond" ), Phase.Seconds > 0.0 ? (double)Phase.ItemCount / Phase.Seconds : 0.0 );
+		}
+		if( Phase.ByteCount > 0 )
+		{
+			JsonWriter->WriteValue( TEXT( "bytes" ), (double)Phase.ByteCount );
+			JsonWriter->WriteValue( TEXT( "megabytesPerSecond" ), Phase.Seconds > 0.0 ? (double)Phase.ByteCount / BytesPerMB / Phase.Seconds : 0.0 );
+		}
+		JsonWriter->WriteValue( TEXT( "usedPhysicalMB" ), (double)Phase.UsedPhysical / BytesPerMB );
+		JsonWriter->WriteValue( TEXT( "peakUsedPhysicalMB" ), (double)Phase.PeakUsedPhysical / BytesPerMB );
+		JsonWriter->WriteValue( TEXT( "concurrentImports" ), Phase.ConcurrentImportCount );
+		JsonWriter->WriteObjectEnd();
+	}
+	JsonWriter->WriteArrayEnd();
+	JsonWriter->WriteObjectEnd();
+	JsonWriter->Close();
+
+	// Mirror the asset's folder under Saved/StreetMap.  The object name is only added as its own level when it differs
+	// from the package name, which is the case for maps that don't have a package to themselves.
+	FString PackageName = AssetPathName;
+	FString ObjectName;
+	AssetPathName.Split( TEXT( "." ), &PackageName, &ObjectName );
+	FString ReportName = PackageName;
+	if( !ObjectName.IsEmpty() && ObjectName != FPackageName::GetShortName( PackageName ) )
+	{
+		ReportName /= FPaths::MakeValidFileName( ObjectName );
+	}
+	const FString ReportFilePath = FPaths::ProjectSavedDir() / TEXT( "StreetMap" ) / ( ReportName + TEXT( ".ImportProfile.json" ) );
+	if( !FFileHelper::SaveStringToFile( Json, *ReportFilePath ) )
+	{
+		if( FeedbackContext != nullptr )
+		{
+			FeedbackContext->Logf( ELogVerbosity::Warning, TEXT( "Unable to write import profile to '%s'" ), *ReportFilePath );
+		}
+	}
+	else if( FeedbackContext != nullptr )
+	{
+		FeedbackContext->Logf( ELogVerbosity::Log, TEXT( "Wrote import profile to '%s'" ), *ReportFilePath );
+	}
+}
@@ -5,6 +5,17 @@
 #include "StreetMap.h"
 
 
+/** Returns true if the file is an OpenStreetMap change file (.osc, or .osc.gz since these are usually distributed gzip
+    compressed) rather than a full map */
+static bool IsOpenStreetMapChangeFile( const FString& Filename )
+{
+	const FString FileExtension = FPaths::GetExtension( Filename );
+	const bool bIsCompressed = FileExtension.Equals( TEXT( "gz" ), ESearchCase::IgnoreCase );
+	const FString UncompressedExtension = bIsCompressed ? FPaths::GetExtension( FPaths::GetBaseFilename( Filename ) ) : FileExtension;
+	return UncompressedExtension.Equals( TEXT( "osc" ), ESearchCase::IgnoreCase );
+}
+
+
 UStreetMapReimportFactory::UStreetMapReimportFactory(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
@@ -25,6 +36,16 @@ bool UStreetMapReimportFactory::CanReimport( UObject* Obj, TArray<FString>& OutF
 void UStreetMapReimportFactory::SetReimportPaths( UObject* Obj, const TArray<FString>& NewReimportPaths )
 {
 	UStreetMap* StreetMap = CastChecked<UStreetMap>( Obj );
+
+	// Change files are applied by the Reimport() that follows, but the map keeps the full OpenStreetMap file as the
+	// file to reimport from
+	if( IsOpenStreetMapChangeFile( NewReimportPaths[0] ) )
+	{
+		PendingChangeFileStreetMap = StreetMap;
+		PendingChangeFilePath = NewReimportPaths[0];
+		return;
+	}
+
 	StreetMap->Modify();
 	StreetMap->AssetImportData->Update( NewReimportPaths[0] );
 }
@@ -34,8 +55,23 @@ EReimportResult::Type UStreetMapReimportFactory::Reimport( UObject* Obj )
 { 
 	UStreetMap* StreetMap = CastChecked<UStreetMap>( Obj );
 
+	// OpenStreetMap change files are applied to the map we already have, rather than replacing it
+	if( PendingChangeFileStreetMap.Get() == StreetMap && !PendingChangeFilePath.IsEmpty() )
+	{
+		const FString ChangeFilePath = PendingChangeFilePath;
+		PendingChangeFileStreetMap.Reset();
+		PendingChangeFilePath.Empty();
+
+		if( ApplyOpenStreetMapChangeFile( StreetMap, ChangeFilePath, GWarn ) )
+		{
+			StreetMap->PostEditChange();
+			StreetMap->MarkPackageDirty();
+			return EReimportResult::Succeeded;
+		}
+		return EReimportResult::Failed;
+	}
+
 	const FString Filename = StreetMap->AssetImportData->GetFirstFilename();
-	const FString FileExtension = FPaths::GetExtension(Filename);
 
 	// If there is no file path provided, can't reimport from source
 	if ( !Filename.Len() )
@@ -43,6 +79,20 @@ EReimportResult::Type UStreetMapReimportFactory::Reimport( UObject* Obj )
 		return EReimportResult::Failed;
 	}
 
+	// Maps from before we kept track of applied change files may still point at the last one they had applied
+	if( IsOpenStreetMapChangeFile( Filename ) )
+	{
+		GWarn->Logf(
+			ELogVerbosity::Error,
+			TEXT( "Street map '%s' was last updated from the change file '%s', which can't be reimported on its own.  Use Reimport With New File to pick the full OpenStreetMap file instead." ),
+			*StreetMap->GetName(),
+			*Filename );
+		return EReimportResult::Failed;
+	}
+
+	// Import with the same options as last time
+	ImportOptions = StreetMap->ImportOptions;
+
 	if( UFactory::StaticImportObject( StreetMap->GetClass(), StreetMap->GetOuter(), *StreetMap->GetName(), RF_Public|RF_Standalone, *Filename, nullptr, this ) )
 	{
 		// Mark the package dirty after the successful import
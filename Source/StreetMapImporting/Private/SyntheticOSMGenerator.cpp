@@ -0,0 +1,360 @@
+// Copyright 2017 Mike Fricker. All Rights Reserved.
+
+#include "SyntheticOSMGenerator.h"
+#include "StreetMapImporting.h"
+#include "HAL/FileManager.h"
+
+
+namespace SyntheticOSMGenerator
+{
+	// Where the map is, and how big each block is in degrees (about 100 meters each way at this latitude)
+	static const double OriginLatitude = 47.6;
+	static const double OriginLongitude = -122.35;
+	static const double BlockLatitudeSize = 0.0009;
+	static const double BlockLongitudeSize = 0.0013;
+
+	// Most buildings a block can have.  Each one goes in its own quarter of the block.
+	static const int32 MaxBuildingsPerBlock = 4;
+
+	// How many nodes make up a building's outline (not counting the closing node, which repeats the first)
+	static const int32 BuildingCornerCount = 4;
+
+	// Salts for MakeRandomStream(), so that each kind of thing at a grid position gets different random numbers
+	static const int32 IntersectionSalt = 1;
+	static const int32 HorizontalStreetSalt = 2;
+	static const int32 VerticalStreetSalt = 3;
+	static const int32 BlockSalt = 4;
+	static const int32 StreetWaySalt = 5;
+
+	// Values we tag buildings with
+	static const TCHAR* BuildingTypes[] = { TEXT( "yes" ), TEXT( "house" ), TEXT( "apartments" ), TEXT( "commercial" ), TEXT( "retail" ) };
+	static const int32 BuildingTypeCount = 5;
+
+	// How much output we build up before writing it to the file
+	static const int32 WriteBufferSize = 1024 * 1024;
+
+
+	/** A kind of street, and what we tag it with */
+	struct FStreetType
+	{
+		const TCHAR* HighwayType;
+		int32 MaxSpeed;
+		bool bIsAlwaysOneWay;
+	};
+
+	static const FStreetType Motorway = { TEXT( "motorway" ), 100, true };
+	static const FStreetType Primary = { TEXT( "primary" ), 60, false };
+	static const FStreetType Secondary = { TEXT( "secondary" ), 50, false };
+	static const FStreetType Tertiary = { TEXT( "tertiary" ), 50, false };
+	static const FStreetType Residential = { TEXT( "residential" ), 30, false };
+
+
+	/** What kind of street runs along a grid line.  Every so often there is a bigger road, like in a real city. */
+	static const FStreetType& GetStreetTypeForGridLine( const int32 Line )
+	{
+		if( Line % 40 == 0 )
+		{
+			return Motorway;
+		}
+		if( Line % 20 == 0 )
+		{
+			return Primary;
+		}
+		if( Line % 10 == 0 )
+		{
+			return Secondary;
+		}
+		if( Line % 5 == 0 )
+		{
+			return Tertiary;
+		}
+		return Residential;
+	}
+}
+
+
+FRandomStream FSyntheticOSMGenerator::MakeRandomStream( const int32 X, const int32 Y, const int32 Salt ) const
+{
+	uint32 Hash = HashCombine( GetTypeHash( Seed ), GetTypeHash( Salt ) );
+	Hash = HashCombine( Hash, GetTypeHash( X ) );
+	Hash = HashCombine( Hash, GetTypeHash( Y ) );
+	return FRandomStream( (int32)Hash );
+}
+
+
+FOSMFile::FOSMCoordinate FSyntheticOSMGenerator::GetIntersectionCoordinate( const int32 X, const int32 Y ) const
+{
+	using namespace SyntheticOSMGenerator;
+
+	// Streets aren't perfectly straight, so nudge each intersection a little
+	FRandomStream Random = MakeRandomStream( X, Y, IntersectionSalt );
+	const double JitterX = Random.FRandRange( -0.05f, 0.05f );
+	const double JitterY = Random.FRandRange( -0.05f, 0.05f );
+	FOSMFile::FOSMCoordinate Coordinate;
+	Coordinate.Latitude = OriginLatitude + ( Y + JitterY ) * BlockLatitudeSize;
+	Coordinate.Longitude = OriginLongitude + ( X + JitterX ) * BlockLongitudeSize;
+	return Coordinate;
+}
+
+
+int32 FSyntheticOSMGenerator::GetBlockBuildingCount( const int32 X, const int32 Y ) const
+{
+	FRandomStream Random = MakeRandomStream( X, Y, SyntheticOSMGenerator::BlockSalt );
+	return Random.RandRange( 0, SyntheticOSMGenerator::MaxBuildingsPerBlock );
+}
+
+
+int64 FSyntheticOSMGenerator::GetIntersectionNodeID( const int32 X, const int32 Y ) const
+{
+	return 1 + (int64)Y * ( GridSize + 1 ) + X;
+}
+
+
+int64 FSyntheticOSMGenerator::GetHorizontalStreetNodeID( const int32 X, const int32 Y, const int32 Index ) const
+{
+	const int64 FirstID = GetIntersectionNodeID( 0, GridSize + 1 );
+	return FirstID + ( (int64)Y * GridSize + X ) * NodesBetweenIntersections + Index;
+}
+
+
+int64 FSyntheticOSMGenerator::GetVerticalStreetNodeID( const int32 X, const int32 Y, const int32 Index ) const
+{
+	const int64 FirstID = GetHorizontalStreetNodeID( 0, GridSize + 1, 0 );
+	return FirstID + ( (int64)X * GridSize + Y ) * NodesBetweenIntersections + Index;
+}
+
+
+int64 FSyntheticOSMGenerator::GetBuildingNodeID( const int32 X, const int32 Y, const int32 Building, const int32 Corner ) const
+{
+	using namespace SyntheticOSMGenerator;
+
+	const int64 FirstID = GetVerticalStreetNodeID( GridSize + 1, 0, 0 );
+	return FirstID + ( ( (int64)Y * GridSize + X ) * MaxBuildingsPerBlock + Building ) * BuildingCornerCount + Corner;
+}
+
+
+bool FSyntheticOSMGenerator::WriteToFile( const FString& FilePath, FFeedbackContext* FeedbackContext )
+{
+	using namespace SyntheticOSMGenerator;
+
+	// Each block has a street along two of its sides (with an intersection and the nodes between intersections), and
+	// half of the most buildings it can have, on average
+	const int32 NodesPerBlock = 2 * ( NodesBetweenIntersections + 1 ) + ( MaxBuildingsPerBlock * BuildingCornerCount ) / 2;
+	GridSize = FMath::Max( 2, (int32)FMath::CeilToDouble( FMath::Sqrt( (double)TargetNodeCount / NodesPerBlock ) ) );
+	NodeCount = 0;
+	WayCount = 0;
+	BuildingCount = 0;
+
+	TUniquePtr<FArchive> FileWriter( IFileManager::Get().CreateFileWriter( *FilePath ) );
+	if( !FileWriter )
+	{
+		if( FeedbackContext != nullptr )
+		{
+			FeedbackContext->Logf( ELogVerbosity::Error, TEXT( "Unable to write synthetic OpenStreetMap file '%s'" ), *FilePath );
+		}
+		return false;
+	}
+
+	TArray<ANSICHAR> WriteBuffer;
+	WriteBuffer.Reserve( WriteBufferSize + 1024 );
+	auto Write = [ &WriteBuffer, &FileWriter ]( const FString& Text )
+	{
+		const FTCHARToUTF8 Converted( *Text );
+		WriteBuffer.Append( (const ANSICHAR*)Converted.Get(), Converted.Length() );
+		if( WriteBuffer.Num() >= WriteBufferSize )
+		{
+			FileWriter->Serialize( WriteBuffer.GetData(), WriteBuffer.Num() );
+			WriteBuffer.Reset();
+		}
+	};
+
+	auto WriteNode = [ &Write, this ]( const int64 NodeID, const double Latitude, const double Longitude )
+	{
+		Write( FString::Printf( TEXT( " <node id=\"%lld\" visible=\"true\" version=\"1\" lat=\"%.7f\" lon=\"%.7f\"/>\n" ), NodeID, Latitude, Longitude ) );
+		++NodeCount;
+	};
+
+	auto WriteTag = [ &Write ]( const TCHAR* Key, const FString& Value )
+	{
+		Write( FString::Printf( TEXT( "  <tag k=\"%s\" v=\"%s\"/>\n" ), Key, *Value ) );
+	};
+
+	Write( TEXT( "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" ) );
+	Write( TEXT( "<osm version=\"0.6\" generator=\"StreetMap synthetic benchmark map\">\n" ) );
+	Write( FString::Printf(
+		TEXT( " <bounds minlat=\"%.7f\" minlon=\"%.7f\" maxlat=\"%.7f\" maxlon=\"%.7f\"/>\n" ),
+		OriginLatitude - BlockLatitudeSize,
+		OriginLongitude - BlockLongitudeSize,
+		OriginLatitude + ( GridSize + 1 ) * BlockLatitudeSize,
+		OriginLongitude + ( GridSize + 1 ) * BlockLongitudeSize ) );
+
+	// Nodes come first, in order of ID like in real files.  Intersections...
+	for( int32 Y = 0; Y <= GridSize; ++Y )
+	{
+		for( int32 X = 0; X <= GridSize; ++X )
+		{
+			const FOSMFile::FOSMCoordinate Coordinate = GetIntersectionCoordinate( X, Y );
+			WriteNode( GetIntersectionNodeID( X, Y ), Coordinate.Latitude, Coordinate.Longitude );
+		}
+	}
+
+	// ...then the nodes between them, which wander a little to either side of the street
+	auto WriteStreetNodes = [ & ]( const int32 X, const int32 Y, const bool bIsHorizontal )
+	{
+		const FOSMFile::FOSMCoordinate Start = GetIntersectionCoordinate( X, Y );
+		const FOSMFile::FOSMCoordinate End = bIsHorizontal ? GetIntersectionCoordinate( X + 1, Y ) : GetIntersectionCoordinate( X, Y + 1 );
+		FRandomStream Random = MakeRandomStream( X, Y, bIsHorizontal ? HorizontalStreetSalt : VerticalStreetSalt );
+		for( int32 Index = 0; Index < NodesBetweenIntersections; ++Index )
+		{
+			const double Alpha = (double)( Index + 1 ) / ( NodesBetweenIntersections + 1 );
+			const double Wander = Random.FRandRange( -0.01f, 0.01f );
+			const double Latitude = FMath::Lerp( Start.Latitude, End.Latitude, Alpha ) + ( bIsHorizontal ? Wander * BlockLatitudeSize : 0.0 );
+			const double Longitude = FMath::Lerp( Start.Longitude, End.Longitude, Alpha ) + ( bIsHorizontal ? 0.0 : Wander * BlockLongitudeSize );
+			WriteNode( bIsHorizontal ? GetHorizontalStreetNodeID( X, Y, Index ) : GetVerticalStreetNodeID( X, Y, Index ), Latitude, Longitude );
+		}
+	};
+	for( int32 Y = 0; Y <= GridSize; ++Y )
+	{
+		for( int32 X = 0; X < GridSize; ++X )
+		{
+			WriteStreetNodes( X, Y, true );
+		}
+	}
+	for( int32 X = 0; X <= GridSize; ++X )
+	{
+		for( int32 Y = 0; Y < GridSize; ++Y )
+		{
+			WriteStreetNodes( X, Y, false );
+		}
+	}
+
+	// ...and then the corners of the buildings.  Each building is a rectangle somewhere in its own quarter of the block.
+	auto WriteBuildingNodes = [ & ]( const int32 X, const int32 Y, const int32 Building )
+	{
+		FRandomStream Random = MakeRandomStream( X, Y, BlockSalt * MaxBuildingsPerBlock + Building + 1 );
+		const double QuarterLatitude = OriginLatitude + ( Y + ( Building / 2 ) * 0.5 ) * BlockLatitudeSize;
+		const double QuarterLongitude = OriginLongitude + ( X + ( Building % 2 ) * 0.5 ) * BlockLongitudeSize;
+		const double MinLatitude = QuarterLatitude + Random.FRandRange( 0.1f, 0.2f ) * BlockLatitudeSize;
+		const double MinLongitude = QuarterLongitude + Random.FRandRange( 0.1f, 0.2f ) * BlockLongitudeSize;
+		const double MaxLatitude = QuarterLatitude + Random.FRandRange( 0.3f, 0.4f ) * BlockLatitudeSize;
+		const double MaxLongitude = QuarterLongitude + Random.FRandRange( 0.3f, 0.4f ) * BlockLongitudeSize;
+		WriteNode( GetBuildingNodeID( X, Y, Building, 0 ), MinLatitude, MinLongitude );
+		WriteNode( GetBuildingNodeID( X, Y, Building, 1 ), MinLatitude, MaxLongitude );
+		WriteNode( GetBuildingNodeID( X, Y, Building, 2 ), MaxLatitude, MaxLongitude );
+		WriteNode( GetBuildingNodeID( X, Y, Building, 3 ), MaxLatitude, MinLongitude );
+	};
+	for( int32 Y = 0; Y < GridSize; ++Y )
+	{
+		for( int32 X = 0; X < GridSize; ++X )
+		{
+			const int32 BlockBuildingCount = GetBlockBuildingCount( X, Y );
+			for( int32 Building = 0; Building < BlockBuildingCount; ++Building )
+			{
+				WriteBuildingNodes( X, Y, Building );
+			}
+		}
+	}
+
+	// Streets run the whole length of each grid line, but are split up into ways a few blocks long, the way OpenStreetMap
+	// streets get split wherever their tags change
+	int64 NextWayID = 1;
+	auto WriteStreets = [ & ]( const int32 Line, const bool bIsHorizontal )
+	{
+		const FStreetType& StreetType = GetStreetTypeForGridLine( Line );
+		FRandomStream Random = MakeRandomStream( bIsHorizontal ? 1 : 0, Line, StreetWaySalt );
+
+		int32 Start = 0;
+		while( Start < GridSize )
+		{
+			const int32 End = FMath::Min( Start + Random.RandRange( 2, 8 ), GridSize );
+
+			Write( FString::Printf( TEXT( " <way id=\"%lld\" visible=\"true\" version=\"1\">\n" ), NextWayID++ ) );
+			for( int32 Block = Start; Block <= End; ++Block )
+			{
+				const int32 X = bIsHorizontal ? Block : Line;
+				const int32 Y = bIsHorizontal ? Line : Block;
+				Write( FString::Printf( TEXT( "  <nd ref=\"%lld\"/>\n" ), GetIntersectionNodeID( X, Y ) ) );
+				if( Block < End )
+				{
+					for( int32 Index = 0; Index < NodesBetweenIntersections; ++Index )
+					{
+						const int64 NodeID = bIsHorizontal ? GetHorizontalStreetNodeID( X, Y, Index ) : GetVerticalStreetNodeID( X, Y, Index );
+						Write( FString::Printf( TEXT( "  <nd ref=\"%lld\"/>\n" ), NodeID ) );
+					}
+				}
+			}
+
+			WriteTag( TEXT( "highway" ), StreetType.HighwayType );
+			WriteTag( TEXT( "name" ), FString::Printf( bIsHorizontal ? TEXT( "%i Street" ) : TEXT( "%i Avenue" ), Line + 1 ) );
+			WriteTag( TEXT( "maxspeed" ), FString::FromInt( StreetType.MaxSpeed ) );
+			WriteTag( TEXT( "surface" ), TEXT( "asphalt" ) );
+			if( StreetType.bIsAlwaysOneWay || Random.FRand() < 0.15f )
+			{
+				WriteTag( TEXT( "oneway" ), TEXT( "yes" ) );
+			}
+			else
+			{
+				WriteTag( TEXT( "lanes" ), TEXT( "2" ) );
+			}
+			Write( TEXT( " </way>\n" ) );
+			++WayCount;
+
+			Start = End;
+		}
+	};
+	for( int32 Y = 0; Y <= GridSize; ++Y )
+	{
+		WriteStreets( Y, true );
+	}
+	for( int32 X = 0; X <= GridSize; ++X )
+	{
+		WriteStreets( X, false );
+	}
+
+	// Buildings, with a mix of types and sizes
+	for( int32 Y = 0; Y < GridSize; ++Y )
+	{
+		for( int32 X = 0; X < GridSize; ++X )
+		{
+			const int32 BlockBuildingCount = GetBlockBuildingCount( X, Y );
+			FRandomStream Random = MakeRandomStream( X, Y, BlockSalt );
+			for( int32 Building = 0; Building < BlockBuildingCount; ++Building )
+			{
+				Write( FString::Printf( TEXT( " <way id=\"%lld\" visible=\"true\" version=\"1\">\n" ), NextWayID++ ) );
+				for( int32 Corner = 0; Corner <= BuildingCornerCount; ++Corner )
+				{
+					Write( FString::Printf( TEXT( "  <nd ref=\"%lld\"/>\n" ), GetBuildingNodeID( X, Y, Building, Corner % BuildingCornerCount ) ) );
+				}
+
+				WriteTag( TEXT( "building" ), BuildingTypes[ Random.RandRange( 0, BuildingTypeCount - 1 ) ] );
+				const int32 Levels = Random.RandRange( 1, 12 );
+				WriteTag( TEXT( "building:levels" ), FString::FromInt( Levels ) );
+				if( Random.FRand() < 0.5f )
+				{
+					WriteTag( TEXT( "height" ), FString::Printf( TEXT( "%.1f" ), Levels * 3.2f ) );
+				}
+				Write( TEXT( " </way>\n" ) );
+				++WayCount;
+				++BuildingCount;
+			}
+		}
+	}
+
+	Write( TEXT( "</osm>\n" ) );
+	FileWriter->Serialize( WriteBuffer.GetData(), WriteBuffer.Num() );
+	const bool bSucceeded = FileWriter->Close();
+
+	if( FeedbackContext != nullptr )
+	{
+		FeedbackContext->Logf(
+			ELogVerbosity::Log,
+			TEXT( "Wrote synthetic OpenStreetMap file '%s' (%i x %i blocks): %lld nodes, %lld ways, %lld buildings" ),
+			*FilePath,
+			GridSize,
+			GridSize,
+			NodeCount,
+			WayCount,
+			BuildingCount );
+	}
+	return bSucceeded;
+}
@@ -1,11 +1,187 @@
 // Copyright 2017 Mike Fricker. All Rights Reserved.
 #pragma once
 
-#include "FastXml.h"
+class FStreetMapImportProfiler;
+
+
+/** Non-owning view of a UTF-8 string that lives inside the XML source buffer.  Not null terminated! */
+struct FOSMStringView
+{
+	/** First character of the string */
+	const ANSICHAR* Data;
+
+	/** Number of characters in the string */
+	int32 Len;
+
+	FOSMStringView()
+		: Data( nullptr ),
+		  Len( 0 )
+	{
+	}
+
+	FOSMStringView( const ANSICHAR* InData, const int32 InLen )
+		: Data( InData ),
+		  Len( InLen )
+	{
+	}
+
+	/** Case-insensitive comparison against a null terminated ASCII literal */
+	bool Equals( const ANSICHAR* Literal ) const;
+
+	/** Parses the string as a base 10 integer */
+	int64 ToInt64() const;
+
+	/** Parses the string as a decimal floating point number */
+	double ToDouble() const;
+
+	/** Decodes the string (UTF-8, with XML character entities) into an FString */
+	FString ToString() const;
+};
+
+
+/** Allocates objects of a single type out of large blocks.  Allocation is just a pointer increment, and all of the
+    objects are destroyed together when the arena is emptied.  Objects never move once they're allocated. */
+template<typename ElementType, int32 ElementsPerBlock = 16384>
+class TOSMArena
+{
+
+public:
+
+	TOSMArena()
+		: NumElements( 0 ),
+		  Cursor( nullptr ),
+		  BlockEnd( nullptr )
+	{
+	}
+
+	~TOSMArena()
+	{
+		Empty();
+	}
+
+	TOSMArena( const TOSMArena& ) = delete;
+	TOSMArena& operator=( const TOSMArena& ) = delete;
+
+	/** Constructs a new object in the arena */
+	template<typename... ArgsType>
+	ElementType* Allocate( ArgsType&&... Args )
+	{
+		if( Cursor == BlockEnd )
+		{
+			Cursor = (ElementType*)FMemory::Malloc( sizeof( ElementType ) * ElementsPerBlock, alignof( ElementType ) );
+			BlockEnd = Cursor + ElementsPerBlock;
+			Blocks.Add( Cursor );
+		}
+
+		++NumElements;
+		return new( Cursor++ ) ElementType( Forward<ArgsType>( Args )... );
+	}
+
+	/** Destroys every object in the arena and frees its memory */
+	void Empty()
+	{
+		for( int32 BlockIndex = 0; BlockIndex < Blocks.Num(); ++BlockIndex )
+		{
+			// Every block is full except for the last one
+			const int32 BlockElementCount = ( BlockIndex < Blocks.Num() - 1 ) ? ElementsPerBlock : (int32)( Cursor - Blocks[ BlockIndex ] );
+			DestructItems( Blocks[ BlockIndex ], BlockElementCount );
+			FMemory::Free( Blocks[ BlockIndex ] );
+		}
+		Blocks.Empty();
+
+		NumElements = 0;
+		Cursor = nullptr;
+		BlockEnd = nullptr;
+	}
+
+	/** Returns the number of objects in the arena */
+	int64 Num() const
+	{
+		return NumElements;
+	}
+
+	/** Returns the number of bytes allocated for the arena's blocks.  Doesn't include memory the objects allocate themselves. */
+	int64 GetAllocatedSize() const
+	{
+		return (int64)Blocks.Num() * ElementsPerBlock * sizeof( ElementType ) + Blocks.GetAllocatedSize();
+	}
+
+
+private:
+
+	// Blocks of memory that we've allocated
+	TArray<ElementType*> Blocks;
+
+	// Number of objects in the arena
+	int64 NumElements;
+
+	// Next free slot in the last block, and the end of that block
+	ElementType* Cursor;
+	ElementType* BlockEnd;
+};
+
+
+/** Keep and drop rules over the tags of ways, compiled into a hash table so that each tag a way has costs a single
+    lookup while the file is parsed.  Rules are in priority order: if several of a way's tags match, the first rule wins. */
+class FOSMTagFilter
+{
+
+public:
+
+	/** Adds a rule for a tag.  An empty Value (or "*") matches any value.  Tags are matched without regard to case. */
+	void AddRule( const FString& Key, const FString& Value, const bool bKeep );
+
+	/** Builds the lookup table.  Call this after adding the rules, before using the filter. */
+	void Compile();
+
+	/** Returns the index of the first rule that matches a tag, or INDEX_NONE if none of them do */
+	int32 FindRule( const FOSMStringView& Key, const FOSMStringView& Value ) const;
+
+	/** Returns whether ways matching the specified rule are kept */
+	bool IsKeepRule( const int32 RuleIndex ) const
+	{
+		return Rules[ RuleIndex ].bKeep;
+	}
+
+	/** Returns true if there are no rules */
+	bool IsEmpty() const
+	{
+		return Rules.Num() == 0;
+	}
+
+
+private:
+
+	struct FRule
+	{
+		// UTF-8 tag key and value, not null terminated
+		TArray<ANSICHAR> Key;
+		TArray<ANSICHAR> Value;
+
+		// Whether the rule matches any value of the key
+		bool bAnyValue;
+
+		// Whether ways that match are kept
+		bool bKeep;
+
+		// Hash of the key, or of the key and value together
+		uint32 Hash;
+	};
+
+	/** Returns the index of the rule with the specified hash whose strings match, or INDEX_NONE */
+	int32 FindRuleWithHash( const uint32 Hash, const FOSMStringView& Key, const FOSMStringView* Value ) const;
+
+	// The rules, in priority order
+	TArray<FRule> Rules;
+
+	// Open addressing hash table of rule indices, with INDEX_NONE in empty slots.  Its size is a power of two.  Only the
+	// first of several rules for the same tag is in here, because the others could never win.
+	TArray<int32> RuleTable;
+};
 
 
 /** OpenStreetMap file loader */
-class FOSMFile : public IFastXmlCallback
+class FOSMFile
 {
 	
 public:
@@ -16,9 +192,8 @@ public:
 	/** Destructor for FOSMFile */
 	virtual ~FOSMFile();
 
-	/** Loads the map from an OpenStreetMap XML file.  Note that in the case of the file path containing the XML data, the string must be mutable for us to parse it quickly. */
-	bool LoadOpenStreetMapFile( FString& OSMFilePath, const bool bIsFilePathActuallyTextBuffer, class FFeedbackContext* FeedbackContext );
-
+	/** Loads the map from an OpenStreetMap XML or PBF file.  Files on disk are memory mapped and parsed in place without being copied, so there is no limit on their size. */
+	bool LoadOpenStreetMapFile( const FString& OSMFilePath, const bool bIsFilePathActuallyTextBuffer, class FFeedbackContext* FeedbackContext );
 
 	struct FOSMWayInfo;
 		
@@ -142,33 +317,54 @@ public:
 
 	struct FOSMWayRef
 	{
-		// Way that we're referencing at this node
-		FOSMWayInfo* Way;
+		// Way that we're referencing at this node (index into Ways)
+		int32 WayIndex;
 			
-		// Index of the node in the way's array of nodes
+		// Index of the node in the way's list of nodes
 		int32 NodeIndex;
 	};
 		
 		
-	struct FOSMNodeInfo
-	{
-		double Latitude;
-		double Longitude;
-		TArray<FOSMWayRef> WayRefs;
-	};
-		
-		
 	struct FOSMWayInfo
 	{
+		FOSMWayInfo()
+			: ID( 0 ),
+			  FirstNode( 0 ),
+			  NodeCount( 0 ),
+			  WayType( EOSMWayType::Other ),
+			  Height( 0.0 ),
+			  BuildingLevels( 0 ),
+			  bIsOneWay( false ),
+			  TagRuleIndex( INDEX_NONE )
+		{
+		}
+
+		// OpenStreetMap ID of this way
+		int64 ID;
+
 		FString Name;
 		FString Ref;
-		TArray<FOSMNodeInfo*> Nodes;
+
+		// Range of this way's nodes in the file's WayNodes array.  Use GetWayNodes() to get at them.
+		int32 FirstNode;
+		int32 NodeCount;
+
 		EOSMWayType WayType;
 		double Height;
 		int32 BuildingLevels;
 
 		// If true, way is only traversable in the order the nodes are listed in the Nodes list
 		uint8 bIsOneWay : 1;
+
+		// Index of the first FOSMTagFilter rule that any of this way's tags matched, or INDEX_NONE
+		int32 TagRuleIndex;
+	};
+
+
+	struct FOSMCoordinate
+	{
+		double Latitude;
+		double Longitude;
 	};
 
 	// Minimum latitude/longitude bounds
@@ -183,18 +379,185 @@ public:
 		
 	// All ways we've parsed
 	TArray<FOSMWayInfo*> Ways;
-		
-	// Maps node IDs to info about each node
-	TMap<int64, FOSMNodeInfo*> NodeMap;
+
+	/** Optional filter that decides which ways to keep.  Ways that are rejected are thrown away as soon as they've been
+	    parsed.  Set this before loading. */
+	TFunction<bool( const FOSMWayInfo& )> WayFilter;
+
+	/** Optional rules over the tags of ways.  Ways that match a drop rule are thrown away as soon as they've been parsed,
+	    before the WayFilter sees them, and every other way remembers which rule it matched.  Set this before loading. */
+	const FOSMTagFilter* TagFilter = nullptr;
+
+	/** If true, the file is read in two passes: first the ways, then only the nodes those ways use.  This uses far less
+	    memory for files where most nodes aren't part of any way we keep.  Set this before loading. */
+	bool bOnlyLoadReferencedNodes = false;
+
+	/** If not empty, only the nodes with these IDs are loaded, and none of the ways.  This is how nodes that an osmChange
+	    file uses without including them are found in the files the map was made from.  Set this before loading. */
+	TArray<int64> NodeIDsToLoad;
+
+	/** Optional outline of the part of the map to load.  Nodes that are outside of its bounds (plus ClipMargin) are thrown
+	    away as they're parsed, and the ways we keep are cut off where they cross the outline.  New nodes are added at
+	    those crossings, with IDs above any node we loaded.  Set this before loading. */
+	TArray<FOSMCoordinate> ClipRegion;
+
+	/** How far outside of the ClipRegion's bounds (in meters) we still load nodes.  Ways are clipped between a node
+	    inside the region and the next one outside of it, so that node needs to be loaded for the way to reach the edge. */
+	double ClipMargin = 0.0;
+
+	/** Nodes on our ways that are closer together than this (in meters) are welded into a single node.  Nodes in exactly
+	    the same place are always welded.  Ways then never have two points in a row in the same place, and buildings
+	    don't double back on themselves.  Set this before loading. */
+	double WeldDistance = 0.0;
+
+	/** Looks up nodes that our ways use but that aren't in the file.  osmChange files only contain the nodes that
+	    changed, so this is how ways in them find the rest of their nodes.  Set this before loading. */
+	TFunction<bool( const int64 NodeID, FOSMCoordinate& OutCoordinate )> ExternalNodeLookup;
+
+	/** Optional profiler that each phase of loading is measured with.  Set this before loading. */
+	FStreetMapImportProfiler* Profiler = nullptr;
+
+	// When loading an osmChange file, the IDs of the ways that were created or modified (including ones the WayFilter
+	// threw away), and of the ways and nodes that were deleted
+	TArray<int64> ChangedWayIDs;
+	TArray<int64> DeletedWayIDs;
+	TArray<int64> DeletedNodeIDs;
+
+	/** Returns the number of nodes we've parsed */
+	int32 GetNodeCount() const
+	{
+		return NodeIDs.Num();
+	}
+
+	/** Returns the OpenStreetMap ID of the specified node */
+	int64 GetNodeID( const int32 NodeIndex ) const
+	{
+		return NodeIDs[ NodeIndex ];
+	}
+
+	/** Returns the latitude of the specified node */
+	double GetNodeLatitude( const int32 NodeIndex ) const
+	{
+		return (double)NodeLatitudes[ NodeIndex ] / CoordinateScale;
+	}
+
+	/** Returns the longitude of the specified node */
+	double GetNodeLongitude( const int32 NodeIndex ) const
+	{
+		return (double)NodeLongitudes[ NodeIndex ] / CoordinateScale;
+	}
+
+	/** Returns how many references from our ways were to nodes that we couldn't find */
+	int32 GetMissingNodeCount() const
+	{
+		return MissingNodeCount;
+	}
+
+	/** Returns how many ways were thrown away because they matched a drop rule in the TagFilter */
+	int32 GetDroppedWayCount() const
+	{
+		return DroppedWayCount;
+	}
+
+	/** Returns how many nodes were welded onto another node near them */
+	int32 GetWeldedNodeCount() const
+	{
+		return WeldedNodeCount;
+	}
+
+	/** Returns how many points were removed from our ways because they were in the same place as the point before them,
+	    or made a building's outline double back on itself */
+	int32 GetRemovedWayNodeCount() const
+	{
+		return RemovedWayNodeCount;
+	}
+
+	/** Returns the index of the node with the specified OpenStreetMap ID, or INDEX_NONE if there is no such node */
+	int32 FindNodeIndex( const int64 NodeID ) const;
+
+	/** Returns the indices of the nodes along the specified way, in order */
+	TArrayView<const int32> GetWayNodes( const FOSMWayInfo& WayInfo ) const
+	{
+		return TArrayView<const int32>( WayNodes.GetData() + WayInfo.FirstNode, WayInfo.NodeCount );
+	}
+
+	/** Returns the indices of the nodes that each point along the specified way started out as, before WeldWayNodes()
+	    welded them onto the nodes that GetWayNodes() returns.  Lined up with GetWayNodes(). */
+	TArrayView<const int32> GetUnweldedWayNodes( const FOSMWayInfo& WayInfo ) const
+	{
+		const TArray<int32>& Nodes = UnweldedWayNodes.Num() > 0 ? UnweldedWayNodes : WayNodes;
+		return TArrayView<const int32>( Nodes.GetData() + WayInfo.FirstNode, WayInfo.NodeCount );
+	}
+
+	/** Returns all of the ways that pass through the specified node */
+	TArrayView<const FOSMWayRef> GetNodeWayRefs( const int32 NodeIndex ) const
+	{
+		return TArrayView<const FOSMWayRef>( NodeWayRefs.GetData() + NodeWayRefOffsets[ NodeIndex ], NodeWayRefOffsets[ NodeIndex + 1 ] - NodeWayRefOffsets[ NodeIndex ] );
+	}
+
+	/** Interprets a single key/value tag on a way, and matches it against the tag filter if there is one.  Only touches
+	    the way itself, so this is safe to call from any thread. */
+	static void ProcessWayTag( FOSMWayInfo& WayInfo, const FOSMStringView& Key, const FOSMStringView& Value, const FOSMTagFilter* TagFilter );
+
+	/** Identifies an element name, attribute name or tag key in the same way as the parser, returning a number for each
+	    name that the parser knows about, or zero for names that it ignores.  Exposed for the benchmark commandlet. */
+	static uint8 ClassifyName( const FOSMStringView& Name );
+
+	/** Identifies the type of way from the value of a highway tag in the same way as the parser */
+	static EOSMWayType ClassifyHighwayType( const FOSMStringView& Value );
 
 protected:
 
-	// IFastXmlCallback overrides
-	virtual bool ProcessXmlDeclaration( const TCHAR* ElementData, int32 XmlFileLineNumber ) override;
-	virtual bool ProcessComment( const TCHAR* Comment ) override;
-	virtual bool ProcessElement( const TCHAR* ElementName, const TCHAR* ElementData, int32 XmlFileLineNumber ) override;
-	virtual bool ProcessAttribute( const TCHAR* AttributeName, const TCHAR* AttributeValue ) override;
-	virtual bool ProcessClose( const TCHAR* Element ) override;
+	/** Parses the UTF-8 XML in the specified buffer.  Returns the number of bytes that were consumed, which stops short of
+	    any element that is cut off by the end of the buffer unless this is the final buffer.  Returns INDEX_NONE on errors. */
+	int64 ParseXmlBuffer( const ANSICHAR* Buffer, const int64 BufferLength, const bool bIsFinalBuffer, FString& OutErrorMessage );
+
+	/** Parses an XML document that is entirely in memory, in chunks so that we can report progress */
+	bool ParseXmlDocument( const ANSICHAR* Document, const int64 DocumentLength, class FFeedbackContext* FeedbackContext, FString& OutErrorMessage );
+
+	/** Parses an XML file by streaming it from disk in fixed-size chunks.  Used when the file can't be memory mapped. */
+	bool ParseXmlFileStreaming( const FString& OSMFilePath, class FFeedbackContext* FeedbackContext, FString& OutErrorMessage );
+
+	/** Parses an OpenStreetMap PBF file, decoding its data blocks on all worker threads (see OSMFilePbf.cpp) */
+	bool ParsePbfFile( const FString& OSMFilePath, class FFeedbackContext* FeedbackContext, FString& OutErrorMessage );
+
+	/** Parses a gzip compressed XML file, decompressing it on a background thread while we parse (see OSMFileGzip.cpp) */
+	bool ParseGzipXmlFile( const FString& OSMFilePath, class FFeedbackContext* FeedbackContext, FString& OutErrorMessage );
+
+	// XML tokenizer events
+	void ProcessElement( const FOSMStringView& ElementName );
+	void ProcessAttribute( const FOSMStringView& AttributeName, const FOSMStringView& AttributeValue );
+	void ProcessClose();
+
+	/** Parses the whole file once, calling back for whichever elements we're currently loading */
+	bool ParseFile( const FString& OSMFilePath, const bool bIsFilePathActuallyTextBuffer, class FFeedbackContext* FeedbackContext, FString& OutErrorMessage );
+
+	/** Adds a node that was parsed from the file, updating our bounds */
+	void AddNode( const int64 NodeID, const double Latitude, const double Longitude );
+
+	/** Adds a way that was parsed from the file, moving it into our WayArena unless the TagFilter or WayFilter rejects it.  The nodes
+	    it references are looked up by FinishLoading(), because they don't have to be in the file before the way. */
+	void AddWay( FOSMWayInfo&& NewWayInfo, const int64* WayNodeIDs, const int32 WayNodeIDCount );
+
+	/** Sorts the nodes by ID, resolves the nodes referenced by each way, and links every node up with its ways */
+	void FinishLoading();
+
+	/** Sorts the nodes by ID.  If a node appears more than once, the last one wins. */
+	void SortNodes();
+
+	/** Cuts the resolved ways down to the parts that are inside the ClipRegion.  Roads are split where they leave the
+	    region, and buildings are trimmed to it.  Called by FinishLoading() before the ways are linked up with nodes. */
+	void ClipWaysToRegion();
+
+	/** Returns the index of a node added where a way crosses the edge of the ClipRegion.  Ways that cross at the same
+	    spot share a node, so they stay connected. */
+	int32 AddClipNode( const double Latitude, const double Longitude, TMap<uint64, int32>& ClipNodeMap );
+
+	/** Welds nodes on our ways that are within WeldDistance of each other, using a spatial hash, then removes the points
+	    this leaves in the same place as the point before them.  Building outlines that double back on themselves are
+	    repaired.  Welding isn't transitive: each node is only welded onto a node within range that wasn't welded onto
+	    anything itself.  Called by FinishLoading() before the ways are linked up with nodes. */
+	void WeldWayNodes();
 
 	
 protected:
@@ -203,25 +566,110 @@ protected:
 	{
 		Root,
 		Node,
+		Node_Tag,
 		Way,
 		Way_NodeRef,
-		Way_Tag
+		Way_Tag,
+		Way_Other,
+		Skipped
+	};
+
+	enum class EChangeAction : uint8
+	{
+		None,
+		Create,
+		Modify,
+		Delete
 	};
 		
+	// Node coordinates are stored in fixed point, in units of 1e-7 degrees.  This is the precision OpenStreetMap uses.
+	static constexpr double CoordinateScale = 10000000.0;
+
+	// All of the nodes we've parsed, sorted by ID once loading has finished
+	TArray<int64> NodeIDs;
+	TArray<int32> NodeLatitudes;
+	TArray<int32> NodeLongitudes;
+
+	// Whether the nodes were added in order of increasing ID, which is the case for almost every OpenStreetMap file
+	bool bNodeIDsAreSorted;
+
+	// Number of way node references that FinishLoading() couldn't resolve
+	int32 MissingNodeCount;
+
+	// Number of ways that the TagFilter threw away
+	int32 DroppedWayCount;
+
+	// Number of nodes that WeldWayNodes() welded onto other nodes, and how many points it removed from ways
+	int32 WeldedNodeCount;
+	int32 RemovedWayNodeCount;
+
+	// Indices of the nodes along each way.  While loading, these are OpenStreetMap node IDs instead.
+	TArray<int32> WayNodes;
+	TArray<int64> PendingWayNodeIDs;
+
+	// The node each entry in WayNodes was before WeldWayNodes() welded it onto another node.  Empty if nothing was welded.
+	TArray<int32> UnweldedWayNodes;
+
+	// Ways that pass through each node, in compressed sparse row form.  The refs for node N are in
+	// NodeWayRefs[ NodeWayRefOffsets[ N ] .. NodeWayRefOffsets[ N + 1 ] - 1 ]
+	TArray<int32> NodeWayRefOffsets;
+	TArray<FOSMWayRef> NodeWayRefs;
+
+	// Storage for all of the ways we've parsed
+	TOSMArena<FOSMWayInfo> WayArena;
+
+	// Number of nodes in the file, including any that we didn't keep
+	int64 FileNodeCount;
+
+	// Which elements we're loading in the current pass over the file
+	bool bLoadNodes;
+	bool bLoadWays;
+
+	// When only loading referenced nodes (or the NodeIDsToLoad), the sorted IDs of the nodes we want
+	TArray<int64> ReferencedNodeIDs;
+
+	// Where the last node we looked for in ReferencedNodeIDs was.  Nodes are almost always in order, so we can usually
+	// find the next one just by stepping forward from here.
+	int32 ReferencedNodeCursor;
+
+	// Bounds of the ClipRegion, grown by the ClipMargin.  Nodes outside of these aren't loaded.
+	double ClipLoadMinLatitude;
+	double ClipLoadMinLongitude;
+	double ClipLoadMaxLatitude;
+	double ClipLoadMaxLongitude;
+
+	// Whether the ClipRegion is convex.  Buildings can only be trimmed exactly against a convex region.
+	bool bClipRegionIsConvex;
+
 	// Current state of parser
 	ParsingState ParsingState;
+
+	// Which section of an osmChange file we're in, and how many elements deep inside of it we are
+	EChangeAction CurrentChangeAction;
+	int32 ChangeActionDepth;
 		
 	// ID of node that is currently being parsed
 	int64 CurrentNodeID;
 		
-	// Node that is currently being parsed
-	FOSMNodeInfo* CurrentNodeInfo;
+	// Location of the node that is currently being parsed
+	double CurrentNodeLatitude;
+	double CurrentNodeLongitude;
 		
 	// Way that is currently being parsed
-	FOSMWayInfo* CurrentWayInfo;
+	FOSMWayInfo CurrentWayInfo;
+
+	// IDs of the nodes referenced by the way that is currently being parsed
+	TArray<int64> CurrentWayNodeIDs;
 		
-	// Current way's tag key string
-	const TCHAR* CurrentWayTagKey;
+	// Current way's tag key string.  Only valid while the tag element is being processed.
+	FOSMStringView CurrentWayTagKey;
+
+	// How deep we are inside of an element that we're skipping
+	int32 SkippedElementDepth;
+
+	// Attributes of the element that is currently being tokenized.  These are gathered up before being processed, so
+	// that we never process an element that turns out to be cut off by the end of a streamed chunk.
+	TArray< TPair< FOSMStringView, FOSMStringView >, TInlineAllocator< 16 > > PendingAttributes;
 };
 
 
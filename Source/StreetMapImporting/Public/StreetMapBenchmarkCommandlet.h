@@ -0,0 +1,35 @@
+// Copyright 2017 Mike Fricker. All Rights Reserved.
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "StreetMapBenchmarkCommandlet.generated.h"
+
+
+/**
+ * Generates synthetic OpenStreetMap files of increasing size (see FSyntheticOSMGenerator), then imports each one, builds
+ * its mesh, runs graph queries on it and times loading it back from memory, appending the timings to a CSV file.
+ * It also times how long the XML parser takes to work out what each element, attribute and tag is, against the chain of
+ * string compares it used to have.  Nothing needs a GPU, so this is meant to be run with -nullrhi on a build machine to
+ * catch performance regressions.
+ *
+ * Usage:
+ *   UE4Editor-Cmd <Project> -run=StreetMapBenchmark -nullrhi [-Nodes=1000,10000,100000,1000000] [-Seed=1]
+ *                 [-Directory=<Dir>] [-Csv=<File>] [-Queries=1000] [-DispatchPasses=200000] [-Options="(...)"]
+ *                 [-GenerateOnly] [-Regenerate]
+ *
+ * Generated files are kept in the directory (Saved/StreetMap/Benchmark by default) and reused by later runs, since the
+ * same size and seed always give the same file.
+ */
+UCLASS()
+class UStreetMapBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	/** UStreetMapBenchmarkCommandlet constructor */
+	UStreetMapBenchmarkCommandlet( const class FObjectInitializer& ObjectInitializer );
+
+	// UCommandlet overrides
+	virtual int32 Main( const FString& Params ) override;
+};
@@ -2,6 +2,7 @@
 #pragma once
 
 #include "Factories/Factory.h"
+#include "StreetMap.h"
 #include "StreetMapFactory.generated.h"
 
 
@@ -13,18 +14,56 @@ class UStreetMapFactory : public UFactory
 {
 	GENERATED_BODY()
 
+	// The batch import commandlet drives the import steps itself, so that it can run several at once
+	friend class UStreetMapImportCommandlet;
+	friend class UStreetMapBenchmarkCommandlet;
+
 public:
 
 	/** UStreetMapFactory constructor */
 	UStreetMapFactory( const class FObjectInitializer& ObjectInitializer );
 
+	/** Options to import with.  When reimporting, these are copied from the map being reimported. */
+	UPROPERTY()
+	FStreetMapImportOptions ImportOptions;
+
+	/** Whether imports can be loaded from (and stored in) the derived data cache.  Turned off for benchmarking, so that
+	    we measure the import itself. */
+	bool bUseImportCache;
+
 protected:
 
 	// UFactory overrides
+	virtual UObject* FactoryCreateFile( UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, const FString& Filename, const TCHAR* Parms, FFeedbackContext* Warn, bool& bOutOperationCanceled ) override;
 	virtual UObject* FactoryCreateText( UClass* Class, UObject* Parent, FName Name, EObjectFlags Flags, UObject* Context, const TCHAR* Type, const TCHAR*& Buffer, const TCHAR* BufferEnd, FFeedbackContext* Warn ) override;
 
-	/** Loads the street map from an OpenStreetMap XML file.  Note that in the case of the file path containing the XML data, the string must be mutable for us to parse it quickly. */
-	bool LoadFromOpenStreetMapXMLFile( class UStreetMap* StreetMap, FString& OSMFilePath, const bool bIsFilePathActuallyTextBuffer, class FFeedbackContext* FeedbackContext );
+	/** Loads the street map from an OpenStreetMap XML file.  Files are memory mapped and parsed in place rather than being loaded into a string first. */
+	bool LoadFromOpenStreetMapXMLFile( class UStreetMap* StreetMap, const FString& OSMFilePath, const bool bIsFilePathActuallyTextBuffer, class FFeedbackContext* FeedbackContext );
+
+	/** Returns the derived data cache key for importing the specified file with our current import options, or an
+	    empty string if the file can't be read */
+	FString GetImportCacheKey( const FString& OSMFilePath ) const;
+
+	/** Saves or loads everything the importer produces for a street map, for storing in the derived data cache */
+	void SerializeImportCacheData( FArchive& Ar, class UStreetMap* StreetMap );
+
+	/** Splits a street map that was just imported into a grid of tiles (see FStreetMapImportOptions::bSplitIntoTiles).
+	    Each tile becomes its own street map asset, and the map itself is left with just the list of tiles.  The tile
+	    packages are only marked dirty, not saved.  Tiles left over from an earlier import are reported, not deleted.
+	    The Profiler is optional. */
+	bool SplitStreetMapIntoTiles( class UStreetMap* StreetMap, class FFeedbackContext* FeedbackContext, class FStreetMapImportProfiler* Profiler );
+
+	/** Finds or creates the street map asset for one tile of a map that is being split into tiles */
+	class UStreetMap* CreateTileStreetMap( class UStreetMap* StreetMap, const int32 TileX, const int32 TileY );
+
+	/** Applies the changes in an OpenStreetMap change file (.osc) to a street map that was imported earlier.  Only the roads,
+	    buildings and nodes that the changes touch are updated.  Nodes that the changes use but the map didn't keep are
+	    looked up in the files the map was made from, so those have to still exist.  The change file is added to the map's
+	    AppliedChangeFiles. */
+	bool ApplyOpenStreetMapChangeFile( class UStreetMap* StreetMap, const FString& OSCFilePath, class FFeedbackContext* FeedbackContext );
+
+	/** Static: Converts latitude and longitude to a position on the map (in centimeters), relative to the map's origin */
+	static FVector2D ConvertLatLongToMapPosition( const double Latitude, const double Longitude, const double OriginLatitude, const double OriginLongitude );
 
 	/** Static: Latitude/longitude scale factor */
 	static const double LatitudeLongitudeScale;
@@ -0,0 +1,33 @@
+// Copyright 2017 Mike Fricker. All Rights Reserved.
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "StreetMapImportCommandlet.generated.h"
+
+
+/**
+ * Imports a batch of OpenStreetMap files into street map assets without opening the editor.  Several files are
+ * converted at once, and the packages are saved as each one finishes.  Runs fine with -nullrhi.
+ *
+ * Usage:
+ *   UE4Editor-Cmd <Project> -run=StreetMapImport <Files...> [-FileList=<File>] [-Destination=/Game/StreetMaps]
+ *                 [-Jobs=<Count>] [-Options="(bPruneUnreferencedNodes=True,bSplitIntoTiles=True,TileSize=2000)"]
+ *
+ * Files can contain wildcards (e.g. C:/OSM/*.osm.pbf).  A file list has one file (or wildcard) per line.  Options are
+ * the FStreetMapImportOptions to import every file with, in the same text form the editor copies and pastes them in.
+ * Each file is saved as <Destination>/<File name without .osm, .osm.gz or .osm.pbf>, so nothing is imported if two of
+ * the files would end up with the same name.
+ */
+UCLASS()
+class UStreetMapImportCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	/** UStreetMapImportCommandlet constructor */
+	UStreetMapImportCommandlet( const class FObjectInitializer& ObjectInitializer );
+
+	// UCommandlet overrides
+	virtual int32 Main( const FString& Params ) override;
+};
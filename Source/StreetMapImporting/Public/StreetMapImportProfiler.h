@@ -0,0 +1,116 @@
+// Copyright 2017 Mike Fricker. All Rights Reserved.
+#pragma once
+
+#include "Stats/Stats.h"
+#include "HAL/ThreadSafeCounter.h"
+
+/** Every phase of an import gets a cycle stat in this group, so imports can be looked at in the profiler */
+DECLARE_STATS_GROUP( TEXT( "StreetMap Import" ), STATGROUP_StreetMapImport, STATCAT_Advanced );
+
+
+/** Measures how long each phase of a street map import takes, how much it got through and how much memory it needed.
+    The results go to the log and to a JSON file next to the project's other saved data, so that imports of the same
+    file can be compared from one version of the importer to the next. */
+class FStreetMapImportProfiler
+{
+
+public:
+
+	/** What we measured for one phase of the import */
+	struct FPhase
+	{
+		/** What the phase was doing */
+		FString Name;
+
+		/** Wall clock time the phase took */
+		double Seconds;
+
+		/** How many things the phase processed (nodes, ways, roads...), or zero if that doesn't apply */
+		int64 ItemCount;
+
+		/** What ItemCount is counting */
+		FString ItemName;
+
+		/** How many bytes of input the phase read, or zero if that doesn't apply */
+		int64 ByteCount;
+
+		/** Physical memory the whole process was using when the phase finished */
+		uint64 UsedPhysical;
+
+		/** Most physical memory the whole process used during the phase.  The platform only tracks the peak over the life
+		    of the process, so if that didn't go up during the phase this is the larger of the usage at the start and end. */
+		uint64 PeakUsedPhysical;
+
+		/** How many imports were running in this process when the phase finished, including this one.  When this is more
+		    than one, the memory figures include what the other imports were using. */
+		int32 ConcurrentImportCount;
+	};
+
+
+	/** Measures a phase of the import for as long as it's in scope, and counts it towards the cycle stat.  The profiler
+	    can be null, in which case only the cycle stat is updated. */
+	class FScopedPhase
+	{
+
+	public:
+
+		FScopedPhase( FStreetMapImportProfiler* InProfiler, const TCHAR* InName, TStatId StatId );
+		~FScopedPhase();
+
+		/** Sets how many things this phase processed, for working out its throughput */
+		void SetItemCount( const int64 InItemCount, const TCHAR* InItemName )
+		{
+			ItemCount = InItemCount;
+			ItemName = InItemName;
+		}
+
+		/** Sets how many bytes of input this phase read, for working out its throughput */
+		void SetByteCount( const int64 InByteCount )
+		{
+			ByteCount = InByteCount;
+		}
+
+
+	private:
+
+		FScopeCycleCounter CycleCounter;
+
+		FStreetMapImportProfiler* Profiler;
+		const TCHAR* Name;
+		double StartTime;
+		uint64 StartUsedPhysical;
+		uint64 StartPeakUsedPhysical;
+
+		int64 ItemCount;
+		const TCHAR* ItemName;
+		int64 ByteCount;
+	};
+
+
+	FStreetMapImportProfiler();
+	~FStreetMapImportProfiler();
+
+	/** Logs every phase we measured, and writes them to Saved/StreetMap/<PackagePath>/<AssetName>.ImportProfile.json, so
+	    that assets with the same name in different folders get their own report.  AssetPathName is the asset's full
+	    path name (UObject::GetPathName()).  SourceFilePath is only recorded, so that the report says what was imported. */
+	void Report( const FString& AssetPathName, const FString& SourceFilePath, FFeedbackContext* FeedbackContext ) const;
+
+	/** Returns the phases we've measured so far, in the order they finished */
+	const TArray<FPhase>& GetPhases() const
+	{
+		return Phases;
+	}
+
+
+private:
+
+	// When we were created, which is when the import started
+	double StartTime;
+
+	// Every phase we've measured
+	TArray<FPhase> Phases;
+
+	// How many profilers are alive in this process, which is how many imports are running at once.  Memory can only be
+	// measured for the whole process, so the report has to say when other imports were sharing it.
+	static FThreadSafeCounter ActiveImportCount;
+};
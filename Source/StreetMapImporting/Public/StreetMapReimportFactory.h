@@ -27,5 +27,12 @@ protected:
 	virtual EReimportResult::Type Reimport( UObject* Obj ) override;
 	virtual int32 GetPriority() const override;
 
+private:
+
+	// Change file picked by SetReimportPaths() for the next Reimport() of this map.  Change files are applied to the map
+	// rather than becoming the file it is reimported from.
+	TWeakObjectPtr<class UStreetMap> PendingChangeFileStreetMap;
+	FString PendingChangeFilePath;
+
 };
 
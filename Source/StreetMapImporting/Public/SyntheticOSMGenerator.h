@@ -0,0 +1,72 @@
+// Copyright 2017 Mike Fricker. All Rights Reserved.
+#pragma once
+
+#include "OSMFile.h"
+#include "Math/RandomStream.h"
+
+
+/** Writes made up OpenStreetMap XML files for benchmarking.  The map is a grid of city blocks, with streets of several
+    types running along the grid lines and buildings inside of the blocks.  Everything is worked out from the seed and
+    the grid position, so the same settings always give exactly the same file, and the file is written as it goes
+    rather than being built up in memory first. */
+class FSyntheticOSMGenerator
+{
+
+public:
+
+	/** Roughly how many nodes the file should have.  The grid is sized to get close to this. */
+	int64 TargetNodeCount = 100000;
+
+	/** Seed for everything random about the map */
+	int32 Seed = 1;
+
+	/** How many extra nodes each street has between two intersections, so that ways are about as long as real ones */
+	int32 NodesBetweenIntersections = 4;
+
+	/** Writes the map to a file.  Returns false if the file couldn't be written. */
+	bool WriteToFile( const FString& FilePath, class FFeedbackContext* FeedbackContext );
+
+	/** How many nodes, ways and buildings the last file we wrote has (buildings are counted among the ways too) */
+	int64 GetNodeCount() const
+	{
+		return NodeCount;
+	}
+	int64 GetWayCount() const
+	{
+		return WayCount;
+	}
+	int64 GetBuildingCount() const
+	{
+		return BuildingCount;
+	}
+
+
+private:
+
+	/** Returns a random stream for one thing on the map, so that it comes out the same no matter which order we go in */
+	FRandomStream MakeRandomStream( const int32 X, const int32 Y, const int32 Salt ) const;
+
+	/** Returns where the intersection at a grid position is */
+	FOSMFile::FOSMCoordinate GetIntersectionCoordinate( const int32 X, const int32 Y ) const;
+
+	/** Returns how many buildings the block at a grid position has */
+	int32 GetBlockBuildingCount( const int32 X, const int32 Y ) const;
+
+	/** IDs of the nodes on the map.  Each kind of node gets its own range, so that IDs can be worked out from grid
+	    positions and the nodes can be written in order of ID. */
+	int64 GetIntersectionNodeID( const int32 X, const int32 Y ) const;
+	int64 GetHorizontalStreetNodeID( const int32 X, const int32 Y, const int32 Index ) const;
+	int64 GetVerticalStreetNodeID( const int32 X, const int32 Y, const int32 Index ) const;
+	int64 GetBuildingNodeID( const int32 X, const int32 Y, const int32 Building, const int32 Corner ) const;
+
+
+private:
+
+	// Number of blocks along each side of the grid
+	int32 GridSize = 0;
+
+	// What we wrote to the last file
+	int64 NodeCount = 0;
+	int64 WayCount = 0;
+	int64 BuildingCount = 0;
+};
@@ -13,7 +13,6 @@ namespace UnrealBuildTool.Rules
           "CoreUObject",
           "Engine",
           "UnrealEd",
-          "XmlParser",
           "AssetTools",
           "Projects",
           "Slate",
@@ -25,11 +24,16 @@ namespace UnrealBuildTool.Rules
           "RawMesh",
           "AssetTools",
           "AssetRegistry",
+          "DerivedDataCache",
+          "Json",
           "StreetMapRuntime"
         }
       );
 
       PrivateIncludePaths.AddRange(new string[]{"StreetMapImporting/Private"});
+
+      // Streaming decompression of .osm.gz files
+      AddEngineThirdPartyPrivateStaticDependencies(Target, "zlib");
     }
   }
 }
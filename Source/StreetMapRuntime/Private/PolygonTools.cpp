@@ -5,7 +5,7 @@
 
 
 // Based off "Efficient Polygon Triangulation" algorithm by John W. Ratcliff (http://flipcode.net/archives/Efficient_Polygon_Triangulation.shtml)
-bool FPolygonTools::TriangulatePolygon( const TArray<FVector2D>& Polygon, TArray<int32>& TempIndices, TArray<int32>& TriangulatedIndices, bool& OutWindsClockwise )
+bool FPolygonTools::TriangulatePolygon( const TArrayView<const FVector2D> Polygon, TArray<int32>& TempIndices, TArray<int32>& TriangulatedIndices, bool& OutWindsClockwise )
 {
 	checkSlow( &TempIndices != &TriangulatedIndices );
 	TriangulatedIndices.Reset();
@@ -2,10 +2,30 @@
 
 #include "StreetMap.h"
 #include "StreetMapRuntime.h"
+#include "StreetMapCustomVersion.h"
 #include "EditorFramework/AssetImportData.h"
+#include "Async/Async.h"
+#include "Serialization/BufferReader.h"
+#include "Serialization/CustomVersion.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC( LogStreetMap, Log, All );
+
+
+const FGuid FStreetMapCustomVersion::GUID( 0xC2D36776, 0x492E48D9, 0xB16DC021, 0x1B0D3D09 );
+
+// Register the custom version with core
+static FCustomVersionRegistration GRegisterStreetMapCustomVersion( FStreetMapCustomVersion::GUID, FStreetMapCustomVersion::LatestVersion, TEXT( "StreetMapVer" ) );
 
 
 UStreetMap::UStreetMap()
+	: TileSize( 0.0f ),
+	  HeaderRoadCount( 0 ),
+	  HeaderNodeCount( 0 ),
+	  HeaderBuildingCount( 0 ),
+	  bIsLoadingGeometry( false ),
+	  GeometryLoadSerialNumber( 0 ),
+	  bIsCachedRoadDataStale( true )
 {
 #if WITH_EDITORONLY_DATA
 	if( !HasAnyFlags( RF_ClassDefaultObject ) )
@@ -27,3 +47,659 @@ void UStreetMap::GetAssetRegistryTags( TArray<FAssetRegistryTag>& OutTags ) cons
 
 	Super::GetAssetRegistryTags( OutTags );
 }
+
+
+void UStreetMap::Serialize( FArchive& Ar )
+{
+	Ar.UsingCustomVersion( FStreetMapCustomVersion::GUID );
+
+	if( Ar.IsSaving() )
+	{
+		// Can't save what we haven't loaded yet
+		FinishLoadingGeometry();
+	}
+	else if( Ar.IsLoading() )
+	{
+		// Whatever we're loading replaces the roads and nodes the cached data was built from
+		bIsCachedRoadDataStale = true;
+	}
+
+	// The roads, nodes and buildings go after the rest of the properties in flat blocks, because loading big maps one
+	// tagged property at a time is very slow.  Maps saved before then only have the tagged properties.
+	const int32 Version = ( Ar.IsLoading() || Ar.IsSaving() ) ? Ar.CustomVer( FStreetMapCustomVersion::GUID ) : (int32)FStreetMapCustomVersion::BeforeCustomVersionWasAdded;
+	const bool bHasBulkGeometry = Version >= FStreetMapCustomVersion::BulkGeometry;
+	if( bHasBulkGeometry && Ar.IsSaving() )
+	{
+		// Keep the geometry out of the tagged properties.  Empty arrays match the defaults, so nothing is written for them.
+		TArray<FStreetMapRoad> SavedRoads = MoveTemp( Roads );
+		TArray<FStreetMapNode> SavedNodes = MoveTemp( Nodes );
+		TArray<FStreetMapBuilding> SavedBuildings = MoveTemp( Buildings );
+		TArray<FVector2D> SavedPointPool = MoveTemp( PointPool );
+		TArray<int32> SavedNodeIndexPool = MoveTemp( NodeIndexPool );
+		TArray<FStreetMapPoolRange> SavedRoadPointRanges = MoveTemp( RoadPointRanges );
+		TArray<FStreetMapPoolRange> SavedBuildingPointRanges = MoveTemp( BuildingPointRanges );
+
+		Super::Serialize( Ar );
+
+		Roads = MoveTemp( SavedRoads );
+		Nodes = MoveTemp( SavedNodes );
+		Buildings = MoveTemp( SavedBuildings );
+		PointPool = MoveTemp( SavedPointPool );
+		NodeIndexPool = MoveTemp( SavedNodeIndexPool );
+		RoadPointRanges = MoveTemp( SavedRoadPointRanges );
+		BuildingPointRanges = MoveTemp( SavedBuildingPointRanges );
+	}
+	else
+	{
+		Super::Serialize( Ar );
+	}
+
+	if( Version >= FStreetMapCustomVersion::GeometryBulkData )
+	{
+		SerializeGeometryBulkData( Ar );
+	}
+	else if( bHasBulkGeometry )
+	{
+		SerializeGeometry( Ar );
+	}
+}
+
+
+void UStreetMap::SerializeGeometryBulkData( FArchive& Ar )
+{
+	if( Ar.IsSaving() )
+	{
+		TArray<uint8> GeometryBytes;
+		FMemoryWriter GeometryWriter( GeometryBytes, true );
+		SerializeGeometry( GeometryWriter );
+
+		// Keep the geometry out of line even when cooking, so that it can be read on its own later
+		GeometryBulkData.SetBulkDataFlags( BULKDATA_Force_NOT_InlinePayload );
+		GeometryBulkData.Lock( LOCK_READ_WRITE );
+		FMemory::Memcpy( GeometryBulkData.Realloc( GeometryBytes.Num() ), GeometryBytes.GetData(), GeometryBytes.Num() );
+		GeometryBulkData.Unlock();
+
+		HeaderRoadCount = Roads.Num();
+		HeaderNodeCount = Nodes.Num();
+		HeaderBuildingCount = Buildings.Num();
+	}
+
+	Ar << HeaderRoadCount;
+	Ar << HeaderNodeCount;
+	Ar << HeaderBuildingCount;
+	GeometryBulkData.Serialize( Ar, this );
+
+	if( Ar.IsLoading() )
+	{
+		// Whatever we had is out of date now
+		++GeometryLoadSerialNumber;
+		bIsLoadingGeometry = true;
+
+		// Archives that aren't packages (like undo and duplication) keep the data inline, so we can read it right away.
+		// Otherwise it is still on disk, and the linker is busy with the rest of the package until PostLoad().
+		if( GeometryBulkData.IsBulkDataLoaded() )
+		{
+			LoadGeometryFromBulkData();
+		}
+	}
+}
+
+
+void UStreetMap::LoadGeometryFromBulkData()
+{
+	const int64 GeometrySize = GeometryBulkData.GetBulkDataSize();
+	void* GeometryData = nullptr;
+	const bool bDiscardInternalCopy = true;
+	GeometryBulkData.GetCopy( &GeometryData, bDiscardInternalCopy );
+
+	const bool bFreeOnClose = true;
+	const bool bIsPersistent = true;
+	FBufferReader GeometryReader( GeometryData, GeometrySize, bFreeOnClose, bIsPersistent );
+	if( !LoadGeometry( GeometryReader ) )
+	{
+		UE_LOG( LogStreetMap, Warning, TEXT( "Street map '%s' has damaged geometry data.  Reimport it to fix it." ), *GetPathName() );
+	}
+}
+
+
+bool UStreetMap::LoadGeometry( FArchive& GeometryReader )
+{
+	bIsCachedRoadDataStale = true;
+	SerializeGeometry( GeometryReader );
+	if( !GeometryReader.IsError() &&
+		( Roads.Num() != HeaderRoadCount || Nodes.Num() != HeaderNodeCount || Buildings.Num() != HeaderBuildingCount ) )
+	{
+		GeometryReader.SetError();
+		Roads.Empty();
+		Nodes.Empty();
+		Buildings.Empty();
+		PointPool.Empty();
+		NodeIndexPool.Empty();
+		RoadPointRanges.Empty();
+		BuildingPointRanges.Empty();
+	}
+
+	bIsLoadingGeometry = false;
+	return !GeometryReader.IsError();
+}
+
+
+bool UStreetMap::StartStreamingGeometry()
+{
+	if( GeometryBulkData.IsStoredCompressedOnDisk() || !GeometryBulkData.CanLoadFromDisk() )
+	{
+		return false;
+	}
+
+	const int32 SerialNumber = ++GeometryLoadSerialNumber;
+	const TWeakObjectPtr<UStreetMap> WeakStreetMap( this );
+
+	// The bulk data knows where its payload really is (in the package file, a separate .ubulk file or an IoStore
+	// container), so it does the read.  The callback runs on whatever thread finished the read, so it hands the bytes
+	// back to the game thread, where the map can be changed safely.  The map may have been loaded again or destroyed by
+	// then, in which case we drop what we read.
+	FBulkDataIORequestCallBack OnReadComplete = [ SerialNumber, WeakStreetMap ]( bool bWasCancelled, IBulkDataIORequest* ReadRequest )
+	{
+		uint8* GeometryData = bWasCancelled ? nullptr : ReadRequest->GetReadResults();
+		const int64 GeometrySize = GeometryData != nullptr ? ReadRequest->GetSize() : 0;
+
+		AsyncTask( ENamedThreads::GameThread, [ ReadRequest, GeometryData, GeometrySize, SerialNumber, WeakStreetMap ]()
+		{
+			// A request can't be deleted from its own callback, so it's deleted here
+			ReadRequest->WaitCompletion();
+			delete ReadRequest;
+
+			const bool bFreeOnClose = true;
+			FBufferReader GeometryReader( GeometryData, GeometrySize, bFreeOnClose );
+
+			UStreetMap* StreetMap = WeakStreetMap.Get();
+			if( StreetMap == nullptr || !StreetMap->bIsLoadingGeometry || StreetMap->GeometryLoadSerialNumber != SerialNumber )
+			{
+				return;
+			}
+
+			if( GeometryData == nullptr || !StreetMap->LoadGeometry( GeometryReader ) )
+			{
+				// Try again through the linker, which will tell us if the data really is damaged
+				StreetMap->LoadGeometryFromBulkData();
+			}
+			StreetMap->OnGeometryLoaded();
+		} );
+	};
+
+	IBulkDataIORequest* ReadRequest = GeometryBulkData.CreateStreamingRequest( AIOP_Normal, &OnReadComplete, nullptr );
+	return ReadRequest != nullptr;
+}
+
+
+void UStreetMap::FinishLoadingGeometry()
+{
+	if( bIsLoadingGeometry )
+	{
+		// Anything still being read in the background will be ignored when it gets here
+		LoadGeometryFromBulkData();
+		OnGeometryLoaded();
+	}
+}
+
+
+void UStreetMap::OnGeometryLoaded()
+{
+	BuildCachedRoadData();
+	GeometryReadyEvent.Broadcast( this );
+}
+
+
+void UStreetMap::SerializeGeometry( FArchive& Ar )
+{
+	// Everything except the names is one flat array per field, so that each one loads with a single copy.  Names are
+	// stored once each in a table that the roads and buildings index into.
+	TArray<FString> Names;
+	TArray<int32> RoadNameIndices;
+	TArray<uint8> RoadTypes;
+	TArray<uint8> RoadOneWayFlags;
+	TArray<FVector2D> RoadBounds;
+	TArray<FStreetMapPoolRange> NodeRoadRefRanges;
+	TArray<FStreetMapRoadRef> RoadRefPool;
+	TArray<int32> BuildingNameIndices;
+	TArray<uint8> BuildingWindingFlags;
+	TArray<float> BuildingHeights;
+	TArray<int32> BuildingLevelCounts;
+	TArray<FVector2D> BuildingBounds;
+	TArray<FStreetMapPoolRange> BuildingFillTriangleRanges;
+	TArray<int32> FillTriangleIndexPool;
+
+	if( Ar.IsSaving() )
+	{
+		// The points are saved straight from the pools, so everything has to be in them
+		bool bNeedsCompacting = !HasCompactGeometry() && ( Roads.Num() > 0 || Buildings.Num() > 0 );
+		PRAGMA_DISABLE_DEPRECATION_WARNINGS
+		for( const FStreetMapRoad& Road : Roads )
+		{
+			bNeedsCompacting |= Road.RoadPoints.Num() > 0 || Road.NodeIndices.Num() > 0;
+		}
+		for( const FStreetMapBuilding& Building : Buildings )
+		{
+			bNeedsCompacting |= Building.BuildingPoints.Num() > 0;
+		}
+		PRAGMA_ENABLE_DEPRECATION_WARNINGS
+		if( bNeedsCompacting )
+		{
+			CompactGeometry();
+		}
+
+		TMap<FString, int32> NameToIndex;
+		auto AddName = [ &Names, &NameToIndex ]( const FString& Name ) -> int32
+		{
+			if( const int32* ExistingNameIndex = NameToIndex.Find( Name ) )
+			{
+				return *ExistingNameIndex;
+			}
+			const int32 NameIndex = Names.Add( Name );
+			NameToIndex.Add( Name, NameIndex );
+			return NameIndex;
+		};
+
+		RoadNameIndices.Reserve( Roads.Num() );
+		RoadTypes.Reserve( Roads.Num() );
+		RoadOneWayFlags.Reserve( Roads.Num() );
+		RoadBounds.Reserve( Roads.Num() * 2 );
+		for( const FStreetMapRoad& Road : Roads )
+		{
+			RoadNameIndices.Add( AddName( Road.RoadName ) );
+			RoadTypes.Add( (uint8)Road.RoadType );
+			RoadOneWayFlags.Add( Road.bIsOneWay ? 1 : 0 );
+			RoadBounds.Add( Road.BoundsMin );
+			RoadBounds.Add( Road.BoundsMax );
+		}
+
+		NodeRoadRefRanges.SetNum( Nodes.Num() );
+		for( int32 NodeIndex = 0; NodeIndex < Nodes.Num(); ++NodeIndex )
+		{
+			const FStreetMapNode& Node = Nodes[ NodeIndex ];
+			NodeRoadRefRanges[ NodeIndex ].First = RoadRefPool.Num();
+			NodeRoadRefRanges[ NodeIndex ].Count = Node.RoadRefs.Num();
+			RoadRefPool.Append( Node.RoadRefs );
+		}
+
+		BuildingNameIndices.Reserve( Buildings.Num() );
+		BuildingWindingFlags.Reserve( Buildings.Num() );
+		BuildingHeights.Reserve( Buildings.Num() );
+		BuildingLevelCounts.Reserve( Buildings.Num() );
+		BuildingBounds.Reserve( Buildings.Num() * 2 );
+		BuildingFillTriangleRanges.SetNum( Buildings.Num() );
+		for( int32 BuildingIndex = 0; BuildingIndex < Buildings.Num(); ++BuildingIndex )
+		{
+			const FStreetMapBuilding& Building = Buildings[ BuildingIndex ];
+			BuildingNameIndices.Add( AddName( Building.BuildingName ) );
+			BuildingWindingFlags.Add( Building.bPointsWindCounterClockwise ? 1 : 0 );
+			BuildingHeights.Add( Building.Height );
+			BuildingLevelCounts.Add( Building.BuildingLevels );
+			BuildingBounds.Add( Building.BoundsMin );
+			BuildingBounds.Add( Building.BoundsMax );
+			BuildingFillTriangleRanges[ BuildingIndex ].First = FillTriangleIndexPool.Num();
+			BuildingFillTriangleRanges[ BuildingIndex ].Count = Building.FillTriangleIndices.Num();
+			FillTriangleIndexPool.Append( Building.FillTriangleIndices );
+		}
+	}
+
+	Ar << Names;
+	RoadNameIndices.BulkSerialize( Ar );
+	RoadTypes.BulkSerialize( Ar );
+	RoadOneWayFlags.BulkSerialize( Ar );
+	RoadBounds.BulkSerialize( Ar );
+	NodeRoadRefRanges.BulkSerialize( Ar );
+	RoadRefPool.BulkSerialize( Ar );
+	BuildingNameIndices.BulkSerialize( Ar );
+	BuildingWindingFlags.BulkSerialize( Ar );
+	BuildingHeights.BulkSerialize( Ar );
+	BuildingLevelCounts.BulkSerialize( Ar );
+	BuildingBounds.BulkSerialize( Ar );
+	BuildingFillTriangleRanges.BulkSerialize( Ar );
+	FillTriangleIndexPool.BulkSerialize( Ar );
+	PointPool.BulkSerialize( Ar );
+	NodeIndexPool.BulkSerialize( Ar );
+	RoadPointRanges.BulkSerialize( Ar );
+	BuildingPointRanges.BulkSerialize( Ar );
+
+	if( Ar.IsLoading() )
+	{
+		// Make sure the blocks agree with each other, and that every index in them points at something, before we build
+		// anything from them.  Damaged data would otherwise crash whatever uses the map.
+		const int32 RoadCount = RoadNameIndices.Num();
+		const int32 NodeCount = NodeRoadRefRanges.Num();
+		const int32 BuildingCount = BuildingNameIndices.Num();
+		bool bIsValid =
+			!Ar.IsError() &&
+			RoadTypes.Num() == RoadCount &&
+			RoadOneWayFlags.Num() == RoadCount &&
+			RoadBounds.Num() == RoadCount * 2 &&
+			RoadPointRanges.Num() == RoadCount &&
+			BuildingWindingFlags.Num() == BuildingCount &&
+			BuildingHeights.Num() == BuildingCount &&
+			BuildingLevelCounts.Num() == BuildingCount &&
+			BuildingBounds.Num() == BuildingCount * 2 &&
+			BuildingFillTriangleRanges.Num() == BuildingCount &&
+			BuildingPointRanges.Num() == BuildingCount &&
+			NodeIndexPool.Num() <= PointPool.Num();
+		for( int32 RoadIndex = 0; bIsValid && RoadIndex < RoadCount; ++RoadIndex )
+		{
+			bIsValid =
+				Names.IsValidIndex( RoadNameIndices[ RoadIndex ] ) &&
+				RoadTypes[ RoadIndex ] <= (uint8)EStreetMapRoadType::Other &&
+				RoadPointRanges[ RoadIndex ].IsWithin( NodeIndexPool.Num() );
+		}
+		for( int32 PoolIndex = 0; bIsValid && PoolIndex < NodeIndexPool.Num(); ++PoolIndex )
+		{
+			bIsValid = NodeIndexPool[ PoolIndex ] == INDEX_NONE || ( NodeIndexPool[ PoolIndex ] >= 0 && NodeIndexPool[ PoolIndex ] < NodeCount );
+		}
+		for( int32 NodeIndex = 0; bIsValid && NodeIndex < NodeCount; ++NodeIndex )
+		{
+			bIsValid = NodeRoadRefRanges[ NodeIndex ].IsWithin( RoadRefPool.Num() );
+		}
+		for( int32 RoadRefIndex = 0; bIsValid && RoadRefIndex < RoadRefPool.Num(); ++RoadRefIndex )
+		{
+			const FStreetMapRoadRef& RoadRef = RoadRefPool[ RoadRefIndex ];
+			bIsValid =
+				RoadRef.RoadIndex >= 0 && RoadRef.RoadIndex < RoadCount &&
+				RoadRef.RoadPointIndex >= 0 && RoadRef.RoadPointIndex < RoadPointRanges[ RoadRef.RoadIndex ].Count;
+		}
+		for( int32 BuildingIndex = 0; bIsValid && BuildingIndex < BuildingCount; ++BuildingIndex )
+		{
+			const FStreetMapPoolRange& FillTriangleRange = BuildingFillTriangleRanges[ BuildingIndex ];
+			const FStreetMapPoolRange& PointRange = BuildingPointRanges[ BuildingIndex ];
+			bIsValid =
+				Names.IsValidIndex( BuildingNameIndices[ BuildingIndex ] ) &&
+				FillTriangleRange.IsWithin( FillTriangleIndexPool.Num() ) &&
+				FillTriangleRange.Count % 3 == 0 &&
+				PointRange.IsWithin( PointPool.Num() );
+
+			// The triangles index the building's own points
+			for( int32 PoolIndex = FillTriangleRange.First; bIsValid && PoolIndex < FillTriangleRange.First + FillTriangleRange.Count; ++PoolIndex )
+			{
+				bIsValid = FillTriangleIndexPool[ PoolIndex ] >= 0 && FillTriangleIndexPool[ PoolIndex ] < PointRange.Count;
+			}
+		}
+		if( !bIsValid )
+		{
+			Ar.SetError();
+			Roads.Empty();
+			Nodes.Empty();
+			Buildings.Empty();
+			PointPool.Empty();
+			NodeIndexPool.Empty();
+			RoadPointRanges.Empty();
+			BuildingPointRanges.Empty();
+			return;
+		}
+
+		Roads.Reset();
+		Roads.SetNum( RoadCount );
+		for( int32 RoadIndex = 0; RoadIndex < RoadCount; ++RoadIndex )
+		{
+			FStreetMapRoad& Road = Roads[ RoadIndex ];
+			Road.RoadName = Names[ RoadNameIndices[ RoadIndex ] ];
+			Road.RoadType = (EStreetMapRoadType)RoadTypes[ RoadIndex ];
+			Road.bIsOneWay = RoadOneWayFlags[ RoadIndex ] != 0;
+			Road.BoundsMin = RoadBounds[ RoadIndex * 2 ];
+			Road.BoundsMax = RoadBounds[ RoadIndex * 2 + 1 ];
+		}
+
+		Nodes.Reset();
+		Nodes.SetNum( NodeCount );
+		for( int32 NodeIndex = 0; NodeIndex < NodeCount; ++NodeIndex )
+		{
+			const FStreetMapPoolRange& Range = NodeRoadRefRanges[ NodeIndex ];
+			Nodes[ NodeIndex ].RoadRefs.Append( RoadRefPool.GetData() + Range.First, Range.Count );
+		}
+
+		Buildings.Reset();
+		Buildings.SetNum( BuildingCount );
+		for( int32 BuildingIndex = 0; BuildingIndex < BuildingCount; ++BuildingIndex )
+		{
+			FStreetMapBuilding& Building = Buildings[ BuildingIndex ];
+			Building.BuildingName = Names[ BuildingNameIndices[ BuildingIndex ] ];
+			Building.bPointsWindCounterClockwise = BuildingWindingFlags[ BuildingIndex ] != 0;
+			Building.Height = BuildingHeights[ BuildingIndex ];
+			Building.BuildingLevels = BuildingLevelCounts[ BuildingIndex ];
+			Building.BoundsMin = BuildingBounds[ BuildingIndex * 2 ];
+			Building.BoundsMax = BuildingBounds[ BuildingIndex * 2 + 1 ];
+			const FStreetMapPoolRange& Range = BuildingFillTriangleRanges[ BuildingIndex ];
+			Building.FillTriangleIndices.Append( FillTriangleIndexPool.GetData() + Range.First, Range.Count );
+		}
+	}
+}
+
+
+void UStreetMap::PostLoad()
+{
+	Super::PostLoad();
+
+	if( bIsLoadingGeometry )
+	{
+		// Games read the geometry in the background.  The editor expects maps to be all there once they're loaded.
+		if( !GIsEditor && StartStreamingGeometry() )
+		{
+			return;
+		}
+		LoadGeometryFromBulkData();
+	}
+
+	// Maps saved before we had the geometry pools still have their points in the roads and buildings
+	if( !HasCompactGeometry() )
+	{
+		CompactGeometry();
+	}
+	BuildCachedRoadData();
+}
+
+
+#if WITH_EDITOR
+void UStreetMap::PostEditChangeProperty( FPropertyChangedEvent& PropertyChangedEvent )
+{
+	Super::PostEditChangeProperty( PropertyChangedEvent );
+
+	// Road points can be edited in the details panel, which gives the road its own arrays again
+	CompactGeometry();
+	BuildCachedRoadData();
+}
+
+
+void UStreetMap::PostEditUndo()
+{
+	Super::PostEditUndo();
+
+	// Undo puts back the geometry, but not the data we work out from it
+	BuildCachedRoadData();
+}
+#endif
+
+
+void UStreetMap::BuildCachedRoadData()
+{
+	for( FStreetMapRoad& Road : Roads )
+	{
+		Road.BuildPointPositionsAlongRoad( *this );
+	}
+
+	// The connections use the road lengths we just worked out
+	bIsCachedRoadDataStale = false;
+	BuildConnectionGraph();
+}
+
+
+// Compacting and expanding the geometry moves the points between the roads' and buildings' own (deprecated) arrays and
+// the map's pools
+PRAGMA_DISABLE_DEPRECATION_WARNINGS
+
+void UStreetMap::CompactGeometry()
+{
+	// Some of the roads and buildings may already be in the pools, so we build new ones from whatever each of them has
+	int32 RoadPointCount = 0;
+	for( const FStreetMapRoad& Road : Roads )
+	{
+		RoadPointCount += Road.GetRoadPoints( *this ).Num();
+	}
+	int32 BuildingPointCount = 0;
+	for( const FStreetMapBuilding& Building : Buildings )
+	{
+		BuildingPointCount += Building.GetBuildingPoints( *this ).Num();
+	}
+
+	TArray<FVector2D> NewPointPool;
+	NewPointPool.Reserve( RoadPointCount + BuildingPointCount );
+	TArray<int32> NewNodeIndexPool;
+	NewNodeIndexPool.Reserve( RoadPointCount );
+	TArray<FStreetMapPoolRange> NewRoadPointRanges;
+	NewRoadPointRanges.SetNum( Roads.Num() );
+	TArray<FStreetMapPoolRange> NewBuildingPointRanges;
+	NewBuildingPointRanges.SetNum( Buildings.Num() );
+
+	// Roads come first, so that the road points in the point pool line up with the node index pool
+	for( int32 RoadIndex = 0; RoadIndex < Roads.Num(); ++RoadIndex )
+	{
+		FStreetMapRoad& Road = Roads[ RoadIndex ];
+		const TArrayView<const FVector2D> RoadPoints = Road.GetRoadPoints( *this );
+		const TArrayView<const int32> RoadNodeIndices = Road.GetNodeIndices( *this );
+
+		FStreetMapPoolRange& Range = NewRoadPointRanges[ RoadIndex ];
+		Range.First = NewPointPool.Num();
+		Range.Count = RoadPoints.Num();
+		NewPointPool.Append( RoadPoints.GetData(), RoadPoints.Num() );
+
+		// The node indices share the road's range, so there has to be exactly one for every point
+		ensure( RoadNodeIndices.Num() == RoadPoints.Num() );
+		NewNodeIndexPool.Append( RoadNodeIndices.GetData(), FMath::Min( RoadNodeIndices.Num(), RoadPoints.Num() ) );
+		while( NewNodeIndexPool.Num() < NewPointPool.Num() )
+		{
+			NewNodeIndexPool.Add( INDEX_NONE );
+		}
+
+		Road.RoadPoints.Empty();
+		Road.NodeIndices.Empty();
+	}
+
+	for( int32 BuildingIndex = 0; BuildingIndex < Buildings.Num(); ++BuildingIndex )
+	{
+		FStreetMapBuilding& Building = Buildings[ BuildingIndex ];
+		const TArrayView<const FVector2D> BuildingPoints = Building.GetBuildingPoints( *this );
+
+		FStreetMapPoolRange& Range = NewBuildingPointRanges[ BuildingIndex ];
+		Range.First = NewPointPool.Num();
+		Range.Count = BuildingPoints.Num();
+		NewPointPool.Append( BuildingPoints.GetData(), BuildingPoints.Num() );
+
+		Building.BuildingPoints.Empty();
+	}
+
+	PointPool = MoveTemp( NewPointPool );
+	NodeIndexPool = MoveTemp( NewNodeIndexPool );
+	RoadPointRanges = MoveTemp( NewRoadPointRanges );
+	BuildingPointRanges = MoveTemp( NewBuildingPointRanges );
+}
+
+
+void UStreetMap::ExpandGeometry()
+{
+	for( int32 RoadIndex = 0; RoadIndex < Roads.Num(); ++RoadIndex )
+	{
+		FStreetMapRoad& Road = Roads[ RoadIndex ];
+		if( Road.RoadPoints.Num() == 0 )
+		{
+			const TArrayView<const FVector2D> PooledRoadPoints = GetPooledRoadPoints( RoadIndex );
+			Road.RoadPoints.Append( PooledRoadPoints.GetData(), PooledRoadPoints.Num() );
+		}
+		if( Road.NodeIndices.Num() == 0 )
+		{
+			const TArrayView<const int32> PooledNodeIndices = GetPooledRoadNodeIndices( RoadIndex );
+			Road.NodeIndices.Append( PooledNodeIndices.GetData(), PooledNodeIndices.Num() );
+		}
+	}
+
+	for( int32 BuildingIndex = 0; BuildingIndex < Buildings.Num(); ++BuildingIndex )
+	{
+		FStreetMapBuilding& Building = Buildings[ BuildingIndex ];
+		if( Building.BuildingPoints.Num() == 0 )
+		{
+			const TArrayView<const FVector2D> PooledBuildingPoints = GetPooledBuildingPoints( BuildingIndex );
+			Building.BuildingPoints.Append( PooledBuildingPoints.GetData(), PooledBuildingPoints.Num() );
+		}
+	}
+
+	PointPool.Empty();
+	NodeIndexPool.Empty();
+	RoadPointRanges.Empty();
+	BuildingPointRanges.Empty();
+}
+
+PRAGMA_ENABLE_DEPRECATION_WARNINGS
+
+
+void UStreetMap::BuildConnectionGraph()
+{
+	for( int32 Direction = 0; Direction < 2; ++Direction )
+	{
+		const bool bIsTravelingForward = Direction == 1;
+		TArray<int32>& DirectionConnectionOffsets = ConnectionOffsets[ Direction ];
+		TArray<FStreetMapConnection>& DirectionConnections = Connections[ Direction ];
+		DirectionConnectionOffsets.SetNumUninitialized( Nodes.Num() + 1 );
+		DirectionConnections.Reset();
+
+		auto AddConnection = [ this, &DirectionConnections ]( const FStreetMapRoadRef& RoadRef, const int32 ConnectedNodePointIndexOnRoad )
+		{
+			const FStreetMapRoad& Road = Roads[ RoadRef.RoadIndex ];
+
+			FStreetMapConnection& Connection = DirectionConnections[ DirectionConnections.AddUninitialized() ];
+			Connection.NodeIndex = Road.GetNodeIndices( *this )[ ConnectedNodePointIndexOnRoad ];
+			Connection.RoadIndex = RoadRef.RoadIndex;
+			Connection.PointIndexOnRoad = RoadRef.RoadPointIndex;
+			Connection.ConnectedNodePointIndexOnRoad = ConnectedNodePointIndexOnRoad;
+			Connection.Length = Road.ComputeDistanceBetweenNodesOnRoad( *this, RoadRef.RoadPointIndex, ConnectedNodePointIndexOnRoad );
+			Connection.Cost = FStreetMapNode::EstimateConnectionCost( Road.RoadType, Connection.Length );
+		};
+
+		// NOTE: The connections must be in the same order that FStreetMapNode::GetConnection() finds them without the graph
+		for( int32 NodeIndex = 0; NodeIndex < Nodes.Num(); ++NodeIndex )
+		{
+			DirectionConnectionOffsets[ NodeIndex ] = DirectionConnections.Num();
+
+			for( const FStreetMapRoadRef& RoadRef : Nodes[ NodeIndex ].RoadRefs )
+			{
+				const FStreetMapRoad& Road = Roads[ RoadRef.RoadIndex ];
+				const TArrayView<const int32> RoadNodeIndices = Road.GetNodeIndices( *this );
+
+				if( RoadRef.RoadPointIndex > 0 && ( !bIsTravelingForward || !Road.IsOneWay() ) )
+				{
+					// We connect to an earlier node up this road
+					int32 EarlierNodeRoadPointIndex = RoadRef.RoadPointIndex - 1;
+					while( RoadNodeIndices[ EarlierNodeRoadPointIndex ] == INDEX_NONE )
+					{
+						--EarlierNodeRoadPointIndex;
+					}
+					AddConnection( RoadRef, EarlierNodeRoadPointIndex );
+				}
+
+				if( RoadRef.RoadPointIndex < ( RoadNodeIndices.Num() - 1 ) && ( bIsTravelingForward || !Road.IsOneWay() ) )
+				{
+					// We connect to a node further down this road
+					int32 LaterNodeRoadPointIndex = RoadRef.RoadPointIndex + 1;
+					while( RoadNodeIndices[ LaterNodeRoadPointIndex ] == INDEX_NONE )
+					{
+						++LaterNodeRoadPointIndex;
+					}
+					AddConnection( RoadRef, LaterNodeRoadPointIndex );
+				}
+			}
+		}
+
+		DirectionConnectionOffsets[ Nodes.Num() ] = DirectionConnections.Num();
+		DirectionConnections.Shrink();
+	}
+}
+
+
+void FStreetMapRoad::BuildPointPositionsAlongRoad( const UStreetMap& StreetMap )
+{
+	ComputePointPositionsAlongRoad( StreetMap, PointPositionsAlongRoad );
+	PointPositionsAlongRoad.Shrink();
+}
@@ -75,6 +75,13 @@ void UStreetMapComponent::SetStreetMap(class UStreetMap* NewStreetMap, bool bCle
 {
 	if (StreetMap != NewStreetMap)
 	{
+		// Stop waiting for the old map's geometry
+		if (StreetMap != nullptr && GeometryReadyHandle.IsValid())
+		{
+			StreetMap->OnGeometryReady().Remove(GeometryReadyHandle);
+		}
+		GeometryReadyHandle.Reset();
+
 		StreetMap = NewStreetMap;
 
 		if (bClearPreviousMeshIfAny)
@@ -270,11 +277,12 @@ void UStreetMapComponent::GenerateMesh()
 					break;
 			}
 			
-			for( int32 PointIndex = 0; PointIndex < Road.RoadPoints.Num() - 1; ++PointIndex )
+			const TArrayView<const FVector2D> RoadPoints = Road.GetRoadPoints( *StreetMap );
+			for( int32 PointIndex = 0; PointIndex < RoadPoints.Num() - 1; ++PointIndex )
 			{
 				AddThick2DLine( 
-					Road.RoadPoints[ PointIndex ],
-					Road.RoadPoints[ PointIndex + 1 ],
+					RoadPoints[ PointIndex ],
+					RoadPoints[ PointIndex + 1 ],
 					RoadZ,
 					RoadThickness,
 					RoadColor,
@@ -289,18 +297,26 @@ void UStreetMapComponent::GenerateMesh()
 		for( int32 BuildingIndex = 0; BuildingIndex < Buildings.Num(); ++BuildingIndex )
 		{
 			const auto& Building = Buildings[ BuildingIndex ];
+			const TArrayView<const FVector2D> BuildingPoints = Building.GetBuildingPoints( *StreetMap );
 
 			// Building mesh (or filled area, if the building has no height)
 
-			// Triangulate this building
-			// @todo: Performance: Triangulating lots of building polygons is quite slow.  We could easily do this 
-			//        as part of the import process and store tessellated geometry instead of doing this at load time.
-			bool WindsClockwise;
-			if( FPolygonTools::TriangulatePolygon( Building.BuildingPoints, TempIndices, /* Out */ TriangulatedVertexIndices, /* Out */ WindsClockwise ) )
+			// Buildings are triangulated when they're imported, and their points always wind counter-clockwise.  Maps
+			// that were imported before we did that need to be triangulated here instead.
+			bool WindsClockwise = false;
+			bool bIsTriangulated;
+			if( Building.bPointsWindCounterClockwise )
+			{
+				bIsTriangulated = Building.FillTriangleIndices.Num() > 0;
+			}
+			else
 			{
-				// @todo: Performance: We could preprocess the building shapes so that the points always wind
-				//        in a consistent direction, so we can skip determining the winding above.
+				bIsTriangulated = FPolygonTools::TriangulatePolygon( BuildingPoints, TempIndices, /* Out */ TriangulatedVertexIndices, /* Out */ WindsClockwise );
+			}
+			const TArray<int32>& FillTriangleIndices = Building.bPointsWindCounterClockwise ? Building.FillTriangleIndices : TriangulatedVertexIndices;
 
+			if( bIsTriangulated )
+			{
 				const int32 FirstTopVertexIndex = this->Vertices.Num();
 
 				// calculate fill Z for buildings
@@ -317,12 +333,12 @@ void UStreetMapComponent::GenerateMesh()
 
 				// Top of building
 				{
-					TempPoints.SetNum( Building.BuildingPoints.Num(), false );
-					for( int32 PointIndex = 0; PointIndex < Building.BuildingPoints.Num(); ++PointIndex )
+					TempPoints.SetNum( BuildingPoints.Num(), false );
+					for( int32 PointIndex = 0; PointIndex < BuildingPoints.Num(); ++PointIndex )
 					{
-						TempPoints[ PointIndex ] = FVector( Building.BuildingPoints[ ( Building.BuildingPoints.Num() - PointIndex ) - 1 ], BuildingFillZ );
+						TempPoints[ PointIndex ] = FVector( BuildingPoints[ ( BuildingPoints.Num() - PointIndex ) - 1 ], BuildingFillZ );
 					}
-					AddTriangles( TempPoints, TriangulatedVertexIndices, FVector::ForwardVector, FVector::UpVector, BuildingFillColor, MeshBoundingBox );
+					AddTriangles( TempPoints, FillTriangleIndices, FVector::ForwardVector, FVector::UpVector, BuildingFillColor, MeshBoundingBox );
 				}
 
 				if( bWant3DBuildings && (Building.Height > KINDA_SMALL_NUMBER || Building.BuildingLevels > 0) )
@@ -331,23 +347,23 @@ void UStreetMapComponent::GenerateMesh()
 					if( bWantLitBuildings )
 					{
 						// Create edges for the walls of the 3D buildings
-						for( int32 LeftPointIndex = 0; LeftPointIndex < Building.BuildingPoints.Num(); ++LeftPointIndex )
+						for( int32 LeftPointIndex = 0; LeftPointIndex < BuildingPoints.Num(); ++LeftPointIndex )
 						{
-							const int32 RightPointIndex = ( LeftPointIndex + 1 ) % Building.BuildingPoints.Num();
+							const int32 RightPointIndex = ( LeftPointIndex + 1 ) % BuildingPoints.Num();
 
 							TempPoints.SetNum( 4, false );
 
 							const int32 TopLeftVertexIndex = 0;
-							TempPoints[ TopLeftVertexIndex ] = FVector( Building.BuildingPoints[ WindsClockwise ? RightPointIndex : LeftPointIndex ], BuildingFillZ );
+							TempPoints[ TopLeftVertexIndex ] = FVector( BuildingPoints[ WindsClockwise ? RightPointIndex : LeftPointIndex ], BuildingFillZ );
 
 							const int32 TopRightVertexIndex = 1;
-							TempPoints[ TopRightVertexIndex ] = FVector( Building.BuildingPoints[ WindsClockwise ? LeftPointIndex : RightPointIndex ], BuildingFillZ );
+							TempPoints[ TopRightVertexIndex ] = FVector( BuildingPoints[ WindsClockwise ? LeftPointIndex : RightPointIndex ], BuildingFillZ );
 
 							const int32 BottomRightVertexIndex = 2;
-							TempPoints[ BottomRightVertexIndex ] = FVector( Building.BuildingPoints[ WindsClockwise ? LeftPointIndex : RightPointIndex ], 0.0f );
+							TempPoints[ BottomRightVertexIndex ] = FVector( BuildingPoints[ WindsClockwise ? LeftPointIndex : RightPointIndex ], 0.0f );
 
 							const int32 BottomLeftVertexIndex = 3;
-							TempPoints[ BottomLeftVertexIndex ] = FVector( Building.BuildingPoints[ WindsClockwise ? RightPointIndex : LeftPointIndex ], 0.0f );
+							TempPoints[ BottomLeftVertexIndex ] = FVector( BuildingPoints[ WindsClockwise ? RightPointIndex : LeftPointIndex ], 0.0f );
 
 
 							TempIndices.SetNum( 6, false );
@@ -370,9 +386,9 @@ void UStreetMapComponent::GenerateMesh()
 					{
 						// Create vertices for the bottom
 						const int32 FirstBottomVertexIndex = this->Vertices.Num();
-						for( int32 PointIndex = 0; PointIndex < Building.BuildingPoints.Num(); ++PointIndex )
+						for( int32 PointIndex = 0; PointIndex < BuildingPoints.Num(); ++PointIndex )
 						{
-							const FVector2D Point = Building.BuildingPoints[ PointIndex ];
+							const FVector2D Point = BuildingPoints[ PointIndex ];
 
 							FStreetMapVertex& NewVertex = *new( this->Vertices )FStreetMapVertex();
 							NewVertex.Position = FVector( Point, 0.0f );
@@ -385,9 +401,9 @@ void UStreetMapComponent::GenerateMesh()
 						}
 
 						// Create edges for the walls of the 3D buildings
-						for( int32 LeftPointIndex = 0; LeftPointIndex < Building.BuildingPoints.Num(); ++LeftPointIndex )
+						for( int32 LeftPointIndex = 0; LeftPointIndex < BuildingPoints.Num(); ++LeftPointIndex )
 						{
-							const int32 RightPointIndex = ( LeftPointIndex + 1 ) % Building.BuildingPoints.Num();
+							const int32 RightPointIndex = ( LeftPointIndex + 1 ) % BuildingPoints.Num();
 
 							const int32 BottomLeftVertexIndex = FirstBottomVertexIndex + LeftPointIndex;
 							const int32 BottomRightVertexIndex = FirstBottomVertexIndex + RightPointIndex;
@@ -414,11 +430,11 @@ void UStreetMapComponent::GenerateMesh()
 			// Building border
 			if( bWantBuildingBorderOnGround )
 			{
-				for( int32 PointIndex = 0; PointIndex < Building.BuildingPoints.Num(); ++PointIndex )
+				for( int32 PointIndex = 0; PointIndex < BuildingPoints.Num(); ++PointIndex )
 				{
 					AddThick2DLine(
-						Building.BuildingPoints[ PointIndex ],
-						Building.BuildingPoints[ ( PointIndex + 1 ) % Building.BuildingPoints.Num() ],
+						BuildingPoints[ PointIndex ],
+						BuildingPoints[ ( PointIndex + 1 ) % BuildingPoints.Num() ],
 						BuildingBorderZ,
 						BuildingBorderThickness,		// Thickness
 						BuildingBorderColor,
@@ -474,6 +490,17 @@ void UStreetMapComponent::PostEditChangeProperty(FPropertyChangedEvent& Property
 
 void UStreetMapComponent::BuildMesh()
 {
+	// The street map's geometry may still be loading in the background.  Rather than waiting for it, we keep whatever
+	// mesh we have and build the new one when the geometry is ready.
+	if (StreetMap != nullptr && !StreetMap->IsGeometryReady())
+	{
+		if (!GeometryReadyHandle.IsValid())
+		{
+			GeometryReadyHandle = StreetMap->OnGeometryReady().AddUObject(this, &UStreetMapComponent::OnStreetMapGeometryReady);
+		}
+		return;
+	}
+
 	// Wipes out our cached mesh data. Maybe unnecessary in case GenerateMesh is clearing cached mesh data and creating a new SceneProxy  !
 	InvalidateMesh();
 
@@ -500,6 +527,18 @@ void UStreetMapComponent::BuildMesh()
 }
 
 
+void UStreetMapComponent::OnStreetMapGeometryReady(UStreetMap* ReadyStreetMap)
+{
+	ReadyStreetMap->OnGeometryReady().Remove(GeometryReadyHandle);
+	GeometryReadyHandle.Reset();
+
+	if (ReadyStreetMap == StreetMap)
+	{
+		BuildMesh();
+	}
+}
+
+
 void UStreetMapComponent::AssignDefaultMaterialIfNeeded()
 {
 	if (this->GetNumMaterials() == 0 || this->GetMaterial(0) == nullptr)
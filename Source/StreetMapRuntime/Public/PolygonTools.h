@@ -1,32 +1,32 @@
 // Copyright 2017 Mike Fricker. All Rights Reserved.
 #pragma once
 
-class FPolygonTools
+class STREETMAPRUNTIME_API FPolygonTools
 {
 
 public:
 
 	/** Triangulate a polygon given a list of contour points, then places results as indices into the original polygon array.  Does not support polygons with holes. */
-	static bool TriangulatePolygon( const TArray<FVector2D>& Polygon, TArray<int32>& TempIndices, TArray<int32>& TriangulatedIndices, bool& OutWindsClockwise );
+	static bool TriangulatePolygon( const TArrayView<const FVector2D> Polygon, TArray<int32>& TempIndices, TArray<int32>& TriangulatedIndices, bool& OutWindsClockwise );
 
 	/** Compute area of a polygon */
-	static inline float Area( const TArray<FVector2D>& Polygon );
+	static inline float Area( const TArrayView<const FVector2D> Polygon );
 
 	/** Determines if the specified point is inside the triangle defined by the three triangle corners */
 	static inline bool IsPointInsideTriangle( const FVector2D TriangleA, const FVector2D TriangleB, const FVector2D TriangleC, const FVector2D Point );
 
 	/** Given a 2D polygon and a point, determines whether the point is inside the polygon.  Supports convex polygons.  If the point is exactly on the polygon boundary, the return value could be either false or true. */
-	static inline bool IsPointInsidePolygon( const TArray<FVector2D>& Polygon, const FVector2D Point );
+	static inline bool IsPointInsidePolygon( const TArrayView<const FVector2D> Polygon, const FVector2D Point );
 
 
 private:
 
 	/** Clips a polygon */
-	static inline bool Snip( const TArray<FVector2D>& Polygon, const int32 U, const int32 V, const int32 W, const int32 PointCount, const int32* VertexIndices );
+	static inline bool Snip( const TArrayView<const FVector2D> Polygon, const int32 U, const int32 V, const int32 W, const int32 PointCount, const int32* VertexIndices );
 };
 
 
-float FPolygonTools::Area( const TArray<FVector2D>& Polygon )
+float FPolygonTools::Area( const TArrayView<const FVector2D> Polygon )
 {
 	const int32 PointCount = Polygon.Num();
 
@@ -57,7 +57,7 @@ bool FPolygonTools::IsPointInsideTriangle( const FVector2D TriangleA, const FVec
 };
 
 
-bool FPolygonTools::IsPointInsidePolygon( const TArray<FVector2D>& Polygon, const FVector2D Point )
+bool FPolygonTools::IsPointInsidePolygon( const TArrayView<const FVector2D> Polygon, const FVector2D Point )
 {
 	const int NumCorners = Polygon.Num();
 	int PreviousCornerIndex = NumCorners - 1;
@@ -78,7 +78,7 @@ bool FPolygonTools::IsPointInsidePolygon( const TArray<FVector2D>& Polygon, cons
 }
 
 
-bool FPolygonTools::Snip( const TArray<FVector2D>& Polygon, const int32 U, const int32 V, const int32 W, const int32 PointCount, const int32* VertexIndices )
+bool FPolygonTools::Snip( const TArrayView<const FVector2D> Polygon, const int32 U, const int32 V, const int32 W, const int32 PointCount, const int32* VertexIndices )
 {
 	const FVector2D A = Polygon[ VertexIndices[ U ] ];
 	const FVector2D B = Polygon[ VertexIndices[ V ] ];
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include "Algo/BinarySearch.h"
+#include "Serialization/BulkData.h"
 #include "StreetMap.generated.h"
 
 
@@ -151,11 +153,15 @@ struct STREETMAPRUNTIME_API FStreetMapRoad
 	UPROPERTY( Category=StreetMap, EditAnywhere )
 	TEnumAsByte<EStreetMapRoadType> RoadType;
 	
-	/** Nodes along this road, one at each point in the RoadPoints list */
+	/** Nodes along this road, one at each point in the RoadPoints list.  Empty once the map's geometry has been compacted,
+	    which it always is on a loaded map, so read them with GetNodeIndices() instead. */
+	UE_DEPRECATED( 4.27, "Please do not access this member directly; it is empty on loaded maps.  Use FStreetMapRoad::GetNodeIndices() instead." )
 	UPROPERTY( Category=StreetMap, EditAnywhere )
 	TArray<int32> NodeIndices;
 
-	/** List of all of the points on this road, one for each node in the NodeIndices list */
+	/** List of all of the points on this road, one for each node in the NodeIndices list.  Empty once the map's geometry
+	    has been compacted, which it always is on a loaded map, so read them with GetRoadPoints() instead. */
+	UE_DEPRECATED( 4.27, "Please do not access this member directly; it is empty on loaded maps.  Use FStreetMapRoad::GetRoadPoints() instead." )
 	UPROPERTY( Category=StreetMap, EditAnywhere )
 	TArray<FVector2D> RoadPoints;
 	
@@ -173,16 +179,41 @@ struct STREETMAPRUNTIME_API FStreetMapRoad
 	UPROPERTY( Category=StreetMap, EditAnywhere )
 	uint8 bIsOneWay : 1;
 
+	/** Distance along the road to each of the points in the RoadPoints list, so that positions along the road can be
+	    looked up without walking it.  This isn't saved.  UStreetMap builds it when the map is loaded or imported. */
+	TArray<float> PointPositionsAlongRoad;
+
 
 	/** Returns this node's index */
 	inline int32 GetRoadIndex( const class UStreetMap& StreetMap ) const;
 
+	/** Gets the points on this road.  These are in RoadPoints, unless the map's geometry has been compacted, in which case
+	    they're in the map's point pool (see UStreetMap::CompactGeometry().)  Always use this instead of RoadPoints when
+	    reading a road on a loaded map. */
+	inline TArrayView<const FVector2D> GetRoadPoints( const class UStreetMap& StreetMap ) const;
+
+	/** Gets the node at each point on this road (INDEX_NONE where there isn't one).  Like GetRoadPoints(), this reads from
+	    the map's pools if the geometry has been compacted. */
+	inline TArrayView<const int32> GetNodeIndices( const class UStreetMap& StreetMap ) const;
+
 	/** Gets the node for the specified point, or the node that came before that if the specified point doesn't have a node */
 	inline const struct FStreetMapNode& GetNodeAtPointIndexOrEarlier( const class UStreetMap& StreetMap, const int32 PointIndex, int32& OutNodeAtPointIndex ) const;
 
 	/** Gets the node for the specified point, or the node that comes next after that if the specified point doesn't have a node */
 	inline const struct FStreetMapNode& GetNodeAtPointIndexOrLater( const class UStreetMap& StreetMap, const int32 PointIndex, int32& OutNodeAtPointIndex ) const;
 
+	/** Fills in PointPositionsAlongRoad from the road's points */
+	void BuildPointPositionsAlongRoad( const class UStreetMap& StreetMap );
+
+	/** Works out the distance along the road to each of its points, by walking along it */
+	template<typename AllocatorType>
+	inline void ComputePointPositionsAlongRoad( const class UStreetMap& StreetMap, TArray<float, AllocatorType>& OutPointPositions ) const;
+
+	/** Returns the distance along the road to each of its points.  If PointPositionsAlongRoad may be out of date (because
+	    the map's roads were changed since it was built, see UStreetMap::MarkCachedRoadDataDirty()), the distances are
+	    worked out into the scratch array instead. */
+	inline TArrayView<const float> GetPointPositionsAlongRoad( const class UStreetMap& StreetMap, TArray<float, TInlineAllocator<32>>& Scratch ) const;
+
 	/** Computes the total length of this road by following along all of it's points */
 	float ComputeLengthOfRoad( const class UStreetMap& StreetMap ) const;
 
@@ -210,6 +241,16 @@ struct STREETMAPRUNTIME_API FStreetMapRoad
 	{
 		return bIsOneWay == 1 ? true : false;
 	}
+
+	// Copying a road copies its deprecated point arrays too, which shouldn't warn
+	PRAGMA_DISABLE_DEPRECATION_WARNINGS
+	FStreetMapRoad() = default;
+	FStreetMapRoad( const FStreetMapRoad& ) = default;
+	FStreetMapRoad( FStreetMapRoad&& ) = default;
+	FStreetMapRoad& operator=( const FStreetMapRoad& ) = default;
+	FStreetMapRoad& operator=( FStreetMapRoad&& ) = default;
+	~FStreetMapRoad() = default;
+	PRAGMA_ENABLE_DEPRECATION_WARNINGS
 };
 
 
@@ -227,6 +268,35 @@ struct STREETMAPRUNTIME_API FStreetMapRoadRef
 	/** Index of the point along road where this node exists */
 	UPROPERTY( Category=StreetMap, EditAnywhere )
 	int32 RoadPointIndex;
+
+	friend FArchive& operator<<( FArchive& Ar, FStreetMapRoadRef& RoadRef )
+	{
+		Ar << RoadRef.RoadIndex;
+		Ar << RoadRef.RoadPointIndex;
+		return Ar;
+	}
+};
+
+
+/** A connection from a node to the next node along one of its roads, in a street map's connection graph.  See
+    UStreetMap::GetConnections(). */
+struct FStreetMapConnection
+{
+	/** Index of the node we connect to */
+	int32 NodeIndex;
+
+	/** Index of the road that connects the two nodes */
+	int32 RoadIndex;
+
+	/** Where the two nodes are on that road */
+	int32 PointIndexOnRoad;
+	int32 ConnectedNodePointIndexOnRoad;
+
+	/** Distance along the road between the two nodes */
+	float Length;
+
+	/** Estimated cost of traveling along the connection (see FStreetMapNode::EstimateConnectionCost()) */
+	float Cost;
 };
 
 
@@ -266,6 +336,14 @@ struct STREETMAPRUNTIME_API FStreetMapNode
 
 	/** Pathfinding: Estimates the 'cost' of the specified connected by index (between 0 and GetConnectionCount() - 1) */
 	inline float GetConnectionCost( const class UStreetMap& StreetMap, const int32 ConnectionIndex, const bool bIsTravelingForward ) const;
+
+	/** Pathfinding: Returns all of the connections from this node, taking into account the direction of travel, in the same
+	    order that GetConnection() numbers them.  This is the fastest way to visit a node's neighbors.  Empty if the map's
+	    connection graph hasn't been built. */
+	inline TArrayView<const FStreetMapConnection> GetConnections( const class UStreetMap& StreetMap, const bool bIsTravelingForward ) const;
+
+	/** Pathfinding: Estimates the 'cost' of traveling the specified distance along a type of road */
+	static inline float EstimateConnectionCost( const EStreetMapRoadType RoadType, const float DistanceBetweenNodes );
 };
 
 
@@ -279,10 +357,23 @@ struct STREETMAPRUNTIME_API FStreetMapBuilding
 	UPROPERTY( Category=StreetMap, EditAnywhere )
 	FString BuildingName;
 
-	/** Polygon points that define the perimeter of the building */
+	/** Polygon points that define the perimeter of the building.  The outline is implicitly closed (the last point
+	    connects back to the first one), and never has two matching points in a row.  Empty once the map's geometry has
+	    been compacted, which it always is on a loaded map, so read them with GetBuildingPoints() instead. */
+	UE_DEPRECATED( 4.27, "Please do not access this member directly; it is empty on loaded maps.  Use FStreetMapBuilding::GetBuildingPoints() instead." )
 	UPROPERTY( Category=StreetMap, EditAnywhere )
 	TArray<FVector2D> BuildingPoints;
 
+	/** Triangles that fill in the building's outline, as three indices into BuildingPoints per triangle.  This is
+	    computed at import time, and is empty if the outline couldn't be triangulated. */
+	UPROPERTY( Category=StreetMap, VisibleAnywhere )
+	TArray<int32> FillTriangleIndices;
+
+	/** True if BuildingPoints were made to wind counter-clockwise and FillTriangleIndices is valid.  Buildings
+	    imported before we did this are triangulated when the mesh is built instead. */
+	UPROPERTY( Category=StreetMap, VisibleAnywhere )
+	bool bPointsWindCounterClockwise;
+
 	/** Height of the building in meters (if known, otherwise zero) */
 	UPROPERTY( Category=StreetMap, EditAnywhere )
 	float Height;
@@ -300,9 +391,332 @@ struct STREETMAPRUNTIME_API FStreetMapBuilding
 	/** 2D bounds (max) of this building's points */
 	UPROPERTY( Category=StreetMap, EditAnywhere )
 	FVector2D BoundsMax;
+
+
+	/** Returns this building's index */
+	inline int32 GetBuildingIndex( const class UStreetMap& StreetMap ) const;
+
+	/** Gets the points around this building.  These are in BuildingPoints, unless the map's geometry has been compacted,
+	    in which case they're in the map's point pool (see UStreetMap::CompactGeometry().)  Always use this instead of
+	    BuildingPoints when reading a building on a loaded map. */
+	inline TArrayView<const FVector2D> GetBuildingPoints( const class UStreetMap& StreetMap ) const;
+
+	// Like FStreetMapRoad, copying a building shouldn't warn about its deprecated point array
+	PRAGMA_DISABLE_DEPRECATION_WARNINGS
+	FStreetMapBuilding()
+		: bPointsWindCounterClockwise( false ),
+		  Height( 0.0f ),
+		  BuildingLevels( 0 )
+	{
+	}
+	FStreetMapBuilding( const FStreetMapBuilding& ) = default;
+	FStreetMapBuilding( FStreetMapBuilding&& ) = default;
+	FStreetMapBuilding& operator=( const FStreetMapBuilding& ) = default;
+	FStreetMapBuilding& operator=( FStreetMapBuilding&& ) = default;
+	~FStreetMapBuilding() = default;
+	PRAGMA_ENABLE_DEPRECATION_WARNINGS
+};
+
+
+/** A point where a road leaves a street map that is one tile of a larger map.  The road continues in the neighboring
+    tile from a node with the same boundary node ID. */
+USTRUCT( BlueprintType )
+struct STREETMAPRUNTIME_API FStreetMapBoundaryNode
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Index of the node in this map */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	int32 NodeIndex;
+
+	/** ID of this point, shared with the neighboring tile */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	int64 BoundaryNodeID;
+};
+
+
+/** One tile of a street map that was split into tiles when it was imported */
+USTRUCT( BlueprintType )
+struct STREETMAPRUNTIME_API FStreetMapTile
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Column of this tile in the grid */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	int32 TileX;
+
+	/** Row of this tile in the grid */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	int32 TileY;
+
+	/** The street map for this tile.  Tiles use the same origin as the map they were split from, so they line up
+	    with each other when placed at the same location. */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	TSoftObjectPtr<class UStreetMap> StreetMap;
+
+	/** 2D bounds (min) of the area covered by this tile */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	FVector2D BoundsMin;
+
+	/** 2D bounds (max) of the area covered by this tile */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	FVector2D BoundsMax;
+};
+
+
+/** What happens to ways that match a tag filter rule */
+UENUM( BlueprintType )
+enum class EStreetMapTagFilterAction : uint8
+{
+	/** Throw the way away */
+	Drop,
+
+	/** Import the way */
+	Keep,
+};
+
+
+/** A rule that decides whether OpenStreetMap ways with a certain tag are imported */
+USTRUCT( BlueprintType )
+struct STREETMAPRUNTIME_API FStreetMapTagFilterRule
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Tag key to match, such as "highway" */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	FString Key;
+
+	/** Tag value to match, such as "footway".  Leave empty (or use "*") to match any value. */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	FString Value;
+
+	/** Whether ways with this tag are imported or thrown away */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	EStreetMapTagFilterAction Action;
+
+	/** Type of road to make the ways this rule keeps into.  Other uses the type their highway tag normally gets.
+	    Buildings are always imported as buildings. */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	TEnumAsByte<EStreetMapRoadType> RoadType;
+
+	FStreetMapTagFilterRule()
+		: Action( EStreetMapTagFilterAction::Drop ),
+		  RoadType( EStreetMapRoadType::Other )
+	{
+	}
+};
+
+
+/** Options that control how a street map is imported from OpenStreetMap data.  These are stored with the map, so
+    that reimporting gives the same results. */
+USTRUCT( BlueprintType )
+struct STREETMAPRUNTIME_API FStreetMapImportOptions
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Only load the nodes that are used by roads and buildings we keep.  The file is read twice (once for ways, then
+	    again for just the nodes they use), which is slower, but uses far less memory for large files where most
+	    nodes are points of interest or belong to ways we don't import. */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	bool bPruneUnreferencedNodes;
+
+	/** Rules that pick which ways to import by their tags, for example to drop footways or parking aisles, or to keep
+	    railways as roads.  When several of a way's tags match, the rule nearest the top of the list wins.  Ways that no
+	    rule matches are imported as usual.  Ways are thrown away as soon as they're parsed, so dropping them saves time
+	    and memory through the rest of the import. */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	TArray<FStreetMapTagFilterRule> TagFilterRules;
+
+	/** Only import the part of the map inside of a latitude/longitude region.  Roads and buildings are cut off at the edge
+	    of the region, and the map is centered on it, so import time and asset size depend on the size of the region
+	    rather than the size of the file. */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	bool bClipToRegion;
+
+	/** Southern edge of the region to import, in degrees */
+	UPROPERTY( Category=StreetMap, EditAnywhere, meta=( EditCondition="bClipToRegion" ) )
+	double ClipMinLatitude;
+
+	/** Western edge of the region to import, in degrees */
+	UPROPERTY( Category=StreetMap, EditAnywhere, meta=( EditCondition="bClipToRegion" ) )
+	double ClipMinLongitude;
+
+	/** Northern edge of the region to import, in degrees */
+	UPROPERTY( Category=StreetMap, EditAnywhere, meta=( EditCondition="bClipToRegion" ) )
+	double ClipMaxLatitude;
+
+	/** Eastern edge of the region to import, in degrees */
+	UPROPERTY( Category=StreetMap, EditAnywhere, meta=( EditCondition="bClipToRegion" ) )
+	double ClipMaxLongitude;
+
+	/** Optional outline of the region to import, used instead of the rectangle above.  X is longitude and Y is latitude,
+	    in degrees.  Buildings are only trimmed exactly against convex outlines.  With other shapes, buildings crossing
+	    the edge are kept whole if their center is inside. */
+	UPROPERTY( Category=StreetMap, EditAnywhere, meta=( EditCondition="bClipToRegion" ) )
+	TArray<FVector2D> ClipPolygon;
+
+	/** How far outside of the region (in meters) nodes are still loaded, so that roads leaving the region can be cut
+	    off right at its edge.  Roads with nodes further apart than this may stop short of the edge. */
+	UPROPERTY( Category=StreetMap, EditAnywhere, meta=( EditCondition="bClipToRegion", ClampMin=0 ) )
+	float ClipMargin;
+
+	/** Split the map into a grid of square tiles, and save each tile as its own street map asset in a folder next to
+	    this one.  This map then only keeps the list of tiles, so that each part of a large map can be loaded and built
+	    on its own. */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	bool bSplitIntoTiles;
+
+	/** Width and height of each tile in meters */
+	UPROPERTY( Category=StreetMap, EditAnywhere, meta=( EditCondition="bSplitIntoTiles", ClampMin=100 ) )
+	float TileSize;
+
+	/** Nodes closer together than this (in centimeters) are welded into a single node, so that roads which only look
+	    connected really are, and roads and buildings never have two points in a row in the same place.  Nodes in exactly
+	    the same place are always welded. */
+	UPROPERTY( Category=StreetMap, EditAnywhere, meta=( ClampMin=0 ) )
+	float WeldTolerance;
+
+	/** Join roads that meet end to end into a single road, where nothing else meets them and both have the same type,
+	    name and direction.  OpenStreetMap splits streets wherever any of their tags change, so this gets rid of a lot of
+	    small roads and the nodes between them.  osmChange files can't be applied to maps imported this way, because
+	    their roads no longer match up with OpenStreetMap ways. */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	bool bMergeRoadChains;
+
+	/** Remove points from roads and building outlines that hardly change their shape (Douglas-Peucker simplification).
+	    Points where roads meet or end are always kept, so the road network stays connected.  Roads that osmChange
+	    files add later can only connect to points that were kept. */
+	UPROPERTY( Category=StreetMap, EditAnywhere )
+	bool bSimplifyLines;
+
+	/** How far (in centimeters) a simplified road or building outline may stray from the original */
+	UPROPERTY( Category=StreetMap, EditAnywhere, meta=( EditCondition="bSimplifyLines", ClampMin=0 ) )
+	float SimplifyTolerance;
+
+	FStreetMapImportOptions()
+		: bPruneUnreferencedNodes( false ),
+		  bClipToRegion( false ),
+		  ClipMinLatitude( 0.0 ),
+		  ClipMinLongitude( 0.0 ),
+		  ClipMaxLatitude( 0.0 ),
+		  ClipMaxLongitude( 0.0 ),
+		  ClipMargin( 500.0f ),
+		  bSplitIntoTiles( false ),
+		  TileSize( 2000.0f ),
+		  WeldTolerance( 1.0f ),
+		  bMergeRoadChains( false ),
+		  bSimplifyLines( false ),
+		  SimplifyTolerance( 100.0f )
+	{
+	}
+};
+
+
+/** Where everything in a street map came from in the OpenStreetMap data.  This lets osmChange files be applied to the
+    map later on, without importing the whole map again. */
+USTRUCT()
+struct STREETMAPRUNTIME_API FStreetMapOSMSourceData
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Latitude of the point the map's coordinates are relative to */
+	UPROPERTY()
+	double OriginLatitude;
+
+	/** Longitude of the point the map's coordinates are relative to */
+	UPROPERTY()
+	double OriginLongitude;
+
+	/** IDs of the OpenStreetMap nodes used by the map's roads and buildings, sorted.  This includes the nodes that were
+	    welded onto other nodes. */
+	UPROPERTY()
+	TArray<int64> NodeIDs;
+
+	/** Location of each of those nodes, in fixed point units of 1e-7 degrees */
+	UPROPERTY()
+	TArray<int32> NodeLatitudes;
+	UPROPERTY()
+	TArray<int32> NodeLongitudes;
+
+	/** OpenStreetMap way that each road came from */
+	UPROPERTY()
+	TArray<int64> RoadWayIDs;
+
+	/** OpenStreetMap node at each point of each road, for all of the roads in order.  A point that was welded onto
+	    another node keeps the ID of the node it started out as. */
+	UPROPERTY()
+	TArray<int64> RoadPointNodeIDs;
+
+	/** OpenStreetMap way that each building came from */
+	UPROPERTY()
+	TArray<int64> BuildingWayIDs;
+
+	/** OpenStreetMap node at each point of each building, for all of the buildings in order.  A point that was welded
+	    onto another node keeps the ID of the node it started out as. */
+	UPROPERTY()
+	TArray<int64> BuildingPointNodeIDs;
+
+	/** OpenStreetMap node that each of the map's nodes came from.  These are always nodes that weren't welded. */
+	UPROPERTY()
+	TArray<int64> MapNodeIDs;
+
+	/** OpenStreetMap nodes that were welded onto another node because they were within the weld tolerance of it, sorted.
+	    Their points are drawn where the other node is. */
+	UPROPERTY()
+	TArray<int64> WeldedNodeIDs;
+
+	/** The node that each of the WeldedNodeIDs was welded onto.  Welding isn't transitive, so these were never welded
+	    onto anything themselves. */
+	UPROPERTY()
+	TArray<int64> WeldedOntoNodeIDs;
+
+	FStreetMapOSMSourceData()
+		: OriginLatitude( 0.0 ),
+		  OriginLongitude( 0.0 )
+	{
+	}
+};
+
+
+/** Where one road's or building's entries are in a street map's geometry pools */
+USTRUCT()
+struct STREETMAPRUNTIME_API FStreetMapPoolRange
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Index of the first entry in the pool */
+	UPROPERTY()
+	int32 First;
+
+	/** How many entries there are */
+	UPROPERTY()
+	int32 Count;
+
+	FStreetMapPoolRange()
+		: First( 0 ),
+		  Count( 0 )
+	{
+	}
+
+	/** Returns true if the range fits in a pool of the specified size */
+	bool IsWithin( const int32 PoolSize ) const
+	{
+		return First >= 0 && Count >= 0 && First <= PoolSize - Count;
+	}
+
+	friend FArchive& operator<<( FArchive& Ar, FStreetMapPoolRange& Range )
+	{
+		Ar << Range.First;
+		Ar << Range.Count;
+		return Ar;
+	}
 };
 
 
+/** Called on the game thread when a street map's geometry has finished loading in the background */
+DECLARE_MULTICAST_DELEGATE_OneParam( FOnStreetMapGeometryReady, class UStreetMap* );
+
+
 /** A loaded street map */
 UCLASS()
 class STREETMAPRUNTIME_API UStreetMap : public UObject
@@ -316,6 +730,119 @@ public:
 
 	// UObject overrides
 	virtual void GetAssetRegistryTags( TArray<FAssetRegistryTag>& OutTags ) const override;
+	virtual void Serialize( FArchive& Ar ) override;
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty( FPropertyChangedEvent& PropertyChangedEvent ) override;
+	virtual void PostEditUndo() override;
+#endif
+
+	/** Returns true if the roads, nodes and buildings are loaded.  In a game, they are read from disk in the background
+	    after the rest of the map (the bounds, tiles and how many of everything there are), so that loading a big map
+	    doesn't hitch.  Until they are ready the map has no roads, nodes or buildings. */
+	bool IsGeometryReady() const
+	{
+		return !bIsLoadingGeometry;
+	}
+
+	/** Called when the geometry finishes loading in the background.  Nothing is called for maps that are already ready,
+	    so check IsGeometryReady() before binding to this. */
+	FOnStreetMapGeometryReady& OnGeometryReady()
+	{
+		return GeometryReadyEvent;
+	}
+
+	/** Loads the geometry right away, if it is still loading in the background.  This blocks until it is read. */
+	void FinishLoadingGeometry();
+
+	/** Gets how many roads, nodes and buildings the map has.  These are known as soon as the map is loaded, even if its
+	    geometry isn't ready yet. */
+	int32 GetRoadCount() const
+	{
+		return bIsLoadingGeometry ? HeaderRoadCount : Roads.Num();
+	}
+	int32 GetNodeCount() const
+	{
+		return bIsLoadingGeometry ? HeaderNodeCount : Nodes.Num();
+	}
+	int32 GetBuildingCount() const
+	{
+		return bIsLoadingGeometry ? HeaderBuildingCount : Buildings.Num();
+	}
+
+	/** Works out the data that speeds up queries on roads but isn't saved with the map: how far along each road its points
+	    are (see FStreetMapRoad::PointPositionsAlongRoad), and the connection graph between nodes.  This is done when the
+	    map is loaded.  Call it again after changing the roads or nodes. */
+	void BuildCachedRoadData();
+
+	/** Tells the map that its roads or nodes were changed, so that queries stop using the cached road data (and walk
+	    the roads instead) until BuildCachedRoadData() is called again.  Use this when changing several things before
+	    rebuilding the cached data once. */
+	void MarkCachedRoadDataDirty()
+	{
+		bIsCachedRoadDataStale = true;
+	}
+
+	/** Returns true if the roads or nodes have changed since BuildCachedRoadData() was last called */
+	bool IsCachedRoadDataStale() const
+	{
+		return bIsCachedRoadDataStale;
+	}
+
+	/** Moves the points and node indices of all of the roads and buildings out of their own arrays and into a few big
+	    arrays shared by the whole map, so that a loaded map is a handful of allocations rather than several for every
+	    road and building.  Roads and buildings that have their own arrays again (because they were edited) are moved
+	    back into the pools too.  Maps are compacted when they're imported and loaded.  Read the geometry with
+	    FStreetMapRoad::GetRoadPoints(), FStreetMapRoad::GetNodeIndices() and FStreetMapBuilding::GetBuildingPoints(),
+	    which work either way. */
+	void CompactGeometry();
+
+	/** Moves the points and node indices back out of the pools and into the roads and buildings, so that they can be
+	    changed.  Call CompactGeometry() again when done. */
+	void ExpandGeometry();
+
+	/** Returns true if the roads' and buildings' geometry is stored in the shared pools */
+	bool HasCompactGeometry() const
+	{
+		return RoadPointRanges.Num() == Roads.Num() && BuildingPointRanges.Num() == Buildings.Num() && ( Roads.Num() > 0 || Buildings.Num() > 0 );
+	}
+
+	/** Gets the pooled points and node indices of a road, or nothing if the geometry hasn't been compacted.  Prefer the
+	    accessors on FStreetMapRoad, which also work before then. */
+	TArrayView<const FVector2D> GetPooledRoadPoints( const int32 RoadIndex ) const
+	{
+		return RoadPointRanges.IsValidIndex( RoadIndex ) ? TArrayView<const FVector2D>( PointPool.GetData() + RoadPointRanges[ RoadIndex ].First, RoadPointRanges[ RoadIndex ].Count ) : TArrayView<const FVector2D>();
+	}
+	TArrayView<const int32> GetPooledRoadNodeIndices( const int32 RoadIndex ) const
+	{
+		return RoadPointRanges.IsValidIndex( RoadIndex ) ? TArrayView<const int32>( NodeIndexPool.GetData() + RoadPointRanges[ RoadIndex ].First, RoadPointRanges[ RoadIndex ].Count ) : TArrayView<const int32>();
+	}
+
+	/** Gets the pooled points of a building, or nothing if the geometry hasn't been compacted.  Prefer
+	    FStreetMapBuilding::GetBuildingPoints(), which also works before then. */
+	TArrayView<const FVector2D> GetPooledBuildingPoints( const int32 BuildingIndex ) const
+	{
+		return BuildingPointRanges.IsValidIndex( BuildingIndex ) ? TArrayView<const FVector2D>( PointPool.GetData() + BuildingPointRanges[ BuildingIndex ].First, BuildingPointRanges[ BuildingIndex ].Count ) : TArrayView<const FVector2D>();
+	}
+
+	/** Pathfinding: Returns the connections from a node to its neighbors along roads, taking into account the direction
+	    of travel.  Empty if the connection graph hasn't been built. */
+	TArrayView<const FStreetMapConnection> GetConnections( const int32 NodeIndex, const bool bIsTravelingForward ) const
+	{
+		if( !HasConnectionGraph() )
+		{
+			return TArrayView<const FStreetMapConnection>();
+		}
+		const int32 Direction = bIsTravelingForward ? 1 : 0;
+		const int32 FirstConnectionIndex = ConnectionOffsets[ Direction ][ NodeIndex ];
+		return TArrayView<const FStreetMapConnection>( Connections[ Direction ].GetData() + FirstConnectionIndex, ConnectionOffsets[ Direction ][ NodeIndex + 1 ] - FirstConnectionIndex );
+	}
+
+	/** Returns true if the connection graph is up to date with the roads and nodes */
+	bool HasConnectionGraph() const
+	{
+		return !bIsCachedRoadDataStale && ConnectionOffsets[ 0 ].Num() == Nodes.Num() + 1;
+	}
 	
 	/** Gets the roads in this street map (read only) */
 	const TArray<FStreetMapRoad>& GetRoads() const
@@ -323,7 +850,7 @@ public:
 		return Roads;
 	}
 
-	/** Gets the roads in this street map */
+	/** Gets the roads in this street map.  Call MarkCachedRoadDataDirty() or BuildCachedRoadData() after changing them. */
 	TArray<FStreetMapRoad>& GetRoads()
 	{
 		return Roads;
@@ -335,7 +862,8 @@ public:
 		return Nodes;
 	}
 
-	/** Gets the nodes on the map.  Nodes describe intersections between roads */
+	/** Gets the nodes on the map.  Nodes describe intersections between roads.  Like the roads, call
+	    MarkCachedRoadDataDirty() or BuildCachedRoadData() after changing them. */
 	TArray<FStreetMapNode>& GetNodes()
 	{
 		return Nodes;
@@ -363,6 +891,24 @@ public:
 		return BoundsMax;
 	}
 
+	/** Gets the nodes where roads leave this map, if it is one tile of a larger map */
+	const TArray<FStreetMapBoundaryNode>& GetBoundaryNodes() const
+	{
+		return BoundaryNodes;
+	}
+
+	/** Gets the tiles this map was split into when it was imported.  Empty unless the map was split into tiles. */
+	const TArray<FStreetMapTile>& GetTiles() const
+	{
+		return Tiles;
+	}
+
+	/** Gets the width and height of this map's tiles in centimeters, or zero if it wasn't split into tiles */
+	float GetTileSize() const
+	{
+		return TileSize;
+	}
+
 
 protected:
 	
@@ -386,14 +932,109 @@ protected:
 	UPROPERTY( Category=StreetMap, VisibleAnywhere)
 	FVector2D BoundsMax;
 
+	/** Nodes where roads leave this map, if it is one tile of a larger map */
+	UPROPERTY( Category=StreetMap, VisibleAnywhere )
+	TArray<FStreetMapBoundaryNode> BoundaryNodes;
+
+	/** Width and height of each tile in centimeters, if this map was split into tiles */
+	UPROPERTY( Category=StreetMap, VisibleAnywhere )
+	float TileSize;
+
+	/** Tiles that this map was split into.  When a map is split into tiles, the roads, nodes and buildings are all
+	    stored in the tiles instead of in this map. */
+	UPROPERTY( Category=StreetMap, VisibleAnywhere )
+	TArray<FStreetMapTile> Tiles;
+
+	/** Points of all of the roads and then all of the buildings, once the geometry has been compacted.  The pools are
+	    saved by SerializeGeometry().  They are still properties so that maps saved before then load. */
+	UPROPERTY()
+	TArray<FVector2D> PointPool;
+
+	/** Node at each road point in PointPool (roads only, so this is shorter than PointPool) */
+	UPROPERTY()
+	TArray<int32> NodeIndexPool;
+
+	/** Where each road's points are in PointPool and NodeIndexPool */
+	UPROPERTY()
+	TArray<FStreetMapPoolRange> RoadPointRanges;
+
+	/** Where each building's points are in PointPool */
+	UPROPERTY()
+	TArray<FStreetMapPoolRange> BuildingPointRanges;
+
+	/** Saves or loads the roads, nodes and buildings as flat blocks of data, one for each of their fields */
+	void SerializeGeometry( FArchive& Ar );
+
+	// The geometry as written by SerializeGeometry().  It is saved apart from the rest of the map, at the end of the
+	// package, so that it can be read later without holding up the load.
+	FByteBulkData GeometryBulkData;
+
+	// How many roads, nodes and buildings are in GeometryBulkData.  These are saved in front of it.
+	int32 HeaderRoadCount;
+	int32 HeaderNodeCount;
+	int32 HeaderBuildingCount;
+
+	// True from when the map is loaded until GeometryBulkData has been read into the roads, nodes and buildings
+	bool bIsLoadingGeometry;
+
+	// Goes up each time we start reading the geometry in the background, so that a read that was overtaken can be ignored
+	int32 GeometryLoadSerialNumber;
+
+	FOnStreetMapGeometryReady GeometryReadyEvent;
+
+	/** Saves or loads the header counts and the bulk data with the geometry in it */
+	void SerializeGeometryBulkData( FArchive& Ar );
+
+	/** Reads the geometry out of GeometryBulkData, blocking until it is loaded */
+	void LoadGeometryFromBulkData();
+
+	/** Reads the geometry from data written by SerializeGeometry(), and checks it against the header counts.  Returns
+	    false (leaving the map empty) if the data is damaged. */
+	bool LoadGeometry( FArchive& GeometryReader );
+
+	/** Starts reading GeometryBulkData from disk in the background, through the bulk data's own streaming request.
+	    Returns false if it can't be read that way. */
+	bool StartStreamingGeometry();
+
+	/** Builds the cached road data for geometry that loaded after PostLoad(), and lets everyone know it's ready */
+	void OnGeometryLoaded();
+
+	// Connection graph between nodes, in compressed sparse row form, for traveling backward [0] and forward [1].  The
+	// connections from node N are Connections[ D ][ ConnectionOffsets[ D ][ N ] .. ConnectionOffsets[ D ][ N + 1 ] - 1 ].
+	// This isn't saved.  BuildCachedRoadData() builds it.
+	TArray<int32> ConnectionOffsets[ 2 ];
+	TArray<FStreetMapConnection> Connections[ 2 ];
+
+	// True when the roads or nodes may have changed since BuildCachedRoadData() last ran, so the connection graph can't
+	// be trusted.  Set by MarkCachedRoadDataDirty() and whenever the geometry is loaded.
+	bool bIsCachedRoadDataStale;
+
+	/** Builds the connection graph from the nodes' road refs */
+	void BuildConnectionGraph();
+
 #if WITH_EDITORONLY_DATA
 	/** Importing data and options used for this mesh */
 	UPROPERTY( VisibleAnywhere, Instanced, Category=ImportSettings )
 	class UAssetImportData* AssetImportData;
 
+	/** Options used when importing this map.  Change these and reimport to apply them. */
+	UPROPERTY( EditAnywhere, Category=ImportSettings )
+	FStreetMapImportOptions ImportOptions;
+
+	/** OpenStreetMap IDs of everything in the map, used to apply osmChange files to it */
+	UPROPERTY()
+	FStreetMapOSMSourceData OSMSourceData;
+
+	/** osmChange files that have been applied to the map since it was last imported in full, oldest first.  The import
+	    data keeps pointing at the full OpenStreetMap file, so a plain reimport starts over from that.  Later changes look
+	    up nodes that the map didn't keep in that file and in these. */
+	UPROPERTY( VisibleAnywhere, Category=ImportSettings )
+	TArray<FString> AppliedChangeFiles;
+
 	friend class UStreetMapFactory;
 	friend class UStreetMapReimportFactory;
 	friend class FStreetMapAssetTypeActions;
+	friend class UStreetMapImportCommandlet;
 #endif	// WITH_EDITORONLY_DATA
 
 };
@@ -407,14 +1048,58 @@ inline int32 FStreetMapRoad::GetRoadIndex( const UStreetMap& StreetMap ) const
 }
 
 
+// These are the only places outside of building and compacting the geometry that should touch the deprecated arrays
+PRAGMA_DISABLE_DEPRECATION_WARNINGS
+
+inline TArrayView<const FVector2D> FStreetMapRoad::GetRoadPoints( const UStreetMap& StreetMap ) const
+{
+	if( RoadPoints.Num() > 0 )
+	{
+		return RoadPoints;
+	}
+	return StreetMap.GetPooledRoadPoints( GetRoadIndex( StreetMap ) );
+}
+
+
+inline TArrayView<const int32> FStreetMapRoad::GetNodeIndices( const UStreetMap& StreetMap ) const
+{
+	if( NodeIndices.Num() > 0 )
+	{
+		return NodeIndices;
+	}
+	return StreetMap.GetPooledRoadNodeIndices( GetRoadIndex( StreetMap ) );
+}
+
+
+inline int32 FStreetMapBuilding::GetBuildingIndex( const UStreetMap& StreetMap ) const
+{
+	// Pointer arithmetic based on array start
+	const int32 BuildingIndex = this - StreetMap.GetBuildings().GetData();
+	return BuildingIndex;
+}
+
+
+inline TArrayView<const FVector2D> FStreetMapBuilding::GetBuildingPoints( const UStreetMap& StreetMap ) const
+{
+	if( BuildingPoints.Num() > 0 )
+	{
+		return BuildingPoints;
+	}
+	return StreetMap.GetPooledBuildingPoints( GetBuildingIndex( StreetMap ) );
+}
+
+PRAGMA_ENABLE_DEPRECATION_WARNINGS
+
+
 inline const FStreetMapNode& FStreetMapRoad::GetNodeAtPointIndexOrEarlier( const UStreetMap& StreetMap, const int32 PointIndex, int32& OutNodeAtPointIndex ) const
 {
+	const TArrayView<const int32> RoadNodeIndices = GetNodeIndices( StreetMap );
 	const FStreetMapNode* CurrentOrEarlierPointNode = nullptr;
 	for( int32 NodePointIndex = PointIndex; NodePointIndex >= 0; --NodePointIndex )
 	{
-		if( NodeIndices[ NodePointIndex ] != INDEX_NONE )
+		if( RoadNodeIndices[ NodePointIndex ] != INDEX_NONE )
 		{
-			CurrentOrEarlierPointNode = &StreetMap.GetNodes()[ NodeIndices[ NodePointIndex ] ];
+			CurrentOrEarlierPointNode = &StreetMap.GetNodes()[ RoadNodeIndices[ NodePointIndex ] ];
 			OutNodeAtPointIndex = NodePointIndex;
 			break;
 		}
@@ -425,12 +1110,13 @@ inline const FStreetMapNode& FStreetMapRoad::GetNodeAtPointIndexOrEarlier( const
 
 inline const FStreetMapNode& FStreetMapRoad::GetNodeAtPointIndexOrLater( const UStreetMap& StreetMap, const int32 PointIndex, int32& OutNodeAtPointIndex ) const
 {
+	const TArrayView<const int32> RoadNodeIndices = GetNodeIndices( StreetMap );
 	const FStreetMapNode* NextOrUpcomingNode = nullptr;
-	for( int32 NodePointIndex = PointIndex; NodePointIndex < RoadPoints.Num(); ++NodePointIndex )
+	for( int32 NodePointIndex = PointIndex; NodePointIndex < RoadNodeIndices.Num(); ++NodePointIndex )
 	{
-		if( NodeIndices[ NodePointIndex ] != INDEX_NONE )
+		if( RoadNodeIndices[ NodePointIndex ] != INDEX_NONE )
 		{
-			NextOrUpcomingNode = &StreetMap.GetNodes()[ NodeIndices[ NodePointIndex ] ];
+			NextOrUpcomingNode = &StreetMap.GetNodes()[ RoadNodeIndices[ NodePointIndex ] ];
 			OutNodeAtPointIndex = NodePointIndex;
 			break;
 		}
@@ -440,81 +1126,92 @@ inline const FStreetMapNode& FStreetMapRoad::GetNodeAtPointIndexOrLater( const U
 }
 
 
-inline float FStreetMapRoad::ComputeLengthOfRoad( const class UStreetMap& StreetMap ) const
+inline TArrayView<const float> FStreetMapRoad::GetPointPositionsAlongRoad( const UStreetMap& StreetMap, TArray<float, TInlineAllocator<32>>& Scratch ) const
 {
-	// @todo: Performance: We could cache the road's total length at load time to avoid having to compute it,
-	//        or we could save it right into the asset file
+	if( !StreetMap.IsCachedRoadDataStale() && PointPositionsAlongRoad.Num() == GetNodeIndices( StreetMap ).Num() )
+	{
+		return PointPositionsAlongRoad;
+	}
 
-	return ComputeDistanceBetweenNodesOnRoad( StreetMap, 0, this->NodeIndices.Num() - 1 );
+	ComputePointPositionsAlongRoad( StreetMap, Scratch );
+	return Scratch;
 }
 
 
-inline float FStreetMapRoad::ComputeDistanceBetweenNodesOnRoad( const class UStreetMap& StreetMap, const int32 NodePointIndexA, const int32 NodePointIndexB ) const
+template<typename AllocatorType>
+inline void FStreetMapRoad::ComputePointPositionsAlongRoad( const UStreetMap& StreetMap, TArray<float, AllocatorType>& OutPointPositions ) const
 {
-	float TotalDistanceSoFar = 0.0f;
+	const TArrayView<const FVector2D> Points = GetRoadPoints( StreetMap );
+	OutPointPositions.SetNumUninitialized( Points.Num() );
 
+	float CurrentPointPositionAlongRoad = 0.0f;
+	for( int32 PointIndex = 0; PointIndex < Points.Num(); ++PointIndex )
+	{
+		if( PointIndex > 0 )
+		{
+			CurrentPointPositionAlongRoad += ( Points[ PointIndex ] - Points[ PointIndex - 1 ] ).Size();
+		}
+		OutPointPositions[ PointIndex ] = CurrentPointPositionAlongRoad;
+	}
+}
+
+
+inline float FStreetMapRoad::ComputeLengthOfRoad( const class UStreetMap& StreetMap ) const
+{
+	return ComputeDistanceBetweenNodesOnRoad( StreetMap, 0, GetNodeIndices( StreetMap ).Num() - 1 );
+}
+
+
+inline float FStreetMapRoad::ComputeDistanceBetweenNodesOnRoad( const class UStreetMap& StreetMap, const int32 NodePointIndexA, const int32 NodePointIndexB ) const
+{
 	// NOTE: It is very important that we use the actual road point indices here and not nodes directly, because the same node can appear
 	// more than once on a single road!
 
-	// @todo: Performance: We can cache distances between connected nodes rather than computing them every time.  This
-	//        can be computed at load time or at import time (and stored in the asset).  Most of the other functions
-	//        in this class that perform Size() computations could be changed to use cached distances also!
+	TArray<float, TInlineAllocator<32>> Scratch;
+	const TArrayView<const float> PointPositions = GetPointPositionsAlongRoad( StreetMap, Scratch );
 
 	const int32 SmallerPointIndex = FMath::Max( 0, FMath::Min( NodePointIndexA, NodePointIndexB ) );
-	const int32 LargerPointIndex = FMath::Min( RoadPoints.Num() - 1, FMath::Max( NodePointIndexA, NodePointIndexB ) );
-
-	for( int32 PointIndex = SmallerPointIndex; PointIndex < LargerPointIndex; ++PointIndex )
+	const int32 LargerPointIndex = FMath::Min( PointPositions.Num() - 1, FMath::Max( NodePointIndexA, NodePointIndexB ) );
+	if( LargerPointIndex <= SmallerPointIndex )
 	{
-		const FVector2D PointLocation = RoadPoints[ PointIndex ];
-		const FVector2D NextPointLocation = RoadPoints[ PointIndex + 1 ];
-
-		const float DistanceBetweenPoints = ( NextPointLocation - PointLocation ).Size();
-			
-		TotalDistanceSoFar += DistanceBetweenPoints;
+		return 0.0f;
 	}
-	
-	// @todo: Malformed data can cause this assertion to trigger.  This could be a single road with at least two adjacent nodes
-	//        at the exact same location.  We need to filter this out at load time probably.
-	// check( TotalDistanceSoFar > 0.0f );
 
-	return TotalDistanceSoFar;
+	return PointPositions[ LargerPointIndex ] - PointPositions[ SmallerPointIndex ];
 }
 
 
 inline void FStreetMapRoad::FindEarlierAndLaterNodesForPositionAlongRoad( const class UStreetMap& StreetMap, const float PositionAlongRoad, const FStreetMapNode*& OutEarlierNode, float& OutEarlierNodePositionAlongRoad, const FStreetMapNode*& OutLaterNode, float& OutLaterNodePositionAlongRoad ) const
 {
-	float CurrentPointPositionAlongRoad = 0.0f;
+	TArray<float, TInlineAllocator<32>> Scratch;
+	const TArrayView<const float> PointPositions = GetPointPositionsAlongRoad( StreetMap, Scratch );
+	const TArrayView<const int32> RoadNodeIndices = GetNodeIndices( StreetMap );
 
 	const FStreetMapNode* EarlierStreetMapNode = nullptr;
 	const FStreetMapNode* LaterStreetMapNode = nullptr;
 
-	const int32 NumPoints = RoadPoints.Num();
-	for( int32 CurrentPointIndex = 0; CurrentPointIndex < NumPoints - 1; ++CurrentPointIndex )
+	// The later node is the first one at or past the position (never the first point), and the earlier node is the
+	// last one before that
+	const int32 NumPoints = RoadNodeIndices.Num();
+	int32 LaterPointIndex = FMath::Max( 1, Algo::LowerBound( PointPositions, PositionAlongRoad ) );
+	while( LaterPointIndex < NumPoints && RoadNodeIndices[ LaterPointIndex ] == INDEX_NONE )
 	{
-		if( this->NodeIndices[ CurrentPointIndex ] != INDEX_NONE )
-		{
-			EarlierStreetMapNode = &StreetMap.GetNodes()[ this->NodeIndices[ CurrentPointIndex ] ];
-			OutEarlierNodePositionAlongRoad = CurrentPointPositionAlongRoad;
-		}
-
-		const int32 NextPointIndex = CurrentPointIndex + 1;
-		const FVector2D CurrentPointLocation = RoadPoints[ CurrentPointIndex ];
-		const FVector2D NextPointLocation = RoadPoints[ NextPointIndex ];
-
-		const float DistanceBetweenPoints = ( NextPointLocation - CurrentPointLocation ).Size();
-		const float NextPointPositionAlongRoad = CurrentPointPositionAlongRoad + DistanceBetweenPoints;
+		++LaterPointIndex;
+	}
+	if( LaterPointIndex < NumPoints )
+	{
+		LaterStreetMapNode = &StreetMap.GetNodes()[ RoadNodeIndices[ LaterPointIndex ] ];
+		OutLaterNodePositionAlongRoad = PointPositions[ LaterPointIndex ];
 
-		if( NextPointPositionAlongRoad >= PositionAlongRoad )
+		for( int32 EarlierPointIndex = LaterPointIndex - 1; EarlierPointIndex >= 0; --EarlierPointIndex )
 		{
-			if( NodeIndices[ NextPointIndex ] != INDEX_NONE )
+			if( RoadNodeIndices[ EarlierPointIndex ] != INDEX_NONE )
 			{
-				LaterStreetMapNode = &StreetMap.GetNodes()[ this->NodeIndices[ NextPointIndex ] ];
-				OutLaterNodePositionAlongRoad = NextPointPositionAlongRoad;
+				EarlierStreetMapNode = &StreetMap.GetNodes()[ RoadNodeIndices[ EarlierPointIndex ] ];
+				OutEarlierNodePositionAlongRoad = PointPositions[ EarlierPointIndex ];
 				break;
 			}
 		}
-			
-		CurrentPointPositionAlongRoad = NextPointPositionAlongRoad;
 	}
 
 	check( EarlierStreetMapNode != nullptr && LaterStreetMapNode != nullptr );
@@ -530,21 +1227,22 @@ inline void FStreetMapRoad::FindEarlierAndLaterNodes( const class UStreetMap& St
 	OutLaterNode = nullptr;
 	OutLaterNodePositionAlongRoad = -1.0f;
 
+	const TArrayView<const int32> RoadNodeIndices = GetNodeIndices( StreetMap );
 	for( int32 EarlierPointIndex = RoadPointIndex - 1; EarlierPointIndex >= 0; --EarlierPointIndex )
 	{
-		if( this->NodeIndices[ EarlierPointIndex ] != INDEX_NONE )
+		if( RoadNodeIndices[ EarlierPointIndex ] != INDEX_NONE )
 		{
-			OutEarlierNode = &StreetMap.GetNodes()[ this->NodeIndices[ EarlierPointIndex ] ];
+			OutEarlierNode = &StreetMap.GetNodes()[ RoadNodeIndices[ EarlierPointIndex ] ];
 			OutEarlierNodePositionAlongRoad = FindPositionAlongRoadForNode( StreetMap, EarlierPointIndex );
 			break;
 		}
 	}
 
-	for( int32 LaterPointIndex = RoadPointIndex + 1; LaterPointIndex < this->RoadPoints.Num(); ++LaterPointIndex )
+	for( int32 LaterPointIndex = RoadPointIndex + 1; LaterPointIndex < RoadNodeIndices.Num(); ++LaterPointIndex )
 	{
-		if( this->NodeIndices[ LaterPointIndex ] != INDEX_NONE )
+		if( RoadNodeIndices[ LaterPointIndex ] != INDEX_NONE )
 		{
-			OutLaterNode = &StreetMap.GetNodes()[ this->NodeIndices[ LaterPointIndex ] ];
+			OutLaterNode = &StreetMap.GetNodes()[ RoadNodeIndices[ LaterPointIndex ] ];
 			OutLaterNodePositionAlongRoad = FindPositionAlongRoadForNode( StreetMap, LaterPointIndex );
 			break;
 		}
@@ -554,54 +1252,32 @@ inline void FStreetMapRoad::FindEarlierAndLaterNodes( const class UStreetMap& St
 
 inline float FStreetMapRoad::FindPositionAlongRoadForNode( const class UStreetMap& StreetMap, const int32 PointIndexForNode ) const
 {
-	float CurrentPointPositionAlongRoad = 0.0f;
-
-	bool bFoundLocation = false;
-	const int32 NumPoints = RoadPoints.Num();
-	for( int32 CurrentPointIndex = 0; CurrentPointIndex < PointIndexForNode; ++CurrentPointIndex )
+	if( PointIndexForNode <= 0 )
 	{
-		const FVector2D CurrentPointLocation = RoadPoints[ CurrentPointIndex ];
-		const FVector2D NextPointLocation = RoadPoints[ CurrentPointIndex + 1 ];
-
-		const float DistanceBetweenPoints = ( NextPointLocation - CurrentPointLocation ).Size();
-		const float NextPointPositionAlongRoad = CurrentPointPositionAlongRoad + DistanceBetweenPoints;
-
-		CurrentPointPositionAlongRoad = NextPointPositionAlongRoad;
+		return 0.0f;
 	}
 
-	return CurrentPointPositionAlongRoad;
+	TArray<float, TInlineAllocator<32>> Scratch;
+	const TArrayView<const float> PointPositions = GetPointPositionsAlongRoad( StreetMap, Scratch );
+	return PointPositions[ PointIndexForNode ];
 }
 
 
 inline FVector2D FStreetMapRoad::MakeLocationAlongRoad( const class UStreetMap& StreetMap, const float PositionAlongRoad ) const
 {
-	FVector2D LocationAlongRoad = FVector2D::ZeroVector;
-	float CurrentPointPositionAlongRoad = 0.0f;
-
-	bool bFoundLocation = false;
-	const int32 NumPoints = RoadPoints.Num();
-	for( int32 CurrentPointIndex = 0; CurrentPointIndex < NumPoints - 1; ++CurrentPointIndex )
-	{
-		const FVector2D CurrentPointLocation = RoadPoints[ CurrentPointIndex ];
-		const FVector2D NextPointLocation = RoadPoints[ CurrentPointIndex + 1 ];
-
-		const float DistanceBetweenPoints = ( NextPointLocation - CurrentPointLocation ).Size();
-		const float NextPointPositionAlongRoad = CurrentPointPositionAlongRoad + DistanceBetweenPoints;
-
-		if( NextPointPositionAlongRoad >= PositionAlongRoad )
-		{
-			const float LerpAlpha = ( PositionAlongRoad - CurrentPointPositionAlongRoad ) / DistanceBetweenPoints;
-			LocationAlongRoad = FMath::Lerp( CurrentPointLocation, NextPointLocation, LerpAlpha );
-			bFoundLocation = true;
-			break;
-		}
-			
-		CurrentPointPositionAlongRoad = NextPointPositionAlongRoad;
-	}
-
-	check( bFoundLocation == true );
-
-	return LocationAlongRoad;
+	TArray<float, TInlineAllocator<32>> Scratch;
+	const TArrayView<const float> PointPositions = GetPointPositionsAlongRoad( StreetMap, Scratch );
+	const TArrayView<const FVector2D> Points = GetRoadPoints( StreetMap );
+
+	// Find the first segment that ends at or past the position
+	const int32 NumPoints = Points.Num();
+	const int32 NextPointIndex = FMath::Max( 1, Algo::LowerBound( PointPositions, PositionAlongRoad ) );
+	check( NextPointIndex < NumPoints );
+
+	const int32 CurrentPointIndex = NextPointIndex - 1;
+	const float DistanceBetweenPoints = PointPositions[ NextPointIndex ] - PointPositions[ CurrentPointIndex ];
+	const float LerpAlpha = ( PositionAlongRoad - PointPositions[ CurrentPointIndex ] ) / DistanceBetweenPoints;
+	return FMath::Lerp( Points[ CurrentPointIndex ], Points[ NextPointIndex ], LerpAlpha );
 }
 
 
@@ -622,7 +1298,7 @@ inline bool FStreetMapNode::IsDeadEnd( const UStreetMap& StreetMap ) const
 
 		const FStreetMapRoadRef& SoleRoadRef = RoadRefs[ 0 ];
 		const FStreetMapRoad& SoleRoad = StreetMap.GetRoads()[ SoleRoadRef.RoadIndex ];
-		if( SoleRoadRef.RoadPointIndex == 0 || SoleRoadRef.RoadPointIndex == ( SoleRoad.NodeIndices.Num() - 1 ) )
+		if( SoleRoadRef.RoadPointIndex == 0 || SoleRoadRef.RoadPointIndex == ( SoleRoad.GetNodeIndices( StreetMap ).Num() - 1 ) )
 		{
 			// The node is attached to only one road, and the node is at the very end of one of the ends of the road
 			return true;
@@ -636,7 +1312,7 @@ inline bool FStreetMapNode::IsDeadEnd( const UStreetMap& StreetMap ) const
 inline FVector2D FStreetMapNode::GetLocation( const UStreetMap& StreetMap ) const
 {
 	const FStreetMapRoadRef& MyFirstRoadRef = RoadRefs[ 0 ];
-	const FVector2D Location = StreetMap.GetRoads()[ MyFirstRoadRef.RoadIndex ].RoadPoints[ MyFirstRoadRef.RoadPointIndex ];
+	const FVector2D Location = StreetMap.GetRoads()[ MyFirstRoadRef.RoadIndex ].GetRoadPoints( StreetMap )[ MyFirstRoadRef.RoadPointIndex ];
 	return Location;
 }
 
@@ -686,11 +1362,17 @@ inline const FStreetMapRoad& FStreetMapNode::GetShortestCostRoadToNode( UStreetM
 
 inline int32 FStreetMapNode::GetConnectionCount( const UStreetMap& StreetMap, const bool bIsTravelingForward ) const
 {
+	if( StreetMap.HasConnectionGraph() )
+	{
+		return GetConnections( StreetMap, bIsTravelingForward ).Num();
+	}
+
 	// NOTE: We're iterating here in the exact same order as in the GetConnection() function below!  That's critically important!
 	int32 TotalConnections = 0;
 	for( const FStreetMapRoadRef& RoadRef : RoadRefs )
 	{
 		const FStreetMapRoad& Road = StreetMap.GetRoads()[ RoadRef.RoadIndex ];
+		const TArrayView<const int32> RoadNodeIndices = Road.GetNodeIndices( StreetMap );
 		
 		if( RoadRef.RoadPointIndex > 0 && ( !bIsTravelingForward || !Road.IsOneWay() ) )
 		{
@@ -698,7 +1380,7 @@ inline int32 FStreetMapNode::GetConnectionCount( const UStreetMap& StreetMap, co
 			++TotalConnections;
 		}
 
-		if( RoadRef.RoadPointIndex < ( Road.NodeIndices.Num() - 1 ) && ( bIsTravelingForward || !Road.IsOneWay() ) )
+		if( RoadRef.RoadPointIndex < ( RoadNodeIndices.Num() - 1 ) && ( bIsTravelingForward || !Road.IsOneWay() ) )
 		{
 			// We connect to a node further down this road
 			++TotalConnections;
@@ -711,20 +1393,37 @@ inline int32 FStreetMapNode::GetConnectionCount( const UStreetMap& StreetMap, co
 
 inline const FStreetMapNode* FStreetMapNode::GetConnection( const UStreetMap& StreetMap, const int32 ConnectionIndex, const bool bIsTravelingForward, const FStreetMapRoad** OutConnectingRoad, int32* OutPointIndexOnRoad, int32* OutConnectedNodePointIndexOnRoad ) const
 {
+	if( StreetMap.HasConnectionGraph() )
+	{
+		const FStreetMapConnection& Connection = GetConnections( StreetMap, bIsTravelingForward )[ ConnectionIndex ];
+		if( OutConnectingRoad != nullptr )
+		{
+			*OutConnectingRoad = &StreetMap.GetRoads()[ Connection.RoadIndex ];
+		}
+		if( OutPointIndexOnRoad != nullptr )
+		{
+			*OutPointIndexOnRoad = Connection.PointIndexOnRoad;
+		}
+		if( OutConnectedNodePointIndexOnRoad != nullptr )
+		{
+			*OutConnectedNodePointIndexOnRoad = Connection.ConnectedNodePointIndexOnRoad;
+		}
+		return &StreetMap.GetNodes()[ Connection.NodeIndex ];
+	}
+
+	// Without the connection graph, we have to search through our roads for the connection
 	if( OutConnectingRoad != nullptr )
 	{
 		*OutConnectingRoad = nullptr;
 	}
 	const FStreetMapNode* ConnectedNode = nullptr;
 
-	// @todo: Performance: We can improve performance by caching additional connectivity information right on
-	//        the node itself.  This function would be a hot spot for any sort of pathfinding computation
-
 	// NOTE: We're iterating here in the exact same order as in the GetConnectionCount() function above!  That's critically important!
 	int32 CurrentConnectionIndex = 0;
 	for( const FStreetMapRoadRef& RoadRef : RoadRefs )
 	{
 		const FStreetMapRoad& Road = StreetMap.GetRoads()[ RoadRef.RoadIndex ];
+		const TArrayView<const int32> RoadNodeIndices = Road.GetNodeIndices( StreetMap );
 		
 		// @todo: Performance: We could avoid the "while" loops below by not storing INDEX_NONEs in the NodeIndices array,
 		//        but instead mapping them to points by going through the node itself, then back to a road
@@ -735,11 +1434,11 @@ inline const FStreetMapNode* FStreetMapNode::GetConnection( const UStreetMap& St
 			if( CurrentConnectionIndex == ConnectionIndex )
 			{
 				int32 EarlierNodeRoadPointIndex = RoadRef.RoadPointIndex - 1;
-				while( Road.NodeIndices[ EarlierNodeRoadPointIndex ] == INDEX_NONE )
+				while( RoadNodeIndices[ EarlierNodeRoadPointIndex ] == INDEX_NONE )
 				{
 					--EarlierNodeRoadPointIndex;
 				}
-				const int32 EarlierNodeIndex = Road.NodeIndices[ EarlierNodeRoadPointIndex ];
+				const int32 EarlierNodeIndex = RoadNodeIndices[ EarlierNodeRoadPointIndex ];
 
 				const FStreetMapNode& EarlierNode = StreetMap.GetNodes()[ EarlierNodeIndex ];
 				ConnectedNode = &EarlierNode;
@@ -763,17 +1462,17 @@ inline const FStreetMapNode* FStreetMapNode::GetConnection( const UStreetMap& St
 			++CurrentConnectionIndex;
 		}
 
-		if( RoadRef.RoadPointIndex < ( Road.NodeIndices.Num() - 1 ) && ( bIsTravelingForward || !Road.IsOneWay() ) )
+		if( RoadRef.RoadPointIndex < ( RoadNodeIndices.Num() - 1 ) && ( bIsTravelingForward || !Road.IsOneWay() ) )
 		{
 			// We connect to node further down this road
 			if( CurrentConnectionIndex == ConnectionIndex )
 			{
 				int32 LaterNodeRoadPointIndex = RoadRef.RoadPointIndex + 1;
-				while( Road.NodeIndices[ LaterNodeRoadPointIndex ] == INDEX_NONE )
+				while( RoadNodeIndices[ LaterNodeRoadPointIndex ] == INDEX_NONE )
 				{
 					++LaterNodeRoadPointIndex;
 				}
-				const int32 LaterNodeIndex = Road.NodeIndices[ LaterNodeRoadPointIndex ];
+				const int32 LaterNodeIndex = RoadNodeIndices[ LaterNodeRoadPointIndex ];
 
 				const FStreetMapNode& LaterNode = StreetMap.GetNodes()[ LaterNodeIndex ];
 				ConnectedNode = &LaterNode;
@@ -804,6 +1503,30 @@ inline const FStreetMapNode* FStreetMapNode::GetConnection( const UStreetMap& St
 
 
 inline float FStreetMapNode::GetConnectionCost( const UStreetMap& StreetMap, const int32 ConnectionIndex, const bool bIsTravelingForward ) const
+{
+	if( StreetMap.HasConnectionGraph() )
+	{
+		return GetConnections( StreetMap, bIsTravelingForward )[ ConnectionIndex ].Cost;
+	}
+
+	int32 MyPointIndexOnRoad;
+	int32 ConnectedNodePointIndexOnRoad;
+
+	const FStreetMapRoad* ConnectingRoad = nullptr;
+	GetConnection( StreetMap, ConnectionIndex, bIsTravelingForward, /* Out */ &ConnectingRoad, /* Out */ &MyPointIndexOnRoad, /* Out */ &ConnectedNodePointIndexOnRoad );
+
+	const float DistanceBetweenNodes = ConnectingRoad->ComputeDistanceBetweenNodesOnRoad( StreetMap, MyPointIndexOnRoad, ConnectedNodePointIndexOnRoad );
+	return EstimateConnectionCost( ConnectingRoad->RoadType, DistanceBetweenNodes );
+}
+
+
+inline TArrayView<const FStreetMapConnection> FStreetMapNode::GetConnections( const UStreetMap& StreetMap, const bool bIsTravelingForward ) const
+{
+	return StreetMap.GetConnections( GetNodeIndex( StreetMap ), bIsTravelingForward );
+}
+
+
+inline float FStreetMapNode::EstimateConnectionCost( const EStreetMapRoadType RoadType, const float DistanceBetweenNodes )
 {
 	/////////////////////////////////////////////////////////
 	// Tweakables for connection cost estimation
@@ -822,21 +1545,13 @@ inline float FStreetMapNode::GetConnectionCost( const UStreetMap& StreetMap, con
 	//        future we could consider taking into account the cost of different types of turns and
 	//        intersections, lane counts, actual speed limits, etc.
 
-	int32 MyPointIndexOnRoad;
-	int32 ConnectedNodePointIndexOnRoad;
-
-	const FStreetMapRoad* ConnectingRoad = nullptr;
-	const FStreetMapNode& ConnectedNode = *GetConnection( StreetMap, ConnectionIndex, bIsTravelingForward, /* Out */ &ConnectingRoad, /* Out */ &MyPointIndexOnRoad, /* Out */ &ConnectedNodePointIndexOnRoad );
-
-	const float DistanceBetweenNodes = ConnectingRoad->ComputeDistanceBetweenNodesOnRoad( StreetMap, MyPointIndexOnRoad, ConnectedNodePointIndexOnRoad );
-	
 	float TotalCost = DistanceBetweenNodes;
 
 	// Apply some scaling to the cost of traveling between these nodes
 	{
 		float SpeedLimit = 0.0f;
 		float TrafficFactor = 0.0f;
-		switch( ConnectingRoad->RoadType )
+		switch( RoadType )
 		{
 			case EStreetMapRoadType::Highway:
 				SpeedLimit = HighwaySpeed;
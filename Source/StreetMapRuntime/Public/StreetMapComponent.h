@@ -124,7 +124,8 @@ public:
 	/** Wipes out our cached mesh data. Designed to be called on demand.*/
 	void InvalidateMesh();
 
-	/** Rebuilds the graphics and physics mesh representation if we don't have one right now.  Designed to be called on demand. */
+	/** Rebuilds the graphics and physics mesh representation if we don't have one right now.  Designed to be called on demand.
+	    If the street map's geometry is still loading, the mesh is built once it has loaded instead. */
 	void BuildMesh();
 
 
@@ -140,6 +141,9 @@ protected:
 	/** Generates a cached mesh from raw street map data */
 	void GenerateMesh();
 
+	/** Builds the mesh that BuildMesh() put off until the street map's geometry had loaded */
+	void OnStreetMapGeometryReady(UStreetMap* ReadyStreetMap);
+
 	/** Adds a 2D line to the raw mesh */
 	void AddThick2DLine(const FVector2D Start, const FVector2D End, const float Z, const float Thickness, const FColor& StartColor, const FColor& EndColor, FBox& MeshBoundingBox);
 
@@ -163,6 +167,9 @@ protected:
 	UPROPERTY(Transient)
 		UBodySetup* StreetMapBodySetup;
 
+	/** Set while we're waiting for the street map's geometry to load so that we can build the mesh */
+	FDelegateHandle GeometryReadyHandle;
+
 
 protected:
 	//
@@ -0,0 +1,31 @@
+// Copyright 2017 Mike Fricker. All Rights Reserved.
+#pragma once
+
+#include "Misc/Guid.h"
+
+
+/** Versions of the street map data that is saved in packages */
+struct STREETMAPRUNTIME_API FStreetMapCustomVersion
+{
+	enum Type
+	{
+		// Before any version changes were made
+		BeforeCustomVersionWasAdded = 0,
+
+		// Roads, nodes and buildings are saved in flat blocks after the tagged properties, instead of as tagged properties
+		BulkGeometry,
+
+		// The flat blocks are saved as bulk data at the end of the package, after a header with the counts in it
+		GeometryBulkData,
+
+		// -----<new versions can be added above this line>-------------------------------------------------
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	/** The GUID for this custom version number */
+	const static FGuid GUID;
+
+private:
+	FStreetMapCustomVersion() {}
+};